@@ -0,0 +1,127 @@
+#
+# Check that PyBuffer shares the images and the NumPy arrays without copy,
+# that the owner of a shared buffer is kept alive, and that PyLabelMap
+# returns copies of the lines of the label objects.
+#
+# usage: PyBufferTest.py wrapperLibraryDirectory...
+#
+
+import sys
+import gc
+
+# the wrapper library built with the test
+sys.path[0:0] = sys.argv[1:]
+import itkConfig
+itkConfig.path[0:0] = sys.argv[1:]
+
+import itk
+import numpy
+
+dim = 2
+IType = itk.Image[itk.UC, dim]
+LMType = itk.LabelMap[itk.LabelObject[itk.UL, dim]]
+PyBuffer = itk.PyBuffer[IType]
+PyLabelMap = itk.PyLabelMap[LMType]
+
+failures = []
+
+def check(condition, message):
+  if not condition:
+    print("failed: " + message)
+    failures.append(message)
+
+def raises(function, *args):
+  try:
+    function(*args)
+  except Exception:
+    return True
+  return False
+
+
+# GetArrayFromImage(): the array is a view on the buffer of the image
+image = IType.New()
+image.SetRegions([5, 3])
+image.Allocate()
+image.FillBuffer(0)
+array = PyBuffer.GetArrayFromImage(image)
+check(array.shape == (3, 5), "the shape of the array is the reversed size of the image")
+check(array.dtype == numpy.uint8, "the array has the pixel type of the image")
+array[1, 2] = 7
+check(image.GetPixel([2, 1]) == 7, "a change in the array is seen in the image")
+image.SetPixel([4, 2], 9)
+check(array[2, 4] == 9, "a change in the image is seen in the array")
+
+# the array keeps the buffer alive once the image is deleted
+del image
+gc.collect()
+check(array[1, 2] == 7 and array[2, 4] == 9 and array.sum() == 16,
+      "the array is still valid after the deletion of the image")
+del array
+gc.collect()
+
+
+# GetImageFromArray(): the image uses the buffer of the array
+array = numpy.zeros((3, 5), numpy.uint8)
+refCount = sys.getrefcount(array)
+image = PyBuffer.GetImageFromArray(array)
+check(sys.getrefcount(array) == refCount + 1, "the image keeps a reference to the array")
+size = image.GetLargestPossibleRegion().GetSize()
+check(size[0] == 5 and size[1] == 3, "the size of the image is the reversed shape of the array")
+array[0, 1] = 4
+check(image.GetPixel([1, 0]) == 4, "a change in the array is seen in the image")
+image.SetPixel([3, 2], 6)
+check(array[2, 3] == 6, "a change in the image is seen in the array")
+
+# round trip: the array of the image is a view on the first array
+view = PyBuffer.GetArrayFromImage(image)
+check(view.ctypes.data == array.ctypes.data, "the round trip doesn't copy the buffer")
+del view
+del image
+gc.collect()
+check(sys.getrefcount(array) == refCount, "the array is released with the image")
+
+# the image keeps a temporary array alive
+image = PyBuffer.GetImageFromArray(numpy.arange(15, dtype=numpy.uint8).reshape(3, 5))
+gc.collect()
+check(image.GetPixel([4, 2]) == 14, "the image is still valid after the deletion of the array")
+
+# no silent copy of an array which can't be shared
+check(raises(PyBuffer.GetImageFromArray, array[:, ::2]), "a non contiguous array is rejected")
+check(raises(PyBuffer.GetImageFromArray, array.astype(numpy.float32)), "an array of another type is rejected")
+check(raises(PyBuffer.GetImageFromArray, numpy.zeros((3, 5, 2), numpy.uint8)), "an array of another dimension is rejected")
+
+
+# GetLinesArray(): a copy of the lines of a label object
+labels = numpy.zeros((3, 5), numpy.uint8)
+labels[0, 1:4] = 1
+labels[2, 0:2] = 1
+labels[1, 4] = 2
+labelImage = PyBuffer.GetImageFromArray(labels)
+converter = itk.LabelImageToLabelMapFilter[IType, LMType].New()
+converter.SetInput(labelImage)
+converter.Update()
+labelMap = converter.GetOutput()
+
+check(list(PyLabelMap.GetLabelsArray(labelMap)) == [1, 2], "the labels of the label map")
+
+labelObject = labelMap.GetLabelObject(1)
+lines = PyLabelMap.GetLinesArray(labelObject)
+check(lines.dtype.names == ("index", "length"), "the fields of the lines")
+check(sorted((tuple(l["index"]), l["length"]) for l in lines) == [((0, 2), 2), ((1, 0), 3)],
+      "the lines of the label object")
+check(lines.flags.owndata, "the lines array owns its buffer")
+
+# adding lines reallocates the line container, but not the array
+for y in range(1000):
+  labelObject.AddLine([0, y + 3], 1)
+check(len(lines) == 2 and sorted(lines["length"]) == [2, 3], "the lines array doesn't change with the label object")
+check(len(PyLabelMap.GetLinesArray(labelObject)) == 1002, "a new lines array has the added lines")
+
+# the lines array doesn't depend on the label object
+del labelObject, labelMap, converter, labelImage
+gc.collect()
+check(sorted(lines["length"]) == [2, 3], "the lines array is still valid after the deletion of the label map")
+
+
+if failures:
+  sys.exit(1)
@@ -0,0 +1,36 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPyBuffer.cxx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+// the only translation unit where the NumPy C API is defined
+#include <Python.h>
+#define PY_ARRAY_UNIQUE_SYMBOL watershed_ARRAY_API
+#include "itkPyBuffer.h"
+
+namespace itk {
+
+bool ImportNumPy()
+{
+  static bool imported = false;
+  if( !imported )
+    {
+    // import_array1() returns false on failure
+    import_array1( false );
+    imported = true;
+    }
+  return true;
+}
+
+}// end namespace itk
@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPyBuffer.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPyBuffer_h
+#define __itkPyBuffer_h
+
+// Python.h must be included before the standard headers
+#include <Python.h>
+#include "itkImage.h"
+#include "itkCommand.h"
+
+// the NumPy C API is defined in itkPyBuffer.cxx, and shared by all the
+// translation units of the wrapper library
+#ifndef PY_ARRAY_UNIQUE_SYMBOL
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL watershed_ARRAY_API
+#endif
+#include "numpy/arrayobject.h"
+
+namespace itk
+{
+
+/** Import the NumPy C API in the wrapper library. It is called by the
+ * methods which need it, and can be called several times. Return false,
+ * with a Python exception set, if NumPy can't be imported. */
+bool ImportNumPy();
+
+/** \class PyArrayTypeTraits
+ *  \brief The NumPy type number of a C++ type
+ */
+template < class T > struct PyArrayTypeTraits {};
+template <> struct PyArrayTypeTraits< char > { enum { Type = NPY_BYTE }; };
+template <> struct PyArrayTypeTraits< signed char > { enum { Type = NPY_BYTE }; };
+template <> struct PyArrayTypeTraits< unsigned char > { enum { Type = NPY_UBYTE }; };
+template <> struct PyArrayTypeTraits< short > { enum { Type = NPY_SHORT }; };
+template <> struct PyArrayTypeTraits< unsigned short > { enum { Type = NPY_USHORT }; };
+template <> struct PyArrayTypeTraits< int > { enum { Type = NPY_INT }; };
+template <> struct PyArrayTypeTraits< unsigned int > { enum { Type = NPY_UINT }; };
+template <> struct PyArrayTypeTraits< long > { enum { Type = NPY_LONG }; };
+template <> struct PyArrayTypeTraits< unsigned long > { enum { Type = NPY_ULONG }; };
+template <> struct PyArrayTypeTraits< float > { enum { Type = NPY_FLOAT }; };
+template <> struct PyArrayTypeTraits< double > { enum { Type = NPY_DOUBLE }; };
+
+
+/** \class PyBufferReleaseCommand
+ *  \brief Release a Python object when the observed ITK object is deleted
+ *
+ * It is used to keep a NumPy array alive as long as an ITK image uses its
+ * buffer. The Python object is released with the interpreter lock held, so
+ * the ITK object can be deleted from any thread.
+ */
+class PyBufferReleaseCommand : public Command
+{
+public:
+  typedef PyBufferReleaseCommand Self;
+  typedef Command                Superclass;
+  typedef SmartPointer<Self>     Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(PyBufferReleaseCommand, Command);
+
+  /** keep a reference to the object until the observed object is deleted */
+  void SetObject( PyObject * obj )
+    {
+    Py_XINCREF( obj );
+    m_Object = obj;
+    }
+
+  void Execute( Object *, const EventObject & )
+    {
+    this->Release();
+    }
+
+  void Execute( const Object *, const EventObject & )
+    {
+    this->Release();
+    }
+
+protected:
+  PyBufferReleaseCommand()
+    {
+    m_Object = NULL;
+    }
+  ~PyBufferReleaseCommand()
+    {
+    this->Release();
+    }
+
+  void Release()
+    {
+    if( m_Object )
+      {
+      PyGILState_STATE state = PyGILState_Ensure();
+      Py_DECREF( m_Object );
+      PyGILState_Release( state );
+      m_Object = NULL;
+      }
+    }
+
+private:
+  PyBufferReleaseCommand(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  PyObject * m_Object;
+};
+
+
+/** \class PyBuffer
+ *  \brief Share the buffer of an image with a NumPy array, without copy
+ *
+ * GetArrayFromImage() returns a NumPy array which uses the buffer of the
+ * image, and GetImageFromArray() returns an image which uses the buffer of
+ * the array. In both cases the data is not copied: a modification of one
+ * is seen in the other, and the owner of the buffer is kept alive as long
+ * as the other one exists.
+ *
+ * The shape of the array is the size of the image in the reverse order, as
+ * the first dimension of an ITK image is the fastest varying one, while it
+ * is the last one for a NumPy array in C order. The array given to
+ * GetImageFromArray() must be C contiguous, aligned, and of the exact
+ * pixel type of the image: no conversion is done, as it would require a
+ * copy.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa PyLabelMap
+ */
+template<class TImage>
+class ITK_EXPORT PyBuffer
+{
+public:
+  /** Standard class typedefs. */
+  typedef PyBuffer Self;
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::SizeType        SizeType;
+  typedef typename ImageType::PixelContainer  PixelContainerType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** Return a NumPy array which shares the buffer of the image */
+  static PyObject * GetArrayFromImage( ImageType * image );
+
+  /** Return an image which shares the buffer of the NumPy array */
+  static ImagePointer GetImageFromArray( PyObject * obj );
+
+private:
+  /** release the pixel container kept by an array */
+  static void ReleasePixelContainer( PyObject * capsule );
+
+  PyBuffer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkPyBuffer.txx"
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPyBuffer.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPyBuffer_txx
+#define __itkPyBuffer_txx
+
+#include "itkPyBuffer.h"
+
+namespace itk {
+
+template<class TImage>
+PyObject *
+PyBuffer<TImage>
+::GetArrayFromImage( ImageType * image )
+{
+  if( !image )
+    { itkGenericExceptionMacro( << "The image is NULL." ); }
+  if( !ImportNumPy() )
+    { return NULL; }
+
+  // the first dimension of the image is the last one of the array
+  npy_intp dims[ ImageDimension ];
+  const SizeType & size = image->GetBufferedRegion().GetSize();
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    dims[ ImageDimension - 1 - i ] = size[i];
+    }
+
+  PyObject * array = PyArray_SimpleNewFromData( ImageDimension, dims, PyArrayTypeTraits< PixelType >::Type,
+                                                image->GetBufferPointer() );
+  if( !array )
+    { return NULL; }
+
+  // the array keeps a reference to the pixel container, so the buffer lives
+  // as long as the array, even if the image is deleted
+  PixelContainerType * container = image->GetPixelContainer();
+  container->Register();
+  PyObject * base = PyCapsule_New( container, NULL, &Self::ReleasePixelContainer );
+  if( !base )
+    {
+    container->UnRegister();
+    Py_DECREF( array );
+    return NULL;
+    }
+
+  // PyArray_SetBaseObject() steals the reference to the capsule, even when
+  // it fails: the capsule then releases the container itself
+  if( PyArray_SetBaseObject( reinterpret_cast< PyArrayObject * >( array ), base ) < 0 )
+    {
+    Py_DECREF( array );
+    return NULL;
+    }
+  return array;
+}
+
+
+template<class TImage>
+typename PyBuffer<TImage>::ImagePointer
+PyBuffer<TImage>
+::GetImageFromArray( PyObject * obj )
+{
+  if( !ImportNumPy() )
+    { itkGenericExceptionMacro( << "NumPy can't be imported." ); }
+  if( !obj || !PyArray_Check( obj ) )
+    { itkGenericExceptionMacro( << "The object is not a NumPy array." ); }
+
+  PyArrayObject * array = reinterpret_cast< PyArrayObject * >( obj );
+  if( PyArray_NDIM( array ) != (int)ImageDimension )
+    {
+    itkGenericExceptionMacro( << "The array has " << PyArray_NDIM( array ) << " dimensions, not "
+                              << ImageDimension << "." );
+    }
+  if( !PyArray_EquivTypenums( PyArray_TYPE( array ), PyArrayTypeTraits< PixelType >::Type ) )
+    { itkGenericExceptionMacro( << "The type of the array is not the pixel type of the image." ); }
+  // a copy would be required to use a non contiguous array
+  if( !PyArray_ISCARRAY( array ) )
+    { itkGenericExceptionMacro( << "The array must be C contiguous, aligned and writeable." ); }
+
+  SizeType size;
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    size[i] = PyArray_DIM( array, ImageDimension - 1 - i );
+    }
+  RegionType region;
+  region.SetSize( size );
+
+  // the pixel container uses the buffer of the array, without owning it, and
+  // keeps a reference to the array until it is deleted
+  typename PixelContainerType::Pointer container = PixelContainerType::New();
+  container->SetImportPointer( static_cast< PixelType * >( PyArray_DATA( array ) ),
+                               region.GetNumberOfPixels(), false );
+  PyBufferReleaseCommand::Pointer release = PyBufferReleaseCommand::New();
+  release->SetObject( obj );
+  container->AddObserver( DeleteEvent(), release );
+
+  ImagePointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetPixelContainer( container );
+  return image;
+}
+
+
+template<class TImage>
+void
+PyBuffer<TImage>
+::ReleasePixelContainer( PyObject * capsule )
+{
+  PixelContainerType * container = static_cast< PixelContainerType * >( PyCapsule_GetPointer( capsule, NULL ) );
+  container->UnRegister();
+}
+
+}// end namespace itk
+#endif
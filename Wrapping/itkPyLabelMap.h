@@ -0,0 +1,118 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPyLabelMap.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPyLabelMap_h
+#define __itkPyLabelMap_h
+
+#include "itkPyBuffer.h"
+#include "itkLabelMap.h"
+
+namespace itk
+{
+
+/** \class PyLabelMap
+ *  \brief Expose the content of a LabelMap as NumPy arrays
+ *
+ * GetLinesArray() returns the lines of a label object as a structured NumPy
+ * array, with an "index" field of ImageDimension integers and a "length"
+ * field. The array is a copy of the line container of the label object: a
+ * view would point to freed memory as soon as a line is added to the label
+ * object, as the container may then be reallocated. The copy is a single
+ * memcpy(), as the lines have the same layout in both.
+ *
+ * GetLabelsArray() returns the labels of the label map, in increasing
+ * order. That array is a copy, as the label objects are not stored
+ * contiguously in the label map, but it only has one element per object.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa PyBuffer, PyAttributeLabelMap, LabelObject
+ */
+template<class TLabelMap>
+class ITK_EXPORT PyLabelMap
+{
+public:
+  /** Standard class typedefs. */
+  typedef PyLabelMap Self;
+
+  /** Some convenient typedefs. */
+  typedef TLabelMap LabelMapType;
+  typedef typename LabelMapType::LabelObjectType  LabelObjectType;
+  typedef typename LabelObjectType::LabelType     LabelType;
+  typedef typename LabelObjectType::LineType      LineType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TLabelMap::ImageDimension);
+
+  /** Return the lines of the label object, in a new structured NumPy
+   * array */
+  static PyObject * GetLinesArray( const LabelObjectType * labelObject );
+
+  /** Return the labels of the label map, in a new NumPy array */
+  static PyObject * GetLabelsArray( const LabelMapType * labelMap );
+
+private:
+  PyLabelMap(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+} ; // end of class
+
+
+/** \class PyAttributeLabelMap
+ *  \brief Expose the attribute of the label objects as a NumPy array
+ *
+ * GetAttributesArray() returns a structured NumPy array with a "label" and
+ * an "attribute" field, with one element per label object, in the order of
+ * the labels. It must be used with a LabelMap of AttributeLabelObject. The
+ * array is a copy, as the attributes are stored in the label objects.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa PyLabelMap, AttributeLabelObject
+ */
+template<class TLabelMap>
+class ITK_EXPORT PyAttributeLabelMap : public PyLabelMap< TLabelMap >
+{
+public:
+  /** Standard class typedefs. */
+  typedef PyAttributeLabelMap Self;
+  typedef PyLabelMap< TLabelMap > Superclass;
+
+  /** Some convenient typedefs. */
+  typedef TLabelMap LabelMapType;
+  typedef typename LabelMapType::LabelObjectType    LabelObjectType;
+  typedef typename LabelObjectType::LabelType       LabelType;
+  typedef typename LabelObjectType::AttributeValueType AttributeValueType;
+
+  /** Return the labels and the attributes of the label objects, in a new
+   * structured NumPy array */
+  static PyObject * GetAttributesArray( const LabelMapType * labelMap );
+
+private:
+  PyAttributeLabelMap(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkPyLabelMap.txx"
+#endif
+
+#endif
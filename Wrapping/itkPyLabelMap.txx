@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkPyLabelMap.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkPyLabelMap_txx
+#define __itkPyLabelMap_txx
+
+#include "itkPyLabelMap.h"
+#include <cstddef>
+#include <cstring>
+
+namespace itk {
+
+template<class TLabelMap>
+PyObject *
+PyLabelMap<TLabelMap>
+::GetLinesArray( const LabelObjectType * labelObject )
+{
+  if( !labelObject )
+    { itkGenericExceptionMacro( << "The label object is NULL." ); }
+  if( !ImportNumPy() )
+    { return NULL; }
+
+  // the fields of LabelObjectLine: its index, then its length
+  PyObject * fields = Py_BuildValue( "[(sN(i)),(sN)]",
+                                     "index", PyArray_DescrFromType( PyArrayTypeTraits< typename LineType::IndexType::IndexValueType >::Type ), (int)ImageDimension,
+                                     "length", PyArray_DescrFromType( PyArrayTypeTraits< typename LineType::LengthType >::Type ) );
+  if( !fields )
+    { return NULL; }
+  PyArray_Descr * descr = NULL;
+  const int converted = PyArray_DescrConverter( fields, &descr );
+  Py_DECREF( fields );
+  if( !converted )
+    { return NULL; }
+  if( descr->elsize != sizeof( LineType ) )
+    {
+    Py_DECREF( descr );
+    itkGenericExceptionMacro( << "The layout of the lines doesn't match the NumPy type." );
+    }
+
+  const LineContainerType & lines = labelObject->GetLineContainer();
+  npy_intp dims[1];
+  dims[0] = lines.size();
+  // PyArray_NewFromDescr() steals the reference to descr. The array owns its
+  // buffer: a view on the lines would be invalidated when the container is
+  // reallocated.
+  PyObject * array = PyArray_NewFromDescr( &PyArray_Type, descr, 1, dims, NULL, NULL, 0, NULL );
+  if( !array || lines.empty() )
+    { return array; }
+
+  std::memcpy( PyArray_DATA( reinterpret_cast< PyArrayObject * >( array ) ), &lines[0],
+               lines.size() * sizeof( LineType ) );
+  return array;
+}
+
+
+template<class TLabelMap>
+PyObject *
+PyLabelMap<TLabelMap>
+::GetLabelsArray( const LabelMapType * labelMap )
+{
+  if( !labelMap )
+    { itkGenericExceptionMacro( << "The label map is NULL." ); }
+  if( !ImportNumPy() )
+    { return NULL; }
+
+  const typename LabelMapType::LabelObjectContainerType & labelObjects = labelMap->GetLabelObjectContainer();
+  npy_intp dims[1];
+  dims[0] = labelObjects.size();
+  PyObject * array = PyArray_SimpleNew( 1, dims, PyArrayTypeTraits< LabelType >::Type );
+  if( !array )
+    { return NULL; }
+
+  LabelType * labels = static_cast< LabelType * >( PyArray_DATA( reinterpret_cast< PyArrayObject * >( array ) ) );
+  for( typename LabelMapType::LabelObjectContainerType::const_iterator it=labelObjects.begin();
+       it!=labelObjects.end(); it++, labels++ )
+    {
+    *labels = it->first;
+    }
+  return array;
+}
+
+
+template<class TLabelMap>
+PyObject *
+PyAttributeLabelMap<TLabelMap>
+::GetAttributesArray( const LabelMapType * labelMap )
+{
+  if( !labelMap )
+    { itkGenericExceptionMacro( << "The label map is NULL." ); }
+  if( !ImportNumPy() )
+    { return NULL; }
+
+  // the fields are stored as in this struct
+  struct RecordType
+    {
+    LabelType label;
+    AttributeValueType attribute;
+    };
+  PyObject * fields = Py_BuildValue( "{s[ss]s[NN]s[ii]si}",
+                                     "names", "label", "attribute",
+                                     "formats", PyArray_DescrFromType( PyArrayTypeTraits< LabelType >::Type ),
+                                                PyArray_DescrFromType( PyArrayTypeTraits< AttributeValueType >::Type ),
+                                     "offsets", (int)offsetof( RecordType, label ), (int)offsetof( RecordType, attribute ),
+                                     "itemsize", (int)sizeof( RecordType ) );
+  if( !fields )
+    { return NULL; }
+  PyArray_Descr * descr = NULL;
+  const int converted = PyArray_DescrConverter( fields, &descr );
+  Py_DECREF( fields );
+  if( !converted )
+    { return NULL; }
+
+  const typename LabelMapType::LabelObjectContainerType & labelObjects = labelMap->GetLabelObjectContainer();
+  npy_intp dims[1];
+  dims[0] = labelObjects.size();
+  // PyArray_NewFromDescr() steals the reference to descr
+  PyObject * array = PyArray_NewFromDescr( &PyArray_Type, descr, 1, dims, NULL, NULL, 0, NULL );
+  if( !array )
+    { return NULL; }
+
+  RecordType * records = static_cast< RecordType * >( PyArray_DATA( reinterpret_cast< PyArrayObject * >( array ) ) );
+  for( typename LabelMapType::LabelObjectContainerType::const_iterator it=labelObjects.begin();
+       it!=labelObjects.end(); it++, records++ )
+    {
+    records->label = it->first;
+    records->attribute = it->second->GetAttribute();
+    }
+  return array;
+}
+
+}// end namespace itk
+#endif
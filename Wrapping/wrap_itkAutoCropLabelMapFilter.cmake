@@ -0,0 +1,11 @@
+WRAP_CLASS("itk::ChangeRegionLabelMapFilter" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LM${d}}" "${ITKT_LM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::AutoCropLabelMapFilter" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LM${d}}" "${ITKT_LM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
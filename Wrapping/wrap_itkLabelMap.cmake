@@ -0,0 +1,8 @@
+WRAP_INCLUDE("itkAttributeLabelObject.h")
+
+WRAP_CLASS("itk::LabelMap" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LO${d}}" "${ITKT_LO${d}}")
+    WRAP_TEMPLATE("${ITKM_ALO${d}}" "${ITKT_ALO${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
@@ -0,0 +1,34 @@
+WRAP_INCLUDE("itkLabelMap.h")
+WRAP_INCLUDE("itkAttributeLabelObject.h")
+
+WRAP_CLASS("itk::ImageSource" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LM${d}}" "${ITKT_LM${d}}")
+    WRAP_TEMPLATE("${ITKM_ALM${d}}" "${ITKT_ALM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::ImageToImageFilter" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    FOREACH(t ${WRAP_ITK_INT})
+      WRAP_TEMPLATE("${ITKM_I${t}${d}}${ITKM_LM${d}}" "${ITKT_I${t}${d}},${ITKT_LM${d}}")
+      WRAP_TEMPLATE("${ITKM_LM${d}}${ITKM_I${t}${d}}" "${ITKT_LM${d}},${ITKT_I${t}${d}}")
+    ENDFOREACH(t)
+    WRAP_TEMPLATE("${ITKM_LM${d}}${ITKM_LM${d}}" "${ITKT_LM${d}},${ITKT_LM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::LabelMapFilter" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    FOREACH(t ${WRAP_ITK_INT})
+      WRAP_TEMPLATE("${ITKM_LM${d}}${ITKM_I${t}${d}}" "${ITKT_LM${d}},${ITKT_I${t}${d}}")
+    ENDFOREACH(t)
+    WRAP_TEMPLATE("${ITKM_LM${d}}${ITKM_LM${d}}" "${ITKT_LM${d}},${ITKT_LM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::InPlaceLabelMapFilter" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LM${d}}" "${ITKT_LM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
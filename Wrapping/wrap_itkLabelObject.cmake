@@ -0,0 +1,11 @@
+WRAP_CLASS("itk::LabelObject" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_UL}${d}" "${ITKT_UL},${d}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::AttributeLabelObject" POINTER)
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_UL}${d}${ITKM_D}" "${ITKT_UL},${d},${ITKT_D}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
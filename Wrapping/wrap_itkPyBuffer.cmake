@@ -0,0 +1,22 @@
+WRAP_INCLUDE("itkAttributeLabelObject.h")
+
+WRAP_CLASS("itk::PyBuffer")
+  FOREACH(d ${WRAP_ITK_DIMS})
+    FOREACH(t ${WRAP_ITK_SCALAR})
+      WRAP_TEMPLATE("${ITKM_I${t}${d}}" "${ITKT_I${t}${d}}")
+    ENDFOREACH(t)
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::PyLabelMap")
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_LM${d}}" "${ITKT_LM${d}}")
+    WRAP_TEMPLATE("${ITKM_ALM${d}}" "${ITKT_ALM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
+
+WRAP_CLASS("itk::PyAttributeLabelMap")
+  FOREACH(d ${WRAP_ITK_DIMS})
+    WRAP_TEMPLATE("${ITKM_ALM${d}}" "${ITKT_ALM${d}}")
+  ENDFOREACH(d)
+END_WRAP_CLASS()
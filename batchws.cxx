@@ -0,0 +1,173 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkBatchedMorphologicalWatershedImageFilter.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkRegionOfInterestImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+
+const int dim = 2;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef unsigned short LType;
+typedef itk::Image< LType, dim > LIType;
+
+typedef itk::BatchedMorphologicalWatershedImageFilter< IType, LIType > BatchType;
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " nbOfTiles level nbOfThreads input output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int nbOfTiles = atoi( argv[1] );
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+  reader->Update();
+
+  // a grid of tiles, with a gap of one pixel between them
+  const IType::RegionType & largest = reader->GetOutput()->GetLargestPossibleRegion();
+  BatchType::RegionListType regions;
+  for( int j=0; j<nbOfTiles; j++ )
+    {
+    for( int i=0; i<nbOfTiles; i++ )
+      {
+      IType::IndexType idx;
+      IType::SizeType size;
+      idx[0] = largest.GetSize()[0] * i / nbOfTiles;
+      idx[1] = largest.GetSize()[1] * j / nbOfTiles;
+      size[0] = largest.GetSize()[0] * ( i + 1 ) / nbOfTiles - idx[0] - 1;
+      size[1] = largest.GetSize()[1] * ( j + 1 ) / nbOfTiles - idx[1] - 1;
+      regions.push_back( IType::RegionType( idx, size ) );
+      }
+    }
+
+  BatchType::Pointer batch = BatchType::New();
+  batch->SetInput( reader->GetOutput() );
+  batch->SetRegions( regions );
+  batch->SetLevel( atoi( argv[2] ) );
+  batch->SetNumberOfThreads( atoi( argv[3] ) );
+  itk::TimeProbe time;
+  time.Start();
+  batch->Update();
+  time.Stop();
+  std::cout << "batch: " << time.GetMeanTime() << std::endl;
+
+  bool ok = true;
+
+  // each region must be segmented as a separate image, with its label
+  // offset
+  unsigned long expectedOffset = 0;
+  for( unsigned long r=0; r<regions.size(); r++ )
+    {
+    if( batch->GetLabelOffsets()[r] != expectedOffset )
+      {
+      std::cerr << "offset of region " << r << ": " << batch->GetLabelOffsets()[r] << " instead of " << expectedOffset << std::endl;
+      ok = false;
+      }
+    expectedOffset += batch->GetNumberOfLabels()[r];
+
+    typedef itk::RegionOfInterestImageFilter< IType, IType > ROIType;
+    ROIType::Pointer roi = ROIType::New();
+    roi->SetInput( reader->GetOutput() );
+    roi->SetRegionOfInterest( regions[r] );
+
+    typedef itk::MorphologicalWatershedImageFilter< IType, LIType > WatershedType;
+    WatershedType::Pointer ws = WatershedType::New();
+    ws->SetInput( roi->GetOutput() );
+    ws->SetLevel( atoi( argv[2] ) );
+    ws->Update();
+
+    unsigned long diff = 0;
+    itk::ImageRegionConstIterator< LIType > it( batch->GetOutput(), regions[r] );
+    itk::ImageRegionConstIterator< LIType > rit( ws->GetOutput(), ws->GetOutput()->GetBufferedRegion() );
+    for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+      {
+      const LType expected = rit.Get() == 0 ? 0 : rit.Get() + batch->GetLabelOffsets()[r];
+      if( it.Get() != expected )
+        {
+        diff++;
+        }
+      }
+    if( diff )
+      {
+      std::cerr << diff << " pixels differ in region " << r << std::endl;
+      ok = false;
+      }
+    }
+
+  // the labels don't depend on the number of threads, and the workers are
+  // reused
+  LIType::Pointer labels = batch->GetOutput();
+  labels->DisconnectPipeline();
+  BatchType::Pointer batch1 = BatchType::New();
+  batch1->SetInput( reader->GetOutput() );
+  batch1->SetRegions( regions );
+  batch1->SetLevel( atoi( argv[2] ) );
+  batch1->SetNumberOfThreads( 1 );
+  batch1->Update();
+
+  // the buffers of the single worker have been sized by all the regions:
+  // segmenting the regions again, one at a time, must neither reallocate
+  // them nor release them
+  const unsigned long scratchSize = batch1->GetScratchSize();
+  if( scratchSize == 0 )
+    {
+    std::cerr << "no scratch memory kept by the worker" << std::endl;
+    ok = false;
+    }
+  for( unsigned long r=0; r<regions.size(); r++ )
+    {
+    batch1->SetRegions( BatchType::RegionListType( 1, regions[r] ) );
+    batch1->Update();
+    if( batch1->GetScratchSize() != scratchSize )
+      {
+      std::cerr << "scratch size after region " << r << ": " << batch1->GetScratchSize() << " instead of " << scratchSize << std::endl;
+      ok = false;
+      }
+    }
+
+  batch1->SetRegions( regions );
+  batch1->Update();
+  if( batch1->GetScratchSize() != scratchSize )
+    {
+    std::cerr << "scratch size after the second update: " << batch1->GetScratchSize() << " instead of " << scratchSize << std::endl;
+    ok = false;
+    }
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it( labels, labels->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > it1( batch1->GetOutput(), batch1->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), it1.GoToBegin(); !it.IsAtEnd(); ++it, ++it1 )
+    {
+    if( it.Get() != it1.Get() )
+      {
+      diff++;
+      }
+    }
+  if( diff )
+    {
+    std::cerr << diff << " pixels differ with a single thread" << std::endl;
+    ok = false;
+    }
+
+  typedef itk::ImageFileWriter< LIType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( labels );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
+
@@ -0,0 +1,203 @@
+#include "itkMappedImageFileReader.h"
+
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkLabelMapMaskImageFilter.h"
+#include "itkHierarchicalQueue.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+#include <fstream>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+
+
+const int dim = 3;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+
+typedef itk::LabelObject< unsigned long, dim > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+
+// check the size and the first and last pixels of the object drawn in a box
+bool checkObject( const LabelMapType * labelMap, const IType::RegionType & box )
+{
+  IType::IndexType last = box.GetIndex();
+  for( int d=0; d<dim; d++ )
+    {
+    last[d] += box.GetSize()[d] - 1;
+    }
+
+  const LabelMapType::LabelObjectContainerType & objects = labelMap->GetLabelObjectContainer();
+  for( LabelMapType::LabelObjectContainerType::const_iterator it = objects.begin(); it != objects.end(); it++ )
+    {
+    const LabelObjectType * object = it->second;
+    if( object->GetIndex( 0 ) == box.GetIndex() )
+      {
+      if( object->Size() != box.GetNumberOfPixels() )
+        {
+        std::cerr << "object at " << box.GetIndex() << ": " << object->Size()
+                  << " pixels instead of " << box.GetNumberOfPixels() << std::endl;
+        return false;
+        }
+      if( object->GetIndex( object->Size() - 1 ) != last )
+        {
+        std::cerr << "object at " << box.GetIndex() << ": last pixel at "
+                  << object->GetIndex( object->Size() - 1 ) << " instead of " << last << std::endl;
+        return false;
+        }
+      return true;
+      }
+    }
+  std::cerr << "no object at " << box.GetIndex() << std::endl;
+  return false;
+}
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " sizeX sizeY sizeZ rawFile nbOfThreads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  IType::SizeType size;
+  for( int d=0; d<dim; d++ )
+    {
+    size[d] = strtoul( argv[d+1], NULL, 10 );
+    }
+  IType::RegionType region;
+  region.SetSize( size );
+  std::cout << "Number of pixels: " << region.GetNumberOfPixels() << std::endl;
+
+  // a sparse file: the file system only allocates the blocks written
+  const char * fileName = argv[4];
+  {
+  std::ofstream file( fileName, std::ios::binary | std::ios::trunc );
+  file.seekp( std::streamoff( region.GetNumberOfPixels() ) - 1 );
+  file.put( 0 );
+  if( !file )
+    {
+    std::cerr << "can't create the sparse file " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // mapped copy-on-write: only the pages written below are allocated
+  typedef itk::MappedImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->SetRawSize( size );
+  reader->CopyOnWriteOn();
+  reader->Update();
+  IType::Pointer image = reader->GetOutput();
+
+  // some boxes at the beginning, in the middle and at the end of the buffer,
+  // so their offsets don't fit in 32 bits on a large image
+  std::vector< IType::RegionType > boxes;
+  IType::SizeType boxSize;
+  boxSize.Fill( 3 );
+  for( int b=0; b<3; b++ )
+    {
+    IType::IndexType idx;
+    for( int d=0; d<dim; d++ )
+      {
+      idx[d] = ( ( size[d] - boxSize[d] - 2 ) * b ) / 2 + 1;
+      }
+    IType::RegionType box( idx, boxSize );
+    boxes.push_back( box );
+    }
+  for( unsigned int b=0; b<boxes.size(); b++ )
+    {
+    std::cout << "box " << b << ": " << boxes[b].GetIndex() << " offset " << image->ComputeOffset( boxes[b].GetIndex() ) << std::endl;
+    itk::ImageRegionIterator< IType > it( image, boxes[b] );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( 255 );
+      }
+    }
+
+  bool ok = true;
+
+  // the labeling reads all the pixels
+  typedef itk::BinaryImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( image );
+  i2l->SetForegroundValue( 255 );
+  i2l->SetNumberOfThreads( atoi( argv[5] ) );
+  itk::TimeProbe time;
+  time.Start();
+  i2l->Update();
+  time.Stop();
+  std::cout << "labeling: " << time.GetMeanTime() << std::endl;
+
+  const LabelMapType * labelMap = i2l->GetOutput();
+  if( labelMap->GetNumberOfLabelObjects() != boxes.size() )
+    {
+    std::cerr << labelMap->GetNumberOfLabelObjects() << " objects instead of " << boxes.size() << std::endl;
+    ok = false;
+    }
+  for( unsigned int b=0; b<boxes.size(); b++ )
+    {
+    ok = checkObject( labelMap, boxes[b] ) && ok;
+    }
+
+  // the last object, cropped from the large image
+  const LabelObjectType * last = labelMap->GetLabelObjectContainer().rbegin()->second;
+  typedef itk::LabelMapMaskImageFilter< LabelMapType, IType > MaskType;
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetInput( labelMap );
+  mask->SetFeatureImage( image );
+  mask->SetLabel( last->GetLabel() );
+  mask->CropOn();
+  mask->SetNumberOfThreads( atoi( argv[5] ) );
+  mask->Update();
+  if( mask->GetOutput()->GetBufferedRegion() != boxes.back() )
+    {
+    std::cerr << "cropped region: " << mask->GetOutput()->GetBufferedRegion()
+              << " instead of " << boxes.back() << std::endl;
+    ok = false;
+    }
+  itk::ImageRegionConstIterator< IType > mit( mask->GetOutput(), mask->GetOutput()->GetBufferedRegion() );
+  for( mit.GoToBegin(); !mit.IsAtEnd(); ++mit )
+    {
+    if( mit.Get() != 255 )
+      {
+      std::cerr << "cropped image: a pixel is not in the object" << std::endl;
+      ok = false;
+      break;
+      }
+    }
+
+  // the queues index their vector from the lowest key
+  typedef itk::HierarchicalQueue< short, unsigned long, std::less< short > > QueueType;
+  QueueType queue;
+  queue.Push( itk::NumericTraits< short >::max(), 1 );
+  queue.Push( itk::NumericTraits< short >::NonpositiveMin(), 0 );
+  queue.Push( itk::NumericTraits< short >::max(), 2 );
+  for( unsigned long i=0; i<3; i++ )
+    {
+    if( queue.FrontValue() != i )
+      {
+      std::cerr << "queue: " << queue.FrontValue() << " instead of " << i << std::endl;
+      ok = false;
+      }
+    queue.Pop();
+    }
+
+  // release the mapping before the file
+  reader = NULL;
+  image = NULL;
+  i2l = NULL;
+  mask = NULL;
+  remove( fileName );
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
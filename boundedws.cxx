@@ -0,0 +1,121 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+template < class TImage >
+unsigned long countDifferences( const TImage * a, const TImage * b )
+{
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< TImage > ait( a, a->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage > bit( b, b->GetBufferedRegion() );
+  for( ait.GoToBegin(), bit.GoToBegin(); !ait.IsAtEnd(); ++ait, ++bit )
+    {
+    if( ait.Get() != bit.Get() )
+      {
+      diff++;
+      }
+    }
+  return diff;
+}
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 8 )
+    {
+    std::cerr << "usage: " << argv[0] << " method markLine fullyConnected level input markers output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[5] );
+
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[6] );
+
+  const PType level = atoi( argv[4] );
+
+  // flood up to the level, with a dense status
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetFloodingMethod( static_cast< FilterType::FloodingMethodType >( atoi( argv[1] ) ) );
+  filter->SetMarkWatershedLine( atoi( argv[2] ) );
+  filter->SetFullyConnected( atoi( argv[3] ) );
+  filter->SetMaximumFloodLevel( level );
+  filter->SetSparseFloodingFraction( 0 );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[7] );
+  writer->Update();
+
+  // the same with a sparse status
+  FilterType::Pointer sparse = FilterType::New();
+  sparse->SetInput( reader->GetOutput() );
+  sparse->SetMarkerImage( reader2->GetOutput() );
+  sparse->SetFloodingMethod( filter->GetFloodingMethod() );
+  sparse->SetMarkWatershedLine( filter->GetMarkWatershedLine() );
+  sparse->SetFullyConnected( filter->GetFullyConnected() );
+  sparse->SetMaximumFloodLevel( level );
+  sparse->SetSparseFloodingFraction( 1 );
+  sparse->Update();
+
+  // a mask of the pixels lower or equal to the level must give the same
+  // result
+  typedef itk::BinaryThresholdImageFilter< IType, IType > ThresholdType;
+  ThresholdType::Pointer th = ThresholdType::New();
+  th->SetInput( reader->GetOutput() );
+  th->SetUpperThreshold( level );
+  th->SetInsideValue( 1 );
+  th->SetOutsideValue( 0 );
+
+  FilterType::Pointer masked = FilterType::New();
+  masked->SetInput( reader->GetOutput() );
+  masked->SetMarkerImage( reader2->GetOutput() );
+  masked->SetMaskImage( th->GetOutput() );
+  masked->SetFloodingMethod( filter->GetFloodingMethod() );
+  masked->SetMarkWatershedLine( filter->GetMarkWatershedLine() );
+  masked->SetFullyConnected( filter->GetFullyConnected() );
+  masked->Update();
+
+  const unsigned long sparseDiff = countDifferences< IType >( filter->GetOutput(), sparse->GetOutput() );
+  const unsigned long maskDiff = countDifferences< IType >( filter->GetOutput(), masked->GetOutput() );
+  std::cout << "Number of pixels different with the sparse status: " << sparseDiff << std::endl;
+  std::cout << "Number of pixels different with the mask: " << maskDiff << std::endl;
+
+  // the pixels above the level must not be flooded
+  unsigned long flooded = 0;
+  itk::ImageRegionConstIterator< IType > iit( reader->GetOutput(), reader->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< IType > mit( reader2->GetOutput(), reader2->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< IType > oit( filter->GetOutput(), filter->GetOutput()->GetBufferedRegion() );
+  for( iit.GoToBegin(), mit.GoToBegin(), oit.GoToBegin(); !iit.IsAtEnd(); ++iit, ++mit, ++oit )
+    {
+    if( iit.Get() > level && mit.Get() == 0 && oit.Get() != 0 )
+      {
+      flooded++;
+      }
+    }
+  std::cout << "Number of pixels flooded above the level: " << flooded << std::endl;
+
+  if( sparseDiff != 0 || maskDiff != 0 || flooded != 0 )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "itkImageFileReader.h"
+
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+
+typedef unsigned char PType;
+typedef itk::Image< PType, 2 > IType;
+typedef unsigned short LType;
+typedef itk::Image< LType, 2 > LIType;
+typedef itk::MorphologicalWatershedImageFilter< IType, LIType > FilterType;
+
+// count the pixels which differ from the ones of a filter built from scratch
+unsigned long compare( FilterType * filter, IType * input )
+{
+  FilterType::Pointer ref = FilterType::New();
+  ref->SetInput( input );
+  ref->SetMarkWatershedLine( filter->GetMarkWatershedLine() );
+  ref->SetFullyConnected( filter->GetFullyConnected() );
+  ref->SetLevel( filter->GetLevel() );
+  ref->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it( filter->GetOutput(), filter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > rit( ref->GetOutput(), ref->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  return diff;
+}
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 4 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected level input" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+  reader->Update();
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkWatershedLine( true );
+  filter->SetFullyConnected( atoi( argv[1] ) );
+  filter->SetLevel( atoi( argv[2] ) );
+
+  unsigned long diff = 0;
+
+  itk::TimeProbe time;
+  time.Start();
+  filter->Update();
+  time.Stop();
+  std::cout << "markers and flooding: " << time.GetMeanTime() << std::endl;
+  diff += compare( filter, reader->GetOutput() );
+
+  // only the flooding is run again
+  filter->SetMarkWatershedLine( false );
+  itk::TimeProbe time2;
+  time2.Start();
+  filter->Update();
+  time2.Stop();
+  std::cout << "flooding only: " << time2.GetMeanTime() << std::endl;
+  diff += compare( filter, reader->GetOutput() );
+
+  // the markers must be computed again
+  filter->SetLevel( filter->GetLevel() + 1 );
+  filter->Update();
+  diff += compare( filter, reader->GetOutput() );
+
+  filter->SetFullyConnected( !filter->GetFullyConnected() );
+  filter->Update();
+  diff += compare( filter, reader->GetOutput() );
+
+  filter->ReleaseMarkers();
+  filter->Modified();
+  filter->Update();
+  diff += compare( filter, reader->GetOutput() );
+
+  std::cout << "Number of pixels different from a new filter: " << diff << std::endl;
+
+  if( diff != 0 )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
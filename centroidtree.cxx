@@ -0,0 +1,136 @@
+#include "itkImageFileReader.h"
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapCentroidTree.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " input1 input2 k radius" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::LabelObject< PType, dim > LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType > LabelMapType;
+  typedef itk::LabelMapCentroidTree< LabelMapType > TreeType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+
+  // a non isotropic spacing, to check that the distances are physical ones
+  LabelMapType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 2.5;
+
+  LabelMapType::Pointer maps[2];
+  for( int i=0; i<2; i++ )
+    {
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[i+1] );
+    I2LType::Pointer i2l = I2LType::New();
+    i2l->SetInput( reader->GetOutput() );
+    i2l->Update();
+    maps[i] = i2l->GetOutput();
+    maps[i]->DisconnectPipeline();
+    maps[i]->SetSpacing( spacing );
+    }
+
+  const unsigned int k = atoi( argv[3] );
+  const double radius = atof( argv[4] );
+
+  TreeType::Pointer tree = TreeType::New();
+  tree->Build( maps[0] );
+  tree->Print( std::cout );
+
+  TreeType::NeighborVectorContainerType nearest;
+  tree->FindNearestNeighbors( maps[1], k, nearest );
+  TreeType::NeighborVectorContainerType inRadius;
+  tree->FindNeighborsInRadius( maps[1], radius, inRadius );
+
+  // compare with all the pairs of objects
+  std::vector< TreeType::PointType > centroids;
+  std::vector< LabelObjectType * > objects;
+  for( unsigned long i=0; i<maps[0]->GetNumberOfLabelObjects(); i++ )
+    {
+    objects.push_back( maps[0]->GetNthLabelObject( i ) );
+    centroids.push_back( TreeType::ComputeCentroid( maps[0], objects.back() ) );
+    }
+
+  const double epsilon = 1e-6;
+  for( unsigned long q=0; q<maps[1]->GetNumberOfLabelObjects(); q++ )
+    {
+    TreeType::PointType point = TreeType::ComputeCentroid( maps[1], maps[1]->GetNthLabelObject( q ) );
+    std::vector< double > distances;
+    std::vector< LabelObjectType * > expected;
+    for( unsigned long i=0; i<objects.size(); i++ )
+      {
+      double distance = point.EuclideanDistanceTo( centroids[i] );
+      distances.push_back( distance );
+      if( distance <= radius )
+        {
+        expected.push_back( objects[i] );
+        }
+      }
+    std::sort( distances.begin(), distances.end() );
+
+    // the objects may be different when several have the same distance,
+    // so only the distances are compared
+    const TreeType::NeighborVectorType & neighbors = nearest[q];
+    if( neighbors.size() != std::min( (unsigned long)k, (unsigned long)distances.size() ) )
+      {
+      std::cerr << "Wrong number of nearest neighbors for object " << q << std::endl;
+      return EXIT_FAILURE;
+      }
+    for( unsigned long i=0; i<neighbors.size(); i++ )
+      {
+      if( fabs( neighbors[i].Distance - distances[i] ) > epsilon
+        || fabs( point.EuclideanDistanceTo( TreeType::ComputeCentroid( maps[0], neighbors[i].Object ) ) - distances[i] ) > epsilon )
+        {
+        std::cerr << "Wrong nearest neighbor " << i << " for object " << q << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    std::vector< LabelObjectType * > found;
+    for( unsigned long i=0; i<inRadius[q].size(); i++ )
+      {
+      found.push_back( inRadius[q][i].Object );
+      if( i > 0 && inRadius[q][i].Distance < inRadius[q][i-1].Distance )
+        {
+        std::cerr << "Neighbors not sorted for object " << q << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    std::sort( found.begin(), found.end() );
+    std::sort( expected.begin(), expected.end() );
+    if( found != expected )
+      {
+      std::cerr << "Wrong neighbors in radius for object " << q << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // each object is its own nearest neighbor in its own map
+  tree->FindNearestNeighbors( maps[0], 1, nearest );
+  for( unsigned long i=0; i<objects.size(); i++ )
+    {
+    if( nearest[i].size() != 1 || nearest[i][0].Distance > epsilon )
+      {
+      std::cerr << "Object " << i << " is not its own nearest neighbor." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return 0;
+}
+
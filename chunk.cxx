@@ -0,0 +1,197 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "itkChunkedVolumeWriter.h"
+#include "itkChunkedVolumeReader.h"
+#include "itkMultiThreader.h"
+
+
+const int dim = 2;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+
+// the volume written in parallel, and the image it comes from
+struct ParallelWriteStruct
+{
+  const char * fileName;
+  const IType * image;
+  unsigned int nbOfStripes;
+  bool ok;
+};
+
+// write a stripe of the image, which doesn't match the chunk grid, with its
+// own writer
+ITK_THREAD_RETURN_TYPE ParallelWriteCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  ParallelWriteStruct * str = static_cast< ParallelWriteStruct * >( info->UserData );
+
+  IType::RegionType region = str->image->GetLargestPossibleRegion();
+  IType::IndexType idx = region.GetIndex();
+  IType::SizeType size = region.GetSize();
+  const unsigned long begin = ( region.GetSize()[0] * info->ThreadID ) / str->nbOfStripes;
+  const unsigned long end = ( region.GetSize()[0] * ( info->ThreadID + 1 ) ) / str->nbOfStripes;
+  idx[0] += begin;
+  size[0] = end - begin;
+  IType::RegionType stripe( idx, size );
+
+  IType::Pointer part = IType::New();
+  part->SetRegions( stripe );
+  part->Allocate();
+  itk::ImageRegionConstIterator< IType > rit( str->image, stripe );
+  itk::ImageRegionIterator< IType > pit( part, stripe );
+  for( rit.GoToBegin(), pit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++pit )
+    {
+    pit.Set( rit.Get() );
+    }
+
+  typedef itk::ChunkedVolumeWriter< IType > ChunkedWriterType;
+  ChunkedWriterType::Pointer cwriter = ChunkedWriterType::New();
+  cwriter->SetFileName( str->fileName );
+  try
+    {
+    cwriter->Open();
+    cwriter->WriteRegion( part );
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cerr << e << std::endl;
+    str->ok = false;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+int main(int arglen, char * argv[])
+{
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  // write the image in a chunked volume, in two parts to exercise the merge
+  // of the partially covered chunks
+  typedef itk::ChunkedVolumeWriter< IType > ChunkedWriterType;
+  ChunkedWriterType::Pointer cwriter = ChunkedWriterType::New();
+  cwriter->SetFileName( argv[2] );
+  IType::SizeType chunkSize;
+  chunkSize.Fill( 50 );
+  chunkSize[1] = 40;
+  cwriter->SetChunkSize( chunkSize );
+  cwriter->SetUseCompression( atoi( argv[4] ) );
+  cwriter->Create( reader->GetOutput() );
+
+  IType::RegionType region = reader->GetOutput()->GetLargestPossibleRegion();
+  IType::RegionType half = region;
+  IType::SizeType halfSize = region.GetSize();
+  halfSize[0] /= 2;
+  half.SetSize( halfSize );
+  IType::Pointer part = IType::New();
+  part->SetRegions( half );
+  part->Allocate();
+  itk::ImageRegionConstIterator< IType > rit( reader->GetOutput(), half );
+  itk::ImageRegionIterator< IType > pit( part, half );
+  for( rit.GoToBegin(), pit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++pit )
+    {
+    pit.Set( rit.Get() );
+    }
+  cwriter->WriteRegion( part );
+
+  // a second writer adds the other half to the existing volume
+  ChunkedWriterType::Pointer cwriter2 = ChunkedWriterType::New();
+  cwriter2->SetFileName( argv[2] );
+  cwriter2->Open();
+  IType::IndexType idx = region.GetIndex();
+  idx[0] += halfSize[0];
+  halfSize[0] = region.GetSize()[0] - halfSize[0];
+  half.SetIndex( idx );
+  half.SetSize( halfSize );
+  part = IType::New();
+  part->SetRegions( half );
+  part->Allocate();
+  itk::ImageRegionConstIterator< IType > rit2( reader->GetOutput(), half );
+  itk::ImageRegionIterator< IType > pit2( part, half );
+  for( rit2.GoToBegin(), pit2.GoToBegin(); !rit2.IsAtEnd(); ++rit2, ++pit2 )
+    {
+    pit2.Set( rit2.Get() );
+    }
+  cwriter2->WriteRegion( part );
+
+  // read it back through the pipeline
+  typedef itk::ChunkedVolumeReader< IType > ChunkedReaderType;
+  ChunkedReaderType::Pointer creader = ChunkedReaderType::New();
+  creader->SetFileName( argv[2] );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( creader->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  // and read a region which doesn't match the chunk grid
+  IType::RegionType sub = region;
+  IType::IndexType subIdx = region.GetIndex();
+  IType::SizeType subSize = region.GetSize();
+  subIdx[0] += 33;
+  subIdx[1] += 17;
+  subSize[0] = 71;
+  subSize[1] = 59;
+  sub.SetIndex( subIdx );
+  sub.SetSize( subSize );
+  IType::Pointer subImage = creader->ReadRegion( sub );
+  itk::ImageRegionConstIterator< IType > sit( subImage, sub );
+  itk::ImageRegionConstIterator< IType > oit( reader->GetOutput(), sub );
+  for( sit.GoToBegin(), oit.GoToBegin(); !sit.IsAtEnd(); ++sit, ++oit )
+    {
+    if( sit.Get() != oit.Get() )
+      {
+      std::cerr << "ReadRegion() differs from the original image at " << sit.GetIndex() << std::endl;
+      return 1;
+      }
+    }
+
+  // several writers, in parallel, whose regions share some chunks: none of
+  // them must lose the updates of the others
+  std::string parallelName = std::string( argv[2] ) + "-parallel";
+  ChunkedWriterType::Pointer pwriter = ChunkedWriterType::New();
+  pwriter->SetFileName( parallelName.c_str() );
+  pwriter->SetChunkSize( chunkSize );
+  pwriter->SetUseCompression( atoi( argv[4] ) );
+  pwriter->Create( reader->GetOutput() );
+
+  ParallelWriteStruct str;
+  str.fileName = parallelName.c_str();
+  str.image = reader->GetOutput();
+  str.nbOfStripes = 8;
+  str.ok = true;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( str.nbOfStripes );
+  // the stripes are computed from the thread ids
+  str.nbOfStripes = threader->GetNumberOfThreads();
+  threader->SetSingleMethod( ParallelWriteCallback, &str );
+  threader->SingleMethodExecute();
+  if( !str.ok )
+    {
+    return 1;
+    }
+
+  ChunkedReaderType::Pointer preader = ChunkedReaderType::New();
+  preader->SetFileName( parallelName.c_str() );
+  preader->Update();
+  itk::ImageRegionConstIterator< IType > ppit( preader->GetOutput(), region );
+  itk::ImageRegionConstIterator< IType > poit( reader->GetOutput(), region );
+  for( ppit.GoToBegin(), poit.GoToBegin(); !ppit.IsAtEnd(); ++ppit, ++poit )
+    {
+    if( ppit.Get() != poit.Get() )
+      {
+      std::cerr << "the parallel writers have lost an update at " << ppit.GetIndex() << std::endl;
+      return 1;
+      }
+    }
+
+  return 0;
+}
+
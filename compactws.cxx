@@ -0,0 +1,66 @@
+#include "itkImageFileReader.h"
+
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " markLine fullyConnected watershedLabel input" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  // a large label type, to use the compact labels
+  typedef unsigned long LType;
+  typedef itk::Image< LType, dim > LIType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+
+  typedef itk::MorphologicalWatershedImageFilter< IType, LIType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkWatershedLine( atoi( argv[1] ) );
+  filter->SetFullyConnected( atoi( argv[2] ) );
+  filter->SetWatershedLabel( atoi( argv[3] ) );
+  filter->SetUseCompactLabels( true );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  filter->Update();
+
+  // the labels must be the same as the ones computed with the output type
+  FilterType::Pointer ref = FilterType::New();
+  ref->SetInput( reader->GetOutput() );
+  ref->SetMarkWatershedLine( atoi( argv[1] ) );
+  ref->SetFullyConnected( atoi( argv[2] ) );
+  ref->SetWatershedLabel( atoi( argv[3] ) );
+  ref->SetUseCompactLabels( false );
+  ref->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it( filter->GetOutput(), filter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > rit( ref->GetOutput(), ref->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  std::cout << "Number of pixels different from the output label type: " << diff << std::endl;
+
+  if( diff != 0 )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkCommand.h"
+
+#include "itkDecomposedWatershedFromMarkersImageFilter.h"
+#include "itkSimpleFilterWatcher.h"
+#include <algorithm>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " markLine fullyConnected input markers output [nbOfProcesses [haloSize]]" << std::endl;
+    return 1;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[4] );
+
+  typedef itk::DecomposedWatershedFromMarkersImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetMarkWatershedLine( atoi( argv[1] ) );
+  filter->SetFullyConnected( atoi( argv[2] ) );
+  if( arglen > 6 )
+    {
+    filter->SetNumberOfProcesses( atoi( argv[6] ) );
+    }
+  if( arglen > 7 )
+    {
+    filter->SetHaloSize( atoi( argv[7] ) );
+    }
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  std::cout << "rounds: " << filter->GetNumberOfRounds() << std::endl;
+  const std::vector< unsigned long > & halos = filter->GetHaloSizes();
+  std::cout << "largest halo: " << *std::max_element( halos.begin(), halos.end() ) << std::endl;
+
+  return 0;
+}
+
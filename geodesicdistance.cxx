@@ -0,0 +1,264 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkGeodesicChamferDistanceImageFilter.h"
+#include "itkGeodesicChamferDistanceLabelMapFilter.h"
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkDanielssonDistanceMapImageFilter.h"
+#include "itkRescaleIntensityImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+#include "itkTimeProbe.h"
+#include <cmath>
+
+
+const int dim = 2;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef float DType;
+typedef itk::Image< DType, dim > DIType;
+
+typedef itk::LabelObject< unsigned long, dim > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " radius nbOfThreads input output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int radius = atoi( argv[1] );
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+  reader->Update();
+
+  // the distance to the border of the mask
+  typedef itk::GeodesicChamferDistanceImageFilter< IType, DIType > DistanceType;
+  DistanceType::Pointer distance = DistanceType::New();
+  distance->SetInput( reader->GetOutput() );
+  distance->SetForegroundValue( 255 );
+  distance->SetNeighborhoodRadius( radius );
+  itk::TimeProbe time;
+  time.Start();
+  distance->Update();
+  time.Stop();
+  std::cout << "image: " << time.GetMeanTime() << " " << distance->GetNumberOfIterations() << " iterations" << std::endl;
+
+  // the euclidean distance to the background
+  typedef itk::BinaryThresholdImageFilter< IType, IType > ThresholdType;
+  ThresholdType::Pointer th = ThresholdType::New();
+  th->SetInput( reader->GetOutput() );
+  th->SetLowerThreshold( 255 );
+  th->SetUpperThreshold( 255 );
+  th->SetInsideValue( 0 );
+  th->SetOutsideValue( 1 );
+
+  typedef itk::DanielssonDistanceMapImageFilter< IType, DIType > DanielssonType;
+  DanielssonType::Pointer danielsson = DanielssonType::New();
+  danielsson->SetInput( th->GetOutput() );
+  danielsson->SetUseImageSpacing( true );
+  danielsson->Update();
+
+  bool ok = true;
+
+  // a chamfer path is never shorter than the straight line, and the chamfer
+  // mask approximates the euclidean length within a few percents
+  const double maxError = radius == 1 ? 1.09 : 1.03;
+  unsigned long nbOfErrors = 0;
+  itk::ImageRegionConstIterator< DIType > it( distance->GetOutput(), distance->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< DIType > eit( danielsson->GetOutput(), danielsson->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+    {
+    if( it.Get() < eit.Get() - 1e-3 || it.Get() > eit.Get() * maxError + 1 )
+      {
+      nbOfErrors++;
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels too far from the euclidean distance" << std::endl;
+    ok = false;
+    }
+
+  // the objects processed separately have the same distance: they don't
+  // touch each other
+  typedef itk::BinaryImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( reader->GetOutput() );
+  i2l->SetForegroundValue( 255 );
+  i2l->SetFullyConnected( true );
+
+  typedef itk::GeodesicChamferDistanceLabelMapFilter< LabelMapType, DIType > LabelMapDistanceType;
+  LabelMapDistanceType::Pointer ldistance = LabelMapDistanceType::New();
+  ldistance->SetInput( i2l->GetOutput() );
+  ldistance->SetNeighborhoodRadius( radius );
+  ldistance->SetNumberOfThreads( atoi( argv[2] ) );
+  i2l->Update();
+  time.Start();
+  ldistance->Update();
+  time.Stop();
+  std::cout << "label map: " << time.GetMeanTime() << std::endl;
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< DIType > lit( ldistance->GetOutput(), ldistance->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), lit.GoToBegin(); !it.IsAtEnd(); ++it, ++lit )
+    {
+    if( std::fabs( it.Get() - lit.Get() ) > 1e-3 )
+      {
+      diff++;
+      }
+    }
+  if( diff )
+    {
+    std::cerr << diff << " pixels differ between the image and the label map" << std::endl;
+    ok = false;
+    }
+
+  // the distance from the deepest pixel, which can't go out of the mask
+  itk::ImageRegionIteratorWithIndex< DIType > mit( distance->GetOutput(), distance->GetOutput()->GetBufferedRegion() );
+  DIType::IndexType seed;
+  DType deepest = 0;
+  for( mit.GoToBegin(); !mit.IsAtEnd(); ++mit )
+    {
+    if( mit.Get() > deepest )
+      {
+      deepest = mit.Get();
+      seed = mit.GetIndex();
+      }
+    }
+  IType::Pointer marker = IType::New();
+  marker->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  marker->CopyInformation( reader->GetOutput() );
+  marker->Allocate();
+  marker->FillBuffer( 0 );
+  marker->SetPixel( seed, 1 );
+
+  DistanceType::Pointer gdistance = DistanceType::New();
+  gdistance->SetInput( reader->GetOutput() );
+  gdistance->SetMarkerImage( marker );
+  gdistance->SetForegroundValue( 255 );
+  gdistance->SetNeighborhoodRadius( radius );
+  gdistance->Update();
+  std::cout << "marker: " << gdistance->GetNumberOfIterations() << " iterations" << std::endl;
+
+  if( gdistance->GetOutput()->GetPixel( seed ) != 0 )
+    {
+    std::cerr << "the seed is at " << gdistance->GetOutput()->GetPixel( seed ) << std::endl;
+    ok = false;
+    }
+  if( gdistance->GetNumberOfIterations() < 1 )
+    {
+    std::cerr << "no iteration" << std::endl;
+    ok = false;
+    }
+  nbOfErrors = 0;
+  itk::ImageRegionIteratorWithIndex< DIType > git( gdistance->GetOutput(), gdistance->GetOutput()->GetBufferedRegion() );
+  for( git.GoToBegin(); !git.IsAtEnd(); ++git )
+    {
+    double d = 0;
+    for( int i=0; i<dim; i++ )
+      {
+      const double step = ( git.GetIndex()[i] - seed[i] ) * reader->GetOutput()->GetSpacing()[i];
+      d += step * step;
+      }
+    if( reader->GetOutput()->GetPixel( git.GetIndex() ) == 255 && git.Get() < std::sqrt( d ) - 1e-3 )
+      {
+      nbOfErrors++;
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels shorter than the euclidean distance from the seed" << std::endl;
+    ok = false;
+    }
+
+  // a single pair of scans is not enough to reach the whole object
+  DistanceType::Pointer sdistance = DistanceType::New();
+  sdistance->SetInput( reader->GetOutput() );
+  sdistance->SetMarkerImage( marker );
+  sdistance->SetForegroundValue( 255 );
+  sdistance->SetNeighborhoodRadius( radius );
+  sdistance->SetMaximumNumberOfIterations( 1 );
+  sdistance->Update();
+  if( sdistance->GetNumberOfIterations() != 1 )
+    {
+    std::cerr << sdistance->GetNumberOfIterations() << " iterations instead of 1" << std::endl;
+    ok = false;
+    }
+
+  // a wall one pixel thick, open at the bottom only: the path from one side
+  // to the other must go around it, even with the long steps of the 5x5
+  // mask
+  IType::Pointer wall = IType::New();
+  IType::RegionType wallRegion;
+  wallRegion.SetSize( 0, 7 );
+  wallRegion.SetSize( 1, 7 );
+  wall->SetRegions( wallRegion );
+  wall->Allocate();
+  wall->FillBuffer( 255 );
+  IType::IndexType idx;
+  idx[0] = 3;
+  for( idx[1]=0; idx[1]<5; idx[1]++ )
+    {
+    wall->SetPixel( idx, 0 );
+    }
+  IType::Pointer wallMarker = IType::New();
+  wallMarker->SetRegions( wallRegion );
+  wallMarker->Allocate();
+  wallMarker->FillBuffer( 0 );
+  idx[0] = 2;
+  idx[1] = 0;
+  wallMarker->SetPixel( idx, 1 );
+
+  DistanceType::Pointer wdistance = DistanceType::New();
+  wdistance->SetInput( wall );
+  wdistance->SetMarkerImage( wallMarker );
+  wdistance->SetForegroundValue( 255 );
+  wdistance->SetNeighborhoodRadius( radius );
+  wdistance->Update();
+
+  // the shortest path from (2,0) to (4,0) goes through (3,5) or (3,6), and
+  // is at least 2 * sqrt( 1 + 5 * 5 ) long
+  idx[0] = 4;
+  const double around = 2 * std::sqrt( 26.0 );
+  if( wdistance->GetOutput()->GetPixel( idx ) < around - 1e-3 )
+    {
+    std::cerr << "the path goes through the wall: " << wdistance->GetOutput()->GetPixel( idx )
+              << " instead of at least " << around << std::endl;
+    ok = false;
+    }
+  // and on the same side of the wall, the pixels are reached straight
+  idx[0] = 0;
+  idx[1] = 0;
+  if( std::fabs( wdistance->GetOutput()->GetPixel( idx ) - 2 ) > 1e-3 )
+    {
+    std::cerr << "the distance next to the seed is " << wdistance->GetOutput()->GetPixel( idx )
+              << " instead of 2" << std::endl;
+    ok = false;
+    }
+
+  typedef itk::RescaleIntensityImageFilter< DIType, IType > RescaleType;
+  RescaleType::Pointer rescale = RescaleType::New();
+  rescale->SetInput( ldistance->GetOutput() );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( rescale->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
+
@@ -0,0 +1,176 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelGrowingLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkSimpleFilterWatcher.h"
+#include <queue>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 7 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected maxDistance threshold input markers output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::LabelObject< PType, dim > LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[5] );
+
+  // the mask
+  typedef itk::BinaryThresholdImageFilter< IType, IType > ThresholdType;
+  ThresholdType::Pointer th = ThresholdType::New();
+  th->SetInput( reader->GetOutput() );
+  th->SetLowerThreshold( atoi( argv[3] ) );
+
+  typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( reader2->GetOutput() );
+
+  const double maxDistance = atof( argv[2] );
+
+  typedef itk::LabelGrowingLabelMapFilter< LabelMapType, IType > GrowType;
+  GrowType::Pointer grow = GrowType::New();
+  grow->SetInput( i2l->GetOutput() );
+  grow->SetMaskImage( th->GetOutput() );
+  grow->SetFullyConnected( atoi( argv[1] ) );
+  grow->SetMaximumDistance( maxDistance );
+  grow->SetInPlace( false );
+  itk::SimpleFilterWatcher watcher(grow, "grow");
+
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, IType > L2IType;
+  L2IType::Pointer l2i = L2IType::New();
+  l2i->SetInput( grow->GetOutput() );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( l2i->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  const IType * markers = reader2->GetOutput();
+  const IType * mask = th->GetOutput();
+  const IType * output = l2i->GetOutput();
+  const IType::RegionType & region = markers->GetLargestPossibleRegion();
+  const GrowType::ConnectivityType::OffsetContainerType & neighbors = grow->GetConnectivity()->GetNeighbors();
+  const PType bg = i2l->GetBackgroundValue();
+
+  // the number of steps to the nearest seed, computed on the whole image
+  typedef itk::Image< long, dim > DistanceImageType;
+  DistanceImageType::Pointer distance = DistanceImageType::New();
+  distance->SetRegions( region );
+  distance->Allocate();
+  distance->FillBuffer( -1 );
+  std::queue< IType::IndexType > queue;
+  itk::ImageRegionConstIteratorWithIndex< IType > it( markers, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != bg )
+      {
+      distance->SetPixel( it.GetIndex(), 0 );
+      queue.push( it.GetIndex() );
+      }
+    }
+  while( !queue.empty() )
+    {
+    IType::IndexType idx = queue.front();
+    queue.pop();
+    for( unsigned int i=0; i<neighbors.size(); i++ )
+      {
+      IType::IndexType n = idx + neighbors[i];
+      if( region.IsInside( n ) && distance->GetPixel( n ) < 0 && mask->GetPixel( n ) != 0 )
+        {
+        distance->SetPixel( n, distance->GetPixel( idx ) + 1 );
+        queue.push( n );
+        }
+      }
+    }
+
+  // the seeds are unchanged, the grown pixels are the ones close enough to
+  // a seed, and each one has been reached from a neighbor of the same object
+  unsigned long diff = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const IType::IndexType & idx = it.GetIndex();
+    PType v = output->GetPixel( idx );
+    long d = distance->GetPixel( idx );
+    if( it.Get() != bg )
+      {
+      if( v != it.Get() )
+        {
+        diff++;
+        }
+      continue;
+      }
+    bool expected = d >= 0 && d <= maxDistance;
+    if( expected != ( v != bg ) )
+      {
+      diff++;
+      continue;
+      }
+    if( v != bg )
+      {
+      bool reached = false;
+      for( unsigned int i=0; i<neighbors.size() && !reached; i++ )
+        {
+        IType::IndexType n = idx + neighbors[i];
+        reached = region.IsInside( n ) && output->GetPixel( n ) == v && distance->GetPixel( n ) == d - 1;
+        }
+      if( !reached )
+        {
+        diff++;
+        }
+      }
+    }
+
+  if( diff != 0 )
+    {
+    std::cerr << diff << " pixels are not correctly grown." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // with a unit spacing and the face connectivity, the steps have all the
+  // same length, so the propagation with the spacing must give the same
+  // result
+  if( !grow->GetFullyConnected() )
+    {
+    IType::Pointer result = l2i->GetOutput();
+    result->DisconnectPipeline();
+    grow->SetUseImageSpacing( true );
+    l2i->Update();
+    itk::ImageRegionConstIterator< IType > rit( result, region );
+    itk::ImageRegionConstIterator< IType > sit( l2i->GetOutput(), region );
+    for( rit.GoToBegin(), sit.GoToBegin(); !rit.IsAtEnd(); ++rit, ++sit )
+      {
+      if( rit.Get() != sit.Get() )
+        {
+        diff++;
+        }
+      }
+    if( diff != 0 )
+      {
+      std::cerr << diff << " pixels differ when the spacing is used." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return 0;
+}
+
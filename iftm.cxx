@@ -0,0 +1,209 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <queue>
+#include <vector>
+#include <set>
+#include <functional>
+#include <cmath>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 7 )
+    {
+    std::cerr << "usage: " << argv[0] << " propagation markLine fullyConnected input markers output" << std::endl;
+    std::cerr << "  propagation: 0 watershed, 1 geodesic voronoi, 2 seeded region growing" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[5] );
+
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetPropagation( static_cast< FilterType::PropagationType >( atoi( argv[1] ) ) );
+  filter->SetMarkWatershedLine( atoi( argv[2] ) );
+  filter->SetFullyConnected( atoi( argv[3] ) );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  const IType * input = reader->GetOutput();
+  const IType * markers = reader2->GetOutput();
+  const IType * output = filter->GetOutput();
+  const IType::RegionType region = output->GetBufferedRegion();
+  const bool markLine = atoi( argv[2] );
+
+  // the neighbors, and the length of the steps
+  std::vector< IType::OffsetType > offsets;
+  std::vector< double > weights;
+  for( int y=-1; y<=1; y++ )
+    {
+    for( int x=-1; x<=1; x++ )
+      {
+      if( ( x != 0 || y != 0 ) && ( atoi( argv[3] ) || x == 0 || y == 0 ) )
+        {
+        IType::OffsetType o;
+        o[0] = x;
+        o[1] = y;
+        offsets.push_back( o );
+        weights.push_back( std::sqrt( std::pow( x * input->GetSpacing()[0], 2 ) + std::pow( y * input->GetSpacing()[1], 2 ) ) );
+        }
+      }
+    }
+
+  bool ok = true;
+
+  // the markers keep their label, each region is connected to a marker with
+  // its label, and the pixels without label are on a watershed line between
+  // two regions
+  IType::Pointer reached = IType::New();
+  reached->SetRegions( region );
+  reached->Allocate();
+  reached->FillBuffer( 0 );
+  std::queue< IType::IndexType > fifo;
+  unsigned long nbOfErrors = 0;
+  itk::ImageRegionConstIteratorWithIndex< IType > it( output, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const PType marker = markers->GetPixel( it.GetIndex() );
+    if( marker != 0 )
+      {
+      if( it.Get() != marker )
+        { nbOfErrors++; }
+      else
+        {
+        reached->SetPixel( it.GetIndex(), 1 );
+        fifo.push( it.GetIndex() );
+        }
+      }
+    }
+  while( !fifo.empty() )
+    {
+    const IType::IndexType idx = fifo.front();
+    fifo.pop();
+    for( unsigned int i=0; i<offsets.size(); i++ )
+      {
+      const IType::IndexType n = idx + offsets[i];
+      if( region.IsInside( n ) && !reached->GetPixel( n ) && output->GetPixel( n ) == output->GetPixel( idx ) )
+        {
+        reached->SetPixel( n, 1 );
+        fifo.push( n );
+        }
+      }
+    }
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != 0 && !reached->GetPixel( it.GetIndex() ) )
+      { nbOfErrors++; }
+    if( it.Get() == 0 )
+      {
+      std::set< PType > neighborLabels;
+      for( unsigned int i=0; i<offsets.size(); i++ )
+        {
+        const IType::IndexType n = it.GetIndex() + offsets[i];
+        if( region.IsInside( n ) && output->GetPixel( n ) != 0 )
+          { neighborLabels.insert( output->GetPixel( n ) ); }
+        }
+      if( !markLine || neighborLabels.size() < 2 )
+        { nbOfErrors++; }
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels with a label not connected to its marker, or with no label" << std::endl;
+    ok = false;
+    }
+
+  if( atoi( argv[1] ) == FilterType::GEODESIC_VORONOI )
+    {
+    // the reference: the cost of the cheapest path from the markers, with
+    // the Dijkstra algorithm. The cost to enter a pixel is its value
+    // weighted by the length of the step.
+    const unsigned long nbOfPixels = region.GetNumberOfPixels();
+    std::vector< double > cost( nbOfPixels, itk::NumericTraits< double >::max() );
+    typedef std::pair< double, unsigned long > ItemType;
+    std::priority_queue< ItemType, std::vector< ItemType >, std::greater< ItemType > > queue;
+    for( unsigned long p=0; p<nbOfPixels; p++ )
+      {
+      if( markers->GetBufferPointer()[p] != 0 )
+        {
+        cost[p] = 0;
+        queue.push( ItemType( 0, p ) );
+        }
+      }
+    while( !queue.empty() )
+      {
+      const ItemType item = queue.top();
+      queue.pop();
+      if( item.first > cost[item.second] )
+        { continue; }
+      const IType::IndexType idx = output->ComputeIndex( item.second );
+      for( unsigned int i=0; i<offsets.size(); i++ )
+        {
+        const IType::IndexType n = idx + offsets[i];
+        if( !region.IsInside( n ) )
+          { continue; }
+        const unsigned long q = output->ComputeOffset( n );
+        const double c = item.first + weights[i] * input->GetPixel( n );
+        if( c < cost[q] )
+          {
+          cost[q] = c;
+          queue.push( ItemType( c, q ) );
+          }
+        }
+      }
+
+    // each pixel has the label of a neighbor on one of its cheapest paths
+    nbOfErrors = 0;
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const unsigned long p = output->ComputeOffset( it.GetIndex() );
+      if( markers->GetBufferPointer()[p] != 0 )
+        { continue; }
+      bool found = false;
+      for( unsigned int i=0; i<offsets.size() && !found; i++ )
+        {
+        const IType::IndexType n = it.GetIndex() + offsets[i];
+        if( region.IsInside( n ) && output->GetPixel( n ) == it.Get() )
+          {
+          const double c = cost[ output->ComputeOffset( n ) ] + weights[i] * input->GetPixel( it.GetIndex() );
+          found = std::fabs( c - cost[p] ) <= 1e-6 * std::max( 1.0, cost[p] );
+          }
+        }
+      if( !found )
+        { nbOfErrors++; }
+      }
+    if( nbOfErrors )
+      {
+      std::cerr << nbOfErrors << " pixels not labeled by one of their cheapest paths" << std::endl;
+      ok = false;
+      }
+    }
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
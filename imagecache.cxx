@@ -0,0 +1,201 @@
+#include "itkImageFileReader.h"
+
+#include "itkImageCache.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkHMinimaImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkBinaryWatershedImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+
+typedef unsigned char PType;
+typedef itk::Image< PType, 2 > IType;
+typedef unsigned short LType;
+typedef itk::Image< LType, 2 > LIType;
+typedef float DType;
+typedef itk::Image< DType, 2 > DIType;
+
+// count the pixels which differ in two images
+template < class TImage >
+unsigned long compare( const TImage * image1, const TImage * image2 )
+{
+  if( image1->GetBufferedRegion() != image2->GetBufferedRegion() )
+    {
+    return image1->GetBufferedRegion().GetNumberOfPixels();
+    }
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< TImage > it( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage > rit( image2, image2->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  return diff;
+}
+
+typedef itk::MorphologicalWatershedImageFilter< IType, LIType > WatershedType;
+typedef itk::HMinimaImageFilter< IType, IType > HMinimaType;
+typedef itk::SignedMaurerDistanceMapImageFilter< IType, DIType > MaurerType;
+typedef itk::BinaryWatershedImageFilter< IType, LIType > BinaryWatershedType;
+
+// copy the parameters of a filter to a new one of the same type
+void configure( WatershedType * filter, WatershedType * ref )
+{
+  filter->SetFullyConnected( ref->GetFullyConnected() );
+  filter->SetMarkWatershedLine( ref->GetMarkWatershedLine() );
+  filter->SetLevel( ref->GetLevel() );
+  filter->SetWatershedLabel( ref->GetWatershedLabel() );
+  filter->SetFloodingMethod( ref->GetFloodingMethod() );
+  filter->SetUseRankTransform( ref->GetUseRankTransform() );
+  filter->SetUseCompactLabels( ref->GetUseCompactLabels() );
+}
+
+void configure( HMinimaType * filter, HMinimaType * ref )
+{
+  filter->SetHeight( ref->GetHeight() );
+  filter->SetFullyConnected( ref->GetFullyConnected() );
+}
+
+void configure( MaurerType * filter, MaurerType * ref )
+{
+  filter->SetSquaredDistance( ref->GetSquaredDistance() );
+  filter->SetInsideIsPositive( ref->GetInsideIsPositive() );
+  filter->SetUseImageSpacing( ref->GetUseImageSpacing() );
+  filter->SetBackgroundValue( ref->GetBackgroundValue() );
+}
+
+void configure( BinaryWatershedType * filter, BinaryWatershedType * ref )
+{
+  filter->SetFullyConnected( ref->GetFullyConnected() );
+  filter->SetBinaryOutput( ref->GetBinaryOutput() );
+  filter->SetLevel( ref->GetLevel() );
+  filter->SetUseImageSpacing( ref->GetUseImageSpacing() );
+  filter->SetBackgroundValue( ref->GetBackgroundValue() );
+  filter->SetForegroundValue( ref->GetForegroundValue() );
+}
+
+// run a new filter, configured like ref, with the cache, and count the
+// differences with ref, which runs without cache
+template < class TFilter >
+unsigned long run( TFilter * ref, itk::ImageCache * cache, const char * name )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  configure( filter.GetPointer(), ref );
+  filter->SetInput( ref->GetInput() );
+  filter->SetCache( cache );
+
+  itk::TimeProbe time;
+  time.Start();
+  filter->Update();
+  time.Stop();
+  std::cout << name << ": " << time.GetMeanTime() << std::endl;
+
+  ref->Update();
+  return compare( filteref->GetOutput(), ref->GetOutput() );
+}
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected level input cacheDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+  reader->Update();
+
+  typedef itk::BinaryThresholdImageFilter< IType, IType > ThresholdType;
+  ThresholdType::Pointer threshold = ThresholdType::New();
+  threshold->SetInput( readeref->GetOutput() );
+  threshold->SetLowerThreshold( 100 );
+  threshold->SetInsideValue( 255 );
+  threshold->SetOutsideValue( 0 );
+  threshold->Update();
+
+  itk::ImageCache::Pointer cache = itk::ImageCache::New();
+  cache->SetDirectory( argv[4] );
+  // start from an empty cache
+  cache->Clear();
+
+  unsigned long diff = 0;
+  bool ok = true;
+
+  // the watershed stores its markers, and the next filter loads them
+  WatershedType::Pointer wshed = WatershedType::New();
+  wshed->SetInput( readeref->GetOutput() );
+  wshed->SetFullyConnected( atoi( argv[1] ) );
+  wshed->SetLevel( atoi( argv[2] ) );
+  diff += run< WatershedType >( wshed, cache, "watershed, markers computed" );
+  diff += run< WatershedType >( wshed, cache, "watershed, markers loaded" );
+  if( cache->GetNumberOfStores() != 1 || cache->GetNumberOfHits() != 1 )
+    {
+    std::cerr << "watershed: " << cache->GetNumberOfStores() << " stores and "
+              << cache->GetNumberOfHits() << " hits, instead of 1 and 1" << std::endl;
+    ok = false;
+    }
+
+  // another level gives other markers
+  wshed->SetLevel( wshed->GetLevel() + 1 );
+  diff += run< WatershedType >( wshed, cache, "watershed, other level" );
+  if( cache->GetNumberOfStores() != 2 || cache->GetNumberOfHits() != 1 )
+    {
+    std::cerr << "watershed: the markers of another level have been loaded" << std::endl;
+    ok = false;
+    }
+
+  // the other filters store their output
+  HMinimaType::Pointer hmin = HMinimaType::New();
+  hmin->SetInput( readeref->GetOutput() );
+  hmin->SetHeight( atoi( argv[2] ) + 2 );
+  hmin->SetFullyConnected( atoi( argv[1] ) );
+  diff += run< HMinimaType >( hmin, cache, "h-minima, computed" );
+  diff += run< HMinimaType >( hmin, cache, "h-minima, loaded" );
+
+  MaurerType::Pointer maurer = MaurerType::New();
+  maurer->SetInput( threshold->GetOutput() );
+  maurer->SetSquaredDistance( false );
+  diff += run< MaurerType >( maurer, cache, "distance map, computed" );
+  diff += run< MaurerType >( maurer, cache, "distance map, loaded" );
+
+  BinaryWatershedType::Pointer bws = BinaryWatershedType::New();
+  bws->SetInput( threshold->GetOutput() );
+  bws->SetFullyConnected( atoi( argv[1] ) );
+  bws->SetForegroundValue( 255 );
+  bws->SetLevel( 1 );
+  diff += run< BinaryWatershedType >( bws, cache, "binary watershed, computed" );
+  diff += run< BinaryWatershedType >( bws, cache, "binary watershed, loaded" );
+
+  if( cache->GetNumberOfStores() != 5 || cache->GetNumberOfHits() != 4 )
+    {
+    std::cerr << cache->GetNumberOfStores() << " stores and " << cache->GetNumberOfHits()
+              << " hits, instead of 5 and 4" << std::endl;
+    ok = false;
+    }
+
+  // a cache too small keeps nothing
+  cache->SetMaximumSize( 1 );
+  cache->Evict();
+  diff += run< HMinimaType >( hmin, cache, "h-minima, after eviction" );
+  if( cache->GetNumberOfHits() != 4 )
+    {
+    std::cerr << "h-minima: an entry has been loaded after eviction" << std::endl;
+    ok = false;
+    }
+  cache->Clear();
+
+  std::cout << "Number of pixels different from a filter without cache: " << diff << std::endl;
+
+  if( diff != 0 || !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "itkImageFileReader.h"
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+const int dim = 2;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef unsigned short LType;
+typedef itk::Image< LType, dim > LIType;
+
+typedef itk::MorphologicalWatershedFromMarkersImageFilter< IType, LIType > FilterType;
+
+// count the pixels which differ in two images
+unsigned long compare( const LIType * image1, const LIType * image2 )
+{
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > rit( image2, image2->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  return diff;
+}
+
+// run the filter in place and with a copy of the markers, and count the
+// differences
+unsigned long run( FilterType * filter, itk::ImageSource< LIType > * markers, const char * name )
+{
+  filter->SetInPlace( false );
+  filter->Update();
+  LIType::Pointer ref = filter->GetOutput();
+  ref->DisconnectPipeline();
+
+  // the markers are read again, and overwritten
+  filter->SetInPlace( true );
+  markers->Update();
+  const LType * markerBuffer = markers->GetOutput()->GetBufferPointer();
+  filter->Update();
+  if( filter->GetOutput()->GetBufferPointer() != markerBuffer )
+    {
+    std::cerr << name << ": the output doesn't use the buffer of the markers" << std::endl;
+    return ref->GetBufferedRegion().GetNumberOfPixels();
+    }
+
+  unsigned long diff = compare( filter->GetOutput(), ref );
+  std::cout << name << ": " << diff << " pixels differ" << std::endl;
+  return diff;
+}
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " markWatershedLine fullyConnected input markers" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  typedef itk::ImageFileReader< LIType > MarkerReaderType;
+  MarkerReaderType::Pointer reader2 = MarkerReaderType::New();
+  reader2->SetFileName( argv[4] );
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetMarkWatershedLine( atoi( argv[1] ) );
+  filter->SetFullyConnected( atoi( argv[2] ) );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  unsigned long diff = 0;
+
+  diff += run( filter, reader2, "hierarchical queue, compact labels" );
+
+  filter->SetUseCompactLabels( false );
+  diff += run( filter, reader2, "hierarchical queue" );
+
+  filter->SetMaximumFloodLevel( 100 );
+  diff += run( filter, reader2, "bounded" );
+  filter->SetMaximumFloodLevel( itk::NumericTraits< PType >::max() );
+
+  filter->SetFloodingMethod( FilterType::SORTED_LEVELS );
+  diff += run( filter, reader2, "sorted levels" );
+
+  filter->SetFloodingMethod( FilterType::MINIMUM_SPANNING_FOREST );
+  diff += run( filter, reader2, "minimum spanning forest" );
+
+  filter->SetFloodingMethod( FilterType::HIERARCHICAL_QUEUE );
+  filter->SetUseImageSpacing( true );
+  diff += run( filter, reader2, "image spacing" );
+
+  if( diff != 0 )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
+
@@ -0,0 +1,286 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBatchedMorphologicalWatershedImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBatchedMorphologicalWatershedImageFilter_h
+#define __itkBatchedMorphologicalWatershedImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkFastMutexLock.h"
+#include <vector>
+#include <string>
+
+namespace itk {
+
+/** \class BatchedMorphologicalWatershedImageFilter
+ * \brief Run the morphological watershed independently on many regions of
+ * a single image
+ *
+ * The well plate montages and the tiled scans are made of many fields which
+ * must be segmented separately. This filter takes the list of the regions
+ * of the input to segment, and runs MorphologicalWatershedImageFilter on
+ * each of them, as if each region were a small image: the h-minima
+ * reconstruction, the labeling of the regional minima and the flooding
+ * don't see the pixels outside the region.
+ *
+ * The regions are processed in parallel: each thread takes the next region
+ * of the list, copies its pixels from the input buffer in a scratch image,
+ * runs the watershed, and writes the labels directly in the output, in the
+ * same region. The scratch image and the watershed filter of each thread
+ * are kept from one region to the other, and from one update to the other.
+ * The watershed keeps its own labeling and flooding filters, so the
+ * buffers of the scratch image, of the markers, of the labels and of the
+ * flooding are only reallocated when a region needs more memory than all
+ * the regions processed before by the thread. GetScratchSize() returns the
+ * memory kept, and ReleaseWorkers() frees it.
+ *
+ * The labels of each region are shifted by a label offset, so the labels
+ * of the output are unique: the offset of a region is the sum of the
+ * largest labels of the regions before it in the list. The labels don't
+ * depend on the number of threads. GetLabelOffsets() returns the offset of
+ * each region, and GetNumberOfLabels() its largest label. The watershed
+ * lines and the pixels outside all the regions are set to 0.
+ *
+ * The regions must be in the largest possible region of the input, and
+ * must not overlap.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedImageFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT BatchedMorphologicalWatershedImageFilter :
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef BatchedMorphologicalWatershedImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename OutputImageType::IndexType      IndexType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** The list of the regions to segment */
+  typedef InputImageRegionType RegionType;
+  typedef std::vector< RegionType > RegionListType;
+
+  /** The watershed run on each region */
+  typedef MorphologicalWatershedImageFilter< TInputImage, TOutputImage > WatershedType;
+  typedef typename WatershedType::FloodingMethodType FloodingMethodType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BatchedMorphologicalWatershedImageFilter,
+               ImageToImageFilter);
+
+  /** Set/Get the regions to segment */
+  void SetRegions( const RegionListType & regions )
+    {
+    m_Regions = regions;
+    this->Modified();
+    }
+  const RegionListType & GetRegions() const
+    {
+    return m_Regions;
+    }
+
+  /** Add a region to segment */
+  void AddRegion( const RegionType & region )
+    {
+    m_Regions.push_back( region );
+    this->Modified();
+    }
+
+  /** Remove all the regions */
+  void ClearRegions()
+    {
+    m_Regions.clear();
+    this->Modified();
+    }
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.  For objects that are 1 pixel wide, use
+   * FullyConnectedOn.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get whether the watershed pixel must be marked or not. Default
+   * is true.
+   */
+  itkSetMacro(MarkWatershedLine, bool);
+  itkGetConstReferenceMacro(MarkWatershedLine, bool);
+  itkBooleanMacro(MarkWatershedLine);
+
+  /**
+   * Set/Get the height of the minima removed before the flooding.
+   * \sa MorphologicalWatershedImageFilter::SetLevel()
+   */
+  itkSetMacro(Level, InputImagePixelType);
+  itkGetMacro(Level, InputImagePixelType);
+
+  /**
+   * Set/Get the algorithm used to flood the regions. Default is
+   * HIERARCHICAL_QUEUE.
+   * \sa MorphologicalWatershedImageFilter::SetFloodingMethod()
+   */
+  itkSetMacro(FloodingMethod, FloodingMethodType);
+  itkGetConstReferenceMacro(FloodingMethod, FloodingMethodType);
+
+  /**
+   * Set/Get whether the flooding is done on the ranks of the input values.
+   * Default is false.
+   * \sa MorphologicalWatershedImageFilter::SetUseRankTransform()
+   */
+  itkSetMacro(UseRankTransform, bool);
+  itkGetConstReferenceMacro(UseRankTransform, bool);
+  itkBooleanMacro(UseRankTransform);
+
+  /** Return the label offset of each region, computed during the last
+   * update */
+  const std::vector< OutputImagePixelType > & GetLabelOffsets() const
+    {
+    return m_LabelOffsets;
+    }
+
+  /** Return the largest label of each region before its offset, computed
+   * during the last update */
+  const std::vector< unsigned long > & GetNumberOfLabels() const
+    {
+    return m_NumberOfLabels;
+    }
+
+  /** Release the scratch images and the watershed filters kept by the
+   * threads */
+  void ReleaseWorkers();
+
+  /** Return the size, in bytes, of the scratch memory kept by the threads:
+   * the scratch images, and the labels and the scratch memory of their
+   * watershed filters */
+  unsigned long GetScratchSize() const;
+
+protected:
+  BatchedMorphologicalWatershedImageFilter();
+  ~BatchedMorphologicalWatershedImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** BatchedMorphologicalWatershedImageFilter needs the entire input be
+   * available. Thus, it needs to provide an implementation of
+   * GenerateInputRequestedRegion(). */
+  void GenerateInputRequestedRegion() ;
+
+  /** BatchedMorphologicalWatershedImageFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+
+  void GenerateData();
+
+  /** Check that the regions are in the input, and don't overlap */
+  void VerifyRegions() const;
+
+  /** Segment a region in a thread, and write its labels, without offset, in
+   * the output */
+  void SegmentRegion( unsigned long r, int threadId );
+
+  /** Add the label offset of a region to its labels in the output */
+  void ShiftRegionLabels( unsigned long r );
+
+  /** Run a pass of the batch with a thread pool: each thread takes the
+   * next region until all the regions are processed */
+  void ExecutePass( bool segment );
+
+  /** the scratch data of a thread */
+  struct WorkerType
+    {
+    InputImagePointer Input;
+    typename WatershedType::Pointer Watershed;
+    };
+
+  /** data shared by the threads */
+  struct ThreadStruct
+    {
+    Self * Filter;
+    bool Segment;
+    };
+
+  static ITK_THREAD_RETURN_TYPE RegionThreaderCallback( void * arg );
+
+private:
+  BatchedMorphologicalWatershedImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  RegionListType m_Regions;
+
+  bool m_FullyConnected;
+
+  bool m_MarkWatershedLine;
+
+  InputImagePixelType m_Level;
+
+  FloodingMethodType m_FloodingMethod;
+
+  bool m_UseRankTransform;
+
+  std::vector< OutputImagePixelType > m_LabelOffsets;
+  std::vector< unsigned long > m_NumberOfLabels;
+
+  // the scratch data of the threads, kept from one update to the other
+  std::vector< WorkerType > m_Workers;
+
+  // the next region to process, and the first error of the threads
+  unsigned long m_NextRegion;
+  std::string m_ErrorMessage;
+  typename FastMutexLock::Pointer m_RegionLock;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBatchedMorphologicalWatershedImageFilter.txx"
+#endif
+
+#endif
+
+
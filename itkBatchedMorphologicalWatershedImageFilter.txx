@@ -0,0 +1,397 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBatchedMorphologicalWatershedImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBatchedMorphologicalWatershedImageFilter_txx
+#define __itkBatchedMorphologicalWatershedImageFilter_txx
+
+#include "itkBatchedMorphologicalWatershedImageFilter.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::BatchedMorphologicalWatershedImageFilter()
+{
+  m_FullyConnected = false;
+  m_MarkWatershedLine = true;
+  m_Level = NumericTraits< InputImagePixelType >::Zero;
+  m_FloodingMethod = WatershedType::HIERARCHICAL_QUEUE;
+  m_UseRankTransform = false;
+  m_NextRegion = 0;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast<InputImageType *>(this->GetInput());
+  if ( !input )
+    { return; }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+    ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+  this->VerifyRegions();
+
+  // the pixels outside the regions are not labeled
+  this->GetOutput()->FillBuffer( NumericTraits< OutputImagePixelType >::Zero );
+
+  const unsigned long nbOfRegions = m_Regions.size();
+  m_NumberOfLabels.assign( nbOfRegions, 0 );
+  m_LabelOffsets.assign( nbOfRegions, NumericTraits< OutputImagePixelType >::Zero );
+  if( nbOfRegions == 0 )
+    {
+    return;
+    }
+
+  m_RegionLock = FastMutexLock::New();
+
+  // segment the regions, in any order
+  this->ExecutePass( true );
+
+  // the offsets only depend on the order of the list, so the labels are the
+  // same with any number of threads
+  double nbOfLabels = 0;
+  for( unsigned long r=0; r<nbOfRegions; r++ )
+    {
+    m_LabelOffsets[r] = static_cast< OutputImagePixelType >( nbOfLabels );
+    nbOfLabels += m_NumberOfLabels[r];
+    }
+  if( nbOfLabels > static_cast< double >( NumericTraits< OutputImagePixelType >::max() ) )
+    {
+    itkExceptionMacro( << "The " << nbOfLabels << " labels of the regions can't be stored in the output pixel type." );
+    }
+
+  // and make their labels unique
+  this->ExecutePass( false );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::VerifyRegions() const
+{
+  const InputImageRegionType & largest = this->GetInput()->GetLargestPossibleRegion();
+  for( unsigned long r=0; r<m_Regions.size(); r++ )
+    {
+    if( !largest.IsInside( m_Regions[r] ) )
+      {
+      itkExceptionMacro( << "Region " << r << " is outside the input image: " << m_Regions[r] );
+      }
+    }
+
+  // the regions are written concurrently in the output: they must not
+  // overlap. The number of regions is small enough to test all the pairs.
+  for( unsigned long r=0; r<m_Regions.size(); r++ )
+    {
+    for( unsigned long s=r+1; s<m_Regions.size(); s++ )
+      {
+      RegionType intersection = m_Regions[r];
+      if( intersection.Crop( m_Regions[s] ) && intersection.GetNumberOfPixels() != 0 )
+        {
+        itkExceptionMacro( << "Regions " << r << " and " << s << " overlap." );
+        }
+      }
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ExecutePass( bool segment )
+{
+  m_NextRegion = 0;
+  m_ErrorMessage = "";
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( std::min( (unsigned long)this->GetNumberOfThreads(), (unsigned long)m_Regions.size() ) );
+  if( m_Workers.size() < (unsigned long)threader->GetNumberOfThreads() )
+    {
+    m_Workers.resize( threader->GetNumberOfThreads() );
+    }
+
+  ThreadStruct str;
+  str.Filter = this;
+  str.Segment = segment;
+  threader->SetSingleMethod( Self::RegionThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  if( !m_ErrorMessage.empty() )
+    {
+    itkExceptionMacro( << m_ErrorMessage );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::RegionThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+  Self * filter = str->Filter;
+
+  while( true )
+    {
+    // take the next region, or stop if they are all processed or if another
+    // thread has failed
+    filter->m_RegionLock->Lock();
+    if( filter->m_NextRegion >= filter->m_Regions.size() || !filter->m_ErrorMessage.empty() )
+      {
+      filter->m_RegionLock->Unlock();
+      return ITK_THREAD_RETURN_VALUE;
+      }
+    const unsigned long r = filter->m_NextRegion;
+    filter->m_NextRegion++;
+    filter->m_RegionLock->Unlock();
+
+    // the exceptions can't go through the threader: they are sent again by
+    // ExecutePass()
+    try
+      {
+      if( str->Segment )
+        {
+        filter->SegmentRegion( r, info->ThreadID );
+        }
+      else
+        {
+        filter->ShiftRegionLabels( r );
+        }
+      }
+    catch( ExceptionObject & e )
+      {
+      filter->m_RegionLock->Lock();
+      if( filter->m_ErrorMessage.empty() )
+        {
+        filter->m_ErrorMessage = e.GetDescription();
+        }
+      filter->m_RegionLock->Unlock();
+      }
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::SegmentRegion( unsigned long r, int threadId )
+{
+  const RegionType & region = m_Regions[r];
+  if( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  WorkerType & worker = m_Workers[threadId];
+
+  if( !worker.Input )
+    {
+    worker.Input = InputImageType::New();
+    worker.Watershed = WatershedType::New();
+    worker.Watershed->SetInput( worker.Input );
+    }
+
+  // the scratch image is a small image at the position of the region. Its
+  // buffer is reallocated only when it is too small for the region.
+  RegionType scratchRegion;
+  scratchRegion.SetSize( region.GetSize() );
+  typename InputImageType::PointType origin;
+  input->TransformIndexToPhysicalPoint( region.GetIndex(), origin );
+  worker.Input->CopyInformation( input );
+  worker.Input->SetRegions( scratchRegion );
+  worker.Input->SetOrigin( origin );
+  worker.Input->Allocate();
+
+  // copy the lines of the region from the input buffer
+  const unsigned long xsize = region.GetSize()[0];
+  const unsigned long nbOfLines = region.GetNumberOfPixels() / xsize;
+  IndexType idx = region.GetIndex();
+  InputImagePixelType * scratch = worker.Input->GetBufferPointer();
+  for( unsigned long l=0; l<nbOfLines; l++ )
+    {
+    const InputImagePixelType * line = input->GetBufferPointer() + input->ComputeOffset( idx );
+    std::copy( line, line + xsize, scratch + l * xsize );
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      idx[d]++;
+      if( idx[d] < region.GetIndex()[d] + (long)region.GetSize()[d] )
+        {
+        break;
+        }
+      idx[d] = region.GetIndex()[d];
+      }
+    }
+  // the watershed must not reuse the markers of the previous region
+  worker.Input->Modified();
+
+  // the parallelism is at the region level
+  worker.Watershed->SetFullyConnected( m_FullyConnected );
+  worker.Watershed->SetMarkWatershedLine( m_MarkWatershedLine );
+  worker.Watershed->SetLevel( m_Level );
+  worker.Watershed->SetWatershedLabel( NumericTraits< OutputImagePixelType >::Zero );
+  worker.Watershed->SetFloodingMethod( m_FloodingMethod );
+  worker.Watershed->SetUseRankTransform( m_UseRankTransform );
+  worker.Watershed->SetNumberOfThreads( 1 );
+  worker.Watershed->Update();
+
+  // write the labels in the output, and find the largest one
+  const OutputImagePixelType * labels = worker.Watershed->GetOutput()->GetBufferPointer();
+  OutputImagePixelType maxLabel = NumericTraits< OutputImagePixelType >::Zero;
+  idx = region.GetIndex();
+  for( unsigned long l=0; l<nbOfLines; l++ )
+    {
+    const OutputImagePixelType * line = labels + l * xsize;
+    std::copy( line, line + xsize, output->GetBufferPointer() + output->ComputeOffset( idx ) );
+    maxLabel = std::max( maxLabel, *std::max_element( line, line + xsize ) );
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      idx[d]++;
+      if( idx[d] < region.GetIndex()[d] + (long)region.GetSize()[d] )
+        {
+        break;
+        }
+      idx[d] = region.GetIndex()[d];
+      }
+    }
+  m_NumberOfLabels[r] = static_cast< unsigned long >( maxLabel );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ShiftRegionLabels( unsigned long r )
+{
+  const RegionType & region = m_Regions[r];
+  const OutputImagePixelType offset = m_LabelOffsets[r];
+  if( region.GetNumberOfPixels() == 0 || offset == NumericTraits< OutputImagePixelType >::Zero )
+    {
+    return;
+    }
+
+  OutputImageType * output = this->GetOutput();
+  const unsigned long xsize = region.GetSize()[0];
+  const unsigned long nbOfLines = region.GetNumberOfPixels() / xsize;
+  IndexType idx = region.GetIndex();
+  for( unsigned long l=0; l<nbOfLines; l++ )
+    {
+    OutputImagePixelType * line = output->GetBufferPointer() + output->ComputeOffset( idx );
+    for( unsigned long x=0; x<xsize; x++ )
+      {
+      // the watershed lines stay at 0
+      if( line[x] != NumericTraits< OutputImagePixelType >::Zero )
+        {
+        line[x] += offset;
+        }
+      }
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      idx[d]++;
+      if( idx[d] < region.GetIndex()[d] + (long)region.GetSize()[d] )
+        {
+        break;
+        }
+      idx[d] = region.GetIndex()[d];
+      }
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ReleaseWorkers()
+{
+  m_Workers.clear();
+}
+
+
+template<class TInputImage, class TOutputImage>
+unsigned long
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::GetScratchSize() const
+{
+  unsigned long size = 0;
+  for( unsigned long t=0; t<m_Workers.size(); t++ )
+    {
+    const WorkerType & worker = m_Workers[t];
+    if( !worker.Input )
+      {
+      continue;
+      }
+    if( worker.Input->GetBufferPointer() )
+      {
+      size += worker.Input->GetPixelContainer()->Capacity() * sizeof( InputImagePixelType );
+      }
+    const OutputImageType * labels = worker.Watershed->GetOutput();
+    if( labels->GetBufferPointer() )
+      {
+      size += labels->GetPixelContainer()->Capacity() * sizeof( OutputImagePixelType );
+      }
+    size += worker.Watershed->GetScratchSize();
+    }
+  return size;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+BatchedMorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Regions: "  << m_Regions.size() << std::endl;
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "Level: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_Level) << std::endl;
+  os << indent << "FloodingMethod: "  << m_FloodingMethod << std::endl;
+  os << indent << "UseRankTransform: "  << m_UseRankTransform << std::endl;
+  os << indent << "Workers: "  << m_Workers.size() << std::endl;
+  os << indent << "ScratchSize: "  << this->GetScratchSize() << std::endl;
+}
+
+}// end namespace itk
+#endif
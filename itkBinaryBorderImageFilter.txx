@@ -446,7 +446,7 @@ BinaryBorderImageFilter< TInputImage, TOutputImage>
 //         std::cout << oStart << " " << oLast << std::endl;
         assert( oStart <= oLast );
         IndexType idx = cIt->where;
-        for( int x=oStart; x<=oLast; x++ )
+        for( long x=oStart; x<=oLast; x++ )
           {
           idx[0] = x;
           output->SetPixel( idx, m_ForegroundValue );
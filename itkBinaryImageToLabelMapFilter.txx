@@ -299,7 +299,7 @@ BinaryImageToLabelMapFilter< TInputImage, TOutputImage >
       {
       // remove the region already joined
       typename std::vector< long > newFirstLineIdToJoin;
-      for( int i = 1; i<m_FirstLineIdToJoin.size(); i+=2 )
+      for( unsigned long i = 1; i<m_FirstLineIdToJoin.size(); i+=2 )
         {
         newFirstLineIdToJoin.push_back( m_FirstLineIdToJoin[i] );
         }
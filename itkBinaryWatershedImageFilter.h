@@ -18,6 +18,7 @@
 #define __itkBinaryWatershedImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkImageCache.h"
 
 namespace itk {
 
@@ -115,6 +116,16 @@ public:
   itkSetMacro(ForegroundValue, InputImagePixelType);
   itkGetMacro(ForegroundValue, InputImagePixelType);
 
+  /**
+   * Set/Get the on-disk cache of the output. When it is set, the output is
+   * stored in the cache, and loaded from there instead of being computed
+   * again for an input with the same content and the same parameters, even
+   * in another process. Default is NULL: no cache.
+   * \sa ImageCache
+   */
+  itkSetObjectMacro(Cache, ImageCache);
+  itkGetObjectMacro(Cache, ImageCache);
+
 protected:
   BinaryWatershedImageFilter();
   ~BinaryWatershedImageFilter() {};
@@ -149,6 +160,8 @@ private:
 
   OutputImagePixelType m_BackgroundValue;
 
+  ImageCache::Pointer m_Cache;
+
 } ; // end of class
 
 } // end namespace itk
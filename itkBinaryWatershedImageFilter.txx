@@ -23,6 +23,7 @@
 #include "itkMorphologicalWatershedImageFilter.h"
 #include "itkMaskImageFilter.h"
 #include "itkNumericTraits.h"
+#include <sstream>
 
 #include "itkLabelObject.h"
 #include "itkLabelMap.h"
@@ -43,6 +44,7 @@ BinaryWatershedImageFilter<TInputImage, TOutputImage, TDistance>
   m_Level = NumericTraits< InputImagePixelType >::Zero;
   m_ForegroundValue = NumericTraits< OutputImagePixelType >::max();
   m_BackgroundValue = NumericTraits< OutputImagePixelType >::Zero;
+  m_Cache = NULL;
 }
 
 template <class TInputImage, class TOutputImage, class TDistance>
@@ -76,6 +78,28 @@ void
 BinaryWatershedImageFilter<TInputImage, TOutputImage, TDistance>
 ::GenerateData()
 {
+  // the output may have been computed already, by this process or by
+  // another one
+  std::string cacheKey;
+  if( m_Cache )
+    {
+    std::ostringstream parameters;
+    parameters.precision( 17 );
+    parameters << m_FullyConnected << " " << m_BinaryOutput << " " << m_UseImageSpacing << " "
+               << static_cast<typename NumericTraits<DistanceType>::PrintType>(m_Level) << " "
+               << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_ForegroundValue) << " "
+               << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << " "
+               << ChunkedVolumePixelTypeName< DistanceType >() << " "
+               << ChunkedVolumePixelTypeName< OutputImagePixelType >();
+    cacheKey = m_Cache->ComputeKey( "BinaryWatershed", parameters.str(), this->GetInput() );
+    OutputImageType * output = this->GetOutput();
+    output->SetBufferedRegion( output->GetRequestedRegion() );
+    if( m_Cache->Load( cacheKey, output ) )
+      {
+      return;
+      }
+    }
+
   // Create a process accumulator for tracking the progress of this minipipeline
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter(this);
@@ -139,6 +163,11 @@ BinaryWatershedImageFilter<TInputImage, TOutputImage, TDistance>
     this->GraftOutput( l2li->GetOutput() );
     
     }
+
+  if( m_Cache )
+    {
+    m_Cache->Store( cacheKey, this->GetOutput() );
+    }
 }
 
 
@@ -155,6 +184,7 @@ BinaryWatershedImageFilter<TInputImage, TOutputImage, TDistance>
   os << indent << "Level: "  << static_cast<typename NumericTraits<DistanceType>::PrintType>(m_Level) << std::endl;
   os << indent << "ForegroundValue: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_ForegroundValue) << std::endl;
   os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "Cache: "  << m_Cache.GetPointer() << std::endl;
 }
   
 }// end namespace itk
@@ -0,0 +1,223 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBinaryWatershedImageToLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.4 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBinaryWatershedImageToLabelMapFilter_h
+#define __itkBinaryWatershedImageToLabelMapFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkAttributeLabelObject.h"
+
+namespace itk {
+
+/** \class BinaryWatershedImageToLabelMapFilter
+ * \brief Split the objects of a binary image, and select them by size and shape, in a LabelMap
+ *
+ * BinaryWatershedImageToLabelMapFilter runs the same splitting as
+ * BinaryWatershedImageFilter, but produces a LabelMap instead of an image,
+ * so the objects can be measured and filtered without encoding them again.
+ * The mini-pipeline is:
+ * - BinaryImageToLabelMapFilter to find the connected components,
+ * - MorphologicalWatershedLabelMapFilter to split them on the watershed of
+ *   their distance map,
+ * - LabelContourAttributeLabelMapFilter to store the number of pixels on
+ *   the contour of each object in its attribute,
+ * - the removal of the objects smaller than MinimumSize, larger than
+ *   MaximumSize, or with a fraction of their pixels on their contour greater
+ *   than MaximumContourRatio, like the thin debris around the nuclei.
+ *
+ * The objects are stored as lines during the whole pipeline: the splitting
+ * only rasterizes each object in its own bounding box, and no label image of
+ * the size of the input is ever allocated.
+ *
+ * The time spent in each stage of the last update, in seconds, is available
+ * with GetLabelingTime(), GetSplittingTime(), GetAttributesTime() and
+ * GetSelectionTime().
+ *
+ * The label object type of the output must provide an attribute, through
+ * the attribute accessor given as template parameter, like
+ * AttributeLabelObject.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa BinaryWatershedImageFilter, MorphologicalWatershedLabelMapFilter, LabelContourAttributeLabelMapFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TOutputImage, class TDistance=float, class TAttributeAccessor=
+    typename Functor::AttributeLabelObjectAccessor< typename TOutputImage::LabelObjectType > >
+class ITK_EXPORT BinaryWatershedImageToLabelMapFilter :
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryWatershedImageToLabelMapFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename OutputImageType::SizeType       SizeType;
+  typedef OutputImageType                          LabelMapType;
+  typedef typename LabelMapType::LabelObjectType   LabelObjectType;
+
+  typedef TAttributeAccessor AttributeAccessorType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  typedef TDistance DistanceType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryWatershedImageToLabelMapFilter,
+               ImageToImageFilter);
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.  For objects that are 1 pixel wide, use
+   * FullyConnectedOn.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get the minimal depth of the basins of the distance map which
+   * produce a new object. Default is 0.
+   */
+  itkSetMacro(Level, DistanceType);
+  itkGetMacro(Level, DistanceType);
+
+  /**
+   * Set/Get whether the distance map will be computing using the image
+   * spacing. Default is true.
+   */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /**
+   * Set/Get the value of the objects in the input image. Default is the
+   * maximum of the input pixel type.
+   */
+  itkSetMacro(ForegroundValue, InputImagePixelType);
+  itkGetMacro(ForegroundValue, InputImagePixelType);
+
+  /**
+   * Set/Get the background value of the output label map. Default is
+   * the minimum of the label type.
+   */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetMacro(BackgroundValue, OutputImagePixelType);
+
+  /**
+   * Set/Get the size range, in pixels, of the objects kept. Default is
+   * [0, max]: no object is removed for its size.
+   */
+  itkSetMacro(MinimumSize, unsigned long);
+  itkGetConstReferenceMacro(MinimumSize, unsigned long);
+  itkSetMacro(MaximumSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumSize, unsigned long);
+
+  /**
+   * Set/Get the maximum fraction of the pixels of an object on its contour.
+   * The thin or irregular objects have most of their pixels on their
+   * contour, the round ones have the lowest fraction for their size.
+   * Default is 1: no object is removed for its shape.
+   */
+  itkSetMacro(MaximumContourRatio, double);
+  itkGetConstReferenceMacro(MaximumContourRatio, double);
+
+  /** Get the time, in seconds, spent in each stage of the last update */
+  itkGetConstReferenceMacro(LabelingTime, double);
+  itkGetConstReferenceMacro(SplittingTime, double);
+  itkGetConstReferenceMacro(AttributesTime, double);
+  itkGetConstReferenceMacro(SelectionTime, double);
+
+protected:
+  BinaryWatershedImageToLabelMapFilter();
+  ~BinaryWatershedImageToLabelMapFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** BinaryWatershedImageToLabelMapFilter needs the entire input be
+   * available. Thus, it needs to provide an implementation of
+   * GenerateInputRequestedRegion(). */
+  void GenerateInputRequestedRegion() ;
+
+  /** BinaryWatershedImageToLabelMapFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+
+  /** Run the mini-pipeline, and select the objects */
+  void GenerateData();
+
+  /** Remove the objects of the output which don't match the size and shape
+   * criteria */
+  void SelectObjects();
+
+private:
+  BinaryWatershedImageToLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  bool m_FullyConnected;
+
+  bool m_UseImageSpacing;
+
+  DistanceType m_Level;
+
+  InputImagePixelType m_ForegroundValue;
+
+  OutputImagePixelType m_BackgroundValue;
+
+  unsigned long m_MinimumSize;
+
+  unsigned long m_MaximumSize;
+
+  double m_MaximumContourRatio;
+
+  double m_LabelingTime;
+  double m_SplittingTime;
+  double m_AttributesTime;
+  double m_SelectionTime;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryWatershedImageToLabelMapFilter.txx"
+#endif
+
+#endif
+
+
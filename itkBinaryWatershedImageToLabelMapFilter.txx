@@ -0,0 +1,197 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBinaryWatershedImageToLabelMapFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.6 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBinaryWatershedImageToLabelMapFilter_txx
+#define __itkBinaryWatershedImageToLabelMapFilter_txx
+
+#include "itkBinaryWatershedImageToLabelMapFilter.h"
+#include "itkNumericTraits.h"
+#include "itkProgressAccumulator.h"
+#include "itkTimeProbe.h"
+
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkMorphologicalWatershedLabelMapFilter.h"
+#include "itkLabelContourAttributeLabelMapFilter.h"
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::BinaryWatershedImageToLabelMapFilter()
+{
+  m_FullyConnected = false;
+  m_UseImageSpacing = true;
+  m_Level = NumericTraits< DistanceType >::Zero;
+  m_ForegroundValue = NumericTraits< InputImagePixelType >::max();
+  m_BackgroundValue = NumericTraits< OutputImagePixelType >::NonpositiveMin();
+  m_MinimumSize = 0;
+  m_MaximumSize = NumericTraits< unsigned long >::max();
+  m_MaximumContourRatio = 1.0;
+  m_LabelingTime = 0;
+  m_SplittingTime = 0;
+  m_AttributesTime = 0;
+  m_SelectionTime = 0;
+}
+
+template <class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+void
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast<InputImageType *>(this->GetInput());
+  if ( !input )
+    { return; }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+
+template <class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+void
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+    ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+void
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::GenerateData()
+{
+  // Create a process accumulator for tracking the progress of this minipipeline
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+
+  // find the objects to split
+  typedef BinaryImageToLabelMapFilter< InputImageType, LabelMapType > I2LType;
+  typename I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( this->GetInput() );
+  i2l->SetFullyConnected( m_FullyConnected );
+  i2l->SetForegroundValue( m_ForegroundValue );
+  i2l->SetBackgroundValue( m_BackgroundValue );
+  i2l->SetNumberOfThreads( this->GetNumberOfThreads() );
+  // the objects before the split are not needed anymore once split
+  i2l->ReleaseDataFlagOn();
+  progress->RegisterInternalFilter(i2l,0.1f);
+
+  TimeProbe labelingTime;
+  labelingTime.Start();
+  i2l->Update();
+  labelingTime.Stop();
+  m_LabelingTime = labelingTime.GetMeanTime();
+
+  // split them, each one in its bounding box
+  typedef MorphologicalWatershedLabelMapFilter< LabelMapType, LabelMapType, DistanceType > WatershedType;
+  typename WatershedType::Pointer watershed = WatershedType::New();
+  watershed->SetInput( i2l->GetOutput() );
+  watershed->SetUseImageSpacing( m_UseImageSpacing );
+  watershed->SetLevel( m_Level );
+  watershed->SetFullyConnected( m_FullyConnected );
+  watershed->SetMarkWatershedLine( false );
+  watershed->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progress->RegisterInternalFilter(watershed,0.8f);
+
+  TimeProbe splittingTime;
+  splittingTime.Start();
+  watershed->Update();
+  splittingTime.Stop();
+  m_SplittingTime = splittingTime.GetMeanTime();
+
+  // the size of the contour of the split objects, in their attribute
+  typedef LabelContourAttributeLabelMapFilter< LabelMapType, AttributeAccessorType > ContourType;
+  typename ContourType::Pointer contour = ContourType::New();
+  contour->SetInput( watershed->GetOutput() );
+  contour->SetFullyConnected( m_FullyConnected );
+  contour->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progress->RegisterInternalFilter(contour,0.1f);
+
+  TimeProbe attributesTime;
+  attributesTime.Start();
+  contour->Update();
+  attributesTime.Stop();
+  m_AttributesTime = attributesTime.GetMeanTime();
+
+  this->GraftOutput( contour->GetOutput() );
+
+  TimeProbe selectionTime;
+  selectionTime.Start();
+  this->SelectObjects();
+  selectionTime.Stop();
+  m_SelectionTime = selectionTime.GetMeanTime();
+}
+
+
+template<class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+void
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::SelectObjects()
+{
+  if( m_MinimumSize == 0 && m_MaximumSize == NumericTraits< unsigned long >::max() && m_MaximumContourRatio >= 1.0 )
+    {
+    // nothing to remove
+    return;
+    }
+
+  LabelMapType * output = this->GetOutput();
+  AttributeAccessorType accessor;
+
+  const typename LabelMapType::LabelObjectContainerType & labelObjectContainer = output->GetLabelObjectContainer();
+  typename LabelMapType::LabelObjectContainerType::const_iterator it = labelObjectContainer.begin();
+  while( it != labelObjectContainer.end() )
+    {
+    typename LabelObjectType::LabelType label = it->first;
+    LabelObjectType * labelObject = it->second;
+    const unsigned long size = labelObject->Size();
+    const double contourRatio = static_cast< double >( accessor( labelObject ) ) / size;
+    // must increment the iterator before removing the object to avoid invalidating the iterator
+    it++;
+    if( size < m_MinimumSize || size > m_MaximumSize || contourRatio > m_MaximumContourRatio )
+      {
+      output->RemoveLabel( label );
+      }
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TDistance, class TAttributeAccessor>
+void
+BinaryWatershedImageToLabelMapFilter<TInputImage, TOutputImage, TDistance, TAttributeAccessor>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "UseImageSpacing: "  << m_UseImageSpacing << std::endl;
+  os << indent << "Level: "  << static_cast<typename NumericTraits<DistanceType>::PrintType>(m_Level) << std::endl;
+  os << indent << "ForegroundValue: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_ForegroundValue) << std::endl;
+  os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "MinimumSize: "  << m_MinimumSize << std::endl;
+  os << indent << "MaximumSize: "  << m_MaximumSize << std::endl;
+  os << indent << "MaximumContourRatio: "  << m_MaximumContourRatio << std::endl;
+  os << indent << "LabelingTime: "  << m_LabelingTime << std::endl;
+  os << indent << "SplittingTime: "  << m_SplittingTime << std::endl;
+  os << indent << "AttributesTime: "  << m_AttributesTime << std::endl;
+  os << indent << "SelectionTime: "  << m_SelectionTime << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,140 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkBlockedBitArray.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkBlockedBitArray_h
+#define __itkBlockedBitArray_h
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class BlockedBitArray
+ *  \brief An array of bits, allocated by blocks when they are first set
+ *
+ * All the bits are false after assign(). The blocks of 4096 bits are only
+ * allocated when one of their bits is set to true, so the memory used is
+ * proportional to the part of the array actually touched, not to its size.
+ * It is used in place of a std::vector< bool > when only a small part of
+ * an image is processed. The interface is the subset of the one of
+ * std::vector< bool > used by the flooding algorithms, so both can be
+ * used by the same template code.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa ImageForestingTransform
+ */
+class BlockedBitArray
+{
+
+public:
+
+  typedef unsigned long SizeType;
+
+  /** a proxy to a bit, to be able to write status[p] = true */
+  class reference
+    {
+    public:
+      reference( BlockedBitArray * array, SizeType p ) : m_Array( array ), m_Position( p ) {}
+
+      inline operator bool() const
+        {
+        return m_Array->Get( m_Position );
+        }
+
+      inline reference & operator=( bool value )
+        {
+        m_Array->Set( m_Position, value );
+        return *this;
+        }
+
+    private:
+      BlockedBitArray * m_Array;
+      SizeType m_Position;
+    };
+
+  BlockedBitArray()
+    {
+    m_Size = 0;
+    }
+
+  /** resize the array and set all the bits to false. The blocks are
+   * released. Only false is supported as value. */
+  void assign( SizeType size, bool )
+    {
+    m_Size = size;
+    std::vector< std::vector< bool > >().swap( m_Blocks );
+    m_Blocks.resize( ( size >> BlockShift ) + 1 );
+    }
+
+  SizeType size() const
+    {
+    return m_Size;
+    }
+
+  inline bool operator[]( SizeType p ) const
+    {
+    return this->Get( p );
+    }
+
+  inline reference operator[]( SizeType p )
+    {
+    return reference( this, p );
+    }
+
+  inline bool Get( SizeType p ) const
+    {
+    const std::vector< bool > & block = m_Blocks[ p >> BlockShift ];
+    return !block.empty() && block[ p & BlockMask ];
+    }
+
+  inline void Set( SizeType p, bool value )
+    {
+    std::vector< bool > & block = m_Blocks[ p >> BlockShift ];
+    if( block.empty() )
+      {
+      if( !value )
+        {
+        return;
+        }
+      block.resize( BlockSize, false );
+      }
+    block[ p & BlockMask ] = value;
+    }
+
+  /** return the allocated memory, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    unsigned long size = m_Blocks.capacity() * sizeof( std::vector< bool > );
+    for( unsigned long i=0; i<m_Blocks.size(); i++ )
+      {
+      size += m_Blocks[i].capacity() / 8;
+      }
+    return size;
+    }
+
+private:
+
+  enum { BlockShift = 12, BlockSize = 1 << BlockShift, BlockMask = BlockSize - 1 };
+
+  SizeType m_Size;
+  std::vector< std::vector< bool > > m_Blocks;
+
+};
+
+} // end namespace itk
+
+#endif
@@ -21,6 +21,8 @@
 #define __itkChangeRegionLabelMapFilter_h
 
 #include "itkInPlaceLabelMapFilter.h"
+#include "itkLabelMapSpatialIndex.h"
+#include <vector>
 
 namespace itk
 {
@@ -32,6 +34,10 @@ namespace itk
  * the objects, they are truncated, or remove. All the objects fully outside the
  * output region are removed.
  *
+ * The spatial index of the label map is used to remove the objects outside
+ * the output region, and to keep the objects inside it, without looking at
+ * their lines. Only the objects on the border of the region are truncated.
+ *
  * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * \sa LabelMapMaskImageFilter
@@ -93,6 +99,8 @@ public:
 
   virtual void PrintSelf(std::ostream& os, Indent indent) const;
 
+  virtual void BeforeThreadedGenerateData();
+
   virtual void ThreadedGenerateData( LabelObjectType * labelObject );
   
   void GenerateInputRequestedRegion() ;
@@ -109,6 +117,9 @@ private:
 
   OutputImageRegionType m_Region;
 
+  // the objects fully inside the region, sorted
+  std::vector< LabelObjectType * > m_InsideObjects;
+
 };
 
 } // end namespace itk
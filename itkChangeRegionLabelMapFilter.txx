@@ -20,6 +20,7 @@
 #ifndef _itkChangeRegionLabelMapFilter_txx
 #define _itkChangeRegionLabelMapFilter_txx
 #include "itkChangeRegionLabelMapFilter.h"
+#include <algorithm>
 
 
 namespace itk
@@ -83,11 +84,55 @@ ChangeRegionLabelMapFilter<TInputImage>
 }
 
 
+template <class TInputImage>
+void 
+ChangeRegionLabelMapFilter<TInputImage>
+::BeforeThreadedGenerateData()
+{
+  // use the spatial index to find the objects which don't need to be
+  // truncated
+  InputImageType * output = this->GetOutput();
+  const typename InputImageType::SpatialIndexType * index = output->GetSpatialIndex();
+
+  std::vector< LabelObjectType * > intersecting;
+  index->FindObjects( m_Region, intersecting );
+  std::sort( intersecting.begin(), intersecting.end() );
+
+  m_InsideObjects.clear();
+  index->FindObjectsInside( m_Region, m_InsideObjects );
+  std::sort( m_InsideObjects.begin(), m_InsideObjects.end() );
+
+  // remove the objects fully outside the region, before the threads iterate
+  // over the objects
+  typedef typename InputImageType::LabelObjectContainerType LabelObjectContainerType;
+  const LabelObjectContainerType & labelObjectContainer = output->GetLabelObjectContainer();
+  typename LabelObjectContainerType::const_iterator it = labelObjectContainer.begin();
+  while( it != labelObjectContainer.end() )
+    {
+    LabelObjectType * labelObject = it->second;
+    // must increment the iterator before removing the object to avoid invalidating the iterator
+    it++;
+    if( !std::binary_search( intersecting.begin(), intersecting.end(), labelObject ) )
+      {
+      output->RemoveLabelObject( labelObject );
+      }
+    }
+
+  Superclass::BeforeThreadedGenerateData();
+}
+
+
 template<class TInputImage>
 void
 ChangeRegionLabelMapFilter<TInputImage>
 ::ThreadedGenerateData( LabelObjectType * labelObject )
 {
+  if( std::binary_search( m_InsideObjects.begin(), m_InsideObjects.end(), labelObject ) )
+    {
+    // nothing to truncate
+    return;
+    }
+
   typename InputImageType::LabelObjectType::LineContainerType::const_iterator lit;
   typename InputImageType::LabelObjectType::LineContainerType lineContainer = labelObject->GetLineContainer();
   labelObject->GetLineContainer().clear();
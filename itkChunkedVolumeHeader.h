@@ -0,0 +1,441 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkChunkedVolumeHeader.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkChunkedVolumeHeader_h
+#define __itkChunkedVolumeHeader_h
+
+#include "itkImageRegion.h"
+#include "itkFixedArray.h"
+#include "itkNumericTraits.h"
+#include "itk_zlib.h"
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <process.h>
+#include <io.h>
+#include <sys/locking.h>
+#define itkChunkedVolumeGetPid _getpid
+#else
+#include <unistd.h>
+#include <sys/file.h>
+#define itkChunkedVolumeGetPid getpid
+#endif
+
+namespace itk
+{
+
+/** Return a name for the pixel type, which doesn't depend on the compiler. */
+template <typename TPixel>
+std::string ChunkedVolumePixelTypeName()
+{
+  std::ostringstream name;
+  if( !NumericTraits< TPixel >::is_specialized )
+    {
+    name << "bytes" << sizeof( TPixel );
+    }
+  else if( NumericTraits< TPixel >::is_integer )
+    {
+    name << ( NumericTraits< TPixel >::is_signed ? "int" : "uint" ) << sizeof( TPixel ) * 8;
+    }
+  else
+    {
+    name << "float" << sizeof( TPixel ) * 8;
+    }
+  return name.str();
+}
+
+/** \class ChunkedVolumeLock
+ *  \brief Exclusive lock on a file, released when the object is destroyed
+ *
+ * The lock works between processes and between the threads of a process,
+ * each lock opening its own file descriptor. IsLocked() returns false if
+ * the file can't be created or locked.
+ */
+class ChunkedVolumeLock
+{
+public:
+  ChunkedVolumeLock( const std::string & fileName )
+    {
+#ifdef _WIN32
+    m_FileDescriptor = _open( fileName.c_str(), _O_RDWR | _O_CREAT, _S_IREAD | _S_IWRITE );
+    m_Locked = m_FileDescriptor >= 0 && _locking( m_FileDescriptor, _LK_LOCK, 1 ) == 0;
+#else
+    m_FileDescriptor = open( fileName.c_str(), O_RDWR | O_CREAT, 0666 );
+    m_Locked = m_FileDescriptor >= 0 && flock( m_FileDescriptor, LOCK_EX ) == 0;
+#endif
+    }
+
+  ~ChunkedVolumeLock()
+    {
+    if( m_FileDescriptor < 0 )
+      { return; }
+#ifdef _WIN32
+    if( m_Locked )
+      { _locking( m_FileDescriptor, _LK_UNLCK, 1 ); }
+    _close( m_FileDescriptor );
+#else
+    if( m_Locked )
+      { flock( m_FileDescriptor, LOCK_UN ); }
+    close( m_FileDescriptor );
+#endif
+    }
+
+  bool IsLocked() const
+    {
+    return m_Locked;
+    }
+
+private:
+  ChunkedVolumeLock(const ChunkedVolumeLock&); //purposely not implemented
+  void operator=(const ChunkedVolumeLock&); //purposely not implemented
+
+  int m_FileDescriptor;
+  bool m_Locked;
+};
+
+
+/** \class ChunkedVolumeHeader
+ *  \brief Geometry of a volume stored as a directory of chunks
+ *
+ * A chunked volume is a directory which contains a "header.json" file and
+ * one file per chunk. The header is a small JSON object:
+ *
+ * \code
+ * {
+ *   "dimension": 3,
+ *   "pixelType": "uint8",
+ *   "index": [0, 0, 0],
+ *   "size": [512, 512, 200],
+ *   "spacing": [0.5, 0.5, 1.5],
+ *   "origin": [0, 0, 0],
+ *   "chunkSize": [64, 64, 64],
+ *   "compression": "zlib"
+ * }
+ * \endcode
+ *
+ * The chunks are regularly spaced, starting at the index of the volume; the
+ * chunks on the upper border may be smaller than ChunkSize. A chunk is stored
+ * in the file "c<i>_<j>_<k>.raw" (or ".zraw" when compressed) where i, j and k
+ * are the position of the chunk in the chunk grid. A missing chunk file is a
+ * chunk filled with zeros, so sparse volumes are cheap to store.
+ *
+ * Each chunk is in its own file, so several writers can produce different
+ * chunks in parallel without any locking. A writer which updates a part of
+ * a chunk locks the file "c<i>_<j>_<k>.lock" while it reads, modifies and
+ * writes back the chunk: the chunk file itself can't be locked because it
+ * is replaced at each write.
+ */
+template <unsigned int VDimension>
+class ChunkedVolumeHeader
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef ChunkedVolumeHeader      Self;
+
+  typedef ImageRegion< VDimension >            RegionType;
+  typedef typename RegionType::IndexType       IndexType;
+  typedef typename RegionType::SizeType        SizeType;
+  typedef FixedArray< double, VDimension >     VectorType;
+
+  ChunkedVolumeHeader()
+    {
+    m_Spacing.Fill( 1.0 );
+    m_Origin.Fill( 0.0 );
+    m_ChunkSize.Fill( 64 );
+    m_Compressed = false;
+    }
+
+  /** The region, spacing and origin of the whole volume */
+  RegionType m_Region;
+  VectorType m_Spacing;
+  VectorType m_Origin;
+
+  /** The size of a chunk - the chunks on the border may be smaller */
+  SizeType m_ChunkSize;
+
+  /** The pixel type name, as given by ChunkedVolumePixelTypeName() */
+  std::string m_PixelType;
+
+  /** Whether the chunks are compressed with zlib or not */
+  bool m_Compressed;
+
+  /** return the number of chunks in each dimension */
+  SizeType GetGridSize() const
+    {
+    SizeType size;
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      size[i] = ( m_Region.GetSize()[i] + m_ChunkSize[i] - 1 ) / m_ChunkSize[i];
+      }
+    return size;
+    }
+
+  /** return the region of the image covered by a chunk */
+  RegionType GetChunkRegion( const IndexType & chunkIndex ) const
+    {
+    IndexType idx;
+    SizeType size;
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      idx[i] = m_Region.GetIndex()[i] + chunkIndex[i] * m_ChunkSize[i];
+      long end = std::min( idx[i] + (long)m_ChunkSize[i], m_Region.GetIndex()[i] + (long)m_Region.GetSize()[i] );
+      size[i] = end - idx[i];
+      }
+    return RegionType( idx, size );
+    }
+
+  /** return the region of the chunk grid covering a region of the image */
+  RegionType GetChunkGridRegion( const RegionType & region ) const
+    {
+    IndexType idx;
+    SizeType size;
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      long begin = region.GetIndex()[i] - m_Region.GetIndex()[i];
+      long end = begin + region.GetSize()[i];
+      idx[i] = begin / (long)m_ChunkSize[i];
+      size[i] = ( end + m_ChunkSize[i] - 1 ) / m_ChunkSize[i] - idx[i];
+      }
+    return RegionType( idx, size );
+    }
+
+  /** return the name of the file used to store a chunk */
+  std::string GetChunkFileName( const std::string & directory, const IndexType & chunkIndex ) const
+    {
+    std::ostringstream name;
+    name << directory << "/c";
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      if( i != 0 )
+        { name << "_"; }
+      name << chunkIndex[i];
+      }
+    name << ( m_Compressed ? ".zraw" : ".raw" );
+    return name.str();
+    }
+
+  /** return the name of the file locked while a chunk is updated */
+  std::string GetChunkLockFileName( const std::string & directory, const IndexType & chunkIndex ) const
+    {
+    std::ostringstream name;
+    name << directory << "/c";
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      if( i != 0 )
+        { name << "_"; }
+      name << chunkIndex[i];
+      }
+    name << ".lock";
+    return name.str();
+    }
+
+  /** read the content of a chunk. The buffer is resized to the number of
+   * pixels of the chunk, and filled with zeros if the chunk has never been
+   * written. Returns false on failure. */
+  template <class TPixel>
+  bool ReadChunk( const std::string & directory, const IndexType & chunkIndex,
+                  std::vector< TPixel > & buffer ) const
+    {
+    const unsigned long nbOfPixels = this->GetChunkRegion( chunkIndex ).GetNumberOfPixels();
+    const unsigned long nbOfBytes = nbOfPixels * sizeof( TPixel );
+    buffer.resize( nbOfPixels );
+    std::string fileName = this->GetChunkFileName( directory, chunkIndex );
+    std::ifstream file( fileName.c_str(), std::ios::binary );
+    if( !file )
+      {
+      std::fill( buffer.begin(), buffer.end(), NumericTraits< TPixel >::Zero );
+      return true;
+      }
+    if( !m_Compressed )
+      {
+      file.read( reinterpret_cast< char * >( &buffer[0] ), nbOfBytes );
+      return !file.fail();
+      }
+    std::ostringstream content;
+    content << file.rdbuf();
+    const std::string compressed = content.str();
+    uLongf size = nbOfBytes;
+    int ret = uncompress( reinterpret_cast< Bytef * >( &buffer[0] ), &size,
+                          reinterpret_cast< const Bytef * >( compressed.data() ), compressed.size() );
+    return ret == Z_OK && size == nbOfBytes;
+    }
+
+  /** write the content of a chunk. The chunk is written in a temporary file
+   * which is then renamed, so the readers never see a partially written
+   * chunk. Returns false on failure. */
+  template <class TPixel>
+  bool WriteChunk( const std::string & directory, const IndexType & chunkIndex,
+                   const std::vector< TPixel > & buffer ) const
+    {
+    const unsigned long nbOfBytes = buffer.size() * sizeof( TPixel );
+    std::string fileName = this->GetChunkFileName( directory, chunkIndex );
+    std::ostringstream tmpName;
+    tmpName << fileName << ".tmp" << itkChunkedVolumeGetPid();
+    std::ofstream file( tmpName.str().c_str(), std::ios::binary | std::ios::trunc );
+    if( !m_Compressed )
+      {
+      file.write( reinterpret_cast< const char * >( &buffer[0] ), nbOfBytes );
+      }
+    else
+      {
+      uLongf size = compressBound( nbOfBytes );
+      std::vector< Bytef > compressed( size );
+      if( compress( &compressed[0], &size, reinterpret_cast< const Bytef * >( &buffer[0] ), nbOfBytes ) != Z_OK )
+        {
+        file.close();
+        remove( tmpName.str().c_str() );
+        return false;
+        }
+      file.write( reinterpret_cast< const char * >( &compressed[0] ), size );
+      }
+    file.close();
+    if( file.fail() )
+      {
+      remove( tmpName.str().c_str() );
+      return false;
+      }
+#ifdef _WIN32
+    // rename() doesn't replace an existing file on windows
+    remove( fileName.c_str() );
+#endif
+    return rename( tmpName.str().c_str(), fileName.c_str() ) == 0;
+    }
+
+  /** write the header in the directory. Returns false on failure. */
+  bool Write( const std::string & directory ) const
+    {
+    std::string fileName = directory + "/header.json";
+    std::ofstream file( fileName.c_str() );
+    file.precision( 17 );
+    file << "{" << std::endl;
+    file << "  \"dimension\": " << VDimension << "," << std::endl;
+    file << "  \"pixelType\": \"" << m_PixelType << "\"," << std::endl;
+    Self::WriteArray( file, "index", m_Region.GetIndex() );
+    Self::WriteArray( file, "size", m_Region.GetSize() );
+    Self::WriteArray( file, "spacing", m_Spacing );
+    Self::WriteArray( file, "origin", m_Origin );
+    Self::WriteArray( file, "chunkSize", m_ChunkSize );
+    file << "  \"compression\": \"" << ( m_Compressed ? "zlib" : "raw" ) << "\"" << std::endl;
+    file << "}" << std::endl;
+    file.close();
+    return !file.fail();
+    }
+
+  /** read the header from the directory. Returns false on failure. This is
+   * not a generic JSON parser: it only reads the headers written by Write(). */
+  bool Read( const std::string & directory )
+    {
+    std::string fileName = directory + "/header.json";
+    std::ifstream file( fileName.c_str() );
+    if( !file )
+      { return false; }
+    std::ostringstream content;
+    content << file.rdbuf();
+    const std::string json = content.str();
+
+    unsigned int dimension = 0;
+    IndexType idx;
+    SizeType size;
+    std::string compression;
+    if( !Self::ReadValue( json, "dimension", &dimension, 1 ) || dimension != VDimension
+        || !Self::ReadValue( json, "index", &idx[0], VDimension )
+        || !Self::ReadValue( json, "size", &size[0], VDimension )
+        || !Self::ReadValue( json, "spacing", &m_Spacing[0], VDimension )
+        || !Self::ReadValue( json, "origin", &m_Origin[0], VDimension )
+        || !Self::ReadValue( json, "chunkSize", &m_ChunkSize[0], VDimension )
+        || !Self::ReadString( json, "pixelType", m_PixelType )
+        || !Self::ReadString( json, "compression", compression ) )
+      {
+      return false;
+      }
+    m_Region = RegionType( idx, size );
+    m_Compressed = ( compression == "zlib" );
+    return true;
+    }
+
+private:
+
+  template <class TArray>
+  static void WriteArray( std::ostream & os, const char * key, const TArray & array )
+    {
+    os << "  \"" << key << "\": [";
+    for( unsigned int i=0; i<VDimension; i++ )
+      {
+      os << ( i == 0 ? "" : ", " ) << array[i];
+      }
+    os << "]," << std::endl;
+    }
+
+  /** return the position of the value associated to the key, or npos */
+  static std::string::size_type FindValue( const std::string & json, const char * key )
+    {
+    std::string quoted = std::string( "\"" ) + key + "\"";
+    std::string::size_type pos = json.find( quoted );
+    if( pos == std::string::npos )
+      { return pos; }
+    pos = json.find( ':', pos + quoted.size() );
+    if( pos == std::string::npos )
+      { return pos; }
+    return pos + 1;
+    }
+
+  template <class TValue>
+  static bool ReadValue( const std::string & json, const char * key, TValue * values, unsigned int nb )
+    {
+    std::string::size_type pos = Self::FindValue( json, key );
+    if( pos == std::string::npos )
+      { return false; }
+    std::string::size_type end = json.find_first_of( nb == 1 ? ",}" : "]", pos );
+    std::string text = json.substr( pos, end - pos );
+    for( std::string::size_type i=0; i<text.size(); i++ )
+      {
+      if( text[i] == '[' || text[i] == ',' )
+        { text[i] = ' '; }
+      }
+    std::istringstream is( text );
+    for( unsigned int i=0; i<nb; i++ )
+      {
+      if( !( is >> values[i] ) )
+        { return false; }
+      }
+    return true;
+    }
+
+  static bool ReadString( const std::string & json, const char * key, std::string & value )
+    {
+    std::string::size_type pos = Self::FindValue( json, key );
+    if( pos == std::string::npos )
+      { return false; }
+    std::string::size_type begin = json.find( '"', pos );
+    std::string::size_type end = json.find( '"', begin + 1 );
+    if( begin == std::string::npos || end == std::string::npos )
+      { return false; }
+    value = json.substr( begin + 1, end - begin - 1 );
+    return true;
+    }
+
+};
+
+} // end namespace itk
+
+#endif
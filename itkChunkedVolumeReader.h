@@ -0,0 +1,128 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkChunkedVolumeReader.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkChunkedVolumeReader_h
+#define __itkChunkedVolumeReader_h
+
+#include "itkImageSource.h"
+#include "itkChunkedVolumeHeader.h"
+#include <string>
+
+namespace itk {
+
+/** \class ChunkedVolumeReader
+ * \brief Read a chunked volume directory
+ *
+ * ChunkedVolumeReader is an image source which only reads the chunks
+ * covering the requested region of its output, so it can be used at the head
+ * of a streamed pipeline. The chunks can also be read directly with GetChunk(),
+ * and any region with ReadRegion(), without using the pipeline.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa ChunkedVolumeWriter, ChunkedVolumeHeader
+ * \ingroup IOFilters
+ */
+template<class TImage>
+class ITK_EXPORT ChunkedVolumeReader : public ImageSource<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef ChunkedVolumeReader Self;
+  typedef ImageSource<TImage> Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::SizeType        SizeType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::SpacingType     SpacingType;
+  typedef typename ImageType::PointType       PointType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef ChunkedVolumeHeader< ImageDimension > HeaderType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(ChunkedVolumeReader, ImageSource);
+
+  /** Set/Get the directory of the chunked volume */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Read a chunk, in a new image which buffered region is the region of the
+   * chunk. */
+  ImagePointer GetChunk( const IndexType & chunkIndex );
+
+  /** Read a region of the volume, in a new image. Only the chunks covered by
+   * the region are read. */
+  ImagePointer ReadRegion( const RegionType & region );
+
+  /** return the header of the volume. It is read by
+   * GenerateOutputInformation(), GetChunk() or ReadRegion(). */
+  const HeaderType & GetHeader() const
+    {
+    return m_Header;
+    }
+
+protected:
+  ChunkedVolumeReader();
+  ~ChunkedVolumeReader() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** Read the geometry from the header */
+  void GenerateOutputInformation();
+
+  /** The reader can produce any region, so it doesn't enlarge the requested
+   * region */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output)) {};
+
+  void GenerateData();
+
+  /** Read the header if it has not already been read */
+  void ReadHeader();
+
+  /** Copy the part of the volume covered by the buffered region of the
+   * image */
+  void FillImage( ImageType * image );
+
+private:
+  ChunkedVolumeReader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string m_FileName;
+  std::string m_HeaderFileName;
+  HeaderType m_Header;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkChunkedVolumeReader.txx"
+#endif
+
+#endif
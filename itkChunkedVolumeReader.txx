@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkChunkedVolumeReader.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkChunkedVolumeReader_txx
+#define __itkChunkedVolumeReader_txx
+
+#include "itkChunkedVolumeReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+
+namespace itk {
+
+template <class TImage>
+ChunkedVolumeReader<TImage>
+::ChunkedVolumeReader()
+{
+  m_FileName = "";
+  m_HeaderFileName = "";
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeReader<TImage>
+::ReadHeader()
+{
+  if( m_FileName == "" )
+    { itkExceptionMacro( << "FileName must be set." ); }
+  if( m_HeaderFileName == m_FileName )
+    {
+    // already read
+    return;
+    }
+  if( !m_Header.Read( m_FileName ) )
+    { itkExceptionMacro( << "Can't read the header of " << m_FileName ); }
+  if( m_Header.m_PixelType != ChunkedVolumePixelTypeName< PixelType >() )
+    {
+    itkExceptionMacro( << "The pixel type of " << m_FileName << " is " << m_Header.m_PixelType
+                       << ", not " << ChunkedVolumePixelTypeName< PixelType >() );
+    }
+  m_HeaderFileName = m_FileName;
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeReader<TImage>
+::GenerateOutputInformation()
+{
+  // the header may have been changed by a writer since the last read
+  m_HeaderFileName = "";
+  this->ReadHeader();
+
+  ImageType * output = this->GetOutput();
+  SpacingType spacing;
+  PointType origin;
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    spacing[i] = m_Header.m_Spacing[i];
+    origin[i] = m_Header.m_Origin[i];
+    }
+  output->SetLargestPossibleRegion( m_Header.m_Region );
+  output->SetSpacing( spacing );
+  output->SetOrigin( origin );
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeReader<TImage>
+::GenerateData()
+{
+  ImageType * output = this->GetOutput();
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
+  this->FillImage( output );
+}
+
+
+template <class TImage>
+typename ChunkedVolumeReader<TImage>::ImagePointer
+ChunkedVolumeReader<TImage>
+::GetChunk( const IndexType & chunkIndex )
+{
+  this->ReadHeader();
+  return this->ReadRegion( m_Header.GetChunkRegion( chunkIndex ) );
+}
+
+
+template <class TImage>
+typename ChunkedVolumeReader<TImage>::ImagePointer
+ChunkedVolumeReader<TImage>
+::ReadRegion( const RegionType & region )
+{
+  this->ReadHeader();
+  if( !m_Header.m_Region.IsInside( region ) )
+    { itkExceptionMacro( << "The region is outside of the volume." ); }
+
+  ImagePointer image = ImageType::New();
+  image->SetRegions( region );
+  SpacingType spacing;
+  PointType origin;
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    spacing[i] = m_Header.m_Spacing[i];
+    origin[i] = m_Header.m_Origin[i];
+    }
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->Allocate();
+  this->FillImage( image );
+  return image;
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeReader<TImage>
+::FillImage( ImageType * image )
+{
+  const RegionType region = image->GetBufferedRegion();
+
+  typedef Image< char, ImageDimension > GridType;
+  typename GridType::Pointer grid = GridType::New();
+  grid->SetRegions( m_Header.GetChunkGridRegion( region ) );
+  ImageRegionIteratorWithIndex< GridType > git( grid, grid->GetRequestedRegion() );
+
+  ProgressReporter progress( this, 0, grid->GetRequestedRegion().GetNumberOfPixels() );
+
+  std::vector< PixelType > buffer;
+  for( git.GoToBegin(); !git.IsAtEnd(); ++git )
+    {
+    const IndexType & chunkIndex = git.GetIndex();
+    if( !m_Header.ReadChunk( m_FileName, chunkIndex, buffer ) )
+      { itkExceptionMacro( << "Can't read the chunk " << chunkIndex << " in " << m_FileName ); }
+
+    RegionType chunkRegion = m_Header.GetChunkRegion( chunkIndex );
+    typename ImageType::Pointer chunk = ImageType::New();
+    chunk->SetRegions( chunkRegion );
+    typename ImageType::PixelContainer::Pointer container = ImageType::PixelContainer::New();
+    container->SetImportPointer( &buffer[0], buffer.size(), false );
+    chunk->SetPixelContainer( container );
+
+    RegionType intersection = chunkRegion;
+    intersection.Crop( region );
+    ImageRegionConstIterator< ImageType > cit( chunk, intersection );
+    ImageRegionIterator< ImageType > it( image, intersection );
+    for( cit.GoToBegin(), it.GoToBegin(); !cit.IsAtEnd(); ++cit, ++it )
+      {
+      it.Set( cit.Get() );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeReader<TImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: "  << m_FileName << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,146 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkChunkedVolumeWriter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkChunkedVolumeWriter_h
+#define __itkChunkedVolumeWriter_h
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkChunkedVolumeHeader.h"
+#include <string>
+#include <vector>
+
+namespace itk {
+
+/** \class ChunkedVolumeWriter
+ * \brief Write an image, chunk by chunk, in a chunked volume directory
+ *
+ * The volume must first be created with Create(), which writes the header,
+ * or opened with Open() to add or replace some chunks in an existing volume.
+ * The chunks can then be written with PutChunk(), or with WriteRegion() which
+ * writes all the chunks covered by the buffered region of an image.
+ *
+ * Each chunk is written in a temporary file which is then renamed, so
+ * several writers, in several threads or processes, can work on the same
+ * volume. A reader never sees a partially written chunk. WriteRegion()
+ * locks each chunk while it writes it, so writers whose regions share a
+ * chunk, like the ones of a volume split on a grid which doesn't match the
+ * chunk grid, don't lose each other's updates. PutChunk() doesn't lock the
+ * chunk: two writers must not put the same chunk.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa ChunkedVolumeReader, ChunkedVolumeHeader
+ * \ingroup IOFilters
+ */
+template<class TImage>
+class ITK_EXPORT ChunkedVolumeWriter : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ChunkedVolumeWriter Self;
+  typedef Object              Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::SizeType        SizeType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::SpacingType     SpacingType;
+  typedef typename ImageType::PointType       PointType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef ChunkedVolumeHeader< ImageDimension > HeaderType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(ChunkedVolumeWriter, Object);
+
+  /** Set/Get the directory of the chunked volume */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Set/Get the size of the chunks. This is only used by Create(). Default
+   * is 64 in all the dimensions. */
+  itkSetMacro(ChunkSize, SizeType);
+  itkGetConstReferenceMacro(ChunkSize, SizeType);
+
+  /** Set/Get whether the chunks are compressed with zlib. This is only used
+   * by Create(). Default is false. */
+  itkSetMacro(UseCompression, bool);
+  itkGetConstReferenceMacro(UseCompression, bool);
+  itkBooleanMacro(UseCompression);
+
+  /** Create a new volume with the given geometry, and write its header. The
+   * chunks of a volume previously stored in the same directory are
+   * removed. */
+  void Create( const RegionType & region, const SpacingType & spacing, const PointType & origin );
+
+  /** Create a new volume with the geometry of the image. The image content
+   * is not written. */
+  void Create( const ImageType * image );
+
+  /** Open an existing volume. */
+  void Open();
+
+  /** Write a chunk. The buffered region of the image must contain the region
+   * of the chunk. */
+  void PutChunk( const IndexType & chunkIndex, const ImageType * image );
+
+  /** Write all the chunks covered by the buffered region of the image. The
+   * chunks only partially covered are merged with their current content. */
+  void WriteRegion( const ImageType * image );
+
+  /** return the header of the volume */
+  const HeaderType & GetHeader() const
+    {
+    return m_Header;
+    }
+
+protected:
+  ChunkedVolumeWriter();
+  ~ChunkedVolumeWriter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+private:
+  ChunkedVolumeWriter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string m_FileName;
+  SizeType m_ChunkSize;
+  bool m_UseCompression;
+  bool m_Opened;
+  HeaderType m_Header;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkChunkedVolumeWriter.txx"
+#endif
+
+#endif
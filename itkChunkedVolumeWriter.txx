@@ -0,0 +1,209 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkChunkedVolumeWriter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkChunkedVolumeWriter_txx
+#define __itkChunkedVolumeWriter_txx
+
+#include "itkChunkedVolumeWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include <itksys/SystemTools.hxx>
+#include <itksys/Directory.hxx>
+
+namespace itk {
+
+template <class TImage>
+ChunkedVolumeWriter<TImage>
+::ChunkedVolumeWriter()
+{
+  m_FileName = "";
+  m_ChunkSize.Fill( 64 );
+  m_UseCompression = false;
+  m_Opened = false;
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::Create( const RegionType & region, const SpacingType & spacing, const PointType & origin )
+{
+  if( m_FileName == "" )
+    { itkExceptionMacro( << "FileName must be set." ); }
+
+  if( !itksys::SystemTools::MakeDirectory( m_FileName.c_str() ) )
+    { itkExceptionMacro( << "Can't create the directory " << m_FileName ); }
+
+  // remove the chunks of a previous volume
+  itksys::Directory directory;
+  directory.Load( m_FileName.c_str() );
+  for( unsigned long i=0; i<directory.GetNumberOfFiles(); i++ )
+    {
+    std::string name = directory.GetFile( i );
+    std::string ext = itksys::SystemTools::GetFilenameLastExtension( name );
+    if( name[0] == 'c' && ( ext == ".raw" || ext == ".zraw" || ext == ".lock" ) )
+      {
+      itksys::SystemTools::RemoveFile( ( m_FileName + "/" + name ).c_str() );
+      }
+    }
+
+  m_Header = HeaderType();
+  m_Header.m_Region = region;
+  for( unsigned int i=0; i<ImageDimension; i++ )
+    {
+    m_Header.m_Spacing[i] = spacing[i];
+    m_Header.m_Origin[i] = origin[i];
+    if( m_ChunkSize[i] == 0 )
+      { itkExceptionMacro( << "ChunkSize must not be 0." ); }
+    }
+  m_Header.m_ChunkSize = m_ChunkSize;
+  m_Header.m_PixelType = ChunkedVolumePixelTypeName< PixelType >();
+  m_Header.m_Compressed = m_UseCompression;
+
+  if( !m_Header.Write( m_FileName ) )
+    { itkExceptionMacro( << "Can't write the header in " << m_FileName ); }
+  m_Opened = true;
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::Create( const ImageType * image )
+{
+  this->Create( image->GetLargestPossibleRegion(), image->GetSpacing(), image->GetOrigin() );
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::Open()
+{
+  if( !m_Header.Read( m_FileName ) )
+    { itkExceptionMacro( << "Can't read the header of " << m_FileName ); }
+  if( m_Header.m_PixelType != ChunkedVolumePixelTypeName< PixelType >() )
+    {
+    itkExceptionMacro( << "The pixel type of " << m_FileName << " is " << m_Header.m_PixelType
+                       << ", not " << ChunkedVolumePixelTypeName< PixelType >() );
+    }
+  m_Opened = true;
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::PutChunk( const IndexType & chunkIndex, const ImageType * image )
+{
+  if( !m_Opened )
+    { itkExceptionMacro( << "The volume must be created or opened before writing a chunk." ); }
+
+  RegionType chunkRegion = m_Header.GetChunkRegion( chunkIndex );
+  if( !image->GetBufferedRegion().IsInside( chunkRegion ) )
+    { itkExceptionMacro( << "The image doesn't contain the chunk " << chunkIndex ); }
+
+  std::vector< PixelType > buffer( chunkRegion.GetNumberOfPixels() );
+  ImageRegionConstIterator< ImageType > it( image, chunkRegion );
+  typename std::vector< PixelType >::iterator bit = buffer.begin();
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++bit )
+    {
+    *bit = it.Get();
+    }
+
+  if( !m_Header.WriteChunk( m_FileName, chunkIndex, buffer ) )
+    { itkExceptionMacro( << "Can't write the chunk " << chunkIndex << " in " << m_FileName ); }
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::WriteRegion( const ImageType * image )
+{
+  if( !m_Opened )
+    { itkExceptionMacro( << "The volume must be created or opened before writing a region." ); }
+
+  RegionType region = image->GetBufferedRegion();
+  if( !region.Crop( m_Header.m_Region ) )
+    {
+    // nothing to write
+    return;
+    }
+
+  // iterate over the chunk grid
+  typedef Image< char, ImageDimension > GridType;
+  typename GridType::Pointer grid = GridType::New();
+  grid->SetRegions( m_Header.GetChunkGridRegion( region ) );
+  ImageRegionIteratorWithIndex< GridType > git( grid, grid->GetRequestedRegion() );
+  for( git.GoToBegin(); !git.IsAtEnd(); ++git )
+    {
+    const IndexType & chunkIndex = git.GetIndex();
+    RegionType chunkRegion = m_Header.GetChunkRegion( chunkIndex );
+
+    // another writer may update the same chunk: the read, the merge and the
+    // write of the chunk must not be interleaved with its own ones
+    ChunkedVolumeLock lock( m_Header.GetChunkLockFileName( m_FileName, chunkIndex ) );
+    if( !lock.IsLocked() )
+      { itkExceptionMacro( << "Can't lock the chunk " << chunkIndex << " in " << m_FileName ); }
+
+    if( region.IsInside( chunkRegion ) )
+      {
+      this->PutChunk( chunkIndex, image );
+      continue;
+      }
+
+    // the chunk is only partially covered: merge it with its current content
+    std::vector< PixelType > buffer;
+    if( !m_Header.ReadChunk( m_FileName, chunkIndex, buffer ) )
+      { itkExceptionMacro( << "Can't read the chunk " << chunkIndex << " in " << m_FileName ); }
+
+    typename ImageType::Pointer chunk = ImageType::New();
+    chunk->SetRegions( chunkRegion );
+    typename ImageType::PixelContainer::Pointer container = ImageType::PixelContainer::New();
+    container->SetImportPointer( &buffer[0], buffer.size(), false );
+    chunk->SetPixelContainer( container );
+
+    RegionType intersection = chunkRegion;
+    intersection.Crop( region );
+    ImageRegionConstIterator< ImageType > it( image, intersection );
+    ImageRegionIterator< ImageType > cit( chunk, intersection );
+    for( it.GoToBegin(), cit.GoToBegin(); !it.IsAtEnd(); ++it, ++cit )
+      {
+      cit.Set( it.Get() );
+      }
+
+    if( !m_Header.WriteChunk( m_FileName, chunkIndex, buffer ) )
+      { itkExceptionMacro( << "Can't write the chunk " << chunkIndex << " in " << m_FileName ); }
+    }
+}
+
+
+template <class TImage>
+void
+ChunkedVolumeWriter<TImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: "  << m_FileName << std::endl;
+  os << indent << "ChunkSize: "  << m_ChunkSize << std::endl;
+  os << indent << "UseCompression: "  << m_UseCompression << std::endl;
+}
+
+}// end namespace itk
+#endif
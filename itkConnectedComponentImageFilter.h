@@ -150,12 +150,30 @@ public:
   itkSetMacro(BackgroundValue, OutputImagePixelType);
   itkGetMacro(BackgroundValue, OutputImagePixelType);
 
+  /**
+   * Set/Get the maximum size, in bytes, of the run length encoding and of
+   * the union-find tables kept from one execution to the other. They are
+   * reused by the next execution, so a stream of images of the same size is
+   * labeled without large allocation. When they are larger than that size,
+   * they are released at the end of the execution. Default is the maximum
+   * of unsigned long.
+   */
+  itkSetMacro(MaximumScratchSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumScratchSize, unsigned long);
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  unsigned long GetScratchSize() const;
+
+  /** Release the scratch memory kept from the last execution */
+  void ReleaseScratch();
+
 protected:
   ConnectedComponentImageFilter() 
     {
     m_FullyConnected = false;
     m_ObjectCount = 0;
     m_BackgroundValue = NumericTraits< OutputImagePixelType >::Zero;
+    m_MaximumScratchSize = NumericTraits< unsigned long >::max();
     }
   virtual ~ConnectedComponentImageFilter() {}
   ConnectedComponentImageFilter(const Self&) {}
@@ -184,6 +202,7 @@ protected:
 private:
   unsigned long m_ObjectCount;
   OutputImagePixelType m_BackgroundValue;
+  unsigned long m_MaximumScratchSize;
 
   // some additional types
   typedef typename TOutputImage::RegionType::SizeType OutSizeType;
@@ -212,7 +231,8 @@ private:
   // functions to support union-find operations
   void InitUnion(const unsigned long int size) 
     {
-    m_UnionFind = UnionFindType(size + 1);
+    // assign() reuses the memory of the previous execution
+    m_UnionFind.assign(size + 1, 0);
     }
   void InsertSet(const unsigned long int label);
   unsigned long int LookupSet(const unsigned long int label);
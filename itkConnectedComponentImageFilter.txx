@@ -161,7 +161,9 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
     inLineIt.NextLine() )
     {
     inLineIt.GoToBeginOfLine();
-    lineEncoding ThisLine;
+    // the line is built in place, to reuse its memory
+    lineEncoding & ThisLine = m_LineMap[lineId];
+    ThisLine.clear();
     while (! inLineIt.IsAtEndOfLine())
       {
       InputPixelType PVal = inLineIt.Get();
@@ -194,7 +196,6 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
         ++inLineIt;
         }
       }
-    m_LineMap[lineId] = ThisLine;
     lineId++;
     progress.CompletedPixel();
     }
@@ -320,7 +321,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
       {
       // remove the region already joined
       typename std::vector< long > newFirstLineIdToJoin;
-      for( int i = 1; i<m_FirstLineIdToJoin.size(); i+=2 )
+      for( unsigned long i = 1; i<m_FirstLineIdToJoin.size(); i+=2 )
         {
         newFirstLineIdToJoin.push_back( m_FirstLineIdToJoin[i] );
         }
@@ -401,8 +402,39 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
 {
   m_NumberOfLabels.clear();
   m_Barrier = NULL;
-  m_LineMap.clear();
   m_Input = NULL;
+
+  // the line map and the union-find tables are kept for the next execution
+  if( this->GetScratchSize() > m_MaximumScratchSize )
+    {
+    this->ReleaseScratch();
+    }
+}
+
+
+template< class TInputImage, class TOutputImage, class TMaskImage >
+unsigned long
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
+::GetScratchSize() const
+{
+  unsigned long size = ( m_UnionFind.capacity() + m_Consecutive.capacity() ) * sizeof( unsigned long )
+    + m_LineMap.capacity() * sizeof( lineEncoding );
+  for( typename LineMapType::const_iterator it = m_LineMap.begin(); it != m_LineMap.end(); ++it )
+    {
+    size += it->capacity() * sizeof( runLength );
+    }
+  return size;
+}
+
+
+template< class TInputImage, class TOutputImage, class TMaskImage >
+void
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
+::ReleaseScratch()
+{
+  LineMapType().swap( m_LineMap );
+  UnionFindType().swap( m_UnionFind );
+  UnionFindType().swap( m_Consecutive );
 }
 
 
@@ -594,7 +626,7 @@ unsigned long int
 ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
 ::CreateConsecutive()
 {
-  m_Consecutive = UnionFindType(m_UnionFind.size());
+  m_Consecutive.assign(m_UnionFind.size(), 0);
   m_Consecutive[m_BackgroundValue] = m_BackgroundValue;
   unsigned long int CLab = 0;
   for (unsigned long int I = 1; I < m_UnionFind.size(); I++)
@@ -655,6 +687,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage>
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "ObjectCount: "  << m_ObjectCount << std::endl;
   os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "MaximumScratchSize: "  << m_MaximumScratchSize << std::endl;
 }
 
 } // end namespace itk
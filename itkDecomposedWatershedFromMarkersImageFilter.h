@@ -0,0 +1,238 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkDecomposedWatershedFromMarkersImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkDecomposedWatershedFromMarkersImageFilter_h
+#define __itkDecomposedWatershedFromMarkersImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkConnectivity.h"
+#include <string>
+#include <vector>
+
+namespace itk {
+
+/** \class DecomposedWatershedFromMarkersImageFilter
+ * \brief Morphological watershed from markers computed by several processes
+ *
+ * This filter computes the transform of
+ * MorphologicalWatershedFromMarkersImageFilter, but splits the work between
+ * several worker processes. It acts as the coordinator:
+ *
+ *  - the input and marker images are written to memory mapped files in a
+ *    working directory, so the workers can share them without copy;
+ *  - the image is split in slabs along its last dimension, and each slab is
+ *    extended by a halo of HaloSize slices on both sides;
+ *  - one worker process is forked for each slab. It maps the shared files,
+ *    floods its extended slab with the propagation of
+ *    MorphologicalWatershedFromMarkersImageFilter, writes the labels of its
+ *    own slab in the shared label file, and writes in a small file whether
+ *    these labels are proven to be exact;
+ *  - the slabs which are not proven exact are flooded again, with their halo
+ *    doubled.
+ *
+ * The flooding processes the pixels in the increasing order of their key in
+ * the hierarchical queue. The rest of the image can only enter the extended
+ * slab through the slices where the halo is cut, with a key at least equal
+ * to the lowest value of these slices: all the pixels put in the queue with
+ * a lower key are labeled exactly like in the flooding of the whole image.
+ * A slab is exact when all its pixels are markers or are put in the queue
+ * with such a key, and it is always exact once its halo covers the whole
+ * image. The output is thus the same as the one of
+ * MorphologicalWatershedFromMarkersImageFilter, with the default
+ * HIERARCHICAL_QUEUE flooding method. A slab is proven in the first round
+ * when the cut slices of its halo are higher than the flooding level of all
+ * its pixels; otherwise its halo grows until it reaches such slices.
+ *
+ * The workers only communicate through the files of the working directory, so
+ * a worker can be run on any node which can map them. The working
+ * directory, its files and the mappings are removed when the filter fails.
+ *
+ * This filter requires a POSIX system (mmap() and fork()). The workers are
+ * forked, not executed: fork() only duplicates the calling thread, so the
+ * filter must not be updated while other threads of the process may hold a
+ * lock, like the threads of a MultiThreader running another filter, or a
+ * worker could deadlock. Update it from the main thread, with no other
+ * pipeline running.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TLabelImage>
+class ITK_EXPORT DecomposedWatershedFromMarkersImageFilter :
+    public ImageToImageFilter<TInputImage, TLabelImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef DecomposedWatershedFromMarkersImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TLabelImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TLabelImage LabelImageType;
+  typedef typename InputImageType::Pointer        InputImagePointer;
+  typedef typename InputImageType::ConstPointer   InputImageConstPointer;
+  typedef typename InputImageType::RegionType     InputImageRegionType;
+  typedef typename InputImageType::PixelType      InputImagePixelType;
+  typedef typename LabelImageType::Pointer        LabelImagePointer;
+  typedef typename LabelImageType::ConstPointer   LabelImageConstPointer;
+  typedef typename LabelImageType::RegionType     LabelImageRegionType;
+  typedef typename LabelImageType::PixelType      LabelImagePixelType;
+
+  typedef typename LabelImageType::IndexType      IndexType;
+  typedef typename LabelImageType::SizeType       SizeType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  typedef Connectivity< ImageDimension > ConnectivityType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(DecomposedWatershedFromMarkersImageFilter,
+               ImageToImageFilter);
+
+   /** Set the marker image */
+  void SetMarkerImage(TLabelImage *input)
+     {
+     // Process object is not const-correct so the const casting is required.
+     this->SetNthInput( 1, const_cast<TLabelImage *>(input) );
+     }
+
+  /** Get the marker image */
+  LabelImageType * GetMarkerImage()
+    {
+    return static_cast<LabelImageType*>(const_cast<DataObject *>(this->ProcessObject::GetInput(1)));
+    }
+
+   /** Set the input image */
+  void SetInput1(TInputImage *input)
+     {
+     this->SetInput( input );
+     }
+
+   /** Set the marker image */
+  void SetInput2(TLabelImage *input)
+     {
+     this->SetMarkerImage( input );
+     }
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.  For objects that are 1 pixel wide, use
+   * FullyConnectedOn.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get whether the watershed pixel must be marked or not. Default
+   * is true.
+   */
+  itkSetMacro(MarkWatershedLine, bool);
+  itkGetConstReferenceMacro(MarkWatershedLine, bool);
+  itkBooleanMacro(MarkWatershedLine);
+
+  itkSetMacro(BackgroundValue, LabelImagePixelType);
+  itkGetMacro(BackgroundValue, LabelImagePixelType);
+
+  /**
+   * Set/Get the number of worker processes, and so the number of slabs.
+   * Default is 2.
+   */
+  itkSetClampMacro(NumberOfProcesses, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstReferenceMacro(NumberOfProcesses, unsigned int);
+
+  /**
+   * Set/Get the initial number of slices added on each side of a slab.
+   * Default is 16.
+   */
+  itkSetMacro(HaloSize, unsigned long);
+  itkGetConstReferenceMacro(HaloSize, unsigned long);
+
+  /**
+   * Set/Get the directory where the shared files are created. Default is
+   * the TMPDIR environment variable, or /tmp.
+   */
+  itkSetStringMacro(WorkingDirectory);
+  itkGetStringMacro(WorkingDirectory);
+
+  /**
+   * Get the number of flooding rounds needed to prove all the slabs exact
+   * in the last execution.
+   */
+  itkGetConstReferenceMacro(NumberOfRounds, unsigned int);
+
+  /**
+   * Get the halo size with which each slab has been proven exact in the
+   * last execution.
+   */
+  const std::vector< unsigned long > & GetHaloSizes() const
+    {
+    return m_HaloSizes;
+    }
+
+protected:
+  DecomposedWatershedFromMarkersImageFilter();
+  ~DecomposedWatershedFromMarkersImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The filter needs all the input and marker images. */
+  void GenerateInputRequestedRegion();
+
+  /** The filter produces all the output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+
+  void GenerateData();
+
+  /** Flood one slab, and write whether its labels are exact. This method is
+   * run in the worker process. It returns false if the slab can't be
+   * processed. */
+  bool FloodSlab( const std::string & directory, unsigned int slab,
+                  const InputImageRegionType & region, unsigned long halo );
+
+private:
+  DecomposedWatershedFromMarkersImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  bool m_FullyConnected;
+  bool m_MarkWatershedLine;
+  LabelImagePixelType m_BackgroundValue;
+  unsigned int m_NumberOfProcesses;
+  unsigned long m_HaloSize;
+  std::string m_WorkingDirectory;
+
+  unsigned int m_NumberOfRounds;
+  std::vector< unsigned long > m_HaloSizes;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkDecomposedWatershedFromMarkersImageFilter.txx"
+#endif
+
+#endif
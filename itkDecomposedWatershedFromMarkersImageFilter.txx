@@ -0,0 +1,552 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkDecomposedWatershedFromMarkersImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkDecomposedWatershedFromMarkersImageFilter_txx
+#define __itkDecomposedWatershedFromMarkersImageFilter_txx
+
+#include "itkDecomposedWatershedFromMarkersImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkImportImageContainer.h"
+#include "itkImageForestingTransform.h"
+#include "itkImageForestingTransformPathCost.h"
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace itk {
+
+/** Map a whole file in memory. If size is not 0, the file is created
+ * with that size. Returns 0 on failure. */
+inline void * DecomposedWatershedMapFile( const std::string & fileName, size_t size, bool writable )
+{
+  int fd;
+  if( size != 0 )
+    {
+    fd = open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600 );
+    if( fd < 0 || ftruncate( fd, size ) != 0 )
+      {
+      if( fd >= 0 )
+        { close( fd ); }
+      return 0;
+      }
+    }
+  else
+    {
+    fd = open( fileName.c_str(), writable ? O_RDWR : O_RDONLY );
+    struct stat st;
+    if( fd < 0 || fstat( fd, &st ) != 0 )
+      {
+      if( fd >= 0 )
+        { close( fd ); }
+      return 0;
+      }
+    size = st.st_size;
+    }
+  int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void * ptr = mmap( 0, size, prot, MAP_SHARED, fd, 0 );
+  // the mapping stays valid after the file descriptor is closed
+  close( fd );
+  if( ptr == MAP_FAILED )
+    {
+    return 0;
+    }
+  return ptr;
+}
+
+/** Unmap a file mapped with DecomposedWatershedMapFile() when leaving the
+ * scope, even with an exception. */
+class DecomposedWatershedMapping
+{
+public:
+  DecomposedWatershedMapping( void * ptr, size_t size )
+    {
+    m_Pointer = ptr;
+    m_Size = size;
+    }
+  ~DecomposedWatershedMapping()
+    {
+    this->Release();
+    }
+  void * GetPointer() const
+    {
+    return m_Pointer;
+    }
+  void Release()
+    {
+    if( m_Pointer )
+      {
+      munmap( m_Pointer, m_Size );
+      m_Pointer = 0;
+      }
+    }
+private:
+  DecomposedWatershedMapping(const DecomposedWatershedMapping&); //purposely not implemented
+  void operator=(const DecomposedWatershedMapping&); //purposely not implemented
+  void * m_Pointer;
+  size_t m_Size;
+};
+
+/** Remove the shared files and the working directory when leaving the
+ * scope, even with an exception. */
+class DecomposedWatershedWorkingDirectory
+{
+public:
+  DecomposedWatershedWorkingDirectory( const std::string & directory, unsigned int nbOfSlabs )
+    {
+    m_Directory = directory;
+    m_NumberOfSlabs = nbOfSlabs;
+    }
+  ~DecomposedWatershedWorkingDirectory()
+    {
+    remove( ( m_Directory + "/input.raw" ).c_str() );
+    remove( ( m_Directory + "/markers.raw" ).c_str() );
+    remove( ( m_Directory + "/labels.raw" ).c_str() );
+    for( unsigned int i=0; i<m_NumberOfSlabs; i++ )
+      {
+      std::ostringstream exactName;
+      exactName << m_Directory << "/exact-" << i << ".raw";
+      remove( exactName.str().c_str() );
+      }
+    rmdir( m_Directory.c_str() );
+    }
+private:
+  DecomposedWatershedWorkingDirectory(const DecomposedWatershedWorkingDirectory&); //purposely not implemented
+  void operator=(const DecomposedWatershedWorkingDirectory&); //purposely not implemented
+  std::string m_Directory;
+  unsigned int m_NumberOfSlabs;
+};
+
+/** The path cost of the flooding, which also stores the key of each pixel
+ * when it is put in the queue. The key of a pixel never changes once it is
+ * in the queue. */
+template <class TInputImage, class TLabelImage>
+class DecomposedWatershedPathCost : public MaxArcPathCost< TInputImage, TLabelImage >
+{
+public:
+  typedef MaxArcPathCost< TInputImage, TLabelImage > Superclass;
+  typedef typename Superclass::KeyType              KeyType;
+  typedef typename Superclass::LabelImagePixelType  LabelImagePixelType;
+
+  void SetKeys( KeyType * keys )
+    {
+    m_Keys = keys;
+    }
+
+  inline KeyType SeedNeighbor( unsigned long p, unsigned long n, unsigned int i, const LabelImagePixelType & label ) const
+    {
+    return m_Keys[n] = Superclass::SeedNeighbor( p, n, i, label );
+    }
+
+  inline KeyType Extend( const KeyType & k, unsigned long p, unsigned long n, unsigned int i, const LabelImagePixelType & label ) const
+    {
+    return m_Keys[n] = Superclass::Extend( k, p, n, i, label );
+    }
+
+  inline bool Relax( const KeyType & k, unsigned long p, unsigned long n, unsigned int i, bool reached,
+                     const LabelImagePixelType & label, KeyType & nk )
+    {
+    if( !Superclass::Relax( k, p, n, i, reached, label, nk ) )
+      { return false; }
+    m_Keys[n] = nk;
+    return true;
+    }
+
+private:
+  KeyType * m_Keys;
+};
+
+
+/** Wait for the end of the worker processes, and return false if one of
+ * them has failed. */
+inline bool DecomposedWatershedWaitForWorkers( const std::vector< pid_t > & workers )
+{
+  bool ok = true;
+  for( unsigned int i=0; i<workers.size(); i++ )
+    {
+    int status;
+    if( waitpid( workers[i], &status, 0 ) < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+      { ok = false; }
+    }
+  return ok;
+}
+
+
+template <class TInputImage, class TLabelImage>
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::DecomposedWatershedFromMarkersImageFilter()
+{
+  this->SetNumberOfRequiredInputs(2);
+  m_FullyConnected = false;
+  m_MarkWatershedLine = true;
+  m_BackgroundValue = NumericTraits< LabelImagePixelType >::Zero;
+  m_NumberOfProcesses = 2;
+  m_HaloSize = 16;
+  m_WorkingDirectory = "";
+  m_NumberOfRounds = 0;
+}
+
+
+template <class TInputImage, class TLabelImage>
+void
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // get pointers to the inputs
+  LabelImagePointer  markerPtr = this->GetMarkerImage();
+
+  InputImagePointer  inputPtr =
+    const_cast< InputImageType * >( this->GetInput() );
+
+  if ( !markerPtr || !inputPtr )
+    { return; }
+
+  markerPtr->SetRequestedRegion(markerPtr->GetLargestPossibleRegion());
+  inputPtr->SetRequestedRegion(inputPtr->GetLargestPossibleRegion());
+}
+
+
+template <class TInputImage, class TLabelImage>
+void
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TLabelImage>
+void
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  const LabelImageType * markers = this->GetMarkerImage();
+  LabelImageType * output = this->GetOutput();
+
+  if ( markers->GetRequestedRegion().GetSize() != input->GetRequestedRegion().GetSize() )
+    { itkExceptionMacro( << "Marker and input must have the same size." ); }
+
+  const InputImageRegionType region = input->GetRequestedRegion();
+  const unsigned int last = ImageDimension - 1;
+  const unsigned long nbOfSlices = region.GetSize()[last];
+  const size_t nbOfPixels = region.GetNumberOfPixels();
+  const unsigned int nbOfSlabs = std::min( (unsigned long)m_NumberOfProcesses, nbOfSlices );
+
+  //---------------------------------------------------------------------------
+  // create the working directory and the shared files
+  //---------------------------------------------------------------------------
+  std::string base = m_WorkingDirectory;
+  if( base.empty() )
+    {
+    const char * tmp = getenv( "TMPDIR" );
+    base = tmp ? tmp : "/tmp";
+    }
+  std::string dirTemplate = base + "/itkDecomposedWatershed-XXXXXX";
+  std::vector< char > dirBuffer( dirTemplate.begin(), dirTemplate.end() );
+  dirBuffer.push_back( '\0' );
+  if( mkdtemp( &dirBuffer[0] ) == 0 )
+    { itkExceptionMacro( << "Can't create a working directory in " << base ); }
+  const std::string directory( &dirBuffer[0] );
+  // removed on all the exits of this method
+  DecomposedWatershedWorkingDirectory workingDirectory( directory, nbOfSlabs );
+
+  const size_t inputBytes = nbOfPixels * sizeof( InputImagePixelType );
+  const size_t labelBytes = nbOfPixels * sizeof( LabelImagePixelType );
+  {
+  DecomposedWatershedMapping inputMap( DecomposedWatershedMapFile( directory + "/input.raw", inputBytes, true ), inputBytes );
+  DecomposedWatershedMapping markerMap( DecomposedWatershedMapFile( directory + "/markers.raw", labelBytes, true ), labelBytes );
+  DecomposedWatershedMapping labelMap( DecomposedWatershedMapFile( directory + "/labels.raw", labelBytes, true ), labelBytes );
+  if( !inputMap.GetPointer() || !markerMap.GetPointer() || !labelMap.GetPointer() )
+    { itkExceptionMacro( << "Can't map the shared files in " << directory ); }
+  memcpy( inputMap.GetPointer(), input->GetBufferPointer(), inputBytes );
+  memcpy( markerMap.GetPointer(), markers->GetBufferPointer(), labelBytes );
+  // the coordinator doesn't need them anymore - the workers map them by themselves
+  }
+
+  // the slabs are [ slabBegin[i], slabBegin[i+1] [ along the last dimension
+  std::vector< unsigned long > slabBegin( nbOfSlabs + 1 );
+  for( unsigned int i=0; i<=nbOfSlabs; i++ )
+    {
+    slabBegin[i] = ( nbOfSlices * i ) / nbOfSlabs;
+    }
+  m_HaloSizes.assign( nbOfSlabs, m_HaloSize );
+  std::vector< bool > dirty( nbOfSlabs, true );
+
+  // the progress is reported for the first round and for the final copy; the
+  // next rounds, if any, are usually much shorter
+  ProgressReporter progress( this, 0, nbOfSlabs * 2 );
+
+  m_NumberOfRounds = 0;
+  bool done = false;
+  while( !done )
+    {
+    m_NumberOfRounds++;
+
+    //-------------------------------------------------------------------------
+    // flood the dirty slabs in the worker processes
+    //-------------------------------------------------------------------------
+    std::vector< pid_t > workers;
+    for( unsigned int i=0; i<nbOfSlabs; i++ )
+      {
+      if( !dirty[i] )
+        { continue; }
+      IndexType slabIndex = region.GetIndex();
+      SizeType slabSize = region.GetSize();
+      slabIndex[last] += slabBegin[i];
+      slabSize[last] = slabBegin[i+1] - slabBegin[i];
+      InputImageRegionType slabRegion( slabIndex, slabSize );
+
+      pid_t pid = fork();
+      if( pid == 0 )
+        {
+        // worker process - don't return in the caller code, even on error
+        bool ok = false;
+        try
+          {
+          ok = this->FloodSlab( directory, i, slabRegion, m_HaloSizes[i] );
+          }
+        catch( ... )
+          {
+          ok = false;
+          }
+        _exit( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+        }
+      if( pid < 0 )
+        {
+        // the workers already started use the working directory: wait for
+        // them before removing it
+        DecomposedWatershedWaitForWorkers( workers );
+        itkExceptionMacro( << "Can't create a worker process." );
+        }
+      workers.push_back( pid );
+      }
+
+    if( !DecomposedWatershedWaitForWorkers( workers ) )
+      { itkExceptionMacro( << "A worker process has failed." ); }
+
+    //-------------------------------------------------------------------------
+    // flood again, with a larger halo, the slabs whose labels may have been
+    // changed by the cut of their halo
+    //-------------------------------------------------------------------------
+    done = true;
+    for( unsigned int i=0; i<nbOfSlabs; i++ )
+      {
+      if( m_NumberOfRounds == 1 )
+        { progress.CompletedPixel(); }
+      if( !dirty[i] )
+        { continue; }
+      std::ostringstream exactName;
+      exactName << directory << "/exact-" << i << ".raw";
+      std::ifstream exactFile( exactName.str().c_str(), std::ios::binary );
+      char exact = 0;
+      exactFile.read( &exact, 1 );
+      if( !exactFile )
+        { itkExceptionMacro( << "Can't read " << exactName.str() ); }
+      dirty[i] = !exact;
+      if( dirty[i] )
+        {
+        m_HaloSizes[i] = std::max( m_HaloSizes[i] * 2, (unsigned long)1 );
+        done = false;
+        }
+      }
+    }
+
+  //---------------------------------------------------------------------------
+  // copy the labels of the slabs to the output. The working directory is
+  // cleaned up on return.
+  //---------------------------------------------------------------------------
+  DecomposedWatershedMapping labelMap( DecomposedWatershedMapFile( directory + "/labels.raw", 0, false ), labelBytes );
+  if( !labelMap.GetPointer() )
+    { itkExceptionMacro( << "Can't map the shared files in " << directory ); }
+  memcpy( output->GetBufferPointer(), labelMap.GetPointer(), labelBytes );
+  for( unsigned int i=0; i<nbOfSlabs; i++ )
+    {
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TLabelImage>
+bool
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::FloodSlab( const std::string & directory, unsigned int slab,
+             const InputImageRegionType & slabRegion, unsigned long halo )
+{
+  const InputImageRegionType region = this->GetInput()->GetRequestedRegion();
+  const unsigned int last = ImageDimension - 1;
+  const unsigned long nbOfSlices = region.GetSize()[last];
+  const size_t sliceSize = region.GetNumberOfPixels() / nbOfSlices;
+
+  // the slab, extended by the halo, in slice numbers relative to the image
+  const unsigned long slabBegin = slabRegion.GetIndex()[last] - region.GetIndex()[last];
+  const unsigned long slabEnd = slabBegin + slabRegion.GetSize()[last];
+  const unsigned long begin = slabBegin >= halo ? slabBegin - halo : 0;
+  const unsigned long end = std::min( slabEnd + halo, nbOfSlices );
+
+  IndexType extendedIndex = region.GetIndex();
+  SizeType extendedSize = region.GetSize();
+  extendedIndex[last] += begin;
+  extendedSize[last] = end - begin;
+  InputImageRegionType extendedRegion( extendedIndex, extendedSize );
+  const size_t nbOfPixels = extendedRegion.GetNumberOfPixels();
+
+  // map the shared files. The mappings are released when the worker exits.
+  InputImagePixelType * inputMap = static_cast< InputImagePixelType * >(
+    DecomposedWatershedMapFile( directory + "/input.raw", 0, false ) );
+  LabelImagePixelType * markerMap = static_cast< LabelImagePixelType * >(
+    DecomposedWatershedMapFile( directory + "/markers.raw", 0, false ) );
+  LabelImagePixelType * labelMap = static_cast< LabelImagePixelType * >(
+    DecomposedWatershedMapFile( directory + "/labels.raw", 0, true ) );
+  if( !inputMap || !markerMap || !labelMap )
+    { return false; }
+
+  // wrap the extended slab in images, without copy: the slabs are contiguous
+  // in the files because they are cut along the last dimension
+  typename InputImageType::Pointer inputSlab = InputImageType::New();
+  inputSlab->SetRegions( extendedRegion );
+  typename InputImageType::PixelContainer::Pointer inputContainer = InputImageType::PixelContainer::New();
+  inputContainer->SetImportPointer( inputMap + begin * sliceSize, nbOfPixels, false );
+  inputSlab->SetPixelContainer( inputContainer );
+
+  typename LabelImageType::Pointer markerSlab = LabelImageType::New();
+  markerSlab->SetRegions( extendedRegion );
+  typename LabelImageType::PixelContainer::Pointer markerContainer = LabelImageType::PixelContainer::New();
+  markerContainer->SetImportPointer( markerMap + begin * sliceSize, nbOfPixels, false );
+  markerSlab->SetPixelContainer( markerContainer );
+
+  typename LabelImageType::Pointer labelSlab = LabelImageType::New();
+  labelSlab->SetRegions( extendedRegion );
+  labelSlab->Allocate();
+
+  // the same propagation as MorphologicalWatershedFromMarkersImageFilter, with
+  // the key of each pixel kept. The pixels never put in the queue keep the
+  // maximum key.
+  typedef DecomposedWatershedPathCost< InputImageType, LabelImageType > PathCostType;
+  std::vector< InputImagePixelType > keys( nbOfPixels, NumericTraits< InputImagePixelType >::max() );
+  typename ConnectivityType::Pointer connectivity = ConnectivityType::New();
+  connectivity->SetFullyConnected( m_FullyConnected );
+  // the worker doesn't report its progress: only the thread 0 of a
+  // reporter does
+  ProgressReporter progress( this, 1, nbOfPixels * 2 );
+  if( m_MarkWatershedLine )
+    {
+    ImageForestingTransform< InputImageType, LabelImageType, PathCostType, WatershedLineTieBreak > ift;
+    ift.SetInput( inputSlab );
+    ift.SetMarkerImage( markerSlab );
+    ift.SetOutput( labelSlab );
+    ift.SetConnectivity( connectivity );
+    ift.SetBackgroundValue( m_BackgroundValue );
+    ift.GetPathCost().SetKeys( &keys[0] );
+    ift.Compute( progress );
+    }
+  else
+    {
+    ImageForestingTransform< InputImageType, LabelImageType, PathCostType, FirstComeTieBreak > ift;
+    ift.SetInput( inputSlab );
+    ift.SetMarkerImage( markerSlab );
+    ift.SetOutput( labelSlab );
+    ift.SetConnectivity( connectivity );
+    ift.SetBackgroundValue( m_BackgroundValue );
+    ift.GetPathCost().SetKeys( &keys[0] );
+    ift.Compute( progress );
+    }
+  const LabelImagePixelType * result = labelSlab->GetBufferPointer();
+  const LabelImagePixelType * markers = markerSlab->GetBufferPointer();
+  const InputImagePixelType * values = inputSlab->GetBufferPointer();
+
+  // the slab goes to the shared label file
+  memcpy( labelMap + slabBegin * sliceSize, result + ( slabBegin - begin ) * sliceSize,
+          ( slabEnd - slabBegin ) * sliceSize * sizeof( LabelImagePixelType ) );
+
+  // The rest of the image can only reach the extended slab through its
+  // first and last slices, when they are cut, and only put their pixels in
+  // the queue with a key at least equal to their value. The keys are never
+  // lower than the key of the pixel which puts them in the queue, so all
+  // the pixels put in the queue with a lower key than the lowest value of
+  // the cut slices get the same label, in the same order, as in the
+  // flooding of the whole image. The markers are never put in the queue by
+  // another pixel, and are not considered.
+  bool cut = false;
+  InputImagePixelType cutLevel = NumericTraits< InputImagePixelType >::max();
+  for( unsigned int side=0; side<2; side++ )
+    {
+    if( ( side == 0 && begin == 0 ) || ( side == 1 && end == nbOfSlices ) )
+      { continue; }
+    const size_t first = side == 0 ? 0 : ( end - begin - 1 ) * sliceSize;
+    for( size_t p=first; p<first+sliceSize; p++ )
+      {
+      if( markers[p] == m_BackgroundValue )
+        {
+        cutLevel = cut ? std::min( cutLevel, values[p] ) : values[p];
+        cut = true;
+        }
+      }
+    }
+
+  // the slab is exact if all its pixels are proven to be
+  char exact = 1;
+  if( cut )
+    {
+    for( size_t p=( slabBegin - begin ) * sliceSize; p<( slabEnd - begin ) * sliceSize && exact; p++ )
+      {
+      if( markers[p] == m_BackgroundValue && !( keys[p] < cutLevel ) )
+        {
+        exact = 0;
+        }
+      }
+    }
+
+  std::ostringstream exactName;
+  exactName << directory << "/exact-" << slab << ".raw";
+  std::ofstream exactFile( exactName.str().c_str(), std::ios::binary | std::ios::trunc );
+  exactFile.write( &exact, 1 );
+  exactFile.close();
+  return !exactFile.fail();
+}
+
+
+template<class TInputImage, class TLabelImage>
+void
+DecomposedWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<LabelImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "NumberOfProcesses: "  << m_NumberOfProcesses << std::endl;
+  os << indent << "HaloSize: "  << m_HaloSize << std::endl;
+  os << indent << "WorkingDirectory: "  << m_WorkingDirectory << std::endl;
+  os << indent << "NumberOfRounds: "  << m_NumberOfRounds << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,227 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkGeodesicChamferDistanceImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkGeodesicChamferDistanceImageFilter_h
+#define __itkGeodesicChamferDistanceImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include <vector>
+
+namespace itk {
+
+/** \class GeodesicChamferDistanceImageFilter
+ * \brief Geodesic distance in a mask, computed with a chamfer mask
+ *
+ * The distance is the length of the shortest path which stays in the mask
+ * (the pixels of the input with the ForegroundValue), so it follows the
+ * shape of the non convex objects where the euclidean distance crosses
+ * their concavities. The path is made of the steps of a chamfer mask: all
+ * the offsets of the 3x3 (or 3x3x3) neighborhood with a NeighborhoodRadius
+ * of 1, and also the offsets of the 5x5 (or 5x5x5) neighborhood which are
+ * not a multiple of a smaller one with a NeighborhoodRadius of 2, for a
+ * better approximation of the euclidean length. Each step weights its
+ * euclidean length, in physical units when UseImageSpacing is true. A step
+ * of the 5x5 neighborhood, like (2,1), passes between the pixels of the
+ * 3x3 one, (1,0) and (1,1): it is only used when those pixels are also in
+ * the mask, so a path can't jump over a background wall one pixel thick.
+ *
+ * The distance is propagated with alternated forward and backward raster
+ * scans, each one using the half of the chamfer mask already visited. Two
+ * scans are enough for a convex mask, but a geodesic path can turn back
+ * several times in the concavities, so the scans are repeated until they
+ * don't change the distance anymore, or until MaximumNumberOfIterations
+ * pairs of scans have been done. GetNumberOfIterations() returns the number
+ * of pairs of scans of the last update, the last one being the one which
+ * has checked the convergence.
+ *
+ * The distance is computed from the pixels of the optional marker image
+ * which are not 0, given with SetMarkerImage(), or, without marker image,
+ * from the border of the mask: the pixels outside the mask are at a
+ * distance of 0, and the mask pixels at the distance of their nearest pixel
+ * outside the mask. The pixels outside the image are not part of that
+ * border. The pixels outside the mask are set to 0 in the output, and the
+ * mask pixels which can't be reached from a marker to the maximum of the
+ * output pixel type.
+ *
+ * The scans are sequential: GeodesicChamferDistanceLabelMapFilter computes
+ * the distance of the objects of a label map in parallel.
+ *
+ * See "Distance transformations in digital images", G. Borgefors, Computer
+ * Vision, Graphics, and Image Processing, 1986.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa GeodesicChamferDistanceLabelMapFilter, SignedMaurerDistanceMapImageFilter
+ * \ingroup ImageFeatureExtraction
+ */
+template<class TInputImage, class TOutputImage, class TMarkerImage=TInputImage>
+class ITK_EXPORT GeodesicChamferDistanceImageFilter :
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef GeodesicChamferDistanceImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef TMarkerImage MarkerImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename MarkerImageType::PixelType      MarkerImagePixelType;
+  typedef typename OutputImageType::IndexType      IndexType;
+  typedef typename OutputImageType::SizeType       SizeType;
+  typedef typename OutputImageType::OffsetType     OffsetType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(GeodesicChamferDistanceImageFilter,
+               ImageToImageFilter);
+
+  /** Set the marker image. The marker image is optional. */
+  void SetMarkerImage(const TMarkerImage *input)
+     {
+     // Process object is not const-correct so the const casting is required.
+     this->SetNthInput( 1, const_cast<TMarkerImage *>(input) );
+     }
+
+  /** Get the marker image */
+  const MarkerImageType * GetMarkerImage() const
+    {
+    return static_cast<const MarkerImageType*>(this->ProcessObject::GetInput(1));
+    }
+
+   /** Set the input image */
+  void SetInput1(const TInputImage *input)
+     {
+     this->SetInput( input );
+     }
+
+   /** Set the marker image */
+  void SetInput2(const TMarkerImage *input)
+     {
+     this->SetMarkerImage( input );
+     }
+
+  /**
+   * Set/Get the value of the mask pixels in the input image. Default is
+   * the maximum of the input pixel type.
+   */
+  itkSetMacro(ForegroundValue, InputImagePixelType);
+  itkGetMacro(ForegroundValue, InputImagePixelType);
+
+  /**
+   * Set/Get the radius of the chamfer mask: 1 for the 3x3 mask, 2 for the
+   * 5x5 mask. Default is 1.
+   */
+  itkSetClampMacro(NeighborhoodRadius, unsigned int, 1, 2);
+  itkGetConstReferenceMacro(NeighborhoodRadius, unsigned int);
+
+  /**
+   * Set/Get whether the distance is computed using the image spacing.
+   * Default is true.
+   */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /**
+   * Set/Get the maximum number of pairs of forward and backward scans.
+   * Default is the maximum of unsigned long: the scans are repeated until
+   * convergence.
+   */
+  itkSetMacro(MaximumNumberOfIterations, unsigned long);
+  itkGetConstReferenceMacro(MaximumNumberOfIterations, unsigned long);
+
+  /** Get the number of pairs of scans done during the last update */
+  itkGetConstReferenceMacro(NumberOfIterations, unsigned long);
+
+protected:
+  GeodesicChamferDistanceImageFilter();
+  ~GeodesicChamferDistanceImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** GeodesicChamferDistanceImageFilter needs the entire input be
+   * available. Thus, it needs to provide an implementation of
+   * GenerateInputRequestedRegion(). */
+  void GenerateInputRequestedRegion() ;
+
+  /** GeodesicChamferDistanceImageFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+
+  void GenerateData();
+
+  /** Build the half of the chamfer mask used by the forward scan: the
+   * offsets to the pixels visited before the current one. The backward scan
+   * uses their opposite. */
+  void ComputeChamferMask();
+
+  /** Run a forward or a backward scan, and return true if a distance has
+   * been changed */
+  bool RasterScan( bool forward );
+
+private:
+  GeodesicChamferDistanceImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  InputImagePixelType m_ForegroundValue;
+
+  unsigned int m_NeighborhoodRadius;
+
+  bool m_UseImageSpacing;
+
+  unsigned long m_MaximumNumberOfIterations;
+
+  unsigned long m_NumberOfIterations;
+
+  // the half chamfer mask, with the offset in the buffer and the weight of
+  // each step, and the offsets of the pixels a long step passes between
+  std::vector< OffsetType > m_Neighbors;
+  std::vector< long > m_Offsets;
+  std::vector< double > m_Weights;
+  std::vector< std::vector< long > > m_Intermediates;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkGeodesicChamferDistanceImageFilter.txx"
+#endif
+
+#endif
+
+
@@ -0,0 +1,347 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkGeodesicChamferDistanceImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkGeodesicChamferDistanceImageFilter_txx
+#define __itkGeodesicChamferDistanceImageFilter_txx
+
+#include "itkGeodesicChamferDistanceImageFilter.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage, class TMarkerImage>
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::GeodesicChamferDistanceImageFilter()
+{
+  m_ForegroundValue = NumericTraits< InputImagePixelType >::max();
+  m_NeighborhoodRadius = 1;
+  m_UseImageSpacing = true;
+  m_MaximumNumberOfIterations = NumericTraits< unsigned long >::max();
+  m_NumberOfIterations = 0;
+}
+
+
+template <class TInputImage, class TOutputImage, class TMarkerImage>
+void
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast<InputImageType *>(this->GetInput());
+  if ( !input )
+    { return; }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+
+  // the marker is optional
+  MarkerImageType * marker = const_cast< MarkerImageType * >( this->GetMarkerImage() );
+  if( marker )
+    {
+    marker->SetRequestedRegion( marker->GetLargestPossibleRegion() );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage, class TMarkerImage>
+void
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+    ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TOutputImage, class TMarkerImage>
+void
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  const MarkerImageType * markerImage = this->GetMarkerImage();
+  OutputImageType * output = this->GetOutput();
+
+  // the pixels are identified by their offset in the buffers, which must
+  // be the same
+  if( input->GetBufferedRegion().GetSize() != output->GetBufferedRegion().GetSize() )
+    { itkExceptionMacro( << "Input and output must have the same buffered region." ); }
+  if( markerImage && markerImage->GetBufferedRegion().GetSize() != output->GetBufferedRegion().GetSize() )
+    { itkExceptionMacro( << "Marker and input must have the same size." ); }
+
+  const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+  const InputImagePixelType * mask = input->GetBufferPointer();
+  const MarkerImagePixelType * markers = markerImage ? markerImage->GetBufferPointer() : NULL;
+  OutputImagePixelType * distance = output->GetBufferPointer();
+  const OutputImagePixelType infinity = NumericTraits< OutputImagePixelType >::max();
+
+  // the seeds are at 0, and the other mask pixels are not reached yet
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( mask[p] != m_ForegroundValue
+        || ( markers && markers[p] != NumericTraits< MarkerImagePixelType >::Zero ) )
+      {
+      distance[p] = NumericTraits< OutputImagePixelType >::Zero;
+      }
+    else
+      {
+      distance[p] = infinity;
+      }
+    }
+
+  this->ComputeChamferMask();
+
+  // the last pair of scans changes nothing, and checks the convergence
+  m_NumberOfIterations = 0;
+  bool changed = true;
+  while( changed && m_NumberOfIterations < m_MaximumNumberOfIterations )
+    {
+    changed = this->RasterScan( true );
+    changed = this->RasterScan( false ) || changed;
+    m_NumberOfIterations++;
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TMarkerImage>
+void
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::ComputeChamferMask()
+{
+  m_Neighbors.clear();
+  m_Offsets.clear();
+  m_Weights.clear();
+  m_Intermediates.clear();
+
+  const OutputImageType * output = this->GetOutput();
+  const SizeType & size = output->GetBufferedRegion().GetSize();
+  const long radius = m_NeighborhoodRadius;
+
+  OffsetType o;
+  o.Fill( -radius );
+  for(;;)
+    {
+    // the pixels visited before the current one by the forward scan: the
+    // last non zero coordinate is negative
+    int last = ImageDimension - 1;
+    while( last >= 0 && o[last] == 0 )
+      {
+      last--;
+      }
+    // the steps which are a multiple of a smaller step are useless. With a
+    // radius of at most 2, they are the ones without any coordinate of 1.
+    bool primitive = false;
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      primitive = primitive || o[d] == 1 || o[d] == -1;
+      }
+
+    if( last >= 0 && o[last] < 0 && primitive )
+      {
+      long offset = 0;
+      long stride = 1;
+      double weight = 0;
+      for( unsigned int d=0; d<ImageDimension; d++ )
+        {
+        offset += o[d] * stride;
+        stride *= size[d];
+        const double step = m_UseImageSpacing ? o[d] * output->GetSpacing()[d] : o[d];
+        weight += step * step;
+        }
+      m_Neighbors.push_back( o );
+      m_Offsets.push_back( offset );
+      m_Weights.push_back( std::sqrt( weight ) );
+
+      // a step with a coordinate of 2 passes between the pixels at half of
+      // its length: the coordinates of 2 are divided by 2, and the
+      // coordinates of 1 are either 0 or 1. (2,1) passes between (1,0) and
+      // (1,1), and (2,1,1) between (1,0,0), (1,1,0), (1,0,1) and (1,1,1).
+      std::vector< long > intermediates;
+      bool isLong = false;
+      for( unsigned int d=0; d<ImageDimension; d++ )
+        {
+        isLong = isLong || o[d] == 2 || o[d] == -2;
+        }
+      if( isLong )
+        {
+        intermediates.push_back( 0 );
+        stride = 1;
+        for( unsigned int d=0; d<ImageDimension; d++ )
+          {
+          if( o[d] == 2 || o[d] == -2 )
+            {
+            for( unsigned int j=0; j<intermediates.size(); j++ )
+              {
+              intermediates[j] += o[d] / 2 * stride;
+              }
+            }
+          else if( o[d] != 0 )
+            {
+            const unsigned int nb = intermediates.size();
+            for( unsigned int j=0; j<nb; j++ )
+              {
+              intermediates.push_back( intermediates[j] + o[d] * stride );
+              }
+            }
+          stride *= size[d];
+          }
+        }
+      m_Intermediates.push_back( intermediates );
+      }
+
+    // the next offset of the neighborhood
+    unsigned int d = 0;
+    while( d < ImageDimension && o[d] == radius )
+      {
+      o[d] = -radius;
+      d++;
+      }
+    if( d == ImageDimension )
+      {
+      break;
+      }
+    o[d]++;
+    }
+}
+
+
+template<class TInputImage, class TOutputImage, class TMarkerImage>
+bool
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::RasterScan( bool forward )
+{
+  const InputImagePixelType * mask = this->GetInput()->GetBufferPointer();
+  OutputImageType * output = this->GetOutput();
+  OutputImagePixelType * distance = output->GetBufferPointer();
+  const SizeType & size = output->GetBufferedRegion().GetSize();
+  const long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+  const long radius = m_NeighborhoodRadius;
+  const unsigned int nbOfNeighbors = m_Offsets.size();
+  const OutputImagePixelType infinity = NumericTraits< OutputImagePixelType >::max();
+
+  // without marker, the pixels outside the mask are the seeds. With a
+  // marker, the paths can't go out of the mask.
+  const bool fromBorder = this->GetMarkerImage() == NULL;
+
+  // the forward scan looks at the half chamfer mask, the backward one at its
+  // opposite
+  const long sign = forward ? 1 : -1;
+
+  // the index of the current pixel, relative to the buffer
+  IndexType idx;
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    idx[d] = forward ? 0 : (long)size[d] - 1;
+    }
+
+  bool changed = false;
+  for( long i=0; i<nbOfPixels; i++ )
+    {
+    const long p = forward ? i : nbOfPixels - 1 - i;
+
+    if( mask[p] == m_ForegroundValue && distance[p] != NumericTraits< OutputImagePixelType >::Zero )
+      {
+      // the neighbors of the pixels far enough from the border are all in
+      // the image
+      bool interior = true;
+      for( unsigned int d=0; d<ImageDimension && interior; d++ )
+        {
+        interior = idx[d] >= radius && idx[d] < (long)size[d] - radius;
+        }
+
+      double best = distance[p];
+      for( unsigned int k=0; k<nbOfNeighbors; k++ )
+        {
+        if( !interior )
+          {
+          bool isInside = true;
+          for( unsigned int d=0; d<ImageDimension && isInside; d++ )
+            {
+            const long c = idx[d] + sign * m_Neighbors[k][d];
+            isInside = c >= 0 && c < (long)size[d];
+            }
+          if( !isInside )
+            {
+            continue;
+            }
+          }
+        const long q = p + sign * m_Offsets[k];
+        if( distance[q] != infinity && ( fromBorder || mask[q] == m_ForegroundValue ) )
+          {
+          // the pixels between p and q are in the box between them, and so
+          // in the image
+          const std::vector< long > & intermediates = m_Intermediates[k];
+          bool isInMask = true;
+          for( unsigned int j=0; j<intermediates.size() && isInMask; j++ )
+            {
+            isInMask = mask[p + sign * intermediates[j]] == m_ForegroundValue;
+            }
+          if( isInMask )
+            {
+            best = std::min( best, distance[q] + m_Weights[k] );
+            }
+          }
+        }
+
+      const OutputImagePixelType value = static_cast< OutputImagePixelType >( best );
+      if( value < distance[p] )
+        {
+        distance[p] = value;
+        changed = true;
+        }
+      }
+
+    // the index of the next pixel
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      if( forward && idx[d] < (long)size[d] - 1 )
+        {
+        idx[d]++;
+        break;
+        }
+      if( !forward && idx[d] > 0 )
+        {
+        idx[d]--;
+        break;
+        }
+      idx[d] = forward ? 0 : (long)size[d] - 1;
+      }
+    }
+  return changed;
+}
+
+
+template<class TInputImage, class TOutputImage, class TMarkerImage>
+void
+GeodesicChamferDistanceImageFilter<TInputImage, TOutputImage, TMarkerImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "ForegroundValue: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_ForegroundValue) << std::endl;
+  os << indent << "NeighborhoodRadius: "  << m_NeighborhoodRadius << std::endl;
+  os << indent << "UseImageSpacing: "  << m_UseImageSpacing << std::endl;
+  os << indent << "MaximumNumberOfIterations: "  << m_MaximumNumberOfIterations << std::endl;
+  os << indent << "NumberOfIterations: "  << m_NumberOfIterations << std::endl;
+}
+
+}// end namespace itk
+#endif
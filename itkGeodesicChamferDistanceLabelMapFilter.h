@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkGeodesicChamferDistanceLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkGeodesicChamferDistanceLabelMapFilter_h
+#define __itkGeodesicChamferDistanceLabelMapFilter_h
+
+#include "itkLabelMapFilter.h"
+#include "itkBarrier.h"
+
+namespace itk {
+
+/** \class GeodesicChamferDistanceLabelMapFilter
+ * \brief Geodesic distance of the pixels of each object of a label map to
+ * its border
+ *
+ * Each object is drawn in an image of its bounding box, with a margin of
+ * one pixel for the background around it, and the geodesic distance of its
+ * pixels to that background is computed with
+ * GeodesicChamferDistanceImageFilter, independently of the other objects.
+ * The objects are processed in parallel, so the sequential raster scans of
+ * the distance run on several objects at once, and a scan only visits the
+ * bounding box of its object. The distances are written in an output image
+ * of the size of the label map, and the background of the label map is set
+ * to 0.
+ *
+ * The touching objects don't see each other: for an object, the pixels of
+ * the other objects are outside of the mask, like the background, so the
+ * distance is always the one to the border of the object.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa GeodesicChamferDistanceImageFilter, MorphologicalWatershedLabelMapFilter
+ * \ingroup ImageFeatureExtraction
+ */
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT GeodesicChamferDistanceLabelMapFilter :
+    public LabelMapFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef GeodesicChamferDistanceLabelMapFilter Self;
+  typedef LabelMapFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename InputImageType::LabelObjectType LabelObjectType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename OutputImageType::IndexType      IndexType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(GeodesicChamferDistanceLabelMapFilter,
+               LabelMapFilter);
+
+  /**
+   * Set/Get the radius of the chamfer mask: 1 for the 3x3 mask, 2 for the
+   * 5x5 mask. Default is 1.
+   */
+  itkSetClampMacro(NeighborhoodRadius, unsigned int, 1, 2);
+  itkGetConstReferenceMacro(NeighborhoodRadius, unsigned int);
+
+  /**
+   * Set/Get whether the distance is computed using the image spacing.
+   * Default is true.
+   */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /**
+   * Set/Get the maximum number of pairs of forward and backward scans for
+   * each object. Default is the maximum of unsigned long: the scans are
+   * repeated until convergence.
+   */
+  itkSetMacro(MaximumNumberOfIterations, unsigned long);
+  itkGetConstReferenceMacro(MaximumNumberOfIterations, unsigned long);
+
+protected:
+  GeodesicChamferDistanceLabelMapFilter();
+  ~GeodesicChamferDistanceLabelMapFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  virtual void BeforeThreadedGenerateData();
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, int threadId );
+
+  virtual void ThreadedGenerateData( LabelObjectType * labelObject );
+
+private:
+  GeodesicChamferDistanceLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int m_NeighborhoodRadius;
+
+  bool m_UseImageSpacing;
+
+  unsigned long m_MaximumNumberOfIterations;
+
+  typename Barrier::Pointer m_Barrier;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkGeodesicChamferDistanceLabelMapFilter.txx"
+#endif
+
+#endif
+
+
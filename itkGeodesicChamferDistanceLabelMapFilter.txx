@@ -0,0 +1,180 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkGeodesicChamferDistanceLabelMapFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkGeodesicChamferDistanceLabelMapFilter_txx
+#define __itkGeodesicChamferDistanceLabelMapFilter_txx
+
+#include "itkGeodesicChamferDistanceLabelMapFilter.h"
+#include "itkGeodesicChamferDistanceImageFilter.h"
+#include "itkNumericTraits.h"
+#include "itkImageRegionIterator.h"
+#include "itkImage.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+GeodesicChamferDistanceLabelMapFilter<TInputImage, TOutputImage>
+::GeodesicChamferDistanceLabelMapFilter()
+{
+  m_NeighborhoodRadius = 1;
+  m_UseImageSpacing = true;
+  m_MaximumNumberOfIterations = NumericTraits< unsigned long >::max();
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+GeodesicChamferDistanceLabelMapFilter<TInputImage, TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize( this->GetNumberOfThreads() );
+
+  Superclass::BeforeThreadedGenerateData();
+
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+GeodesicChamferDistanceLabelMapFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData( const OutputImageRegionType& outputRegionForThread, int threadId )
+{
+  OutputImageType * output = this->GetOutput();
+
+  // the background is at a distance of 0 of the objects border
+  ImageRegionIterator< OutputImageType > oIt( output, outputRegionForThread );
+  for( oIt.GoToBegin(); !oIt.IsAtEnd(); ++oIt )
+    {
+    oIt.Set( NumericTraits< OutputImagePixelType >::Zero );
+    }
+
+  // wait for the other threads to complete that part
+  m_Barrier->Wait();
+
+  // and delegate to the superclass implementation to use the thread support for the label objects
+  Superclass::ThreadedGenerateData( outputRegionForThread, threadId );
+
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+GeodesicChamferDistanceLabelMapFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData( LabelObjectType * labelObject )
+{
+  OutputImageType * output = this->GetOutput();
+  const InputImageType * input = this->GetInput();
+
+  typedef Image< unsigned char, ImageDimension > MaskImageType;
+  typedef typename MaskImageType::RegionType MaskRegionType;
+
+  typename InputImageType::LabelObjectType::LineContainerType::const_iterator lit;
+  typename InputImageType::LabelObjectType::LineContainerType & lineContainer = labelObject->GetLineContainer();
+
+  if( lineContainer.empty() )
+    {
+    return;
+    }
+
+  // the bounding box of the object
+  IndexType mins = lineContainer.begin()->GetIndex();
+  IndexType maxs = mins;
+  for( lit = lineContainer.begin(); lit != lineContainer.end(); lit++ )
+    {
+    const IndexType & idx = lit->GetIndex();
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      mins[d] = std::min( mins[d], idx[d] );
+      maxs[d] = std::max( maxs[d], idx[d] );
+      }
+    maxs[0] = std::max( maxs[0], (long)( idx[0] + lit->GetLength() - 1 ) );
+    }
+
+  // with a margin of one pixel for the background around the object, in the
+  // image
+  const InputImageRegionType & largest = input->GetLargestPossibleRegion();
+  typename MaskRegionType::IndexType regionIndex;
+  typename MaskRegionType::SizeType regionSize;
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    const long begin = std::max( mins[d] - 1, largest.GetIndex()[d] );
+    const long end = std::min( maxs[d] + 1, (long)( largest.GetIndex()[d] + largest.GetSize()[d] - 1 ) );
+    regionIndex[d] = begin;
+    regionSize[d] = end - begin + 1;
+    }
+  MaskRegionType region( regionIndex, regionSize );
+
+  // draw the object in its own small image
+  typename MaskImageType::Pointer mask = MaskImageType::New();
+  mask->SetRegions( region );
+  mask->SetSpacing( input->GetSpacing() );
+  mask->SetOrigin( input->GetOrigin() );
+  mask->Allocate();
+  mask->FillBuffer( 0 );
+  for( lit = lineContainer.begin(); lit != lineContainer.end(); lit++ )
+    {
+    IndexType idx = lit->GetIndex();
+    unsigned long length = lit->GetLength();
+    for( unsigned long i=0; i<length; i++)
+      {
+      mask->SetPixel( idx, 1 );
+      idx[0]++;
+      }
+    }
+
+  // the object is processed by a single thread: the parallelism is at the
+  // object level
+  typedef GeodesicChamferDistanceImageFilter< MaskImageType, OutputImageType > DistanceType;
+  typename DistanceType::Pointer distance = DistanceType::New();
+  distance->SetInput( mask );
+  distance->SetForegroundValue( 1 );
+  distance->SetNeighborhoodRadius( m_NeighborhoodRadius );
+  distance->SetUseImageSpacing( m_UseImageSpacing );
+  distance->SetMaximumNumberOfIterations( m_MaximumNumberOfIterations );
+  distance->SetNumberOfThreads( 1 );
+  distance->Update();
+
+  // copy the distance of the pixels of the object in the output
+  const OutputImageType * distanceImage = distance->GetOutput();
+  for( lit = lineContainer.begin(); lit != lineContainer.end(); lit++ )
+    {
+    IndexType idx = lit->GetIndex();
+    unsigned long length = lit->GetLength();
+    for( unsigned long i=0; i<length; i++)
+      {
+      output->SetPixel( idx, distanceImage->GetPixel( idx ) );
+      idx[0]++;
+      }
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+GeodesicChamferDistanceLabelMapFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NeighborhoodRadius: "  << m_NeighborhoodRadius << std::endl;
+  os << indent << "UseImageSpacing: "  << m_UseImageSpacing << std::endl;
+  os << indent << "MaximumNumberOfIterations: "  << m_MaximumNumberOfIterations << std::endl;
+}
+
+}// end namespace itk
+#endif
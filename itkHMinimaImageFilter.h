@@ -18,6 +18,9 @@
 #define __itkHMinimaImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkShiftScaleImageFilter.h"
+#include "itkImageCache.h"
 
 namespace itk {
 
@@ -41,6 +44,10 @@ namespace itk {
  * dilation.  The "marker" image for the geodesic dilation is
  * the input image plus the height parameter h.
  *
+ * The internal filters are kept from one execution to the other, so the
+ * scratch memory of the reconstruction is reused. See
+ * SetMaximumScratchSize().
+ *
  * Geodesic morphology and the H-Minima algorithm is described in
  * Chapter 6 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
@@ -79,6 +86,10 @@ public:
   itkStaticConstMacro(OutputImageDimension, unsigned int,
                       TOutputImage::ImageDimension);
 
+  /** The internal filters */
+  typedef ShiftScaleImageFilter<TInputImage, TInputImage> ShiftFilterType;
+  typedef ReconstructionByErosionImageFilter<TInputImage, TInputImage> ErodeFilterType;
+
   /** Standard New method. */
   itkNewMacro(Self);  
 
@@ -110,6 +121,48 @@ public:
   itkSetMacro(FullyConnected, bool);
   itkGetConstReferenceMacro(FullyConnected, bool);
   itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get the on-disk cache of the output. When it is set, the output is
+   * stored in the cache, and loaded from there instead of being computed
+   * again for an input with the same content and the same parameters, even
+   * in another process. Default is NULL: no cache.
+   * \sa ImageCache
+   */
+  itkSetObjectMacro(Cache, ImageCache);
+  itkGetObjectMacro(Cache, ImageCache);
+
+  /**
+   * Set/Get the maximum size, in bytes, of the scratch memory of the
+   * reconstruction kept from one execution to the other. Default is the
+   * maximum of unsigned long.
+   * \sa ReconstructionImageFilter::SetMaximumScratchSize()
+   */
+  void SetMaximumScratchSize( unsigned long size )
+    {
+    if( size != m_Erode->GetMaximumScratchSize() )
+      {
+      m_Erode->SetMaximumScratchSize( size );
+      this->Modified();
+      }
+    }
+
+  unsigned long GetMaximumScratchSize() const
+    {
+    return m_Erode->GetMaximumScratchSize();
+    }
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  unsigned long GetScratchSize() const
+    {
+    return m_Erode->GetScratchSize();
+    }
+
+  /** Release the scratch memory kept from the last execution */
+  void ReleaseScratch()
+    {
+    m_Erode->ReleaseScratch();
+    }
   
 protected:
   HMinimaImageFilter();
@@ -136,6 +189,11 @@ private:
   InputImagePixelType m_Height;
   unsigned long m_NumberOfIterationsUsed;
   bool                m_FullyConnected;
+  ImageCache::Pointer m_Cache;
+
+  // the internal filters, kept from one execution to the other
+  typename ShiftFilterType::Pointer m_Shift;
+  typename ErodeFilterType::Pointer m_Erode;
 } ; // end of class
 
 } // end namespace itk
@@ -20,9 +20,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkHMinimaImageFilter.h"
-#include "itkReconstructionByErosionImageFilter.h"
-#include "itkShiftScaleImageFilter.h"
 #include "itkProgressAccumulator.h"
+#include <sstream>
 
 namespace itk {
 
@@ -33,6 +32,11 @@ HMinimaImageFilter<TInputImage, TOutputImage>
   m_Height =  2;
   m_NumberOfIterationsUsed = 1;
   m_FullyConnected = false;
+  m_Cache = NULL;
+  m_Shift = ShiftFilterType::New();
+  // the shifted image is only read by the reconstruction
+  m_Shift->ReleaseDataFlagOn();
+  m_Erode = ErodeFilterType::New();
 }
 
 template <class TInputImage, class TOutputImage>
@@ -65,36 +69,56 @@ void
 HMinimaImageFilter<TInputImage, TOutputImage>
 ::GenerateData()
 {
+  // the output may have been computed already, by this process or by
+  // another one
+  std::string cacheKey;
+  if( m_Cache )
+    {
+    std::ostringstream parameters;
+    parameters.precision( 17 );
+    parameters << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_Height) << " "
+               << m_FullyConnected << " "
+               << ChunkedVolumePixelTypeName< typename TOutputImage::PixelType >();
+    cacheKey = m_Cache->ComputeKey( "HMinima", parameters.str(), this->GetInput() );
+    OutputImageType * output = this->GetOutput();
+    output->SetBufferedRegion( output->GetRequestedRegion() );
+    if( m_Cache->Load( cacheKey, output ) )
+      {
+      return;
+      }
+    }
+
   // Allocate the output
   this->AllocateOutputs();
   
   // construct a marker image to manipulate using reconstruction by
   // erosion. the marker image is the input image minus the height
   // parameter.
-  typedef ShiftScaleImageFilter<TInputImage, TInputImage>
-    ShiftFilterType;
-  typename ShiftFilterType::Pointer shift = ShiftFilterType::New();
-  shift->SetInput( this->GetInput() );
-  shift->SetShift( static_cast<typename ShiftFilterType::RealType>(m_Height) );
+  m_Shift->SetInput( this->GetInput() );
+  m_Shift->SetShift( static_cast<typename ShiftFilterType::RealType>(m_Height) );
+  m_Shift->SetNumberOfThreads( this->GetNumberOfThreads() );
 
-  // Delegate to a geodesic erosion filter.
+  // Delegate to a geodesic erosion filter. It is kept from one execution to
+  // the other, so it reuses its scratch memory.
   //
   //
-  typename ReconstructionByErosionImageFilter<TInputImage, TInputImage>::Pointer
-    erode
-    = ReconstructionByErosionImageFilter<TInputImage, TInputImage>::New();
+  ErodeFilterType * erode = m_Erode;
 
   // Create a process accumulator for tracking the progress of this minipipeline
   ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
   progress->SetMiniPipelineFilter( this );
-  progress->RegisterInternalFilter( shift, 0.2f);
+  progress->RegisterInternalFilter( m_Shift, 0.2f);
   progress->RegisterInternalFilter( erode, 0.8f );
 
   // set up the erode filter
   //erode->RunOneIterationOff();             // run to convergence
-  erode->SetMarkerImage( shift->GetOutput() );
+  erode->SetMarkerImage( m_Shift->GetOutput() );
   erode->SetMaskImage( this->GetInput() );
   erode->SetFullyConnected( m_FullyConnected );
+  erode->SetNumberOfThreads( this->GetNumberOfThreads() );
+  // the output is grafted again at each execution, so the filter must run
+  // even if its inputs and parameters have not changed
+  erode->Modified();
 
   // graft our output to the erode filter to force the proper regions
   // to be generated
@@ -107,6 +131,11 @@ HMinimaImageFilter<TInputImage, TOutputImage>
   // output. this is needed to get the appropriate regions passed
   // back.
   this->GraftOutput( erode->GetOutput() );
+
+  if( m_Cache )
+    {
+    m_Cache->Store( cacheKey, this->GetOutput() );
+    }
 }
 
 
@@ -123,6 +152,8 @@ HMinimaImageFilter<TInputImage, TOutputImage>
   os << indent << "Number of iterations used to produce current output: "
      << m_NumberOfIterationsUsed << std::endl;
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "Cache: "  << m_Cache.GetPointer() << std::endl;
+  os << indent << "MaximumScratchSize: "  << this->GetMaximumScratchSize() << std::endl;
 }
   
 }// end namespace itk
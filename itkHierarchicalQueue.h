@@ -17,7 +17,10 @@
 #ifndef __itkHierarchicalQueue_h
 #define __itkHierarchicalQueue_h
 
-// #include <vector>
+#include "itkLightObject.h"
+#include "itkObjectFactory.h"
+#include "itkNumericTraits.h"
+#include <vector>
 #include <list>
 #include <map>
 
@@ -99,6 +102,20 @@ public:
     m_Size--;
     }
 
+  /** remove all the elements of the queue */
+  void Clear()
+    {
+    m_Map.clear();
+    m_Size = 0;
+    }
+
+  /** return the memory used by the queue, in bytes. The FIFOs are released
+   * as soon as they are empty, so an empty queue uses no memory. */
+  unsigned long GetMemorySize() const
+    {
+    return m_Size * ( sizeof( ValueType ) + 2 * sizeof( void * ) );
+    }
+
   HierarchicalQueue()
     {
     m_Size = 0;
@@ -130,8 +147,8 @@ public:
   typedef TKey KeyType;
   typedef TCompare CompareType;
 
-  typedef std::list<ValueType>      ValueListType;
-  typedef std::vector<ValueListType>  VectorType;
+  typedef std::vector<ValueType>     ValueListType;
+  typedef std::vector<ValueListType> VectorType;
 
   // for code conciseness
   typedef NumericTraits< TKey > NT;
@@ -147,16 +164,18 @@ public:
   inline const ValueType & FrontValue() const
     {
     assert(!this->Empty());
-    return m_Vector[ m_CurrentValue  - NT::NonpositiveMin() ].front();
+    const size_t position = Self::Position( m_CurrentValue );
+    return m_Vector[ position ][ m_Head[ position ] ];
     }
 
   /** push a value in the queue */
   inline void Push( const KeyType & k, const ValueType & v)
     {
-      assert( (int)(k  - NT::NonpositiveMin()) < (int)m_Vector.size() );
-    assert( k  - NT::NonpositiveMin() >= 0 );
+    // a key lower than the minimum wraps to a position larger than the
+    // vector
+    assert( Self::Position( k ) < m_Vector.size() );
 
-    m_Vector[ k  - NT::NonpositiveMin() ].push_back( v );
+    m_Vector[ Self::Position( k ) ].push_back( v );
     if( this->Empty() || m_Compare( k, m_CurrentValue ) )
       {
       m_CurrentValue = k;
@@ -180,24 +199,55 @@ public:
   inline void Pop()
     {
     assert(!this->Empty());
-    ValueListType & valueList = m_Vector[ m_CurrentValue  - NT::NonpositiveMin() ];
-    valueList.pop_front();
+    const size_t position = Self::Position( m_CurrentValue );
+    ValueListType & valueList = m_Vector[ position ];
+    m_Head[ position ]++;
     m_Size--;
 
-    if( valueList.empty() && !this->Empty() )
+    if( m_Head[ position ] == valueList.size() )
       {
-      // update the current key to a new value
-      while( m_Vector[ m_CurrentValue - NT::NonpositiveMin() ].empty() )
+      // the FIFO of that key is empty: it keeps its memory for the next
+      // pushes
+      valueList.clear();
+      m_Head[ position ] = 0;
+      if( !this->Empty() )
         {
-        m_CurrentValue += m_Direction;
+        // update the current key to a new value
+        while( m_Vector[ Self::Position( m_CurrentValue ) ].empty() )
+          {
+          m_CurrentValue += m_Direction;
+          }
         }
       }
+    }
 
+  /** remove all the elements of the queue. The memory of the FIFOs is kept,
+   * so a queue reused for the same kind of data doesn't allocate anything. */
+  void Clear()
+    {
+    for( size_t i=0; i<m_Vector.size(); i++ )
+      {
+      m_Vector[i].clear();
+      m_Head[i] = 0;
+      }
+    m_Size = 0;
+    }
+
+  /** return the memory used by the queue, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    unsigned long size = m_Vector.capacity() * ( sizeof( ValueListType ) + sizeof( unsigned long ) );
+    for( size_t i=0; i<m_Vector.size(); i++ )
+      {
+      size += m_Vector[i].capacity() * sizeof( ValueType );
+      }
+    return size;
     }
 
   VectorHierarchicalQueue()
     {
-    m_Vector.resize( NT::max() - NT::NonpositiveMin() + 1 );
+    m_Vector.resize( Self::Position( NT::max() ) + 1 );
+    m_Head.resize( m_Vector.size(), 0 );
     if( m_Compare( NT::max(), NT::NonpositiveMin() ) )
       {
       m_Direction = -1;
@@ -216,9 +266,18 @@ public:
 
 protected:
 
+  /** the position of the FIFO of a key in m_Vector. The difference is
+   * computed on the size type, so it doesn't overflow for the keys wider
+   * than int. */
+  static inline size_t Position( const KeyType & k )
+    {
+    return static_cast< size_t >( k ) - static_cast< size_t >( NT::NonpositiveMin() );
+    }
+
 private:
 
   VectorType m_Vector;
+  std::vector<unsigned long> m_Head;
   unsigned long m_Size;
   TKey m_CurrentValue;
   TCompare m_Compare;
@@ -226,6 +285,152 @@ private:
 
 };
 
+/** \class DenseHierarchicalQueue
+ *  \brief A hierarchical queue for the keys in a dense range starting at 0
+ *
+ * The keys must be unsigned integers, and all the values between 0 and the
+ * highest key should be used, like the ranks produced by
+ * RankTransformImageFilter. A FIFO is stored for each key in a vector,
+ * without the cost of the map of HierarchicalQueue, and without the
+ * allocation of the full range of the key type of VectorHierarchicalQueue,
+ * which is not possible with 32 bits keys. The vector grows with the
+ * highest key pushed, and can be presized with SetNumberOfKeys(). The
+ * lowest key is returned first. The FIFOs keep their memory when they are
+ * emptied, so a queue reused with Clear() doesn't allocate anything once
+ * it has reached its largest size.
+ */
+template <typename TKey, typename TValue>
+class DenseHierarchicalQueue
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef DenseHierarchicalQueue      Self;
+
+  typedef TValue ValueType;
+  typedef TKey KeyType;
+
+  typedef std::vector<ValueType>     ValueListType;
+  typedef std::vector<ValueListType> VectorType;
+
+  /** return the current key */
+  inline const KeyType & FrontKey() const
+    {
+    assert(!this->Empty());
+    return m_CurrentValue;
+    }
+
+  /** return the current value */
+  inline const ValueType & FrontValue() const
+    {
+    assert(!this->Empty());
+    return m_Vector[ m_CurrentValue ][ m_Head[ m_CurrentValue ] ];
+    }
+
+  /** push a value in the queue */
+  inline void Push( const KeyType & k, const ValueType & v)
+    {
+    if( k >= m_Vector.size() )
+      {
+      this->SetNumberOfKeys( k + 1 );
+      }
+    m_Vector[ k ].push_back( v );
+    if( this->Empty() || k < m_CurrentValue )
+      {
+      m_CurrentValue = k;
+      }
+    m_Size++;
+    }
+
+  /** return the size of the queue */
+  inline const unsigned long & Size() const
+    {
+    return m_Size;
+    }
+
+  /** return true if the queue is empty */
+  inline const bool Empty() const
+    {
+    return m_Size == 0;
+    }
+
+  /** remove the first element of the queue */
+  inline void Pop()
+    {
+    assert(!this->Empty());
+    ValueListType & valueList = m_Vector[ m_CurrentValue ];
+    m_Head[ m_CurrentValue ]++;
+    m_Size--;
+
+    if( m_Head[ m_CurrentValue ] == valueList.size() )
+      {
+      // the FIFO of that key is empty: it keeps its memory for the next
+      // pushes
+      valueList.clear();
+      m_Head[ m_CurrentValue ] = 0;
+      if( !this->Empty() )
+        {
+        // update the current key to a new value
+        while( m_Vector[ m_CurrentValue ].empty() )
+          {
+          m_CurrentValue++;
+          }
+        }
+      }
+    }
+
+  /** allocate the FIFOs of the keys lower than n */
+  void SetNumberOfKeys( unsigned long n )
+    {
+    if( n > m_Vector.size() )
+      {
+      m_Vector.resize( n );
+      m_Head.resize( n, 0 );
+      }
+    }
+
+  /** remove all the elements of the queue, and keep the memory */
+  void Clear()
+    {
+    for( size_t i=0; i<m_Vector.size(); i++ )
+      {
+      m_Vector[i].clear();
+      m_Head[i] = 0;
+      }
+    m_Size = 0;
+    m_CurrentValue = 0;
+    }
+
+  /** return the memory used by the queue, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    unsigned long size = m_Vector.capacity() * ( sizeof( ValueListType ) + sizeof( unsigned long ) );
+    for( size_t i=0; i<m_Vector.size(); i++ )
+      {
+      size += m_Vector[i].capacity() * sizeof( ValueType );
+      }
+    return size;
+    }
+
+  DenseHierarchicalQueue()
+    {
+    m_Size = 0;
+    m_CurrentValue = 0;
+    }
+
+
+protected:
+
+private:
+
+  VectorType m_Vector;
+  std::vector<unsigned long> m_Head;
+  unsigned long m_Size;
+  TKey m_CurrentValue;
+
+};
+
 template <typename TValue, typename TCompare >
 class HierarchicalQueue<unsigned char, TValue, TCompare>
 : public VectorHierarchicalQueue<unsigned char, TValue, TCompare>
@@ -257,6 +462,74 @@ class HierarchicalQueue<bool, TValue, TCompare>
 };
 
 
+/** \class HierarchicalQueueHolderBase
+ *  \brief A hierarchical queue of any type, owned by a smart pointer
+ *
+ * The filters keep their queue from one execution to the other in a
+ * HierarchicalQueueHolderBase::Pointer, and get the queue of the type they
+ * need back with a dynamic_cast to HierarchicalQueueHolder.
+ */
+class HierarchicalQueueHolderBase : public LightObject
+{
+public:
+  typedef HierarchicalQueueHolderBase Self;
+  typedef LightObject                 Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  itkTypeMacro(HierarchicalQueueHolderBase, LightObject);
+
+  /** return the memory used by the queue, in bytes */
+  virtual unsigned long GetMemorySize() const = 0;
+
+protected:
+  HierarchicalQueueHolderBase() {}
+  virtual ~HierarchicalQueueHolderBase() {}
+
+private:
+  HierarchicalQueueHolderBase(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+/** \class HierarchicalQueueHolder
+ *  \brief Own a hierarchical queue of type TQueue
+ */
+template <typename TQueue>
+class HierarchicalQueueHolder : public HierarchicalQueueHolderBase
+{
+public:
+  typedef HierarchicalQueueHolder     Self;
+  typedef HierarchicalQueueHolderBase Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  typedef TQueue QueueType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(HierarchicalQueueHolder, HierarchicalQueueHolderBase);
+
+  QueueType & GetQueue()
+    {
+    return m_Queue;
+    }
+
+  virtual unsigned long GetMemorySize() const
+    {
+    return m_Queue.GetMemorySize();
+    }
+
+protected:
+  HierarchicalQueueHolder() {}
+  virtual ~HierarchicalQueueHolder() {}
+
+private:
+  HierarchicalQueueHolder(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  QueueType m_Queue;
+};
+
+
 } // end namespace itk
 
 #endif
@@ -0,0 +1,415 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkImageCache.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkImageCache_h
+#define __itkImageCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageFileWriter.h"
+#include "itkMappedImageFileReader.h"
+#include "itkChunkedVolumeHeader.h"
+#include "vxl_config.h"
+#include <itksys/SystemTools.hxx>
+#include <itksys/Directory.hxx>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+namespace itk
+{
+
+/** \class ContentHash
+ *  \brief A fast 128 bits hash of a sequence of bytes
+ *
+ * The data is hashed 8 bytes at a time in two independent 64 bits lanes,
+ * which are mixed at the end. It is fast enough to hash a whole image
+ * buffer, and wide enough to identify the content of a cache entry, but it
+ * is not a cryptographic hash.
+ */
+class ContentHash
+{
+
+public:
+
+  typedef vxl_uint_64 WordType;
+
+  ContentHash()
+    {
+    m_Lane1 = 0x9e3779b97f4a7c15ULL;
+    m_Lane2 = 0xc2b2ae3d27d4eb4fULL;
+    m_Length = 0;
+    }
+
+  void Update( const void * data, size_t size )
+    {
+    const char * bytes = static_cast< const char * >( data );
+    const size_t nbOfWords = size / sizeof( WordType );
+    for( size_t i=0; i<nbOfWords; i++ )
+      {
+      WordType w;
+      memcpy( &w, bytes + i * sizeof( WordType ), sizeof( WordType ) );
+      this->Mix( w );
+      }
+    // the remaining bytes, padded with zeros
+    if( size % sizeof( WordType ) != 0 )
+      {
+      WordType w = 0;
+      memcpy( &w, bytes + nbOfWords * sizeof( WordType ), size % sizeof( WordType ) );
+      this->Mix( w );
+      }
+    m_Length += size;
+    }
+
+  void Update( const std::string & s )
+    {
+    // the length separates the consecutive strings
+    WordType size = s.size();
+    this->Update( &size, sizeof( size ) );
+    this->Update( s.data(), s.size() );
+    }
+
+  /** return the hash as 32 hexadecimal digits */
+  std::string GetDigest() const
+    {
+    WordType h1 = m_Lane1 ^ m_Length;
+    WordType h2 = m_Lane2 ^ m_Length;
+    h1 += h2;
+    h2 += h1;
+    h1 = Self::Finalize( h1 );
+    h2 = Self::Finalize( h2 );
+    h1 += h2;
+    h2 += h1;
+    char digest[33];
+    sprintf( digest, "%016llx%016llx", (unsigned long long)h1, (unsigned long long)h2 );
+    return digest;
+    }
+
+private:
+
+  typedef ContentHash Self;
+
+  static inline WordType Rotate( WordType x, int r )
+    {
+    return ( x << r ) | ( x >> ( 64 - r ) );
+    }
+
+  inline void Mix( WordType w )
+    {
+    m_Lane1 ^= Self::Rotate( w * 0x87c37b91114253d5ULL, 31 ) * 0x4cf5ad432745937fULL;
+    m_Lane1 = Self::Rotate( m_Lane1, 27 ) * 5 + 0x52dce729;
+    m_Lane2 ^= Self::Rotate( w * 0x4cf5ad432745937fULL, 33 ) * 0x87c37b91114253d5ULL;
+    m_Lane2 = Self::Rotate( m_Lane2, 31 ) * 5 + 0x38495ab5;
+    }
+
+  static inline WordType Finalize( WordType k )
+    {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+    }
+
+  WordType m_Lane1;
+  WordType m_Lane2;
+  WordType m_Length;
+
+};
+
+
+/** \class ImageCache
+ *  \brief An on-disk cache of images, addressed by the content of their inputs
+ *
+ * The composite filters which accept an ImageCache store there the images
+ * they compute, and load them instead of computing them again when the same
+ * stage is run with the same parameters on an input with the same content,
+ * in the same process or in another one.
+ *
+ * The key of an entry is a hash of the name of the stage, of its parameters,
+ * and of the geometry, pixel type and buffer of its input. The entries are
+ * uncompressed MetaImage files in the cache directory, named after their
+ * key. They are loaded with MappedImageFileReader, copy-on-write, so a cache
+ * hit costs almost nothing until the pixels are used.
+ *
+ * The total size of the entries is limited by MaximumSize: the least
+ * recently used entries are removed after each store. The modification time
+ * of an entry is updated each time it is loaded, so the cache can be shared
+ * by several processes without any other bookkeeping.
+ *
+ * The hash of the last input is kept with its modification time, so several
+ * stages run on the same input only hash it once.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MappedImageFileReader, ContentHash
+ */
+class ImageCache : public Object
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef ImageCache                Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageCache, Object);
+
+  /** Set/Get the directory of the cache. It is created if needed. */
+  itkSetStringMacro(Directory);
+  itkGetStringMacro(Directory);
+
+  /** Set/Get the maximum size of the entries, in bytes. Default is 1 GB. */
+  itkSetMacro(MaximumSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumSize, unsigned long);
+
+  /** Get the number of entries loaded and stored since the creation of the
+   * cache */
+  itkGetConstReferenceMacro(NumberOfHits, unsigned long);
+  itkGetConstReferenceMacro(NumberOfStores, unsigned long);
+
+  /** Return the key of a stage run with some parameters on an input */
+  template <class TInputImage>
+  std::string ComputeKey( const std::string & stage, const std::string & parameters, const TInputImage * input )
+    {
+    // the hash of the input, which may be known already
+    if( input != m_LastInput || input->GetMTime() != m_LastInputMTime )
+      {
+      ContentHash hash;
+      std::ostringstream geometry;
+      geometry.precision( 17 );
+      geometry << ChunkedVolumePixelTypeName< typename TInputImage::PixelType >() << " "
+               << input->GetBufferedRegion() << " ";
+      for( unsigned int d=0; d<TInputImage::ImageDimension; d++ )
+        {
+        geometry << input->GetSpacing()[d] << " " << input->GetOrigin()[d] << " ";
+        }
+      hash.Update( geometry.str() );
+      hash.Update( input->GetBufferPointer(),
+                   input->GetBufferedRegion().GetNumberOfPixels() * sizeof( typename TInputImage::PixelType ) );
+      m_LastInput = input;
+      m_LastInputMTime = input->GetMTime();
+      m_LastInputHash = hash.GetDigest();
+      }
+
+    ContentHash hash;
+    hash.Update( stage );
+    hash.Update( parameters );
+    hash.Update( m_LastInputHash );
+    return hash.GetDigest();
+    }
+
+  /** Load the entry of a key in an image. The regions, the spacing and the
+   * origin of the image must already be set: only its pixel container is
+   * replaced. Return false if there is no entry with that key, or if it
+   * doesn't match the pixel type or the size of the image. */
+  template <class TImage>
+  bool Load( const std::string & key, TImage * image )
+    {
+    const std::string fileName = this->GetEntryFileName( key );
+    if( !itksys::SystemTools::FileExists( fileName.c_str() ) )
+      {
+      return false;
+      }
+    typedef MappedImageFileReader< TImage > ReaderType;
+    typename ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( fileName );
+    reader->CopyOnWriteOn();
+    try
+      {
+      reader->Update();
+      }
+    catch( ExceptionObject & )
+      {
+      // another pixel type, or an entry being removed
+      return false;
+      }
+    if( reader->GetOutput()->GetLargestPossibleRegion().GetSize() != image->GetBufferedRegion().GetSize() )
+      {
+      return false;
+      }
+    image->SetPixelContainer( reader->GetOutput()->GetPixelContainer() );
+    // the entry is now the most recently used one
+    utime( fileName.c_str(), NULL );
+    m_NumberOfHits++;
+    return true;
+    }
+
+  /** Store the buffer of an image with a key, and remove the least recently
+   * used entries if the cache is too large. A failure to store the entry is
+   * not an error: the entry is simply not available. */
+  template <class TImage>
+  void Store( const std::string & key, const TImage * image )
+    {
+    if( !this->MakeDirectory() )
+      {
+      return;
+      }
+    // written in a temporary file which is then renamed, so the other
+    // processes never see a partial entry
+    const std::string fileName = this->GetEntryFileName( key );
+    std::ostringstream tmpName;
+    tmpName << m_Directory << "/tmp" << itkChunkedVolumeGetPid() << "-" << key << ".mha";
+
+    // the entry is written without its geometry, which is known by the
+    // filter loading it
+    typename TImage::RegionType region;
+    region.SetSize( image->GetBufferedRegion().GetSize() );
+    typename TImage::Pointer entry = TImage::New();
+    entry->SetRegions( region );
+    entry->SetPixelContainer( const_cast< TImage * >( image )->GetPixelContainer() );
+
+    typedef ImageFileWriter< TImage > WriterType;
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetInput( entry );
+    writer->SetFileName( tmpName.str().c_str() );
+    writer->UseCompressionOff();
+    try
+      {
+      writer->Update();
+      }
+    catch( ExceptionObject & )
+      {
+      itksys::SystemTools::RemoveFile( tmpName.str().c_str() );
+      return;
+      }
+#ifdef _WIN32
+    // rename() doesn't replace an existing file on windows
+    remove( fileName.c_str() );
+#endif
+    if( rename( tmpName.str().c_str(), fileName.c_str() ) != 0 )
+      {
+      itksys::SystemTools::RemoveFile( tmpName.str().c_str() );
+      return;
+      }
+    m_NumberOfStores++;
+    this->Evict();
+    }
+
+  /** Remove the least recently used entries until the cache is not larger
+   * than MaximumSize */
+  void Evict()
+    {
+    typedef std::pair< long, std::string > EntryType;
+    std::vector< EntryType > entries;
+    unsigned long size = 0;
+    itksys::Directory directory;
+    directory.Load( m_Directory.c_str() );
+    for( unsigned long i=0; i<directory.GetNumberOfFiles(); i++ )
+      {
+      const std::string name = directory.GetFile( i );
+      if( itksys::SystemTools::GetFilenameLastExtension( name ) != ".mha" || name.compare( 0, 3, "tmp" ) == 0 )
+        {
+        continue;
+        }
+      const std::string fileName = m_Directory + "/" + name;
+      entries.push_back( EntryType( itksys::SystemTools::ModifiedTime( fileName.c_str() ), fileName ) );
+      size += itksys::SystemTools::FileLength( fileName.c_str() );
+      }
+
+    std::sort( entries.begin(), entries.end() );
+    for( unsigned long i=0; i<entries.size() && size > m_MaximumSize; i++ )
+      {
+      const unsigned long length = itksys::SystemTools::FileLength( entries[i].second.c_str() );
+      if( itksys::SystemTools::RemoveFile( entries[i].second.c_str() ) )
+        {
+        size -= length;
+        }
+      }
+    }
+
+  /** Remove all the entries */
+  void Clear()
+    {
+    const unsigned long maximumSize = m_MaximumSize;
+    m_MaximumSize = 0;
+    this->Evict();
+    m_MaximumSize = maximumSize;
+    }
+
+protected:
+
+  ImageCache()
+    {
+    m_Directory = "";
+    m_MaximumSize = 1UL << 30;
+    m_NumberOfHits = 0;
+    m_NumberOfStores = 0;
+    m_LastInput = NULL;
+    m_LastInputMTime = 0;
+    }
+  ~ImageCache() {};
+
+  void PrintSelf(std::ostream& os, Indent indent) const
+    {
+    Superclass::PrintSelf(os, indent);
+
+    os << indent << "Directory: "  << m_Directory << std::endl;
+    os << indent << "MaximumSize: "  << m_MaximumSize << std::endl;
+    os << indent << "NumberOfHits: "  << m_NumberOfHits << std::endl;
+    os << indent << "NumberOfStores: "  << m_NumberOfStores << std::endl;
+    }
+
+  std::string GetEntryFileName( const std::string & key ) const
+    {
+    return m_Directory + "/" + key + ".mha";
+    }
+
+  bool MakeDirectory()
+    {
+    if( m_Directory == "" )
+      {
+      itkWarningMacro( << "Directory must be set to store the entries." );
+      return false;
+      }
+    return itksys::SystemTools::MakeDirectory( m_Directory.c_str() );
+    }
+
+private:
+
+  ImageCache(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string m_Directory;
+  unsigned long m_MaximumSize;
+  unsigned long m_NumberOfHits;
+  unsigned long m_NumberOfStores;
+
+  // the hash of the last input, and its identity
+  const void * m_LastInput;
+  unsigned long m_LastInputMTime;
+  std::string m_LastInputHash;
+
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,280 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkImageForestingTransform.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkImageForestingTransform_h
+#define __itkImageForestingTransform_h
+
+#include "itkImage.h"
+#include "itkConnectivity.h"
+#include "itkProgressReporter.h"
+#include "itkHierarchicalQueue.h"
+#include "itkBlockedBitArray.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class WatershedLineTieBreak
+ *  \brief The pixels are labeled when they are removed from the queue
+ *
+ * A pixel gets the label of its already labeled neighbors. If they have
+ * several labels, the pixel is a watershed line pixel, and is not
+ * propagated. This is the algorithm of Meyer.
+ */
+struct WatershedLineTieBreak
+{
+  itkStaticConstMacro(LabelAtPop, bool, true);
+};
+
+/** \class FirstComeTieBreak
+ *  \brief The pixels are labeled when they are put in the queue
+ *
+ * A pixel gets the label of the first pixel which reaches it, and keeps it
+ * as long as no cheaper path is found by the path cost. This is the
+ * algorithm of Beucher when the path cost never improves a reached pixel.
+ */
+struct FirstComeTieBreak
+{
+  itkStaticConstMacro(LabelAtPop, bool, false);
+};
+
+
+/** \class ImageForestingTransform
+ *  \brief Propagate the labels of a marker image, according to a path cost
+ *
+ * This class is the seeded propagation shared by the flooding algorithms:
+ * the pixels are processed in the order of their cost in a hierarchical
+ * queue, and receive the label of the marker which reaches them with the
+ * lowest cost. The way the cost is computed is given by the TPathCost
+ * policy, and the way the labels compete by the TTieBreak policy. Both are
+ * template parameters, so their methods are inlined in the propagation
+ * loop.
+ *
+ * The path cost policy must provide:
+ *  - a KeyType typedef: the type of the keys of the queue;
+ *  - a QueueType typedef: the type of the queue;
+ *  - Initialize( input, neighbors ): prepare the auxiliary data;
+ *  - Conquer( p, label ): called each time a label is given to a pixel;
+ *  - Seed( p ): the key of a marker pixel, when the labels are given in the
+ *    queue;
+ *  - SeedNeighbor( p, n, i, label ): the key of the neighbor n of the marker
+ *    pixel p, when the labels are given out of the queue;
+ *  - Extend( k, p, n, i, label ): the key of the neighbor n of the pixel p
+ *    of key k, when the labels are given out of the queue;
+ *  - Relax( k, p, n, i, reached, label, nk ): whether the neighbor n must get
+ *    the label of p, with the new key nk, when the labels are given in the
+ *    queue;
+ *  - IsCurrent( k, p ): false if the key k of p has been improved since p
+ *    has been put in the queue.
+ *
+ * The pixels are identified by their offset in the buffer, and i is the
+ * position of the neighbor in the connectivity.
+ *
+ * The propagation can be bounded with SetMaskImage() and
+ * SetMaximumValue(): the pixels outside the mask, or with an input value
+ * greater than the maximum value, are never put in the queue and keep the
+ * background label. When the bounded region is a small part of the image,
+ * SetUseSparseStatus( true ) stores the status of the pixels in a
+ * BlockedBitArray, which only allocates the blocks actually reached.
+ *
+ * The pixels on the border of the image are flagged before the
+ * propagation, so only them compute their index and check the bounds of
+ * their neighbors. SetBorderBuffer() keeps the flags from one propagation
+ * to the other, and SetQueue() the buckets of the queue: the queue must then
+ * provide a Clear() method, called before the propagation.
+ *
+ * Input, marker, mask and output images must have the same buffered region.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter, MaxArcPathCost,
+ * LexicographicPathCost, AdditivePathCost, RegionMeanPathCost
+ */
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage=TLabelImage>
+class ImageForestingTransform
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef ImageForestingTransform      Self;
+
+  typedef TInputImage InputImageType;
+  typedef TLabelImage LabelImageType;
+  typedef TPathCost   PathCostType;
+  typedef TTieBreak   TieBreakType;
+  typedef TMaskImage  MaskImageType;
+
+  typedef typename InputImageType::PixelType     InputImagePixelType;
+  typedef typename LabelImageType::PixelType     LabelImagePixelType;
+  typedef typename MaskImageType::PixelType      MaskImagePixelType;
+  typedef typename LabelImageType::IndexType     IndexType;
+  typedef typename LabelImageType::SizeType      SizeType;
+  typedef typename LabelImageType::OffsetType    OffsetType;
+  typedef typename PathCostType::KeyType         KeyType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  typedef Connectivity< ImageDimension > ConnectivityType;
+
+  typedef typename PathCostType::QueueType QueueType;
+
+  ImageForestingTransform();
+
+  void SetInput( const InputImageType * input )
+    {
+    m_Input = input;
+    }
+
+  void SetMarkerImage( const LabelImageType * markers )
+    {
+    m_MarkerImage = markers;
+    }
+
+  void SetOutput( LabelImageType * output )
+    {
+    m_Output = output;
+    }
+
+  void SetConnectivity( const ConnectivityType * connectivity )
+    {
+    m_Connectivity = connectivity;
+    }
+
+  /** The label of the pixels without marker in the marker image, and of
+   * the watershed line in the output image */
+  void SetBackgroundValue( const LabelImagePixelType & value )
+    {
+    m_BackgroundValue = value;
+    }
+
+  /** Restrict the propagation to the pixels where the mask is not zero. The
+   * markers outside the mask are kept in the output. */
+  void SetMaskImage( const MaskImageType * mask )
+    {
+    m_MaskImage = mask;
+    }
+
+  /** Restrict the propagation to the pixels with an input value lower or
+   * equal to the given value */
+  void SetMaximumValue( const InputImagePixelType & value )
+    {
+    m_MaximumValue = value;
+    m_UseMaximumValue = true;
+    }
+
+  /** Store the status of the pixels in a BlockedBitArray instead of a
+   * std::vector< bool > of the size of the image. The status buffer is not
+   * used in that case. */
+  void SetUseSparseStatus( bool value )
+    {
+    m_UseSparseStatus = value;
+    }
+
+  /** Set a vector used to store the status of the pixels. It is kept by the
+   * caller, so its memory can be reused by the next propagations. If it is
+   * not set, a new vector is allocated by Compute(). */
+  void SetStatusBuffer( std::vector< bool > * status )
+    {
+    m_StatusBuffer = status;
+    }
+
+  /** Set a vector used to flag the pixels on the border of the image, kept
+   * by the caller like the status buffer. It is not used with a sparse
+   * status. */
+  void SetBorderBuffer( std::vector< bool > * border )
+    {
+    m_BorderBuffer = border;
+    }
+
+  /** Set the queue used by the propagation, kept by the caller like the
+   * status buffer. It is cleared before the propagation, but keeps its
+   * memory. If it is not set, a new queue is created by Compute(). */
+  void SetQueue( QueueType * queue )
+    {
+    m_Queue = queue;
+    }
+
+  /** Return the path cost, to let the caller configure it */
+  PathCostType & GetPathCost()
+    {
+    return m_PathCost;
+    }
+
+  /** Propagate the labels of the markers in the output image */
+  void Compute( ProgressReporter & progress );
+
+private:
+
+  /** store in m_Inside the position of the neighbors of p which are
+   * inside the image. Only the pixels flagged in border have their index
+   * computed and their neighbors checked. */
+  template < class TBorder >
+  inline void ComputeNeighbors( unsigned long p, const TBorder & border );
+
+  /** flag the marker and floodable pixels on the border of the image */
+  template < class TBorder >
+  void ComputeBorder( TBorder & border );
+
+  /** whether the pixel p can receive a label */
+  inline bool IsFloodable( unsigned long p ) const
+    {
+    return ( !m_MaskBuffer || m_MaskBuffer[p] != NumericTraits< MaskImagePixelType >::Zero )
+      && ( !m_UseMaximumValue || !( m_MaximumValue < m_InputBuffer[p] ) );
+    }
+
+  /** the propagation where the labels are given out of the queue, with the
+   * status of the pixels and the border flags stored in a
+   * std::vector< bool > or in a BlockedBitArray */
+  template < class TStatus >
+  void ComputeLabelAtPop( TStatus & status, const TStatus & border, ProgressReporter & progress );
+
+  /** the propagation where the labels are given in the queue */
+  void ComputeLabelAtPush( const std::vector< bool > & border, ProgressReporter & progress );
+
+  const InputImageType * m_Input;
+  const LabelImageType * m_MarkerImage;
+  LabelImageType * m_Output;
+  const ConnectivityType * m_Connectivity;
+  const MaskImageType * m_MaskImage;
+  LabelImagePixelType m_BackgroundValue;
+  InputImagePixelType m_MaximumValue;
+  bool m_UseMaximumValue;
+  bool m_UseSparseStatus;
+  PathCostType m_PathCost;
+
+  IndexType m_Start;
+  SizeType m_Size;
+  std::vector< OffsetType > m_Neighbors;
+  std::vector< long > m_Offsets;
+  std::vector< unsigned int > m_Inside;
+  std::vector< bool > * m_StatusBuffer;
+  std::vector< bool > * m_BorderBuffer;
+  QueueType * m_Queue;
+  unsigned long m_NumberOfPixels;
+  const InputImagePixelType * m_InputBuffer;
+  const MaskImagePixelType * m_MaskBuffer;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageForestingTransform.txx"
+#endif
+
+#endif
@@ -0,0 +1,368 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkImageForestingTransform.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkImageForestingTransform_txx
+#define __itkImageForestingTransform_txx
+
+#include "itkImageForestingTransform.h"
+
+namespace itk {
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::ImageForestingTransform()
+{
+  m_Input = NULL;
+  m_MarkerImage = NULL;
+  m_Output = NULL;
+  m_Connectivity = NULL;
+  m_MaskImage = NULL;
+  m_BackgroundValue = NumericTraits< LabelImagePixelType >::Zero;
+  m_MaximumValue = NumericTraits< InputImagePixelType >::max();
+  m_UseMaximumValue = false;
+  m_UseSparseStatus = false;
+  m_StatusBuffer = NULL;
+  m_BorderBuffer = NULL;
+  m_Queue = NULL;
+  m_NumberOfPixels = 0;
+  m_InputBuffer = NULL;
+  m_MaskBuffer = NULL;
+}
+
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+template <class TBorder>
+void
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::ComputeNeighbors( unsigned long p, const TBorder & border )
+{
+  m_Inside.clear();
+  if( !border[p] )
+    {
+    // all the neighbors are in the image
+    for( unsigned int i=0; i<m_Neighbors.size(); i++ )
+      {
+      m_Inside.push_back( i );
+      }
+    return;
+    }
+  const IndexType idx = m_Output->ComputeIndex( p );
+  for( unsigned int i=0; i<m_Neighbors.size(); i++ )
+    {
+    bool inside = true;
+    for( unsigned int d=0; d<ImageDimension && inside; d++ )
+      {
+      long c = idx[d] + m_Neighbors[i][d];
+      inside = c >= m_Start[d] && c < m_Start[d] + (long)m_Size[d];
+      }
+    if( inside )
+      {
+      m_Inside.push_back( i );
+      }
+    }
+}
+
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+template <class TBorder>
+void
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::ComputeBorder( TBorder & border )
+{
+  // the index is incremented along the buffer, without division. Only the
+  // pixels whose neighbors are computed are flagged, so a sparse border only
+  // allocates the blocks of the markers and of the floodable pixels.
+  const LabelImagePixelType * markers = m_MarkerImage->GetBufferPointer();
+  border.assign( m_NumberOfPixels, false );
+  SizeType position;
+  position.Fill( 0 );
+  for( unsigned long p=0; p<m_NumberOfPixels; p++ )
+    {
+    bool onBorder = false;
+    for( unsigned int d=0; d<ImageDimension && !onBorder; d++ )
+      {
+      onBorder = position[d] == 0 || position[d] == m_Size[d] - 1;
+      }
+    if( onBorder && ( markers[p] != m_BackgroundValue || this->IsFloodable( p ) ) )
+      {
+      border[p] = true;
+      }
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      if( ++position[d] < m_Size[d] )
+        { break; }
+      position[d] = 0;
+      }
+    }
+}
+
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+void
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::Compute( ProgressReporter & progress )
+{
+  if( !m_Input || !m_MarkerImage || !m_Output || !m_Connectivity )
+    { itkGenericExceptionMacro( << "Input, marker image, output and connectivity must be set." ); }
+
+  m_Start = m_Output->GetBufferedRegion().GetIndex();
+  m_Size = m_Output->GetBufferedRegion().GetSize();
+  if( m_Input->GetBufferedRegion().GetSize() != m_Size || m_MarkerImage->GetBufferedRegion().GetSize() != m_Size )
+    { itkGenericExceptionMacro( << "Input, marker image and output must have the same buffered region." ); }
+  if( m_MaskImage && m_MaskImage->GetBufferedRegion().GetSize() != m_Size )
+    { itkGenericExceptionMacro( << "Mask image and output must have the same buffered region." ); }
+  m_NumberOfPixels = m_Output->GetBufferedRegion().GetNumberOfPixels();
+  m_InputBuffer = m_Input->GetBufferPointer();
+  m_MaskBuffer = m_MaskImage ? m_MaskImage->GetBufferPointer() : NULL;
+
+  // the neighbors, in the same order as in the neighborhood iterators, and
+  // their offset in the buffer
+  m_Neighbors = m_Connectivity->GetNeighbors();
+  m_Offsets.assign( m_Neighbors.size(), 0 );
+  for( unsigned int i=0; i<m_Neighbors.size(); i++ )
+    {
+    long stride = 1;
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      m_Offsets[i] += m_Neighbors[i][d] * stride;
+      stride *= m_Size[d];
+      }
+    }
+  m_Inside.reserve( m_Neighbors.size() );
+
+  m_PathCost.Initialize( m_Input, m_Neighbors );
+
+  if( TieBreakType::LabelAtPop )
+    {
+    // the pixels already in the queue or processed
+    if( m_UseSparseStatus )
+      {
+      BlockedBitArray status;
+      BlockedBitArray border;
+      this->ComputeBorder( border );
+      this->ComputeLabelAtPop( status, border, progress );
+      }
+    else
+      {
+      std::vector< bool > localStatus;
+      std::vector< bool > localBorder;
+      std::vector< bool > & border = m_BorderBuffer ? *m_BorderBuffer : localBorder;
+      this->ComputeBorder( border );
+      this->ComputeLabelAtPop( m_StatusBuffer ? *m_StatusBuffer : localStatus, border, progress );
+      }
+    }
+  else
+    {
+    std::vector< bool > localBorder;
+    std::vector< bool > & border = m_BorderBuffer ? *m_BorderBuffer : localBorder;
+    this->ComputeBorder( border );
+    this->ComputeLabelAtPush( border, progress );
+    }
+}
+
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+template <class TStatus>
+void
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::ComputeLabelAtPop( TStatus & status, const TStatus & border, ProgressReporter & progress )
+{
+  const LabelImagePixelType bgLabel = m_BackgroundValue;
+  const unsigned long nbOfPixels = m_NumberOfPixels;
+  const LabelImagePixelType * markers = m_MarkerImage->GetBufferPointer();
+  LabelImagePixelType * labels = m_Output->GetBufferPointer();
+
+  // FAH (in french: File d'Attente Hierarchique)
+  QueueType localQueue;
+  QueueType & fah = m_Queue ? *m_Queue : localQueue;
+  if( m_Queue )
+    {
+    fah.Clear();
+    }
+
+  // only the marker pixels are set, so a sparse status only allocates the
+  // blocks of the markers
+  status.assign( nbOfPixels, false );
+
+  // copy the markers to the output image
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    labels[p] = markers[p];
+    if( markers[p] != bgLabel )
+      {
+      status[p] = true;
+      m_PathCost.Conquer( p, labels[p] );
+      }
+    }
+
+  // put the background neighbors of the markers in the queue
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( markers[p] != bgLabel )
+      {
+      this->ComputeNeighbors( p, border );
+      for( unsigned int j=0; j<m_Inside.size(); j++ )
+        {
+        const unsigned int & i = m_Inside[j];
+        const unsigned long n = p + m_Offsets[i];
+        if( !status[n] && markers[n] == bgLabel && this->IsFloodable( n ) )
+          {
+          fah.Push( m_PathCost.SeedNeighbor( p, n, i, labels[p] ), n );
+          status[n] = true;
+          }
+        }
+      // this pixel will not be used in the flooding stage.
+      progress.CompletedPixel();
+      }
+    progress.CompletedPixel();
+    }
+
+  // flooding
+  while( !fah.Empty() )
+    {
+    const KeyType currentValue = fah.FrontKey();
+    const unsigned long p = fah.FrontValue();
+    fah.Pop();
+    if( !m_PathCost.IsCurrent( currentValue, p ) )
+      { continue; }
+
+    // If there is only one marker value in the neighbors, give that value
+    // to the pixel, else keep it as is (watershed line)
+    this->ComputeNeighbors( p, border );
+    LabelImagePixelType marker = bgLabel;
+    bool collision = false;
+    for( unsigned int j=0; j<m_Inside.size(); j++ )
+      {
+      const LabelImagePixelType & o = labels[ p + m_Offsets[ m_Inside[j] ] ];
+      if( o != bgLabel )
+        {
+        if( marker != bgLabel && o != marker )
+          {
+          collision = true;
+          break;
+          }
+        marker = o;
+        }
+      }
+    if( !collision )
+      {
+      labels[p] = marker;
+      m_PathCost.Conquer( p, marker );
+      // and propagate to the neighbors
+      for( unsigned int j=0; j<m_Inside.size(); j++ )
+        {
+        const unsigned int & i = m_Inside[j];
+        const unsigned long n = p + m_Offsets[i];
+        if( !status[n] && this->IsFloodable( n ) )
+          {
+          fah.Push( m_PathCost.Extend( currentValue, p, n, i, marker ), n );
+          status[n] = true;
+          }
+        }
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template <class TInputImage, class TLabelImage, class TPathCost, class TTieBreak, class TMaskImage>
+void
+ImageForestingTransform<TInputImage, TLabelImage, TPathCost, TTieBreak, TMaskImage>
+::ComputeLabelAtPush( const std::vector< bool > & border, ProgressReporter & progress )
+{
+  const LabelImagePixelType bgLabel = m_BackgroundValue;
+  const unsigned long nbOfPixels = m_NumberOfPixels;
+  const LabelImagePixelType * markers = m_MarkerImage->GetBufferPointer();
+  LabelImagePixelType * labels = m_Output->GetBufferPointer();
+
+  // FAH (in french: File d'Attente Hierarchique)
+  QueueType localQueue;
+  QueueType & fah = m_Queue ? *m_Queue : localQueue;
+  if( m_Queue )
+    {
+    fah.Clear();
+    }
+
+  // copy the markers to the output image
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    labels[p] = markers[p];
+    if( labels[p] != bgLabel )
+      {
+      m_PathCost.Conquer( p, labels[p] );
+      }
+    }
+
+  // put the markers with a background neighbor in the queue
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( markers[p] != bgLabel )
+      {
+      const KeyType key = m_PathCost.Seed( p );
+      this->ComputeNeighbors( p, border );
+      bool haveBgNeighbor = false;
+      for( unsigned int j=0; j<m_Inside.size(); j++ )
+        {
+        const unsigned long n = p + m_Offsets[ m_Inside[j] ];
+        if( markers[n] == bgLabel && this->IsFloodable( n ) )
+          {
+          haveBgNeighbor = true;
+          break;
+          }
+        }
+      if( haveBgNeighbor )
+        {
+        fah.Push( key, p );
+        }
+      else
+        {
+        // this pixel will not be used in the flooding stage.
+        progress.CompletedPixel();
+        }
+      }
+    progress.CompletedPixel();
+    }
+
+  // flooding
+  while( !fah.Empty() )
+    {
+    const KeyType currentValue = fah.FrontKey();
+    const unsigned long p = fah.FrontValue();
+    fah.Pop();
+    if( !m_PathCost.IsCurrent( currentValue, p ) )
+      { continue; }
+
+    const LabelImagePixelType currentMarker = labels[p];
+    this->ComputeNeighbors( p, border );
+    for( unsigned int j=0; j<m_Inside.size(); j++ )
+      {
+      const unsigned int & i = m_Inside[j];
+      const unsigned long n = p + m_Offsets[i];
+      KeyType key;
+      if( this->IsFloodable( n )
+          && m_PathCost.Relax( currentValue, p, n, i, labels[n] != bgLabel, currentMarker, key ) )
+        {
+        labels[n] = currentMarker;
+        m_PathCost.Conquer( n, currentMarker );
+        fah.Push( key, n );
+        progress.CompletedPixel();
+        }
+      }
+    }
+}
+
+}// end namespace itk
+#endif
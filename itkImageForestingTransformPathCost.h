@@ -0,0 +1,359 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkImageForestingTransformPathCost.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkImageForestingTransformPathCost_h
+#define __itkImageForestingTransformPathCost_h
+
+#include "itkNumericTraits.h"
+#include "itkHierarchicalQueue.h"
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/** \class MaxArcPathCost
+ *  \brief The cost of a path is the highest pixel value along the path
+ *
+ * This is the cost of the flooding: the watershed of Meyer with
+ * WatershedLineTieBreak, and the one of Beucher with FirstComeTieBreak.
+ * TQueue is the queue used by the propagation; DenseHierarchicalQueue can
+ * be used on a rank image.
+ *
+ * \sa ImageForestingTransform
+ */
+template <class TInputImage, class TLabelImage,
+          class TQueue=HierarchicalQueue< typename TInputImage::PixelType, unsigned long > >
+class MaxArcPathCost
+{
+public:
+  typedef typename TInputImage::PixelType   InputImagePixelType;
+  typedef typename TInputImage::OffsetType  OffsetType;
+  typedef typename TLabelImage::PixelType   LabelImagePixelType;
+  typedef InputImagePixelType               KeyType;
+  typedef TQueue                            QueueType;
+
+  void Initialize( const TInputImage * input, const std::vector< OffsetType > & )
+    {
+    m_Buffer = input->GetBufferPointer();
+    }
+
+  inline void Conquer( unsigned long, const LabelImagePixelType & ) {}
+
+  inline KeyType Seed( unsigned long p ) const
+    {
+    return m_Buffer[p];
+    }
+
+  inline KeyType SeedNeighbor( unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & ) const
+    {
+    return m_Buffer[n];
+    }
+
+  inline KeyType Extend( const KeyType & k, unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & ) const
+    {
+    return std::max( k, m_Buffer[n] );
+    }
+
+  inline bool Relax( const KeyType & k, unsigned long, unsigned long n, unsigned int, bool reached,
+                     const LabelImagePixelType &, KeyType & nk )
+    {
+    if( reached )
+      { return false; }
+    nk = std::max( k, m_Buffer[n] );
+    return true;
+    }
+
+  inline bool IsCurrent( const KeyType &, unsigned long ) const
+    {
+    return true;
+    }
+
+private:
+  const InputImagePixelType * m_Buffer;
+};
+
+
+/** \class LexicographicPathCost
+ *  \brief The cost of a path is the highest pixel value, then the distance
+ * on the plateau
+ *
+ * The pixels of a plateau are given to the nearest marker, according to
+ * the image spacing. The lower pixels not reached yet are filled to the
+ * level of the plateau, so the basins are reconstructed while they are
+ * flooded. With WatershedLineTieBreak, the distance is not used.
+ *
+ * \sa ImageForestingTransform
+ */
+template <class TInputImage, class TLabelImage>
+class LexicographicPathCost
+{
+public:
+  typedef typename TInputImage::PixelType   InputImagePixelType;
+  typedef typename TInputImage::OffsetType  OffsetType;
+  typedef typename TLabelImage::PixelType   LabelImagePixelType;
+  typedef InputImagePixelType               KeyType;
+  typedef HierarchicalQueue< KeyType, unsigned long > QueueType;
+  typedef float                             DistancePixelType;
+
+  void Initialize( const TInputImage * input, const std::vector< OffsetType > & neighbors )
+    {
+    const unsigned long nbOfPixels = input->GetBufferedRegion().GetNumberOfPixels();
+    m_Reconstruction.assign( input->GetBufferPointer(), input->GetBufferPointer() + nbOfPixels );
+    m_Distance.assign( nbOfPixels, NumericTraits< DistancePixelType >::max() );
+    const typename TInputImage::SpacingType & spacing = input->GetSpacing();
+    m_Weights.clear();
+    for( unsigned int i=0; i<neighbors.size(); i++ )
+      {
+      float w = 0;
+      for( unsigned int d=0; d<TInputImage::ImageDimension; d++ )
+        {
+        w += pow( neighbors[i][d] * spacing[d], 2 );
+        }
+      m_Weights.push_back( sqrt( w ) );
+      }
+    }
+
+  inline void Conquer( unsigned long, const LabelImagePixelType & ) {}
+
+  inline KeyType Seed( unsigned long p )
+    {
+    m_Distance[p] = 0;
+    return NumericTraits< InputImagePixelType >::NonpositiveMin();
+    }
+
+  inline KeyType SeedNeighbor( unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & ) const
+    {
+    return m_Reconstruction[n];
+    }
+
+  inline KeyType Extend( const KeyType & k, unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & ) const
+    {
+    return std::max( k, m_Reconstruction[n] );
+    }
+
+  inline bool Relax( const KeyType & k, unsigned long p, unsigned long n, unsigned int i, bool reached,
+                     const LabelImagePixelType &, KeyType & nk )
+    {
+    DistancePixelType distance;
+    const InputImagePixelType & value = m_Reconstruction[n];
+    nk = k;
+    if( value == k )
+      {
+      // we are on the same plateau
+      distance = m_Distance[p] + m_Weights[i];
+      }
+    else if( value > k )
+      {
+      // new plateau
+      distance = m_Weights[i];
+      nk = value;
+      }
+    else if( !reached )
+      {
+      // reconstruction
+      m_Reconstruction[n] = k;
+      distance = m_Distance[p] + m_Weights[i];
+      }
+    else
+      {
+      // going somewhere we've been
+      return false;
+      }
+    if( distance < m_Distance[n] )
+      {
+      // found a cheaper way of getting to the target pixel
+      m_Distance[n] = distance;
+      return true;
+      }
+    return false;
+    }
+
+  inline bool IsCurrent( const KeyType &, unsigned long ) const
+    {
+    return true;
+    }
+
+private:
+  std::vector< InputImagePixelType > m_Reconstruction;
+  std::vector< DistancePixelType > m_Distance;
+  std::vector< DistancePixelType > m_Weights;
+};
+
+
+/** \class AdditivePathCost
+ *  \brief The cost of a path is the sum of the pixel values along the
+ * path, weighted by the length of the steps
+ *
+ * The pixel values are the cost to cross the pixels, and must be positive.
+ * With a constant input image, the labels are propagated to the nearest
+ * marker, which gives the geodesic Voronoi partition of the image. Use it
+ * with FirstComeTieBreak: the cost of a pixel is then improved until it is
+ * minimal, as in the Dijkstra algorithm.
+ *
+ * \sa ImageForestingTransform
+ */
+template <class TInputImage, class TLabelImage>
+class AdditivePathCost
+{
+public:
+  typedef typename TInputImage::PixelType   InputImagePixelType;
+  typedef typename TInputImage::OffsetType  OffsetType;
+  typedef typename TLabelImage::PixelType   LabelImagePixelType;
+  typedef double                            KeyType;
+  typedef HierarchicalQueue< KeyType, unsigned long > QueueType;
+
+  void Initialize( const TInputImage * input, const std::vector< OffsetType > & neighbors )
+    {
+    m_Buffer = input->GetBufferPointer();
+    m_Cost.assign( input->GetBufferedRegion().GetNumberOfPixels(), NumericTraits< KeyType >::max() );
+    const typename TInputImage::SpacingType & spacing = input->GetSpacing();
+    m_Weights.clear();
+    for( unsigned int i=0; i<neighbors.size(); i++ )
+      {
+      double w = 0;
+      for( unsigned int d=0; d<TInputImage::ImageDimension; d++ )
+        {
+        w += pow( neighbors[i][d] * spacing[d], 2 );
+        }
+      m_Weights.push_back( sqrt( w ) );
+      }
+    }
+
+  inline void Conquer( unsigned long, const LabelImagePixelType & ) {}
+
+  inline KeyType Seed( unsigned long p )
+    {
+    m_Cost[p] = 0;
+    return 0;
+    }
+
+  inline KeyType SeedNeighbor( unsigned long, unsigned long n, unsigned int i, const LabelImagePixelType & ) const
+    {
+    return m_Weights[i] * m_Buffer[n];
+    }
+
+  inline KeyType Extend( const KeyType & k, unsigned long, unsigned long n, unsigned int i, const LabelImagePixelType & ) const
+    {
+    return k + m_Weights[i] * m_Buffer[n];
+    }
+
+  inline bool Relax( const KeyType &, unsigned long p, unsigned long n, unsigned int i, bool,
+                     const LabelImagePixelType &, KeyType & nk )
+    {
+    nk = m_Cost[p] + m_Weights[i] * m_Buffer[n];
+    if( nk < m_Cost[n] )
+      {
+      m_Cost[n] = nk;
+      return true;
+      }
+    return false;
+    }
+
+  /** a pixel may be in the queue several times; only the last one is used */
+  inline bool IsCurrent( const KeyType & k, unsigned long p ) const
+    {
+    return k <= m_Cost[p];
+    }
+
+private:
+  const InputImagePixelType * m_Buffer;
+  std::vector< KeyType > m_Cost;
+  std::vector< KeyType > m_Weights;
+};
+
+
+/** \class RegionMeanPathCost
+ *  \brief The cost of a pixel is its distance to the mean of the region
+ *
+ * This is the seeded region growing of Adams and Bischof: the pixels
+ * adjacent to a region are put in the queue with the absolute difference
+ * between their value and the mean of the region, and the mean is updated
+ * each time a pixel is added to a region. With WatershedLineTieBreak, the
+ * pixels which touch several regions are kept as boundary pixels.
+ *
+ * See "Seeded Region Growing", R. Adams and L. Bischof, IEEE PAMI, 1994.
+ *
+ * \sa ImageForestingTransform
+ */
+template <class TInputImage, class TLabelImage>
+class RegionMeanPathCost
+{
+public:
+  typedef typename TInputImage::PixelType   InputImagePixelType;
+  typedef typename TInputImage::OffsetType  OffsetType;
+  typedef typename TLabelImage::PixelType   LabelImagePixelType;
+  typedef double                            KeyType;
+  typedef HierarchicalQueue< KeyType, unsigned long > QueueType;
+
+  void Initialize( const TInputImage * input, const std::vector< OffsetType > & )
+    {
+    m_Buffer = input->GetBufferPointer();
+    m_Sum.clear();
+    m_Count.clear();
+    }
+
+  inline void Conquer( unsigned long p, const LabelImagePixelType & label )
+    {
+    m_Sum[label] += m_Buffer[p];
+    m_Count[label]++;
+    }
+
+  inline KeyType Seed( unsigned long ) const
+    {
+    return 0;
+    }
+
+  inline KeyType SeedNeighbor( unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & label )
+    {
+    return this->Delta( n, label );
+    }
+
+  inline KeyType Extend( const KeyType &, unsigned long, unsigned long n, unsigned int, const LabelImagePixelType & label )
+    {
+    return this->Delta( n, label );
+    }
+
+  inline bool Relax( const KeyType &, unsigned long, unsigned long n, unsigned int, bool reached,
+                     const LabelImagePixelType & label, KeyType & nk )
+    {
+    if( reached )
+      { return false; }
+    nk = this->Delta( n, label );
+    return true;
+    }
+
+  inline bool IsCurrent( const KeyType &, unsigned long ) const
+    {
+    return true;
+    }
+
+private:
+  inline KeyType Delta( unsigned long n, const LabelImagePixelType & label )
+    {
+    return fabs( m_Buffer[n] - m_Sum[label] / m_Count[label] );
+    }
+
+  const InputImagePixelType * m_Buffer;
+  std::map< LabelImagePixelType, double > m_Sum;
+  std::map< LabelImagePixelType, unsigned long > m_Count;
+};
+
+} // end namespace itk
+
+#endif
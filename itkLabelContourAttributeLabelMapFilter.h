@@ -0,0 +1,94 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelContourAttributeLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelContourAttributeLabelMapFilter_h
+#define __itkLabelContourAttributeLabelMapFilter_h
+
+#include "itkLabelContourLabelMapFilter.h"
+#include "itkAttributeLabelObject.h"
+
+namespace itk
+{
+
+/** \class LabelContourAttributeLabelMapFilter
+ * \brief Store the number of pixels of the contour of the objects in an attribute
+ *
+ * The contour is computed as in LabelContourLabelMapFilter, but the lines
+ * of the objects are kept unchanged: only the number of pixels on the inner
+ * contour is stored in the attribute given by the attribute accessor. It can
+ * be used as a simple, connectivity dependent, estimation of the perimeter
+ * of the objects.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa LabelContourLabelMapFilter, AttributeLabelObject
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TImage, class TAttributeAccessor=
+    typename Functor::AttributeLabelObjectAccessor< typename TImage::LabelObjectType > >
+class ITK_EXPORT LabelContourAttributeLabelMapFilter : public LabelContourLabelMapFilter<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelContourAttributeLabelMapFilter  Self;
+  typedef LabelContourLabelMapFilter<TImage>  Superclass;
+  typedef SmartPointer<Self>  Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelContourAttributeLabelMapFilter, LabelContourLabelMapFilter);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename Superclass::LabelObjectType   LabelObjectType;
+  typedef typename Superclass::LineContainerType LineContainerType;
+
+  typedef TAttributeAccessor AttributeAccessorType;
+  typedef typename AttributeAccessorType::AttributeValueType AttributeValueType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+protected:
+  LabelContourAttributeLabelMapFilter() {};
+  ~LabelContourAttributeLabelMapFilter() {};
+
+  virtual void ThreadedGenerateData( LabelObjectType * labelObject )
+    {
+    LineContainerType contour;
+    this->ComputeContour( labelObject, contour );
+    unsigned long size = 0;
+    for( typename LineContainerType::const_iterator it = contour.begin(); it != contour.end(); it++ )
+      {
+      size += it->GetLength();
+      }
+    AttributeAccessorType accessor;
+    accessor( labelObject, static_cast< AttributeValueType >( size ) );
+    }
+
+private:
+  LabelContourAttributeLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+};
+
+} // end namespace itk
+
+#endif
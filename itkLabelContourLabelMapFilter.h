@@ -0,0 +1,175 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelContourLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelContourLabelMapFilter_h
+#define __itkLabelContourLabelMapFilter_h
+
+#include "itkInPlaceLabelMapFilter.h"
+#include "itkConnectivity.h"
+#include <vector>
+#include <map>
+
+namespace itk
+{
+
+/** \class LabelContourLabelMapFilter
+ * \brief Replace the objects of a label map by their inner contour
+ *
+ * A pixel of an object is on its contour if one of its neighbors, according
+ * to the connectivity, is in the image but not in the object: it is either
+ * in the background or in another object. The pixels outside the largest
+ * possible region of the label map are not considered, so the objects are
+ * not closed on the border of the image, as with BinaryBorderImageFilter.
+ *
+ * The contour is computed directly from the lines of the objects, without
+ * building an image: each line is compared with the lines of the same
+ * object in the neighbor rows and slices, and only the parts of the line
+ * facing a hole in those rows are kept. The cost is proportional to the
+ * number of lines, not to the number of pixels, and the objects are
+ * processed in parallel.
+ *
+ * The lines of the objects are replaced by the lines of their contour. Use
+ * LabelContourAttributeLabelMapFilter to keep the objects unchanged and
+ * only store the size of their contour.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa BinaryBorderImageFilter, LabelContourAttributeLabelMapFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template <class TImage>
+class ITK_EXPORT LabelContourLabelMapFilter : public InPlaceLabelMapFilter<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelContourLabelMapFilter  Self;
+  typedef InPlaceLabelMapFilter<TImage>  Superclass;
+  typedef SmartPointer<Self>  Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelContourLabelMapFilter, InPlaceLabelMapFilter);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::LabelObjectType LabelObjectType;
+
+  typedef typename LabelObjectType::LineType          LineType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef Connectivity< ImageDimension > ConnectivityType;
+  typedef typename ConnectivityType::OffsetType OffsetType;
+
+  /**
+   * Set/Get whether the contour is defined by the face connectivity or by the
+   * face+edge+vertex connectivity. Default is FullyConnectedOff. A fully
+   * connected neighborhood gives a thicker contour.
+   */
+  void SetFullyConnected( bool value )
+    {
+    int oldCellDimension = m_Connectivity->GetCellDimension();
+    m_Connectivity->SetFullyConnected( value );
+    if( oldCellDimension != m_Connectivity->GetCellDimension() )
+      {
+      this->Modified();
+      }
+    }
+
+  bool GetFullyConnected() const
+    {
+    return m_Connectivity->GetFullyConnected();
+    }
+
+  void FullyConnectedOn()
+    {
+    this->SetFullyConnected( true );
+    }
+
+  void FullyConnectedOff()
+    {
+    this->SetFullyConnected( false );
+    }
+
+  /**
+   * Get/Set the connectivity used to find the neighbors of the pixels.
+   */
+  itkSetObjectMacro( Connectivity, ConnectivityType );
+  itkGetObjectMacro( Connectivity, ConnectivityType );
+  itkGetConstObjectMacro( Connectivity, ConnectivityType );
+
+protected:
+  LabelContourLabelMapFilter();
+  ~LabelContourLabelMapFilter() {};
+
+  virtual void PrintSelf(std::ostream& os, Indent indent) const;
+
+  virtual void BeforeThreadedGenerateData();
+
+  virtual void ThreadedGenerateData( LabelObjectType * labelObject );
+
+  /** Compute the lines of the contour of an object. The lines are sorted in
+   * the raster order and don't overlap. This method is thread safe once
+   * BeforeThreadedGenerateData() has been called. */
+  void ComputeContour( const LabelObjectType * labelObject, LineContainerType & contour ) const;
+
+private:
+  LabelContourLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  /** the first and the last index on the axis 0 of a part of a row */
+  typedef std::pair< long, long > RunType;
+  typedef std::vector< RunType > RunContainerType;
+
+  /** the runs of an object, by row. The key is the index of the first pixel
+   * of the row. */
+  typedef std::map< IndexType, RunContainerType, Functor::IndexLexicographicCompare< ImageDimension > > RowMapType;
+
+  /** a neighbor row, and the shifts on the axis 0 of the neighbors of a
+   * pixel in that row */
+  struct RowNeighborType
+    {
+    OffsetType Offset;
+    long MinShift;
+    long MaxShift;
+    };
+
+  typename ConnectivityType::Pointer m_Connectivity;
+
+  // set by BeforeThreadedGenerateData(), and shared by the threads
+  RegionType m_Region;
+  std::vector< RowNeighborType > m_RowNeighbors;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelContourLabelMapFilter.txx"
+#endif
+
+#endif
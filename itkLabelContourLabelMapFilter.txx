@@ -0,0 +1,258 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelContourLabelMapFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelContourLabelMapFilter_txx
+#define __itkLabelContourLabelMapFilter_txx
+
+#include "itkLabelContourLabelMapFilter.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TImage>
+LabelContourLabelMapFilter<TImage>
+::LabelContourLabelMapFilter()
+{
+  m_Connectivity = ConnectivityType::New();
+  m_Connectivity->SetFullyConnected( false );
+}
+
+
+template <class TImage>
+void
+LabelContourLabelMapFilter<TImage>
+::BeforeThreadedGenerateData()
+{
+  Superclass::BeforeThreadedGenerateData();
+
+  m_Region = this->GetOutput()->GetLargestPossibleRegion();
+
+  // group the neighbors by row. The shifts on the axis 0 are always -1, 0, 1
+  // or only 0, so they are stored as an interval.
+  m_RowNeighbors.clear();
+  const typename ConnectivityType::OffsetContainerType & neighbors = m_Connectivity->GetNeighbors();
+  for( unsigned int i=0; i<neighbors.size(); i++ )
+    {
+    OffsetType offset = neighbors[i];
+    long shift = offset[0];
+    offset[0] = 0;
+    bool sameRow = true;
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      if( offset[d] != 0 )
+        {
+        sameRow = false;
+        }
+      }
+    if( sameRow )
+      {
+      // the neighbors in the same row are managed with the runs themselves
+      continue;
+      }
+    bool found = false;
+    for( unsigned int j=0; j<m_RowNeighbors.size() && !found; j++ )
+      {
+      if( m_RowNeighbors[j].Offset == offset )
+        {
+        m_RowNeighbors[j].MinShift = std::min( m_RowNeighbors[j].MinShift, shift );
+        m_RowNeighbors[j].MaxShift = std::max( m_RowNeighbors[j].MaxShift, shift );
+        found = true;
+        }
+      }
+    if( !found )
+      {
+      RowNeighborType rowNeighbor;
+      rowNeighbor.Offset = offset;
+      rowNeighbor.MinShift = shift;
+      rowNeighbor.MaxShift = shift;
+      m_RowNeighbors.push_back( rowNeighbor );
+      }
+    }
+}
+
+
+template <class TImage>
+void
+LabelContourLabelMapFilter<TImage>
+::ThreadedGenerateData( LabelObjectType * labelObject )
+{
+  LineContainerType contour;
+  this->ComputeContour( labelObject, contour );
+  labelObject->GetLineContainer().swap( contour );
+}
+
+
+template <class TImage>
+void
+LabelContourLabelMapFilter<TImage>
+::ComputeContour( const LabelObjectType * labelObject, LineContainerType & contour ) const
+{
+  contour.clear();
+
+  const IndexType & regionIdx = m_Region.GetIndex();
+  const long min0 = regionIdx[0];
+  const long max0 = regionIdx[0] + (long)m_Region.GetSize()[0] - 1;
+
+  // store the runs by row, sorted, and merge the ones which are touching, so
+  // a pixel just before or just after a run is never in the object
+  RowMapType rows;
+  const LineContainerType & lines = labelObject->GetLineContainer();
+  for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+    {
+    IndexType rowIdx = lit->GetIndex();
+    long first = rowIdx[0];
+    rowIdx[0] = 0;
+    rows[ rowIdx ].push_back( RunType( first, first + (long)lit->GetLength() - 1 ) );
+    }
+
+  for( typename RowMapType::iterator rit = rows.begin(); rit != rows.end(); rit++ )
+    {
+    RunContainerType & runs = rit->second;
+    std::sort( runs.begin(), runs.end() );
+    unsigned long last = 0;
+    for( unsigned long i=1; i<runs.size(); i++ )
+      {
+      if( runs[i].first <= runs[last].second + 1 )
+        {
+        runs[last].second = std::max( runs[last].second, runs[i].second );
+        }
+      else
+        {
+        runs[++last] = runs[i];
+        }
+      }
+    runs.resize( last + 1 );
+    }
+
+  RunContainerType holes;
+  RunContainerType contourRuns;
+  const RunContainerType emptyRow;
+
+  for( typename RowMapType::const_iterator rit = rows.begin(); rit != rows.end(); rit++ )
+    {
+    const IndexType & rowIdx = rit->first;
+    const RunContainerType & runs = rit->second;
+    contourRuns.clear();
+
+    // the neighbors in the same row: only the ends of the runs can have a
+    // neighbor outside the object
+    for( typename RunContainerType::const_iterator it = runs.begin(); it != runs.end(); it++ )
+      {
+      if( it->first > min0 )
+        {
+        contourRuns.push_back( RunType( it->first, it->first ) );
+        }
+      if( it->second < max0 )
+        {
+        contourRuns.push_back( RunType( it->second, it->second ) );
+        }
+      }
+
+    // the neighbor rows: the pixels in front of a hole of the neighbor row,
+    // with the shift of the connectivity, are on the contour
+    for( unsigned int n=0; n<m_RowNeighbors.size(); n++ )
+      {
+      const RowNeighborType & rowNeighbor = m_RowNeighbors[n];
+      IndexType nIdx = rowIdx + rowNeighbor.Offset;
+      bool inside = true;
+      for( unsigned int d=1; d<ImageDimension; d++ )
+        {
+        if( nIdx[d] < regionIdx[d] || nIdx[d] >= regionIdx[d] + (long)m_Region.GetSize()[d] )
+          {
+          inside = false;
+          }
+        }
+      if( !inside )
+        {
+        continue;
+        }
+
+      typename RowMapType::const_iterator nit = rows.find( nIdx );
+      const RunContainerType & nRuns = nit != rows.end() ? nit->second : emptyRow;
+
+      // the holes of the neighbor row, extended by the shifts. Their bounds
+      // are still sorted after the extension.
+      holes.clear();
+      long start = min0;
+      for( typename RunContainerType::const_iterator it = nRuns.begin(); it != nRuns.end(); it++ )
+        {
+        if( it->first > start )
+          {
+          holes.push_back( RunType( start - rowNeighbor.MaxShift, it->first - 1 - rowNeighbor.MinShift ) );
+          }
+        start = it->second + 1;
+        }
+      if( start <= max0 )
+        {
+        holes.push_back( RunType( start - rowNeighbor.MaxShift, max0 - rowNeighbor.MinShift ) );
+        }
+
+      // intersect the runs with the holes
+      typename RunContainerType::const_iterator hit = holes.begin();
+      for( typename RunContainerType::const_iterator it = runs.begin(); it != runs.end() && hit != holes.end(); it++ )
+        {
+        while( hit != holes.end() && hit->second < it->first )
+          {
+          hit++;
+          }
+        for( typename RunContainerType::const_iterator hit2 = hit; hit2 != holes.end() && hit2->first <= it->second; hit2++ )
+          {
+          contourRuns.push_back( RunType( std::max( it->first, hit2->first ), std::min( it->second, hit2->second ) ) );
+          }
+        }
+      }
+
+    if( contourRuns.empty() )
+      {
+      continue;
+      }
+
+    // merge the parts of the contour, and store them as lines
+    std::sort( contourRuns.begin(), contourRuns.end() );
+    RunType current = contourRuns[0];
+    IndexType idx = rowIdx;
+    for( unsigned long i=1; i<contourRuns.size(); i++ )
+      {
+      if( contourRuns[i].first <= current.second + 1 )
+        {
+        current.second = std::max( current.second, contourRuns[i].second );
+        }
+      else
+        {
+        idx[0] = current.first;
+        contour.push_back( LineType( idx, current.second - current.first + 1 ) );
+        current = contourRuns[i];
+        }
+      }
+    idx[0] = current.first;
+    contour.push_back( LineType( idx, current.second - current.first + 1 ) );
+    }
+}
+
+
+template <class TImage>
+void
+LabelContourLabelMapFilter<TImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << this->GetFullyConnected() << std::endl;
+  os << indent << "Connectivity: "  << m_Connectivity.GetPointer() << std::endl;
+}
+
+}// end namespace itk
+#endif
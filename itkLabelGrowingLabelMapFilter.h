@@ -0,0 +1,293 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelGrowingLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelGrowingLabelMapFilter_h
+#define __itkLabelGrowingLabelMapFilter_h
+
+#include "itkInPlaceLabelMapFilter.h"
+#include "itkConnectivity.h"
+#include "itkBlockedBitArray.h"
+#include "itkImage.h"
+#include <vector>
+#include <queue>
+
+namespace itk
+{
+
+/** \class LabelGrowingLabelMapFilter
+ * \brief Grow the objects of a label map in a mask, up to a maximum distance
+ *
+ * The objects of the label map are used as seeds and grow all together, in
+ * a breadth-first order: a pixel is given to the first object which reaches
+ * it, so the conflicts between neighbor objects are resolved by distance,
+ * as with a watershed on the distance map, but without computing it. This is
+ * typically used to expand the nuclei of an image to their cells.
+ *
+ * The growing is restricted to the pixels where the optional mask image is
+ * not 0, and to the pixels at a distance to the seed smaller than or equal
+ * to MaximumDistance. By default, the distance is the number of steps from
+ * the seed, with the neighbors defined by the connectivity. With
+ * UseImageSpacing, each step counts for its physical length, and the front
+ * is propagated in the order of that distance.
+ *
+ * Only the pixels reached by the growing are visited: the pixels are stored
+ * in a queue, and the visited ones in a BlockedBitArray, so the memory used
+ * is proportional to the grown area, not to the size of the image. In the
+ * breadth-first order, a pixel is given to its object when it is pushed, so
+ * it is queued only once. With UseImageSpacing, a shorter path can still be
+ * found after a pixel is pushed, so a pixel is pushed once by each neighbor
+ * which reaches it, and the duplicates are skipped when they are popped.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter, BlockedBitArray
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template <class TImage, class TMaskImage=Image< unsigned char, TImage::ImageDimension > >
+class ITK_EXPORT LabelGrowingLabelMapFilter : public InPlaceLabelMapFilter<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelGrowingLabelMapFilter  Self;
+  typedef InPlaceLabelMapFilter<TImage>  Superclass;
+  typedef SmartPointer<Self>  Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelGrowingLabelMapFilter, InPlaceLabelMapFilter);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::ConstPointer    ImageConstPointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::LabelObjectType LabelObjectType;
+
+  typedef typename LabelObjectType::LineType          LineType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  typedef TMaskImage MaskImageType;
+  typedef typename MaskImageType::PixelType       MaskImagePixelType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  typedef Connectivity< ImageDimension > ConnectivityType;
+  typedef typename ConnectivityType::OffsetType OffsetType;
+
+  /** Set the mask image. The objects only grow in the pixels where the mask
+   * is not 0. The mask is optional. */
+  void SetMaskImage(const TMaskImage *input)
+    {
+    // Process object is not const-correct so the const casting is required.
+    this->SetNthInput( 1, const_cast<TMaskImage *>(input) );
+    }
+
+  /** Get the mask image */
+  const MaskImageType * GetMaskImage() const
+    {
+    return static_cast<const MaskImageType*>(this->ProcessObject::GetInput(1));
+    }
+
+   /** Set the mask image */
+  void SetInput2(const TMaskImage *input)
+    {
+    this->SetMaskImage( input );
+    }
+
+  /**
+   * Set/Get the maximum distance between a grown pixel and its seed. Default
+   * is the maximum value of a double, so the objects grow in all the mask.
+   */
+  itkSetMacro(MaximumDistance, double);
+  itkGetConstReferenceMacro(MaximumDistance, double);
+
+  /**
+   * Set/Get whether the distance is computed with the spacing of the image.
+   * Default is false: the distance is the number of steps.
+   */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /**
+   * Set/Get whether the neighbors are defined by the face connectivity or by
+   * the face+edge+vertex connectivity. Default is FullyConnectedOff.
+   */
+  void SetFullyConnected( bool value )
+    {
+    int oldCellDimension = m_Connectivity->GetCellDimension();
+    m_Connectivity->SetFullyConnected( value );
+    if( oldCellDimension != m_Connectivity->GetCellDimension() )
+      {
+      this->Modified();
+      }
+    }
+
+  bool GetFullyConnected() const
+    {
+    return m_Connectivity->GetFullyConnected();
+    }
+
+  void FullyConnectedOn()
+    {
+    this->SetFullyConnected( true );
+    }
+
+  void FullyConnectedOff()
+    {
+    this->SetFullyConnected( false );
+    }
+
+  /**
+   * Get/Set the connectivity used to find the neighbors of the pixels.
+   */
+  itkSetObjectMacro( Connectivity, ConnectivityType );
+  itkGetObjectMacro( Connectivity, ConnectivityType );
+  itkGetConstObjectMacro( Connectivity, ConnectivityType );
+
+protected:
+  LabelGrowingLabelMapFilter();
+  ~LabelGrowingLabelMapFilter() {};
+
+  virtual void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** LabelGrowingLabelMapFilter needs the entire mask. */
+  void GenerateInputRequestedRegion();
+
+  void GenerateData();
+
+  /** a pixel in the queue, with the number of its object and its distance to
+   * the seed. The order of insertion is used to keep a breadth-first order
+   * between the pixels at the same distance. */
+  struct QueueItemType
+    {
+    double Distance;
+    unsigned long Order;
+    unsigned long Offset;
+    unsigned long Object;
+
+    bool operator>( const QueueItemType & other ) const
+      {
+      return Distance > other.Distance || ( Distance == other.Distance && Order > other.Order );
+      }
+    };
+
+  /** grow the objects from their seeds. The queue is a
+   * std::queue when all the steps have the same length, and a priority
+   * queue otherwise. */
+  template < class TQueue >
+  void Grow( TQueue & queue, const std::vector< LabelObjectType * > & objects );
+
+  /** push the neighbors of a pixel which can be grown */
+  template < class TQueue >
+  void PushNeighbors( TQueue & queue, const QueueItemType & item );
+
+  /** the front of both kinds of queue */
+  template < class TQueue >
+  static const QueueItemType & QueueFront( const TQueue & queue )
+    {
+    return queue.top();
+    }
+
+  static const QueueItemType & QueueFront( const std::queue< QueueItemType > & queue )
+    {
+    return queue.front();
+    }
+
+  /** whether the pixels are given to their object when they are pushed. In
+   * a FIFO, the first object which pushes a pixel is also the first one to
+   * pop it. */
+  template < class TQueue >
+  static bool IsGrownAtPush( const TQueue & )
+    {
+    return false;
+    }
+
+  static bool IsGrownAtPush( const std::queue< QueueItemType > & )
+    {
+    return true;
+    }
+
+  /** sort the lines in the raster order */
+  struct LineRasterCompare
+    {
+    bool operator()( const LineType & a, const LineType & b ) const
+      {
+      for( int d=ImageDimension-1; d>=0; d-- )
+        {
+        if( a.GetIndex()[d] != b.GetIndex()[d] )
+          {
+          return a.GetIndex()[d] < b.GetIndex()[d];
+          }
+        }
+      return false;
+      }
+    };
+
+  inline unsigned long IndexToOffset( const IndexType & idx ) const
+    {
+    unsigned long offset = 0;
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      offset += ( idx[d] - m_Region.GetIndex()[d] ) * m_Strides[d];
+      }
+    return offset;
+    }
+
+  inline void OffsetToIndex( unsigned long offset, IndexType & idx ) const
+    {
+    for( int d=ImageDimension-1; d>=0; d-- )
+      {
+      idx[d] = m_Region.GetIndex()[d] + offset / m_Strides[d];
+      offset = offset % m_Strides[d];
+      }
+    }
+
+private:
+  LabelGrowingLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typename ConnectivityType::Pointer m_Connectivity;
+  double m_MaximumDistance;
+  bool m_UseImageSpacing;
+
+  // the state of the growing, only valid in GenerateData()
+  RegionType m_Region;
+  unsigned long m_Strides[ImageDimension];
+  std::vector< OffsetType > m_Neighbors;
+  std::vector< long > m_NeighborOffsets;
+  std::vector< double > m_StepLengths;
+  const MaskImagePixelType * m_Mask;
+  BlockedBitArray m_Visited;
+  std::vector< std::vector< unsigned long > > m_Grown;
+  unsigned long m_Order;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelGrowingLabelMapFilter.txx"
+#endif
+
+#endif
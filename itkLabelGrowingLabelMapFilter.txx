@@ -0,0 +1,300 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelGrowingLabelMapFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelGrowingLabelMapFilter_txx
+#define __itkLabelGrowingLabelMapFilter_txx
+
+#include "itkLabelGrowingLabelMapFilter.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+namespace itk {
+
+template <class TImage, class TMaskImage>
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::LabelGrowingLabelMapFilter()
+{
+  m_Connectivity = ConnectivityType::New();
+  m_Connectivity->SetFullyConnected( false );
+  m_MaximumDistance = NumericTraits< double >::max();
+  m_UseImageSpacing = false;
+  m_Mask = NULL;
+  m_Order = 0;
+}
+
+
+template <class TImage, class TMaskImage>
+void
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the mask.
+  MaskImageType * mask = const_cast<MaskImageType *>(this->GetMaskImage());
+  if ( mask )
+    {
+    mask->SetRequestedRegion( mask->GetLargestPossibleRegion() );
+    }
+}
+
+
+template <class TImage, class TMaskImage>
+void
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::GenerateData()
+{
+  // Allocate the output
+  this->AllocateOutputs();
+
+  ImageType * output = this->GetOutput();
+
+  m_Region = output->GetLargestPossibleRegion();
+  unsigned long nbOfPixels = 1;
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    m_Strides[d] = nbOfPixels;
+    nbOfPixels *= m_Region.GetSize()[d];
+    }
+
+  m_Mask = NULL;
+  const MaskImageType * mask = this->GetMaskImage();
+  if( mask )
+    {
+    if( mask->GetBufferedRegion() != m_Region )
+      {
+      itkExceptionMacro( << "The mask image must have the same region as the label map." );
+      }
+    m_Mask = mask->GetBufferPointer();
+    }
+
+  // the neighbors, with their offset in the buffer and the length of the step
+  m_Neighbors = m_Connectivity->GetNeighbors();
+  m_NeighborOffsets.resize( m_Neighbors.size() );
+  m_StepLengths.resize( m_Neighbors.size() );
+  for( unsigned int i=0; i<m_Neighbors.size(); i++ )
+    {
+    long offset = 0;
+    double length = 0;
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      offset += m_Neighbors[i][d] * (long)m_Strides[d];
+      double l = m_Neighbors[i][d] * output->GetSpacing()[d];
+      length += l * l;
+      }
+    m_NeighborOffsets[i] = offset;
+    m_StepLengths[i] = m_UseImageSpacing ? sqrt( length ) : 1.0;
+    }
+
+  // mark the seeds as visited, so they are never grown
+  const typename ImageType::LabelObjectContainerType & labelObjectContainer = output->GetLabelObjectContainer();
+  std::vector< LabelObjectType * > objects;
+  objects.reserve( labelObjectContainer.size() );
+  m_Visited.assign( nbOfPixels, false );
+  for( typename ImageType::LabelObjectContainerType::const_iterator it = labelObjectContainer.begin();
+    it != labelObjectContainer.end();
+    it++ )
+    {
+    objects.push_back( it->second );
+    const LineContainerType & lines = it->second->GetLineContainer();
+    for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      unsigned long offset = this->IndexToOffset( lit->GetIndex() );
+      for( unsigned long i=0; i<lit->GetLength(); i++ )
+        {
+        m_Visited.Set( offset + i, true );
+        }
+      }
+    }
+
+  ProgressReporter progress( this, 0, objects.size() );
+
+  // grow all the objects together. The queue only contains the pixels of
+  // the front, so it stays small.
+  m_Grown.assign( objects.size(), std::vector< unsigned long >() );
+  m_Order = 0;
+  if( m_UseImageSpacing )
+    {
+    std::priority_queue< QueueItemType, std::vector< QueueItemType >, std::greater< QueueItemType > > queue;
+    this->Grow( queue, objects );
+    }
+  else
+    {
+    std::queue< QueueItemType > queue;
+    this->Grow( queue, objects );
+    }
+
+  // add the grown pixels to their objects
+  for( unsigned long o=0; o<objects.size(); o++ )
+    {
+    std::vector< unsigned long > & grown = m_Grown[o];
+    if( !grown.empty() )
+      {
+      LineContainerType & lines = objects[o]->GetLineContainer();
+      std::sort( grown.begin(), grown.end() );
+      IndexType idx;
+      for( unsigned long i=0; i<grown.size(); i++ )
+        {
+        this->OffsetToIndex( grown[i], idx );
+        if( i != 0 && grown[i] == grown[i-1] + 1 && idx[0] != m_Region.GetIndex()[0] )
+          {
+          lines.back().SetLength( lines.back().GetLength() + 1 );
+          }
+        else
+          {
+          lines.push_back( LineType( idx, 1 ) );
+          }
+        }
+
+      // keep the lines sorted, and merge the grown ones with the seed
+      std::sort( lines.begin(), lines.end(), LineRasterCompare() );
+      unsigned long last = 0;
+      for( unsigned long i=1; i<lines.size(); i++ )
+        {
+        if( lines[last].IsNextIndex( lines[i].GetIndex() ) )
+          {
+          lines[last].SetLength( lines[last].GetLength() + lines[i].GetLength() );
+          }
+        else
+          {
+          lines[++last] = lines[i];
+          }
+        }
+      lines.resize( last + 1 );
+
+      // release the memory now
+      std::vector< unsigned long >().swap( grown );
+      }
+    progress.CompletedPixel();
+    }
+
+  // release the memory used by the growing
+  m_Visited.assign( 0, false );
+  m_Mask = NULL;
+}
+
+
+template <class TImage, class TMaskImage>
+template < class TQueue >
+void
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::Grow( TQueue & queue, const std::vector< LabelObjectType * > & objects )
+{
+  // the neighbors of the seeds start the front
+  for( unsigned long o=0; o<objects.size(); o++ )
+    {
+    const LineContainerType & lines = objects[o]->GetLineContainer();
+    for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      QueueItemType item;
+      item.Distance = 0;
+      item.Object = o;
+      item.Offset = this->IndexToOffset( lit->GetIndex() );
+      for( unsigned long i=0; i<lit->GetLength(); i++, item.Offset++ )
+        {
+        this->PushNeighbors( queue, item );
+        }
+      }
+    }
+
+  while( !queue.empty() )
+    {
+    QueueItemType item = QueueFront( queue );
+    queue.pop();
+    if( !IsGrownAtPush( queue ) )
+      {
+      // the pixel may have been reached by another object, or by the same
+      // one with a shorter path
+      if( m_Visited.Get( item.Offset ) )
+        {
+        continue;
+        }
+      m_Visited.Set( item.Offset, true );
+      m_Grown[ item.Object ].push_back( item.Offset );
+      }
+    this->PushNeighbors( queue, item );
+    }
+}
+
+
+template <class TImage, class TMaskImage>
+template < class TQueue >
+void
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::PushNeighbors( TQueue & queue, const QueueItemType & item )
+{
+  IndexType idx;
+  this->OffsetToIndex( item.Offset, idx );
+  const IndexType & regionIdx = m_Region.GetIndex();
+  const typename RegionType::SizeType & regionSize = m_Region.GetSize();
+
+  for( unsigned int i=0; i<m_Neighbors.size(); i++ )
+    {
+    bool inside = true;
+    for( unsigned int d=0; d<ImageDimension && inside; d++ )
+      {
+      long n = idx[d] + m_Neighbors[i][d];
+      inside = n >= regionIdx[d] && n < regionIdx[d] + (long)regionSize[d];
+      }
+    if( !inside )
+      {
+      continue;
+      }
+    unsigned long offset = item.Offset + m_NeighborOffsets[i];
+    if( m_Visited.Get( offset )
+      || ( m_Mask && m_Mask[offset] == NumericTraits< MaskImagePixelType >::Zero ) )
+      {
+      continue;
+      }
+    double distance = item.Distance + m_StepLengths[i];
+    if( distance > m_MaximumDistance )
+      {
+      continue;
+      }
+    QueueItemType neighbor;
+    neighbor.Distance = distance;
+    neighbor.Order = m_Order++;
+    neighbor.Offset = offset;
+    neighbor.Object = item.Object;
+    if( IsGrownAtPush( queue ) )
+      {
+      // the pixel is not pushed again by its other neighbors
+      m_Visited.Set( offset, true );
+      m_Grown[ item.Object ].push_back( offset );
+      }
+    queue.push( neighbor );
+    }
+}
+
+
+template <class TImage, class TMaskImage>
+void
+LabelGrowingLabelMapFilter<TImage, TMaskImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << this->GetFullyConnected() << std::endl;
+  os << indent << "Connectivity: "  << m_Connectivity.GetPointer() << std::endl;
+  os << indent << "MaximumDistance: "  << m_MaximumDistance << std::endl;
+  os << indent << "UseImageSpacing: "  << m_UseImageSpacing << std::endl;
+}
+
+}// end namespace itk
+#endif
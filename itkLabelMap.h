@@ -25,6 +25,9 @@
 
 namespace itk
 {
+
+template <class TLabelMap> class LabelMapSpatialIndex;
+
 /** \class LabelMap
  *  \brief Templated n-dimensional image to store labeled objects.
  *
@@ -44,6 +47,12 @@ namespace itk
  * L is the number of lines in the image (imageSize[1] * imageSize[2] for a 3D
  * image).
  *
+ * GetSpatialIndex() returns an R-tree of the bounding boxes of the objects,
+ * to find the objects in a region without scanning all of them. It is built
+ * when needed, and built again after a modification of the label map. The
+ * label objects modified directly, without the methods of the label map,
+ * must be followed by a call to Modified().
+ *
  * \ingroup ImageObjects */
 template <class TLabelObject >
 class ITK_EXPORT LabelMap : public ImageBase<TLabelObject::ImageDimension>
@@ -105,6 +114,9 @@ public:
   /** Offset typedef (relative position between indices) */
   typedef typename Superclass::OffsetValueType OffsetValueType;
 
+  /** the spatial index of the label objects */
+  typedef LabelMapSpatialIndex< Self > SpatialIndexType;
+
   /** Convenience methods to set the LargestPossibleRegion,
    *  BufferedRegion and RequestedRegion. Allocate must still be called.
    */
@@ -307,6 +319,14 @@ public:
    */
   unsigned long GetNumberOfLabelObjects() const;
   
+  /**
+   * Return the spatial index of the label objects. It is built, or built
+   * again, if the label map has been modified since the last call. This
+   * method is not thread safe: it should be called before starting the
+   * threads which use the index.
+   */
+  const SpatialIndexType * GetSpatialIndex() const;
+
   /**
    * Set/Get the background label
    */
@@ -334,6 +354,10 @@ private:
 
   LabelObjectContainerType m_LabelObjectContainer;
   LabelType m_BackgroundValue;
+
+  // built on demand by GetSpatialIndex()
+  mutable SmartPointer< SpatialIndexType > m_SpatialIndex;
+  mutable bool m_SpatialIndexIsValid;
 };
 
 } // end namespace itk
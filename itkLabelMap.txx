@@ -21,6 +21,7 @@
 #define _itkLabelMap_txx
 
 #include "itkLabelMap.h"
+#include "itkLabelMapSpatialIndex.h"
 #include "itkProcessObject.h"
 
 namespace itk
@@ -34,6 +35,7 @@ LabelMap<TLabelObject>
 ::LabelMap()
 {
   m_BackgroundValue = NumericTraits< LabelType >::Zero;
+  m_SpatialIndexIsValid = false;
   this->Initialize();
 }
 
@@ -62,6 +64,7 @@ LabelMap<TLabelObject>
 ::Initialize()
 {
   m_LabelObjectContainer.clear();
+  m_SpatialIndexIsValid = false;
 }
 
 
@@ -104,6 +107,7 @@ LabelMap<TLabelObject>
       // Now copy anything remaining that is needed
       m_LabelObjectContainer = imgData->m_LabelObjectContainer;
       m_BackgroundValue = imgData->m_BackgroundValue;
+      m_SpatialIndexIsValid = false;
       }
     else
       {
@@ -248,6 +252,7 @@ LabelMap<TLabelObject>
     return;
     }
 
+  m_SpatialIndexIsValid = false;
   typename LabelObjectContainerType::iterator it = m_LabelObjectContainer.find( label );
 
   if( it != m_LabelObjectContainer.end() )
@@ -279,6 +284,7 @@ LabelMap<TLabelObject>
     return;
     }
 
+  m_SpatialIndexIsValid = false;
   typename LabelObjectContainerType::iterator it = m_LabelObjectContainer.find( label );
 
   if( it != m_LabelObjectContainer.end() )
@@ -326,6 +332,7 @@ LabelMap<TLabelObject>
   assert( !this->HasLabel( labelObject->GetLabel() ) );
 
   m_LabelObjectContainer[ labelObject->GetLabel() ] = labelObject;
+  m_SpatialIndexIsValid = false;
 }
 
 
@@ -414,6 +421,7 @@ LabelMap<TLabelObject>
     return;
     }
   m_LabelObjectContainer.erase( label );
+  m_SpatialIndexIsValid = false;
 }
 
 
@@ -423,6 +431,7 @@ LabelMap<TLabelObject>
 ::ClearLabels()
 {
   m_LabelObjectContainer.clear();
+  m_SpatialIndexIsValid = false;
 }
 
 
@@ -444,6 +453,26 @@ LabelMap<TLabelObject>
 }
 
 
+template<class TLabelObject >
+const typename LabelMap<TLabelObject>::SpatialIndexType *
+LabelMap<TLabelObject>
+::GetSpatialIndex() const
+{
+  if( m_SpatialIndex.IsNull() )
+    {
+    m_SpatialIndex = SpatialIndexType::New();
+    }
+  // the label objects may have been modified by a filter, without the
+  // methods of the label map, so the modification time is also checked
+  if( !m_SpatialIndexIsValid || this->GetMTime() > m_SpatialIndex->GetBuildTime() )
+    {
+    m_SpatialIndex->Build( this );
+    m_SpatialIndexIsValid = true;
+    }
+  return m_SpatialIndex;
+}
+
+
 template<class TLabelObject >
 void 
 LabelMap<TLabelObject>
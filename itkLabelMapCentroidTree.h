@@ -0,0 +1,234 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapCentroidTree.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapCentroidTree_h
+#define __itkLabelMapCentroidTree_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkPoint.h"
+#include <vector>
+#include <algorithm>
+
+namespace itk
+{
+
+/** \class LabelMapCentroidTree
+ *  \brief A KD-tree of the centroids of the objects of a label map
+ *
+ * The centroids of the objects are computed in parallel from their lines,
+ * in physical coordinates, so the spacing and the origin of the label map
+ * are taken into account. They are stored in a balanced KD-tree: each node
+ * is the median of its subtree on the axis where the centroids of that
+ * subtree are the most spread. The tree is stored implicitly in a single
+ * array, and is never updated: it must be built again when the objects are
+ * modified.
+ *
+ * FindNearestNeighbors() returns the k objects with the closest centroids
+ * to a point, and FindNeighborsInRadius() the objects with a centroid in a
+ * ball, both sorted by increasing distance. The batch versions run the same
+ * query for the centroid of all the objects of another label map, in
+ * parallel, to link the objects of two slices or of two time points without
+ * comparing all the pairs of objects. When the query label map is the one
+ * used to build the tree, each object is its own nearest neighbor.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa LabelMap, LabelMapSpatialIndex
+ * \ingroup DataRepresentation
+ */
+template <class TLabelMap>
+class ITK_EXPORT LabelMapCentroidTree : public Object
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef LabelMapCentroidTree      Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelMapCentroidTree, Object);
+
+  typedef TLabelMap LabelMapType;
+  typedef typename LabelMapType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TLabelMap::ImageDimension);
+
+  typedef Point< double, ImageDimension > PointType;
+
+  /** an object found by a query, and the distance of its centroid to the
+   * query point, in physical units */
+  struct NeighborType
+    {
+    LabelObjectType * Object;
+    double Distance;
+    };
+  typedef std::vector< NeighborType > NeighborVectorType;
+
+  /** the results of a batch query, in the order of the objects of the query
+   * label map */
+  typedef std::vector< NeighborVectorType > NeighborVectorContainerType;
+
+  /** Set/Get the number of threads used to compute the centroids and to run
+   * the batch queries */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstReferenceMacro( NumberOfThreads, int );
+
+  /** Build the tree for the objects of a label map. The label map is not
+   * kept. */
+  void Build( const LabelMapType * labelMap );
+
+  /** Release the memory used by the tree */
+  void Clear();
+
+  /** Return the number of objects in the tree */
+  unsigned long GetNumberOfObjects() const
+    {
+    return m_Entries.size();
+    }
+
+  /** Return the centroid of an object, in the physical coordinates of the
+   * label map. The empty objects have no centroid, and return the origin of
+   * the label map. */
+  static PointType ComputeCentroid( const LabelMapType * labelMap, const LabelObjectType * labelObject );
+
+  /** Replace the content of neighbors by the k objects with the closest
+   * centroids to the point, sorted by distance. Less than k objects are
+   * returned when the tree is smaller than k. */
+  void FindNearestNeighbors( const PointType & point, unsigned int k, NeighborVectorType & neighbors ) const;
+
+  /** Replace the content of neighbors by the objects with a centroid at a
+   * distance lower than or equal to radius from the point, sorted by
+   * distance */
+  void FindNeighborsInRadius( const PointType & point, double radius, NeighborVectorType & neighbors ) const;
+
+  /** Run FindNearestNeighbors() for the centroids of all the objects of a
+   * label map, in parallel. neighbors[i] are the neighbors of the object at
+   * the position i in the label object container of that label map. */
+  void FindNearestNeighbors( const LabelMapType * labelMap, unsigned int k, NeighborVectorContainerType & neighbors ) const;
+
+  /** Run FindNeighborsInRadius() for the centroids of all the objects of a
+   * label map, in parallel. neighbors[i] are the neighbors of the object at
+   * the position i in the label object container of that label map. */
+  void FindNeighborsInRadius( const LabelMapType * labelMap, double radius, NeighborVectorContainerType & neighbors ) const;
+
+  /** return the allocated memory, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    return m_Entries.capacity() * sizeof( EntryType );
+    }
+
+protected:
+
+  LabelMapCentroidTree();
+  ~LabelMapCentroidTree() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** an object and its centroid. In the tree, Axis is the axis used to split
+   * the subtree of which the entry is the median. */
+  struct EntryType
+    {
+    PointType Centroid;
+    LabelObjectType * Object;
+    unsigned int Axis;
+    };
+
+  /** compare the centroids of two entries on an axis */
+  struct AxisCompare
+    {
+    AxisCompare( unsigned int axis ) : m_Axis( axis ) {}
+    bool operator()( const EntryType & a, const EntryType & b ) const
+      {
+      return a.Centroid[m_Axis] < b.Centroid[m_Axis];
+      }
+    unsigned int m_Axis;
+    };
+
+  /** order the neighbors by distance */
+  struct DistanceCompare
+    {
+    bool operator()( const NeighborType & a, const NeighborType & b ) const
+      {
+      return a.Distance < b.Distance;
+      }
+    };
+
+  /** build the subtree of the entries in [begin, end) */
+  void BuildSubtree( unsigned long begin, unsigned long end );
+
+  /** search the subtree of the entries in [begin, end). The neighbors are
+   * stored in a max-heap on the squared distance. With k == 0, all the
+   * neighbors closer than the squared radius are kept. */
+  void Search( unsigned long begin, unsigned long end, const PointType & point, unsigned int k, double & squaredRadius, NeighborVectorType & neighbors ) const;
+
+  /** data shared by the threads */
+  struct ThreadStruct
+    {
+    const Self * Tree;
+    int NumberOfThreads;
+    const LabelMapType * LabelMap;
+    std::vector< EntryType > * Entries;
+    bool Nearest;
+    unsigned int K;
+    double Radius;
+    NeighborVectorContainerType * Neighbors;
+    };
+
+  static ITK_THREAD_RETURN_TYPE CentroidThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE QueryThreaderCallback( void * arg );
+
+  /** compute the centroids of the entries in parallel */
+  void ComputeCentroids( const LabelMapType * labelMap, std::vector< EntryType > & entries ) const;
+
+  /** run a batch query in parallel: FindNearestNeighbors() with k if
+   * nearest is true, FindNeighborsInRadius() with radius otherwise */
+  void BatchQuery( const LabelMapType * labelMap, bool nearest, unsigned int k, double radius, NeighborVectorContainerType & neighbors ) const;
+
+  /** the number of threads to use for n items */
+  int GetNumberOfThreadsFor( unsigned long n ) const
+    {
+    return std::min( (unsigned long)m_NumberOfThreads, n / 64 + 1 );
+    }
+
+private:
+
+  LabelMapCentroidTree(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  int m_NumberOfThreads;
+
+  // the median of the range [begin, end) is at (begin + end) / 2
+  std::vector< EntryType > m_Entries;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMapCentroidTree.txx"
+#endif
+
+#endif
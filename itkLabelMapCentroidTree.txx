@@ -0,0 +1,398 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapCentroidTree.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapCentroidTree_txx
+#define __itkLabelMapCentroidTree_txx
+
+#include "itkLabelMapCentroidTree.h"
+#include "itkContinuousIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <class TLabelMap>
+LabelMapCentroidTree<TLabelMap>
+::LabelMapCentroidTree()
+{
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::Build( const LabelMapType * labelMap )
+{
+  m_Entries.clear();
+
+  const typename LabelMapType::LabelObjectContainerType & container = labelMap->GetLabelObjectContainer();
+  m_Entries.reserve( container.size() );
+  for( typename LabelMapType::LabelObjectContainerType::const_iterator it = container.begin();
+    it != container.end();
+    it++ )
+    {
+    // the empty objects have no centroid
+    if( !it->second->GetLineContainer().empty() )
+      {
+      EntryType entry;
+      entry.Object = it->second.GetPointer();
+      entry.Axis = 0;
+      m_Entries.push_back( entry );
+      }
+    }
+
+  this->ComputeCentroids( labelMap, m_Entries );
+  this->BuildSubtree( 0, m_Entries.size() );
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::Clear()
+{
+  std::vector< EntryType >().swap( m_Entries );
+}
+
+
+template <class TLabelMap>
+typename LabelMapCentroidTree<TLabelMap>::PointType
+LabelMapCentroidTree<TLabelMap>
+::ComputeCentroid( const LabelMapType * labelMap, const LabelObjectType * labelObject )
+{
+  ContinuousIndex< double, ImageDimension > centroid;
+  centroid.Fill( 0 );
+  double size = 0;
+  const LineContainerType & lines = labelObject->GetLineContainer();
+  for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+    {
+    const typename LabelObjectType::IndexType & idx = lit->GetIndex();
+    const double length = lit->GetLength();
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      centroid[d] += idx[d] * length;
+      }
+    // the mean of the indexes of the line on the axis 0
+    centroid[0] += length * ( length - 1 ) / 2.0;
+    size += length;
+    }
+  if( size > 0 )
+    {
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      centroid[d] /= size;
+      }
+    }
+
+  PointType point;
+  labelMap->TransformContinuousIndexToPhysicalPoint( centroid, point );
+  return point;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::BuildSubtree( unsigned long begin, unsigned long end )
+{
+  if( end - begin <= 1 )
+    {
+    return;
+    }
+
+  // split on the axis with the largest spread
+  PointType min = m_Entries[begin].Centroid;
+  PointType max = min;
+  for( unsigned long i=begin+1; i<end; i++ )
+    {
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      min[d] = std::min( min[d], m_Entries[i].Centroid[d] );
+      max[d] = std::max( max[d], m_Entries[i].Centroid[d] );
+      }
+    }
+  unsigned int axis = 0;
+  for( unsigned int d=1; d<ImageDimension; d++ )
+    {
+    if( max[d] - min[d] > max[axis] - min[axis] )
+      {
+      axis = d;
+      }
+    }
+
+  const unsigned long median = ( begin + end ) / 2;
+  std::nth_element( m_Entries.begin() + begin, m_Entries.begin() + median, m_Entries.begin() + end, AxisCompare( axis ) );
+  m_Entries[median].Axis = axis;
+
+  this->BuildSubtree( begin, median );
+  this->BuildSubtree( median + 1, end );
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::Search( unsigned long begin, unsigned long end, const PointType & point, unsigned int k, double & squaredRadius, NeighborVectorType & neighbors ) const
+{
+  if( begin >= end )
+    {
+    return;
+    }
+
+  const unsigned long median = ( begin + end ) / 2;
+  const EntryType & entry = m_Entries[median];
+
+  const double squaredDistance = point.SquaredEuclideanDistanceTo( entry.Centroid );
+  if( squaredDistance <= squaredRadius )
+    {
+    NeighborType neighbor;
+    neighbor.Object = entry.Object;
+    neighbor.Distance = squaredDistance;
+    if( k == 0 )
+      {
+      neighbors.push_back( neighbor );
+      }
+    else
+      {
+      if( neighbors.size() == k )
+        {
+        std::pop_heap( neighbors.begin(), neighbors.end(), DistanceCompare() );
+        neighbors.pop_back();
+        }
+      neighbors.push_back( neighbor );
+      std::push_heap( neighbors.begin(), neighbors.end(), DistanceCompare() );
+      // the radius shrinks to the farthest of the k neighbors
+      if( neighbors.size() == k )
+        {
+        squaredRadius = neighbors.front().Distance;
+        }
+      }
+    }
+
+  if( end - begin == 1 )
+    {
+    return;
+    }
+
+  // the side of the point first, then the other side if the ball crosses
+  // the splitting plane
+  const double diff = point[entry.Axis] - entry.Centroid[entry.Axis];
+  if( diff < 0 )
+    {
+    this->Search( begin, median, point, k, squaredRadius, neighbors );
+    if( diff * diff <= squaredRadius )
+      {
+      this->Search( median + 1, end, point, k, squaredRadius, neighbors );
+      }
+    }
+  else
+    {
+    this->Search( median + 1, end, point, k, squaredRadius, neighbors );
+    if( diff * diff <= squaredRadius )
+      {
+      this->Search( begin, median, point, k, squaredRadius, neighbors );
+      }
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::FindNearestNeighbors( const PointType & point, unsigned int k, NeighborVectorType & neighbors ) const
+{
+  neighbors.clear();
+  if( k == 0 )
+    {
+    return;
+    }
+  double squaredRadius = NumericTraits< double >::max();
+  this->Search( 0, m_Entries.size(), point, k, squaredRadius, neighbors );
+  std::sort_heap( neighbors.begin(), neighbors.end(), DistanceCompare() );
+  for( typename NeighborVectorType::iterator it = neighbors.begin(); it != neighbors.end(); it++ )
+    {
+    it->Distance = sqrt( it->Distance );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::FindNeighborsInRadius( const PointType & point, double radius, NeighborVectorType & neighbors ) const
+{
+  neighbors.clear();
+  if( radius < 0 )
+    {
+    return;
+    }
+  double squaredRadius = radius * radius;
+  this->Search( 0, m_Entries.size(), point, 0, squaredRadius, neighbors );
+  std::sort( neighbors.begin(), neighbors.end(), DistanceCompare() );
+  for( typename NeighborVectorType::iterator it = neighbors.begin(); it != neighbors.end(); it++ )
+    {
+    it->Distance = sqrt( it->Distance );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::FindNearestNeighbors( const LabelMapType * labelMap, unsigned int k, NeighborVectorContainerType & neighbors ) const
+{
+  this->BatchQuery( labelMap, true, k, 0, neighbors );
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::FindNeighborsInRadius( const LabelMapType * labelMap, double radius, NeighborVectorContainerType & neighbors ) const
+{
+  this->BatchQuery( labelMap, false, 0, radius, neighbors );
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::ComputeCentroids( const LabelMapType * labelMap, std::vector< EntryType > & entries ) const
+{
+  if( entries.empty() )
+    {
+    return;
+    }
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( this->GetNumberOfThreadsFor( entries.size() ) );
+  ThreadStruct str;
+  str.Tree = this;
+  str.NumberOfThreads = threader->GetNumberOfThreads();
+  str.LabelMap = labelMap;
+  str.Entries = &entries;
+  threader->SetSingleMethod( Self::CentroidThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::BatchQuery( const LabelMapType * labelMap, bool nearest, unsigned int k, double radius, NeighborVectorContainerType & neighbors ) const
+{
+  // the query points are the centroids of the objects of the other label map
+  const typename LabelMapType::LabelObjectContainerType & container = labelMap->GetLabelObjectContainer();
+  std::vector< EntryType > queries( container.size() );
+  typename std::vector< EntryType >::iterator qit = queries.begin();
+  for( typename LabelMapType::LabelObjectContainerType::const_iterator it = container.begin();
+    it != container.end();
+    it++, qit++ )
+    {
+    qit->Object = it->second.GetPointer();
+    qit->Axis = 0;
+    }
+  this->ComputeCentroids( labelMap, queries );
+
+  neighbors.clear();
+  neighbors.resize( queries.size() );
+  if( queries.empty() )
+    {
+    return;
+    }
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( this->GetNumberOfThreadsFor( queries.size() ) );
+  ThreadStruct str;
+  str.Tree = this;
+  str.NumberOfThreads = threader->GetNumberOfThreads();
+  str.LabelMap = labelMap;
+  str.Entries = &queries;
+  str.Nearest = nearest;
+  str.K = k;
+  str.Radius = radius;
+  str.Neighbors = &neighbors;
+  threader->SetSingleMethod( Self::QueryThreaderCallback, &str );
+  threader->SingleMethodExecute();
+}
+
+
+template <class TLabelMap>
+ITK_THREAD_RETURN_TYPE
+LabelMapCentroidTree<TLabelMap>
+::CentroidThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+
+  std::vector< EntryType > & entries = *str->Entries;
+  const unsigned long n = entries.size();
+  const unsigned long begin = n * info->ThreadID / str->NumberOfThreads;
+  const unsigned long end = n * ( info->ThreadID + 1 ) / str->NumberOfThreads;
+  for( unsigned long e=begin; e<end; e++ )
+    {
+    entries[e].Centroid = ComputeCentroid( str->LabelMap, entries[e].Object );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TLabelMap>
+ITK_THREAD_RETURN_TYPE
+LabelMapCentroidTree<TLabelMap>
+::QueryThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+
+  const std::vector< EntryType > & queries = *str->Entries;
+  const unsigned long n = queries.size();
+  const unsigned long begin = n * info->ThreadID / str->NumberOfThreads;
+  const unsigned long end = n * ( info->ThreadID + 1 ) / str->NumberOfThreads;
+  for( unsigned long q=begin; q<end; q++ )
+    {
+    // an empty object has no centroid, and no neighbor
+    if( queries[q].Object->GetLineContainer().empty() )
+      {
+      continue;
+      }
+    if( str->Nearest )
+      {
+      str->Tree->FindNearestNeighbors( queries[q].Centroid, str->K, (*str->Neighbors)[q] );
+      }
+    else
+      {
+      str->Tree->FindNeighborsInRadius( queries[q].Centroid, str->Radius, (*str->Neighbors)[q] );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapCentroidTree<TLabelMap>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfThreads: "  << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfObjects: "  << m_Entries.size() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "itkLabelMapFilter.h"
 #include "itkBarrier.h"
+#include <vector>
 
 namespace itk {
 
@@ -32,6 +33,9 @@ namespace itk {
  * Negated = false (the default) or it can mask the input image for a single label, when
  * Negated equals true. In Both cases, the label is set with SetLabel(). 
  *
+ * The spatial index of the label map is used to compute the cropped region,
+ * and to skip the objects outside of it.
+ *
  * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * \sa LabelMapToBinaryImageFilter, LabelMapToLabelImageFilter
@@ -177,6 +181,9 @@ private:
 
   typename Barrier::Pointer m_Barrier;
 
+  // the objects intersecting the output region, sorted
+  std::vector< LabelObjectType * > m_Objects;
+
 } ; // end of class
 
 } // end namespace itk
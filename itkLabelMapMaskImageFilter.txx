@@ -22,6 +22,8 @@
 #include "itkProgressReporter.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
+#include "itkLabelMapSpatialIndex.h"
+#include <algorithm>
 
 namespace itk {
 
@@ -106,55 +108,9 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
         }
       else
         {
-        // compute the bounding box of all the objects which don't have that label
-        IndexType mins;
-        mins.Fill( NumericTraits< long >::max() );
-        IndexType maxs;
-        maxs.Fill( NumericTraits< long >::NonpositiveMin() );
-        typename InputImageType::LabelObjectContainerType container = this->GetInput()->GetLabelObjectContainer();
-        for( typename InputImageType::LabelObjectContainerType::const_iterator loit = container.begin();
-             loit != container.end();
-             loit++ )
-          {
-          if( loit->first != m_Label )
-            {
-            typename LabelObjectType::LineContainerType::const_iterator lit;
-            typename LabelObjectType::LineContainerType & lineContainer = loit->second->GetLineContainer();
-            // iterate over all the lines
-            for( lit = lineContainer.begin(); lit != lineContainer.end(); lit++ )
-              {
-              const IndexType & idx = lit->GetIndex();
-              unsigned long length = lit->GetLength();
-    
-              // update the mins and maxs
-              for( int i=0; i<ImageDimension; i++)
-                {
-                if( idx[i] < mins[i] )
-                  {
-                  mins[i] = idx[i];
-                  }
-                if( idx[i] > maxs[i] )
-                  {
-                  maxs[i] = idx[i];
-                  }
-                }
-              // must fix the max for the axis 0
-              if( idx[0] + length > maxs[0] )
-                {
-                maxs[0] = idx[0] + length - 1;
-                }
-              }
-            }
-          }
-          
-          // final computation
-          SizeType regionSize;
-          for( int i=0; i<ImageDimension; i++ )
-            {
-            regionSize[i] = maxs[i] - mins[i] + 1;
-            }
-          cropRegion.SetIndex( mins );
-          cropRegion.SetSize( regionSize );
+        // the bounding box of all the objects, which don't have that label,
+        // is known by the spatial index
+        cropRegion = input->GetSpatialIndex()->GetBoundingBox();
           
         }
       }
@@ -258,6 +214,15 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
   m_Barrier = Barrier::New();
   m_Barrier->Initialize( this->GetNumberOfThreads() );
 
+  // only the objects intersecting the output region have to be written. The
+  // others are skipped without looking at their lines.
+  m_Objects.clear();
+  if( this->GetInput()->GetBackgroundValue() == m_Label )
+    {
+    this->GetInput()->GetSpatialIndex()->FindObjects( this->GetOutput()->GetLargestPossibleRegion(), m_Objects );
+    std::sort( m_Objects.begin(), m_Objects.end() );
+    }
+
   Superclass::BeforeThreadedGenerateData();
 
 }
@@ -323,7 +288,7 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
           {
           IndexType idx = lit->GetIndex();
           unsigned long length = lit->GetLength();
-          for( int i=0; i<length; i++)
+          for( unsigned long i=0; i<length; i++)
             {
             output->SetPixel( idx, input2->GetPixel( idx ) );
             idx[0]++;
@@ -346,7 +311,7 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
           {
           IndexType idx = lit->GetIndex();
           unsigned long length = lit->GetLength();
-          for( int i=0; i<length; i++)
+          for( unsigned long i=0; i<length; i++)
             {
             if( !testIdxIsInside || outputRegion.IsInside( idx ) )
               {
@@ -368,6 +333,12 @@ void
 LabelMapMaskImageFilter<TInputImage, TOutputImage>
 ::ThreadedGenerateData( LabelObjectType * labelObject )
 {
+  if( !std::binary_search( m_Objects.begin(), m_Objects.end(), labelObject ) )
+    {
+    // outside the output region
+    return;
+    }
+
   OutputImageType * output = this->GetOutput();
   InputImageType * input = const_cast<InputImageType *>(this->GetInput());
   const OutputImageType * input2 = this->GetFeatureImage();
@@ -389,7 +360,7 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
       {
       IndexType idx = lit->GetIndex();
       unsigned long length = lit->GetLength();
-      for( int i=0; i<length; i++)
+      for( unsigned long i=0; i<length; i++)
         {
         if( !testIdxIsInside || outputRegion.IsInside( idx ) )
           {
@@ -413,7 +384,7 @@ LabelMapMaskImageFilter<TInputImage, TOutputImage>
       {
       IndexType idx = lit->GetIndex();
       unsigned long length = lit->GetLength();
-      for( int i=0; i<length; i++)
+      for( unsigned long i=0; i<length; i++)
         {
         output->SetPixel( idx, input2->GetPixel( idx ) );
         idx[0]++;
@@ -0,0 +1,274 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapOverlapMeasures.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapOverlapMeasures_h
+#define __itkLabelMapOverlapMeasures_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include <vector>
+#include <map>
+#include <utility>
+#include <cmath>
+
+namespace itk
+{
+
+/** \class LabelMapOverlapMeasures
+ *  \brief The overlap of the objects of two label maps, and the agreement
+ *  measures of the two segmentations
+ *
+ * Compute() intersects the lines of the objects of a source and of a target
+ * label map, row by row and in parallel, to build the sparse table of the
+ * number of pixels shared by each pair of objects. The pixels are never
+ * visited one by one: two lines are intersected in constant time. The label
+ * images can be compared after their conversion with
+ * LabelImageToLabelMapFilter.
+ *
+ * All the measures are then derived from that table and from the size of
+ * the objects, the pixels outside the objects being counted as the
+ * intersection of the backgrounds:
+ * - the Jaccard and Dice coefficients of the foregrounds of the two label
+ *   maps, whatever the labels of the objects,
+ * - the variation of information, in nats, and the adjusted Rand index of
+ *   the two partitions of the image, the background being one of the
+ *   regions of each partition,
+ * - for each object, the object of the other label map with the highest
+ *   Jaccard coefficient (intersection over union), and the mean of that
+ *   coefficient over the objects of the source label map.
+ *
+ * The two label maps must have the same largest possible region.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa LabelMap, LabelImageToLabelMapFilter
+ * \ingroup DataRepresentation
+ */
+template <class TLabelMap>
+class ITK_EXPORT LabelMapOverlapMeasures : public Object
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef LabelMapOverlapMeasures   Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelMapOverlapMeasures, Object);
+
+  typedef TLabelMap LabelMapType;
+  typedef typename LabelMapType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LabelType LabelType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+  typedef typename LabelMapType::RegionType RegionType;
+  typedef typename LabelMapType::IndexType IndexType;
+  typedef typename LabelMapType::SizeType SizeType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TLabelMap::ImageDimension);
+
+  /** the number of pixels shared by a source and a target object, indexed
+   * by their labels. Only the pairs of objects which overlap are stored. */
+  typedef std::pair< LabelType, LabelType > LabelPairType;
+  typedef std::map< LabelPairType, unsigned long > OverlapTableType;
+
+  /** the size of the objects, indexed by their labels */
+  typedef std::map< LabelType, unsigned long > SizeTableType;
+
+  /** the best match of an object in the other label map. The objects which
+   * don't overlap any object are matched with the background, with a
+   * Jaccard coefficient of 0. */
+  struct MatchType
+    {
+    LabelType Label;
+    double Jaccard;
+    };
+  typedef std::map< LabelType, MatchType > MatchTableType;
+
+  /** Set/Get the number of threads used to intersect the lines */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstReferenceMacro( NumberOfThreads, int );
+
+  /** Build the overlap table of the two label maps, and compute the
+   * measures. The label maps are not kept. */
+  void Compute( const LabelMapType * source, const LabelMapType * target );
+
+  /** Release the memory used by the tables */
+  void Clear();
+
+  /** Return the overlap table */
+  const OverlapTableType & GetOverlapTable() const
+    {
+    return m_OverlapTable;
+    }
+
+  /** Return the number of pixels shared by two objects */
+  unsigned long GetOverlap( const LabelType & sourceLabel, const LabelType & targetLabel ) const;
+
+  /** Return the size of the objects of the source and target label maps */
+  const SizeTableType & GetSourceSizes() const
+    {
+    return m_SourceSizes;
+    }
+  const SizeTableType & GetTargetSizes() const
+    {
+    return m_TargetSizes;
+    }
+
+  /** Return the best match of the objects of the source label map in the
+   * target label map, and the reverse */
+  const MatchTableType & GetSourceBestMatches() const
+    {
+    return m_SourceBestMatches;
+    }
+  const MatchTableType & GetTargetBestMatches() const
+    {
+    return m_TargetBestMatches;
+    }
+
+  /** Return the Jaccard coefficient of the foregrounds: the number of
+   * pixels in the objects of both label maps, over the number of pixels in
+   * the objects of any of them */
+  itkGetConstReferenceMacro( Jaccard, double );
+
+  /** Return the Dice coefficient of the foregrounds */
+  itkGetConstReferenceMacro( Dice, double );
+
+  /** Return the variation of information of the two partitions, in nats.
+   * It is 0 for identical partitions. */
+  itkGetConstReferenceMacro( VariationOfInformation, double );
+
+  /** Return the adjusted Rand index of the two partitions. It is 1 for
+   * identical partitions, and close to 0 for independent ones. */
+  itkGetConstReferenceMacro( AdjustedRandIndex, double );
+
+  /** Return the mean of the Jaccard coefficient of the best matches of the
+   * objects of the source label map */
+  itkGetConstReferenceMacro( MeanBestMatchJaccard, double );
+
+protected:
+
+  LabelMapOverlapMeasures();
+  ~LabelMapOverlapMeasures() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** a line of an object, in a row */
+  struct RunType
+    {
+    unsigned long Begin;
+    unsigned long End;
+    LabelType Label;
+    bool operator<( const RunType & other ) const
+      {
+      return Begin < other.Begin;
+      }
+    };
+
+  /** the lines of all the objects of a label map, grouped by row: the lines
+   * of the row r are in [RowBegin[r], RowBegin[r+1]) */
+  struct RunTableType
+    {
+    std::vector< RunType > Runs;
+    std::vector< unsigned long > RowBegin;
+    };
+
+  /** the row of a line, in the region of the label maps */
+  unsigned long ComputeRow( const IndexType & idx ) const
+    {
+    unsigned long row = 0;
+    unsigned long stride = 1;
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      row += ( idx[d] - m_Region.GetIndex()[d] ) * stride;
+      stride *= m_Region.GetSize()[d];
+      }
+    return row;
+    }
+
+  /** the number of pairs of pixels in a set of n pixels */
+  static double NumberOfPairs( double n )
+    {
+    return n * ( n - 1 ) / 2;
+    }
+
+  /** the contribution of a cell of the contingency table, with nij pixels in
+   * a row of ni pixels and a column of nj pixels, to the variation of
+   * information, multiplied by the number of pixels */
+  static double Information( double nij, double ni, double nj )
+    {
+    return nij * ( std::log( ni ) + std::log( nj ) - 2 * std::log( nij ) );
+    }
+
+  /** group the lines of the objects by row, and compute the size of the
+   * objects */
+  void BuildRunTable( const LabelMapType * labelMap, RunTableType & table, SizeTableType & sizes ) const;
+
+  /** compute the measures from the overlap table */
+  void ComputeMeasures();
+
+  /** find the best match of the objects of a label map */
+  void ComputeBestMatches( bool source, MatchTableType & matches ) const;
+
+  /** data shared by the threads */
+  struct ThreadStruct
+    {
+    int NumberOfThreads;
+    RunTableType * Source;
+    RunTableType * Target;
+    std::vector< OverlapTableType > * Overlaps;
+    };
+
+  static ITK_THREAD_RETURN_TYPE OverlapThreaderCallback( void * arg );
+
+private:
+
+  LabelMapOverlapMeasures(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  int m_NumberOfThreads;
+
+  RegionType m_Region;
+  LabelType m_SourceBackgroundValue;
+  LabelType m_TargetBackgroundValue;
+
+  OverlapTableType m_OverlapTable;
+  SizeTableType m_SourceSizes;
+  SizeTableType m_TargetSizes;
+  MatchTableType m_SourceBestMatches;
+  MatchTableType m_TargetBestMatches;
+
+  double m_Jaccard;
+  double m_Dice;
+  double m_VariationOfInformation;
+  double m_AdjustedRandIndex;
+  double m_MeanBestMatchJaccard;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMapOverlapMeasures.txx"
+#endif
+
+#endif
@@ -0,0 +1,372 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapOverlapMeasures.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapOverlapMeasures_txx
+#define __itkLabelMapOverlapMeasures_txx
+
+#include "itkLabelMapOverlapMeasures.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk
+{
+
+template <class TLabelMap>
+LabelMapOverlapMeasures<TLabelMap>
+::LabelMapOverlapMeasures()
+{
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_SourceBackgroundValue = NumericTraits< LabelType >::Zero;
+  m_TargetBackgroundValue = NumericTraits< LabelType >::Zero;
+  m_Jaccard = 0;
+  m_Dice = 0;
+  m_VariationOfInformation = 0;
+  m_AdjustedRandIndex = 0;
+  m_MeanBestMatchJaccard = 0;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::Compute( const LabelMapType * source, const LabelMapType * target )
+{
+  if( source->GetLargestPossibleRegion() != target->GetLargestPossibleRegion() )
+    {
+    itkExceptionMacro( << "The label maps must have the same largest possible region." );
+    }
+  m_Region = source->GetLargestPossibleRegion();
+  m_SourceBackgroundValue = source->GetBackgroundValue();
+  m_TargetBackgroundValue = target->GetBackgroundValue();
+
+  RunTableType sourceRuns;
+  RunTableType targetRuns;
+  this->BuildRunTable( source, sourceRuns, m_SourceSizes );
+  this->BuildRunTable( target, targetRuns, m_TargetSizes );
+
+  // each thread intersects the lines of a range of rows in its own table
+  const unsigned long nbOfRows = sourceRuns.RowBegin.size() - 1;
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( std::min( (unsigned long)m_NumberOfThreads, nbOfRows / 64 + 1 ) );
+  std::vector< OverlapTableType > overlaps( threader->GetNumberOfThreads() );
+  ThreadStruct str;
+  str.NumberOfThreads = threader->GetNumberOfThreads();
+  str.Source = &sourceRuns;
+  str.Target = &targetRuns;
+  str.Overlaps = &overlaps;
+  threader->SetSingleMethod( Self::OverlapThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  m_OverlapTable.clear();
+  for( unsigned int t=0; t<overlaps.size(); t++ )
+    {
+    for( typename OverlapTableType::const_iterator it = overlaps[t].begin(); it != overlaps[t].end(); it++ )
+      {
+      m_OverlapTable[ it->first ] += it->second;
+      }
+    }
+
+  this->ComputeMeasures();
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::Clear()
+{
+  OverlapTableType().swap( m_OverlapTable );
+  SizeTableType().swap( m_SourceSizes );
+  SizeTableType().swap( m_TargetSizes );
+  MatchTableType().swap( m_SourceBestMatches );
+  MatchTableType().swap( m_TargetBestMatches );
+}
+
+
+template <class TLabelMap>
+unsigned long
+LabelMapOverlapMeasures<TLabelMap>
+::GetOverlap( const LabelType & sourceLabel, const LabelType & targetLabel ) const
+{
+  typename OverlapTableType::const_iterator it = m_OverlapTable.find( LabelPairType( sourceLabel, targetLabel ) );
+  if( it == m_OverlapTable.end() )
+    {
+    return 0;
+    }
+  return it->second;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::BuildRunTable( const LabelMapType * labelMap, RunTableType & table, SizeTableType & sizes ) const
+{
+  unsigned long nbOfRows = 1;
+  for( unsigned int d=1; d<ImageDimension; d++ )
+    {
+    nbOfRows *= m_Region.GetSize()[d];
+    }
+  table.RowBegin.assign( nbOfRows + 1, 0 );
+  sizes.clear();
+
+  // count the lines in each row
+  const typename LabelMapType::LabelObjectContainerType & container = labelMap->GetLabelObjectContainer();
+  typename LabelMapType::LabelObjectContainerType::const_iterator it;
+  for( it = container.begin(); it != container.end(); it++ )
+    {
+    const LineContainerType & lines = it->second->GetLineContainer();
+    for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      table.RowBegin[ this->ComputeRow( lit->GetIndex() ) + 1 ]++;
+      }
+    }
+  for( unsigned long r=0; r<nbOfRows; r++ )
+    {
+    table.RowBegin[r+1] += table.RowBegin[r];
+    }
+
+  // and store them at the position of their row
+  table.Runs.resize( table.RowBegin.back() );
+  std::vector< unsigned long > position( table.RowBegin.begin(), table.RowBegin.end() - 1 );
+  const long start = m_Region.GetIndex()[0];
+  for( it = container.begin(); it != container.end(); it++ )
+    {
+    unsigned long size = 0;
+    const LineContainerType & lines = it->second->GetLineContainer();
+    for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      RunType run;
+      run.Begin = lit->GetIndex()[0] - start;
+      run.End = run.Begin + lit->GetLength();
+      run.Label = it->first;
+      table.Runs[ position[ this->ComputeRow( lit->GetIndex() ) ]++ ] = run;
+      size += lit->GetLength();
+      }
+    sizes.insert( sizes.end(), typename SizeTableType::value_type( it->first, size ) );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::ComputeMeasures()
+{
+  const double nbOfPixels = m_Region.GetNumberOfPixels();
+
+  // the cells of the contingency table of the objects which overlap
+  std::map< LabelType, unsigned long > sourceCovered;
+  std::map< LabelType, unsigned long > targetCovered;
+  double intersection = 0;
+  double pairs = 0;
+  double information = 0;
+  for( typename OverlapTableType::const_iterator it = m_OverlapTable.begin(); it != m_OverlapTable.end(); it++ )
+    {
+    const double nij = it->second;
+    sourceCovered[ it->first.first ] += it->second;
+    targetCovered[ it->first.second ] += it->second;
+    intersection += nij;
+    pairs += NumberOfPairs( nij );
+    information += Information( nij, m_SourceSizes[ it->first.first ], m_TargetSizes[ it->first.second ] );
+    }
+
+  double sourceForeground = 0;
+  for( typename SizeTableType::const_iterator it = m_SourceSizes.begin(); it != m_SourceSizes.end(); it++ )
+    {
+    sourceForeground += it->second;
+    }
+  double targetForeground = 0;
+  for( typename SizeTableType::const_iterator it = m_TargetSizes.begin(); it != m_TargetSizes.end(); it++ )
+    {
+    targetForeground += it->second;
+    }
+  const double sourceBackground = nbOfPixels - sourceForeground;
+  const double targetBackground = nbOfPixels - targetForeground;
+
+  // the cells of the objects with the background of the other label map
+  double sourcePairs = NumberOfPairs( sourceBackground );
+  for( typename SizeTableType::const_iterator it = m_SourceSizes.begin(); it != m_SourceSizes.end(); it++ )
+    {
+    const double ni = it->second;
+    const double nibg = ni - sourceCovered[ it->first ];
+    if( nibg > 0 )
+      {
+      pairs += NumberOfPairs( nibg );
+      information += Information( nibg, ni, targetBackground );
+      }
+    sourcePairs += NumberOfPairs( ni );
+    }
+  double targetPairs = NumberOfPairs( targetBackground );
+  for( typename SizeTableType::const_iterator it = m_TargetSizes.begin(); it != m_TargetSizes.end(); it++ )
+    {
+    const double nj = it->second;
+    const double nbgj = nj - targetCovered[ it->first ];
+    if( nbgj > 0 )
+      {
+      pairs += NumberOfPairs( nbgj );
+      information += Information( nbgj, sourceBackground, nj );
+      }
+    targetPairs += NumberOfPairs( nj );
+    }
+
+  // and the cell of the two backgrounds
+  const double nbgbg = nbOfPixels - sourceForeground - targetForeground + intersection;
+  if( nbgbg > 0 )
+    {
+    pairs += NumberOfPairs( nbgbg );
+    information += Information( nbgbg, sourceBackground, targetBackground );
+    }
+
+  const double unionSize = sourceForeground + targetForeground - intersection;
+  m_Jaccard = unionSize > 0 ? intersection / unionSize : 1.0;
+  m_Dice = unionSize > 0 ? 2 * intersection / ( sourceForeground + targetForeground ) : 1.0;
+  m_VariationOfInformation = nbOfPixels > 0 ? information / nbOfPixels : 0.0;
+
+  const double expectedPairs = nbOfPixels > 1 ? sourcePairs * targetPairs / NumberOfPairs( nbOfPixels ) : 0.0;
+  const double maxPairs = ( sourcePairs + targetPairs ) / 2;
+  m_AdjustedRandIndex = maxPairs != expectedPairs ? ( pairs - expectedPairs ) / ( maxPairs - expectedPairs ) : 1.0;
+
+  this->ComputeBestMatches( true, m_SourceBestMatches );
+  this->ComputeBestMatches( false, m_TargetBestMatches );
+  m_MeanBestMatchJaccard = 0;
+  for( typename MatchTableType::const_iterator it = m_SourceBestMatches.begin(); it != m_SourceBestMatches.end(); it++ )
+    {
+    m_MeanBestMatchJaccard += it->second.Jaccard;
+    }
+  if( !m_SourceBestMatches.empty() )
+    {
+    m_MeanBestMatchJaccard /= m_SourceBestMatches.size();
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::ComputeBestMatches( bool source, MatchTableType & matches ) const
+{
+  const SizeTableType & sizes = source ? m_SourceSizes : m_TargetSizes;
+  const SizeTableType & otherSizes = source ? m_TargetSizes : m_SourceSizes;
+
+  // all the objects are matched with the background until an overlapping
+  // object is found
+  MatchType background;
+  background.Label = source ? m_TargetBackgroundValue : m_SourceBackgroundValue;
+  background.Jaccard = 0;
+  matches.clear();
+  for( typename SizeTableType::const_iterator it = sizes.begin(); it != sizes.end(); it++ )
+    {
+    matches.insert( matches.end(), typename MatchTableType::value_type( it->first, background ) );
+    }
+
+  for( typename OverlapTableType::const_iterator it = m_OverlapTable.begin(); it != m_OverlapTable.end(); it++ )
+    {
+    const LabelType & label = source ? it->first.first : it->first.second;
+    const LabelType & otherLabel = source ? it->first.second : it->first.first;
+    const double nij = it->second;
+    const double unionSize = sizes.find( label )->second + otherSizes.find( otherLabel )->second - nij;
+    const double jaccard = nij / unionSize;
+    MatchType & match = matches[ label ];
+    if( jaccard > match.Jaccard )
+      {
+      match.Label = otherLabel;
+      match.Jaccard = jaccard;
+      }
+    }
+}
+
+
+template <class TLabelMap>
+ITK_THREAD_RETURN_TYPE
+LabelMapOverlapMeasures<TLabelMap>
+::OverlapThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+
+  RunTableType & source = *str->Source;
+  RunTableType & target = *str->Target;
+  OverlapTableType & overlaps = (*str->Overlaps)[ info->ThreadID ];
+
+  const unsigned long nbOfRows = source.RowBegin.size() - 1;
+  const unsigned long begin = nbOfRows * info->ThreadID / str->NumberOfThreads;
+  const unsigned long end = nbOfRows * ( info->ThreadID + 1 ) / str->NumberOfThreads;
+
+  // the same pair of objects is usually found on several consecutive lines
+  typename OverlapTableType::iterator last = overlaps.end();
+
+  for( unsigned long r=begin; r<end; r++ )
+    {
+    typename std::vector< RunType >::iterator sit = source.Runs.begin() + source.RowBegin[r];
+    typename std::vector< RunType >::iterator send = source.Runs.begin() + source.RowBegin[r+1];
+    typename std::vector< RunType >::iterator tit = target.Runs.begin() + target.RowBegin[r];
+    typename std::vector< RunType >::iterator tend = target.Runs.begin() + target.RowBegin[r+1];
+    if( sit == send || tit == tend )
+      {
+      continue;
+      }
+
+    // the lines of the row are stored in the order of the objects: sort
+    // them by position, and walk both rows together
+    std::sort( sit, send );
+    std::sort( tit, tend );
+    while( sit != send && tit != tend )
+      {
+      const unsigned long b = std::max( sit->Begin, tit->Begin );
+      const unsigned long e = std::min( sit->End, tit->End );
+      if( b < e )
+        {
+        const LabelPairType pair( sit->Label, tit->Label );
+        if( last == overlaps.end() || last->first != pair )
+          {
+          last = overlaps.insert( typename OverlapTableType::value_type( pair, 0 ) ).first;
+          }
+        last->second += e - b;
+        }
+      if( sit->End < tit->End )
+        {
+        sit++;
+        }
+      else
+        {
+        tit++;
+        }
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapOverlapMeasures<TLabelMap>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfThreads: "  << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfOverlaps: "  << m_OverlapTable.size() << std::endl;
+  os << indent << "Jaccard: "  << m_Jaccard << std::endl;
+  os << indent << "Dice: "  << m_Dice << std::endl;
+  os << indent << "VariationOfInformation: "  << m_VariationOfInformation << std::endl;
+  os << indent << "AdjustedRandIndex: "  << m_AdjustedRandIndex << std::endl;
+  os << indent << "MeanBestMatchJaccard: "  << m_MeanBestMatchJaccard << std::endl;
+}
+
+} // end namespace itk
+
+#endif
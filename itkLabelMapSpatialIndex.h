@@ -0,0 +1,249 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapSpatialIndex.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapSpatialIndex_h
+#define __itkLabelMapSpatialIndex_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "itkImageRegion.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class LabelMapSpatialIndex
+ *  \brief A packed R-tree of the bounding boxes of the objects of a label map
+ *
+ * The bounding boxes of the objects are computed in parallel, and stored in
+ * the leaves of an R-tree built bottom-up with the sort-tile-recursive
+ * method: the boxes are sorted by their center on the first axis, cut in
+ * slabs, each slab is sorted on the next axis, and so on. Each node stores
+ * the bounding box of its NodeCapacity children. The tree is never updated:
+ * it is built again when the label map is modified.
+ *
+ * FindObjects() returns the objects with a bounding box intersecting a
+ * region, or containing an index, in O(log(N) + K) for N objects and K
+ * results, instead of a scan of all the lines of all the objects.
+ *
+ * The spatial index of a label map is usually obtained with
+ * LabelMap::GetSpatialIndex(), which builds it when needed.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa LabelMap
+ * \ingroup DataRepresentation
+ */
+template <class TLabelMap>
+class ITK_EXPORT LabelMapSpatialIndex : public Object
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef LabelMapSpatialIndex      Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(LabelMapSpatialIndex, Object);
+
+  typedef TLabelMap LabelMapType;
+  typedef typename LabelMapType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TLabelMap::ImageDimension);
+
+  typedef ImageRegion< ImageDimension >    RegionType;
+  typedef typename RegionType::IndexType   IndexType;
+  typedef typename RegionType::SizeType    SizeType;
+
+  typedef std::vector< LabelObjectType * > LabelObjectVectorType;
+
+  /** Set/Get the number of children of a node. Default is 16. */
+  itkSetClampMacro( NodeCapacity, unsigned int, 2, NumericTraits< unsigned int >::max() );
+  itkGetConstReferenceMacro( NodeCapacity, unsigned int );
+
+  /** Set/Get the number of threads used to compute the bounding boxes */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstReferenceMacro( NumberOfThreads, int );
+
+  /** Build the tree for the objects of a label map. The label map is not
+   * kept. */
+  void Build( const LabelMapType * labelMap );
+
+  /** Release the memory used by the tree */
+  void Clear();
+
+  /** Return the time of the last Build() */
+  unsigned long GetBuildTime() const
+    {
+    return m_BuildTime.GetMTime();
+    }
+
+  /** Return the number of objects in the tree */
+  unsigned long GetNumberOfObjects() const
+    {
+    return m_Entries.size();
+    }
+
+  /** Append to objects the objects with a bounding box intersecting the
+   * region. The objects are in no particular order. */
+  void FindObjects( const RegionType & region, LabelObjectVectorType & objects ) const;
+
+  /** Append to objects the objects with a bounding box containing the
+   * index. The objects are in no particular order. */
+  void FindObjects( const IndexType & idx, LabelObjectVectorType & objects ) const;
+
+  /** Append to objects the objects with a bounding box fully inside the
+   * region. The objects are in no particular order. */
+  void FindObjectsInside( const RegionType & region, LabelObjectVectorType & objects ) const;
+
+  /** Return the bounding box of all the objects, or an empty region if there
+   * is no object */
+  RegionType GetBoundingBox() const;
+
+  /** return the allocated memory, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    unsigned long size = m_Entries.capacity() * sizeof( EntryType );
+    for( unsigned int l=0; l<m_Levels.size(); l++ )
+      {
+      size += m_Levels[l].capacity() * sizeof( NodeType );
+      }
+    return size;
+    }
+
+protected:
+
+  LabelMapSpatialIndex();
+  ~LabelMapSpatialIndex() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** an object and its bounding box. The bounds are included. */
+  struct EntryType
+    {
+    IndexType Min;
+    IndexType Max;
+    LabelObjectType * Object;
+    };
+
+  /** a node of the tree: the bounding box of its children, which are the
+   * entries FirstChild to FirstChild+NumberOfChildren-1 for the nodes of the
+   * first level, or the nodes of the previous level otherwise */
+  struct NodeType
+    {
+    IndexType Min;
+    IndexType Max;
+    unsigned long FirstChild;
+    unsigned long NumberOfChildren;
+    };
+
+  /** compare the center of two boxes on an axis */
+  template< class TBox >
+  struct CenterCompare
+    {
+    CenterCompare( unsigned int axis ) : m_Axis( axis ) {}
+    bool operator()( const TBox & a, const TBox & b ) const
+      {
+      return a.Min[m_Axis] + a.Max[m_Axis] < b.Min[m_Axis] + b.Max[m_Axis];
+      }
+    unsigned int m_Axis;
+    };
+
+  /** sort the boxes in [begin, end) with the sort-tile-recursive method,
+   * starting at the given axis */
+  template< class TBox >
+  void SortTileRecursive( typename std::vector< TBox >::iterator begin, typename std::vector< TBox >::iterator end, unsigned int axis );
+
+  /** group the boxes of a level in nodes */
+  template< class TBox >
+  void BuildLevel( const std::vector< TBox > & boxes, std::vector< NodeType > & nodes );
+
+  template< class TBox >
+  static inline bool Intersects( const TBox & box, const IndexType & min, const IndexType & max )
+    {
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      if( box.Max[d] < min[d] || box.Min[d] > max[d] )
+        {
+        return false;
+        }
+      }
+    return true;
+    }
+
+  template< class TBox >
+  static inline bool IsInside( const TBox & box, const IndexType & min, const IndexType & max )
+    {
+    for( unsigned int d=0; d<ImageDimension; d++ )
+      {
+      if( box.Min[d] < min[d] || box.Max[d] > max[d] )
+        {
+        return false;
+        }
+      }
+    return true;
+    }
+
+  /** search the children of a node. With inside, only the objects fully
+   * inside the box are kept. */
+  void FindObjects( unsigned int level, unsigned long node, const IndexType & min, const IndexType & max, bool inside, LabelObjectVectorType & objects ) const;
+
+  /** the bounds of a region. Return false if the region is empty. */
+  static bool RegionToBounds( const RegionType & region, IndexType & min, IndexType & max );
+
+  /** data shared by the threads computing the bounding boxes */
+  struct ThreadStruct
+    {
+    Self * Index;
+    int NumberOfThreads;
+    };
+
+  static ITK_THREAD_RETURN_TYPE BoundingBoxThreaderCallback( void * arg );
+
+  /** compute the bounding boxes of a part of the entries */
+  void ThreadedComputeBoundingBoxes( int threadId, int nbOfThreads );
+
+private:
+
+  LabelMapSpatialIndex(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned int m_NodeCapacity;
+  int m_NumberOfThreads;
+
+  std::vector< EntryType > m_Entries;
+  // m_Levels[0] are the leaves, and the last level has a single node
+  std::vector< std::vector< NodeType > > m_Levels;
+
+  TimeStamp m_BuildTime;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelMapSpatialIndex.txx"
+#endif
+
+#endif
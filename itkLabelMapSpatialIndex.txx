@@ -0,0 +1,338 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkLabelMapSpatialIndex.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkLabelMapSpatialIndex_txx
+#define __itkLabelMapSpatialIndex_txx
+
+#include "itkLabelMapSpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+template <class TLabelMap>
+LabelMapSpatialIndex<TLabelMap>
+::LabelMapSpatialIndex()
+{
+  m_NodeCapacity = 16;
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::Build( const LabelMapType * labelMap )
+{
+  m_Entries.clear();
+  m_Levels.clear();
+
+  const typename LabelMapType::LabelObjectContainerType & container = labelMap->GetLabelObjectContainer();
+  m_Entries.resize( container.size() );
+  typename std::vector< EntryType >::iterator eit = m_Entries.begin();
+  for( typename LabelMapType::LabelObjectContainerType::const_iterator it = container.begin();
+    it != container.end();
+    it++, eit++ )
+    {
+    eit->Object = it->second.GetPointer();
+    }
+
+  // the bounding boxes, in parallel
+  if( !m_Entries.empty() )
+    {
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads( std::min( (unsigned long)m_NumberOfThreads, (unsigned long)m_Entries.size() / 64 + 1 ) );
+    ThreadStruct str;
+    str.Index = this;
+    str.NumberOfThreads = threader->GetNumberOfThreads();
+    threader->SetSingleMethod( Self::BoundingBoxThreaderCallback, &str );
+    threader->SingleMethodExecute();
+    }
+
+  // the empty objects can't be found, and would break the order of the boxes
+  unsigned long last = 0;
+  for( unsigned long i=0; i<m_Entries.size(); i++ )
+    {
+    if( m_Entries[i].Min[0] <= m_Entries[i].Max[0] )
+      {
+      m_Entries[last++] = m_Entries[i];
+      }
+    }
+  m_Entries.resize( last );
+
+  if( !m_Entries.empty() )
+    {
+    // the leaves
+    this->template SortTileRecursive< EntryType >( m_Entries.begin(), m_Entries.end(), 0 );
+    m_Levels.resize( 1 );
+    this->BuildLevel( m_Entries, m_Levels[0] );
+
+    // and the upper levels, up to the root. The nodes of a level can be
+    // reordered as long as the next level is not built.
+    while( m_Levels.back().size() > 1 )
+      {
+      std::vector< NodeType > & level = m_Levels.back();
+      this->template SortTileRecursive< NodeType >( level.begin(), level.end(), 0 );
+      std::vector< NodeType > nodes;
+      this->BuildLevel( level, nodes );
+      m_Levels.push_back( nodes );
+      }
+    }
+
+  m_BuildTime.Modified();
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::Clear()
+{
+  std::vector< EntryType >().swap( m_Entries );
+  std::vector< std::vector< NodeType > >().swap( m_Levels );
+}
+
+
+template <class TLabelMap>
+ITK_THREAD_RETURN_TYPE
+LabelMapSpatialIndex<TLabelMap>
+::BoundingBoxThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+  str->Index->ThreadedComputeBoundingBoxes( info->ThreadID, str->NumberOfThreads );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::ThreadedComputeBoundingBoxes( int threadId, int nbOfThreads )
+{
+  const unsigned long n = m_Entries.size();
+  const unsigned long begin = n * threadId / nbOfThreads;
+  const unsigned long end = n * ( threadId + 1 ) / nbOfThreads;
+
+  for( unsigned long e=begin; e<end; e++ )
+    {
+    EntryType & entry = m_Entries[e];
+    entry.Min.Fill( NumericTraits< long >::max() );
+    entry.Max.Fill( NumericTraits< long >::NonpositiveMin() );
+    const LineContainerType & lines = entry.Object->GetLineContainer();
+    for( typename LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      const IndexType & idx = lit->GetIndex();
+      for( unsigned int d=0; d<ImageDimension; d++ )
+        {
+        entry.Min[d] = std::min( entry.Min[d], idx[d] );
+        entry.Max[d] = std::max( entry.Max[d], idx[d] );
+        }
+      // must fix the max for the axis 0
+      entry.Max[0] = std::max( entry.Max[0], idx[0] + (long)lit->GetLength() - 1 );
+      }
+    }
+}
+
+
+template <class TLabelMap>
+template< class TBox >
+void
+LabelMapSpatialIndex<TLabelMap>
+::SortTileRecursive( typename std::vector< TBox >::iterator begin, typename std::vector< TBox >::iterator end, unsigned int axis )
+{
+  std::sort( begin, end, CenterCompare< TBox >( axis ) );
+  if( axis == ImageDimension - 1 )
+    {
+    return;
+    }
+
+  // cut in slabs of a whole number of nodes, and sort each slab on the next
+  // axis
+  const unsigned long n = end - begin;
+  const unsigned long nbOfNodes = ( n + m_NodeCapacity - 1 ) / m_NodeCapacity;
+  unsigned long nbOfSlabs = (unsigned long)ceil( pow( (double)nbOfNodes, 1.0 / ( ImageDimension - axis ) ) );
+  nbOfSlabs = std::max( nbOfSlabs, 1UL );
+  const unsigned long slabSize = ( ( nbOfNodes + nbOfSlabs - 1 ) / nbOfSlabs ) * m_NodeCapacity;
+  for( unsigned long i=0; i<n; i+=slabSize )
+    {
+    this->template SortTileRecursive< TBox >( begin + i, begin + std::min( i + slabSize, n ), axis + 1 );
+    }
+}
+
+
+template <class TLabelMap>
+template< class TBox >
+void
+LabelMapSpatialIndex<TLabelMap>
+::BuildLevel( const std::vector< TBox > & boxes, std::vector< NodeType > & nodes )
+{
+  nodes.resize( ( boxes.size() + m_NodeCapacity - 1 ) / m_NodeCapacity );
+  for( unsigned long i=0; i<nodes.size(); i++ )
+    {
+    NodeType & node = nodes[i];
+    node.FirstChild = i * m_NodeCapacity;
+    node.NumberOfChildren = std::min( (unsigned long)m_NodeCapacity, (unsigned long)boxes.size() - node.FirstChild );
+    node.Min = boxes[node.FirstChild].Min;
+    node.Max = boxes[node.FirstChild].Max;
+    for( unsigned long c=node.FirstChild+1; c<node.FirstChild+node.NumberOfChildren; c++ )
+      {
+      for( unsigned int d=0; d<ImageDimension; d++ )
+        {
+        node.Min[d] = std::min( node.Min[d], boxes[c].Min[d] );
+        node.Max[d] = std::max( node.Max[d], boxes[c].Max[d] );
+        }
+      }
+    }
+}
+
+
+template <class TLabelMap>
+bool
+LabelMapSpatialIndex<TLabelMap>
+::RegionToBounds( const RegionType & region, IndexType & min, IndexType & max )
+{
+  min = region.GetIndex();
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    if( region.GetSize()[d] == 0 )
+      {
+      return false;
+      }
+    max[d] = min[d] + (long)region.GetSize()[d] - 1;
+    }
+  return true;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::FindObjects( const RegionType & region, LabelObjectVectorType & objects ) const
+{
+  IndexType min;
+  IndexType max;
+  if( !m_Levels.empty() && RegionToBounds( region, min, max ) )
+    {
+    this->FindObjects( m_Levels.size() - 1, 0, min, max, false, objects );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::FindObjects( const IndexType & idx, LabelObjectVectorType & objects ) const
+{
+  if( !m_Levels.empty() )
+    {
+    this->FindObjects( m_Levels.size() - 1, 0, idx, idx, false, objects );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::FindObjectsInside( const RegionType & region, LabelObjectVectorType & objects ) const
+{
+  IndexType min;
+  IndexType max;
+  if( !m_Levels.empty() && RegionToBounds( region, min, max ) )
+    {
+    this->FindObjects( m_Levels.size() - 1, 0, min, max, true, objects );
+    }
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::FindObjects( unsigned int level, unsigned long node, const IndexType & min, const IndexType & max, bool inside, LabelObjectVectorType & objects ) const
+{
+  const NodeType & n = m_Levels[level][node];
+  if( !Intersects( n, min, max ) )
+    {
+    return;
+    }
+  const unsigned long end = n.FirstChild + n.NumberOfChildren;
+  if( level == 0 )
+    {
+    for( unsigned long c=n.FirstChild; c<end; c++ )
+      {
+      const EntryType & entry = m_Entries[c];
+      if( inside ? IsInside( entry, min, max ) : Intersects( entry, min, max ) )
+        {
+        objects.push_back( entry.Object );
+        }
+      }
+    }
+  else
+    {
+    for( unsigned long c=n.FirstChild; c<end; c++ )
+      {
+      this->FindObjects( level - 1, c, min, max, inside, objects );
+      }
+    }
+}
+
+
+template <class TLabelMap>
+typename LabelMapSpatialIndex<TLabelMap>::RegionType
+LabelMapSpatialIndex<TLabelMap>
+::GetBoundingBox() const
+{
+  RegionType region;
+  if( m_Levels.empty() )
+    {
+    IndexType idx;
+    idx.Fill( 0 );
+    SizeType size;
+    size.Fill( 0 );
+    region.SetIndex( idx );
+    region.SetSize( size );
+    return region;
+    }
+  const NodeType & root = m_Levels.back()[0];
+  SizeType size;
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    size[d] = root.Max[d] - root.Min[d] + 1;
+    }
+  region.SetIndex( root.Min );
+  region.SetSize( size );
+  return region;
+}
+
+
+template <class TLabelMap>
+void
+LabelMapSpatialIndex<TLabelMap>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NodeCapacity: "  << m_NodeCapacity << std::endl;
+  os << indent << "NumberOfThreads: "  << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfObjects: "  << m_Entries.size() << std::endl;
+  os << indent << "NumberOfLevels: "  << m_Levels.size() << std::endl;
+  os << indent << "BuildTime: "  << m_BuildTime.GetMTime() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -135,7 +135,7 @@ LabelMapToBinaryImageFilter<TInputImage, TOutputImage>
     {
     IndexType idx = lit->GetIndex();
     unsigned long length = lit->GetLength();
-    for( int i=0; i<length; i++)
+    for( unsigned long i=0; i<length; i++)
       {
       output->SetPixel( idx, m_ForegroundValue );
       idx[0]++;
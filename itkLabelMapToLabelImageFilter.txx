@@ -60,7 +60,7 @@ LabelMapToLabelImageFilter<TInputImage, TOutputImage>
     {
     IndexType idx = lit->GetIndex();
     unsigned long length = lit->GetLength();
-    for( int i=0; i<length; i++)
+    for( unsigned long i=0; i<length; i++)
       {
       this->GetOutput()->SetPixel( idx, label );
       idx[0]++;
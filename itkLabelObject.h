@@ -17,7 +17,7 @@
 #ifndef __itkLabelObject_h
 #define __itkLabelObject_h
 
-#include <deque>
+#include <vector>
 #include <itkLightObject.h>
 #include "itkLabelMap.h"
 #include "itkLabelObjectLine.h"
@@ -46,7 +46,7 @@ class ITK_EXPORT NumberOfLinesLabelObjectAccessor
 {
 public:
   typedef TLabelObject LabelObjectType;
-  typedef int AttributeValueType;
+  typedef unsigned long AttributeValueType;
 
   inline const AttributeValueType operator()( const LabelObjectType * labelObject )
     {
@@ -100,6 +100,10 @@ private:
  *
  * All the subclasses of LabelObject have to reinplement the CopyDataFrom() method.
  *
+ * The lines are stored contiguously in a std::vector, so they can be copied
+ * in a single block to other libraries, like the NumPy arrays of the Python
+ * wrappers (see PyLabelMap).
+ *
  * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * \sa LabelMapFilter, AttributeLabelObject
@@ -132,7 +136,7 @@ public:
 
   typedef typename LineType::LengthType LengthType;
 
-  typedef typename std::deque< LineType > LineContainerType;
+  typedef typename std::vector< LineType > LineContainerType;
 
   /**
    * Set/Get the label associated with that object.
@@ -216,24 +220,24 @@ public:
     return m_LineContainer;
     }
 
-  int GetNumberOfLines() const
+  unsigned long GetNumberOfLines() const
     {
     return m_LineContainer.size();
     }
 
-  const LineType & GetLine( int i ) const
+  const LineType & GetLine( unsigned long i ) const
     {
     return m_LineContainer[i];
     }
   
-  LineType & GetLine( int i )
+  LineType & GetLine( unsigned long i )
     {
     return m_LineContainer[i];
     }
 
-  int Size() const
+  unsigned long Size() const
     {
-    int size = 0;
+    unsigned long size = 0;
     for( typename LineContainerType::const_iterator it=m_LineContainer.begin();
       it != m_LineContainer.end();
       it++ )
@@ -243,15 +247,15 @@ public:
     return size;
     }
   
-  IndexType GetIndex( int offset ) const
+  IndexType GetIndex( unsigned long offset ) const
     {
-    int o = offset;
+    unsigned long o = offset;
     for( typename LineContainerType::const_iterator it=m_LineContainer.begin();
       it != m_LineContainer.end();
       it++ )
       {
-      int size = it->GetLength();
-      if( o > size)
+      const unsigned long size = it->GetLength();
+      if( o >= size)
         {
         o -= size;
         }
@@ -0,0 +1,247 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMappedImageContainer.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMappedImageContainer_h
+#define __itkMappedImageContainer_h
+
+#include "itkImportImageContainer.h"
+#include <string>
+#include <cstddef>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/** \class MappedFile
+ *  \brief A whole file mapped in memory
+ *
+ * The file is mapped read only, or copy-on-write: the pages written are
+ * then private to the process, and the file is never modified. The pages
+ * are only read from the disk when they are first accessed. The mapping is
+ * released by Unmap() or by the destructor.
+ *
+ * \sa MappedImageContainer
+ */
+class MappedFile
+{
+
+public:
+
+  MappedFile()
+    {
+    m_Data = NULL;
+    m_Length = 0;
+#ifdef _WIN32
+    m_File = INVALID_HANDLE_VALUE;
+    m_Mapping = NULL;
+#endif
+    }
+
+  ~MappedFile()
+    {
+    this->Unmap();
+    }
+
+  /** map the file. Return false on failure, or if the file is empty. */
+  bool Map( const std::string & fileName, bool copyOnWrite )
+    {
+    this->Unmap();
+#ifdef _WIN32
+    m_File = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( m_File == INVALID_HANDLE_VALUE )
+      {
+      return false;
+      }
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( m_File, &size ) || size.QuadPart == 0 )
+      {
+      this->Unmap();
+      return false;
+      }
+    m_Mapping = CreateFileMappingA( m_File, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL );
+    if( m_Mapping == NULL )
+      {
+      this->Unmap();
+      return false;
+      }
+    m_Data = static_cast< char * >( MapViewOfFile( m_Mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 ) );
+    if( m_Data == NULL )
+      {
+      this->Unmap();
+      return false;
+      }
+    m_Length = (size_t)size.QuadPart;
+#else
+    int fd = open( fileName.c_str(), O_RDONLY );
+    if( fd < 0 )
+      {
+      return false;
+      }
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || st.st_size == 0 )
+      {
+      close( fd );
+      return false;
+      }
+    void * data = mmap( NULL, (size_t)st.st_size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+                        MAP_PRIVATE, fd, 0 );
+    // the mapping keeps its own reference to the file
+    close( fd );
+    if( data == MAP_FAILED )
+      {
+      return false;
+      }
+    m_Data = static_cast< char * >( data );
+    m_Length = (size_t)st.st_size;
+#endif
+    return true;
+    }
+
+  /** release the mapping */
+  void Unmap()
+    {
+#ifdef _WIN32
+    if( m_Data != NULL )
+      {
+      UnmapViewOfFile( m_Data );
+      }
+    if( m_Mapping != NULL )
+      {
+      CloseHandle( m_Mapping );
+      m_Mapping = NULL;
+      }
+    if( m_File != INVALID_HANDLE_VALUE )
+      {
+      CloseHandle( m_File );
+      m_File = INVALID_HANDLE_VALUE;
+      }
+#else
+    if( m_Data != NULL )
+      {
+      munmap( m_Data, m_Length );
+      }
+#endif
+    m_Data = NULL;
+    m_Length = 0;
+    }
+
+  char * GetData() const
+    {
+    return m_Data;
+    }
+
+  size_t GetLength() const
+    {
+    return m_Length;
+    }
+
+private:
+
+  MappedFile(const MappedFile&); //purposely not implemented
+  void operator=(const MappedFile&); //purposely not implemented
+
+  char * m_Data;
+  size_t m_Length;
+#ifdef _WIN32
+  HANDLE m_File;
+  HANDLE m_Mapping;
+#endif
+
+};
+
+
+/** \class MappedImageContainer
+ *  \brief A pixel container which uses a part of a file mapped in memory
+ *
+ * The pixels are not copied: the container points directly in the mapping,
+ * and the file is unmapped when the container is deleted. It can be used
+ * as the pixel container of an Image, so the filters can start before the
+ * file has been read, and only the pages of the file actually used are read.
+ *
+ * When the file is mapped read only, writing a pixel crashes the program;
+ * map it copy-on-write to give the container to a filter which runs in
+ * place.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MappedImageFileReader, MappedFile
+ */
+template <typename TElementIdentifier, typename TElement>
+class ITK_EXPORT MappedImageContainer : public ImportImageContainer<TElementIdentifier, TElement>
+{
+public:
+  /** Standard class typedefs. */
+  typedef MappedImageContainer Self;
+  typedef ImportImageContainer<TElementIdentifier, TElement> Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  typedef TElementIdentifier ElementIdentifier;
+  typedef TElement           Element;
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(MappedImageContainer, ImportImageContainer);
+
+  /** Map the file, and use the size elements starting at offset bytes from
+   * the beginning of the file. Return false if the file can't be mapped or
+   * is too small. */
+  bool Map( const std::string & fileName, size_t offset, ElementIdentifier size, bool copyOnWrite )
+    {
+    this->Initialize();
+    m_File.Unmap();
+    if( !m_File.Map( fileName, copyOnWrite ) )
+      {
+      return false;
+      }
+    if( offset + size * sizeof( Element ) > m_File.GetLength() )
+      {
+      m_File.Unmap();
+      return false;
+      }
+    this->SetImportPointer( reinterpret_cast< Element * >( m_File.GetData() + offset ), size, false );
+    return true;
+    }
+
+protected:
+  MappedImageContainer() {};
+  ~MappedImageContainer() {};
+
+private:
+  MappedImageContainer(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  MappedFile m_File;
+
+};
+
+} // end namespace itk
+
+#endif
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMappedImageFileReader.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMappedImageFileReader_h
+#define __itkMappedImageFileReader_h
+
+#include "itkImageSource.h"
+#include "itkMappedImageContainer.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace itk {
+
+/** \class MappedImageFileReader
+ * \brief Read an uncompressed image by mapping its data file in memory
+ *
+ * MappedImageFileReader maps the data file of an image in memory, and uses
+ * the mapping as the buffer of its output, without copying it. The reader
+ * returns immediately, whatever the size of the file, and the operating
+ * system reads the pages of the file when the filters first access them.
+ *
+ * The format is chosen from the extension of the file name:
+ * - ".hdr" or ".img": an Analyze 7.5 image. The orientation field is
+ *   ignored: the pixels are in the order of the file.
+ * - ".mha" or ".mhd": an uncompressed MetaImage, with its data in the same
+ *   file or in a single other file.
+ * - any other extension: a raw file, which geometry is given with
+ *   SetRawSize(), SetRawHeaderSize() and SetRawBigEndian().
+ *
+ * The pixel type stored in the file must be exactly the pixel type of the
+ * image, as a conversion would require a copy. When the byte order of the
+ * file is not the one of the system, or when the data is not aligned on the
+ * size of a pixel, the data is copied in a new buffer; GetMapped() tells
+ * whether the last update has used the mapping.
+ *
+ * The mapping is read only by default: a filter which writes in its input
+ * buffer, like a filter running in place, would crash the program. With
+ * CopyOnWriteOn(), the pages written are copied in the memory of the
+ * process, and the file is never modified.
+ *
+ * The output is always the whole image, as the mapping of the whole file is
+ * not more expensive than the mapping of a part of it.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MappedImageContainer, ChunkedVolumeReader
+ * \ingroup IOFilters
+ */
+template<class TImage>
+class ITK_EXPORT MappedImageFileReader : public ImageSource<TImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef MappedImageFileReader Self;
+  typedef ImageSource<TImage> Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TImage ImageType;
+  typedef typename ImageType::Pointer         ImagePointer;
+  typedef typename ImageType::PixelType       PixelType;
+  typedef typename ImageType::IndexType       IndexType;
+  typedef typename ImageType::SizeType        SizeType;
+  typedef typename ImageType::RegionType      RegionType;
+  typedef typename ImageType::SpacingType     SpacingType;
+  typedef typename ImageType::PointType       PointType;
+  typedef typename ImageType::PixelContainer  PixelContainerType;
+
+  typedef MappedImageContainer< typename PixelContainerType::ElementIdentifier, PixelType > MappedContainerType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(MappedImageFileReader, ImageSource);
+
+  /** Set/Get the file name. For an Analyze image, both the ".hdr" and the
+   * ".img" file names can be used. */
+  itkSetStringMacro(FileName);
+  itkGetStringMacro(FileName);
+
+  /** Set/Get whether the mapping is copy-on-write. Default is false: the
+   * output buffer is read only. */
+  itkSetMacro(CopyOnWrite, bool);
+  itkGetConstReferenceMacro(CopyOnWrite, bool);
+  itkBooleanMacro(CopyOnWrite);
+
+  /** Set/Get the size of a raw image. It is required to read a raw file. */
+  itkSetMacro(RawSize, SizeType);
+  itkGetConstReferenceMacro(RawSize, SizeType);
+
+  /** Set/Get the number of bytes to skip at the beginning of a raw file.
+   * Default is 0. */
+  itkSetMacro(RawHeaderSize, unsigned long);
+  itkGetConstReferenceMacro(RawHeaderSize, unsigned long);
+
+  /** Set/Get whether the pixels of a raw file are stored with the most
+   * significant byte first. Default is the byte order of the system. */
+  itkSetMacro(RawBigEndian, bool);
+  itkGetConstReferenceMacro(RawBigEndian, bool);
+  itkBooleanMacro(RawBigEndian);
+
+  /** Return whether the output of the last update uses the mapping, or a
+   * copy of the data */
+  itkGetConstReferenceMacro(Mapped, bool);
+
+protected:
+  MappedImageFileReader();
+  ~MappedImageFileReader() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** Read the geometry from the header */
+  void GenerateOutputInformation();
+
+  /** The whole image is always produced */
+  void EnlargeOutputRequestedRegion(DataObject *output);
+
+  void GenerateData();
+
+  /** Read the header of an Analyze image */
+  void ReadAnalyzeHeader( const std::string & headerFileName );
+
+  /** Read the header of a MetaImage */
+  void ReadMetaImageHeader();
+
+  /** Set the geometry of a raw image */
+  void ReadRawHeader();
+
+  /** check that the type name read in the header is the pixel type of the
+   * image */
+  void CheckPixelType( const std::string & typeName );
+
+  /** set the size from the dimensions read in a header. The dimensions
+   * after ImageDimension must be 1. */
+  void SetSizeFromHeader( const std::vector< unsigned long > & dims );
+
+  /** return the lower case extension of a file name, with the dot */
+  static std::string GetExtension( const std::string & fileName );
+
+  /** read a value at a position in the header of an Analyze file, with a
+   * byte swap if the file has not the byte order of the system */
+  template <class T>
+  static T AnalyzeHeaderValue( const char * header, unsigned int pos, bool swap )
+    {
+    char bytes[ sizeof( T ) ];
+    memcpy( bytes, header + pos, sizeof( T ) );
+    if( swap )
+      {
+      std::reverse( bytes, bytes + sizeof( T ) );
+      }
+    T value;
+    memcpy( &value, bytes, sizeof( T ) );
+    return value;
+    }
+
+private:
+  MappedImageFileReader(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  std::string m_FileName;
+  bool m_CopyOnWrite;
+  SizeType m_RawSize;
+  unsigned long m_RawHeaderSize;
+  bool m_RawBigEndian;
+  bool m_Mapped;
+
+  // set by GenerateOutputInformation()
+  std::string m_DataFileName;
+  size_t m_DataOffset;
+  bool m_DataBigEndian;
+  SizeType m_Size;
+  SpacingType m_Spacing;
+  PointType m_Origin;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMappedImageFileReader.txx"
+#endif
+
+#endif
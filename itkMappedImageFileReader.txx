@@ -0,0 +1,412 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkMappedImageFileReader.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkMappedImageFileReader_txx
+#define __itkMappedImageFileReader_txx
+
+#include "itkMappedImageFileReader.h"
+#include "itkChunkedVolumeHeader.h"
+#include "itkByteSwapper.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+namespace itk {
+
+template <class TImage>
+MappedImageFileReader<TImage>
+::MappedImageFileReader()
+{
+  m_FileName = "";
+  m_CopyOnWrite = false;
+  m_RawSize.Fill( 0 );
+  m_RawHeaderSize = 0;
+  m_RawBigEndian = ByteSwapper< int >::SystemIsBigEndian();
+  m_Mapped = false;
+  m_DataOffset = 0;
+  m_DataBigEndian = m_RawBigEndian;
+  m_Size.Fill( 0 );
+  m_Spacing.Fill( 1.0 );
+  m_Origin.Fill( 0.0 );
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::GenerateOutputInformation()
+{
+  if( m_FileName == "" )
+    { itkExceptionMacro( << "FileName must be set." ); }
+
+  m_Spacing.Fill( 1.0 );
+  m_Origin.Fill( 0.0 );
+
+  const std::string ext = Self::GetExtension( m_FileName );
+  const std::string base = m_FileName.substr( 0, m_FileName.size() - ext.size() );
+  if( ext == ".gz" || ext == ".z" || ext == ".bz2" )
+    {
+    itkExceptionMacro( << "Can't map the compressed file " << m_FileName );
+    }
+  else if( ext == ".hdr" || ext == ".img" )
+    {
+    m_DataFileName = base + ".img";
+    this->ReadAnalyzeHeader( base + ".hdr" );
+    }
+  else if( ext == ".mha" || ext == ".mhd" )
+    {
+    this->ReadMetaImageHeader();
+    }
+  else
+    {
+    this->ReadRawHeader();
+    }
+
+  ImageType * output = this->GetOutput();
+  RegionType region;
+  region.SetSize( m_Size );
+  output->SetLargestPossibleRegion( region );
+  output->SetSpacing( m_Spacing );
+  output->SetOrigin( m_Origin );
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::ReadAnalyzeHeader( const std::string & headerFileName )
+{
+  char header[348];
+  std::ifstream file( headerFileName.c_str(), std::ios::binary );
+  file.read( header, sizeof( header ) );
+  if( !file )
+    { itkExceptionMacro( << "Can't read the Analyze header " << headerFileName ); }
+
+  // the size of the header is used to find the byte order
+  bool swap = false;
+  if( Self::AnalyzeHeaderValue< int >( header, 0, false ) != 348 )
+    {
+    swap = true;
+    if( Self::AnalyzeHeaderValue< int >( header, 0, true ) != 348 )
+      { itkExceptionMacro( << headerFileName << " is not an Analyze header." ); }
+    }
+  m_DataBigEndian = ( ByteSwapper< int >::SystemIsBigEndian() != swap );
+
+  const short nbOfDims = Self::AnalyzeHeaderValue< short >( header, 40, swap );
+  if( nbOfDims < 1 || nbOfDims > 7 )
+    { itkExceptionMacro( << "Invalid number of dimensions in " << headerFileName ); }
+  std::vector< unsigned long > dims( nbOfDims );
+  for( short d=0; d<nbOfDims; d++ )
+    {
+    dims[d] = Self::AnalyzeHeaderValue< short >( header, 42 + 2 * d, swap );
+    if( d < (short)ImageDimension )
+      {
+      float spacing = Self::AnalyzeHeaderValue< float >( header, 80 + 4 * d, swap );
+      m_Spacing[d] = spacing > 0 ? spacing : 1.0;
+      }
+    }
+  this->SetSizeFromHeader( dims );
+
+  std::string typeName;
+  switch( Self::AnalyzeHeaderValue< short >( header, 70, swap ) )
+    {
+    case 2: typeName = "uint8"; break;
+    case 4: typeName = "int16"; break;
+    case 8: typeName = "int32"; break;
+    case 16: typeName = "float32"; break;
+    case 64: typeName = "float64"; break;
+    default:
+      itkExceptionMacro( << "Unsupported Analyze data type in " << headerFileName );
+    }
+  this->CheckPixelType( typeName );
+
+  const float voxOffset = Self::AnalyzeHeaderValue< float >( header, 108, swap );
+  m_DataOffset = voxOffset > 0 ? (size_t)voxOffset : 0;
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::ReadMetaImageHeader()
+{
+  std::ifstream file( m_FileName.c_str(), std::ios::binary );
+  if( !file )
+    { itkExceptionMacro( << "Can't open " << m_FileName ); }
+
+  std::vector< unsigned long > dims;
+  std::string typeName;
+  std::string dataFile;
+  long headerSize = 0;
+  m_DataBigEndian = false;
+
+  // the keys are read up to ElementDataFile, which is always the last one
+  std::string line;
+  while( dataFile == "" && std::getline( file, line ) )
+    {
+    std::string::size_type eq = line.find( '=' );
+    if( eq == std::string::npos )
+      {
+      continue;
+      }
+    std::istringstream keyStream( line.substr( 0, eq ) );
+    std::string key;
+    keyStream >> key;
+    std::istringstream values( line.substr( eq + 1 ) );
+    std::string value;
+    values >> value;
+
+    if( key == "ObjectType" && value != "Image" )
+      { itkExceptionMacro( << m_FileName << " is not an image." ); }
+    else if( key == "DimSize" )
+      {
+      dims.clear();
+      for( std::istringstream is( line.substr( eq + 1 ) ); is >> value; )
+        {
+        dims.push_back( atol( value.c_str() ) );
+        }
+      }
+    else if( key == "ElementSpacing" || key == "ElementSize" )
+      {
+      std::istringstream is( line.substr( eq + 1 ) );
+      for( unsigned int d=0; d<ImageDimension && is >> m_Spacing[d]; d++ ) {}
+      }
+    else if( key == "Offset" || key == "Origin" || key == "Position" )
+      {
+      std::istringstream is( line.substr( eq + 1 ) );
+      for( unsigned int d=0; d<ImageDimension && is >> m_Origin[d]; d++ ) {}
+      }
+    else if( key == "ElementType" )
+      {
+      if( value == "MET_UCHAR" ) { typeName = "uint8"; }
+      else if( value == "MET_CHAR" ) { typeName = "int8"; }
+      else if( value == "MET_USHORT" ) { typeName = "uint16"; }
+      else if( value == "MET_SHORT" ) { typeName = "int16"; }
+      else if( value == "MET_UINT" ) { typeName = "uint32"; }
+      else if( value == "MET_INT" ) { typeName = "int32"; }
+      else if( value == "MET_ULONG_LONG" ) { typeName = "uint64"; }
+      else if( value == "MET_LONG_LONG" ) { typeName = "int64"; }
+      else if( value == "MET_FLOAT" ) { typeName = "float32"; }
+      else if( value == "MET_DOUBLE" ) { typeName = "float64"; }
+      else
+        { itkExceptionMacro( << "Unsupported MetaImage element type " << value << " in " << m_FileName ); }
+      }
+    else if( key == "ElementNumberOfChannels" && value != "1" )
+      { itkExceptionMacro( << "Only scalar images can be mapped: " << m_FileName ); }
+    else if( ( key == "CompressedData" && value == "True" ) || ( key == "BinaryData" && value == "False" ) )
+      { itkExceptionMacro( << "Can't map the compressed or ASCII data of " << m_FileName ); }
+    else if( key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB" )
+      {
+      m_DataBigEndian = ( value == "True" );
+      }
+    else if( key == "HeaderSize" )
+      {
+      headerSize = atol( value.c_str() );
+      }
+    else if( key == "ElementDataFile" )
+      {
+      dataFile = value;
+      std::string rest;
+      if( value == "" || value == "LIST" || ( values >> rest ) || value.find( '%' ) != std::string::npos )
+        { itkExceptionMacro( << "Can't map the data of " << m_FileName << ", which is not in a single file." ); }
+      }
+    }
+
+  if( dataFile == "" || typeName == "" || dims.empty() )
+    { itkExceptionMacro( << "Incomplete MetaImage header in " << m_FileName ); }
+  this->SetSizeFromHeader( dims );
+  this->CheckPixelType( typeName );
+
+  if( dataFile == "LOCAL" )
+    {
+    m_DataFileName = m_FileName;
+    m_DataOffset = (size_t)file.tellg();
+    return;
+    }
+
+  // the data file is relative to the directory of the header
+  if( dataFile[0] == '/' || dataFile[0] == '\\' || ( dataFile.size() > 1 && dataFile[1] == ':' ) )
+    {
+    m_DataFileName = dataFile;
+    }
+  else
+    {
+    std::string::size_type slash = m_FileName.find_last_of( "/\\" );
+    m_DataFileName = slash == std::string::npos ? dataFile : m_FileName.substr( 0, slash + 1 ) + dataFile;
+    }
+
+  if( headerSize >= 0 )
+    {
+    m_DataOffset = headerSize;
+    }
+  else
+    {
+    // the data is at the end of the file
+    std::ifstream data( m_DataFileName.c_str(), std::ios::binary );
+    data.seekg( 0, std::ios::end );
+    const size_t dataSize = RegionType( m_Size ).GetNumberOfPixels() * sizeof( PixelType );
+    const size_t fileSize = (size_t)data.tellg();
+    if( !data || fileSize < dataSize )
+      { itkExceptionMacro( << "The data file " << m_DataFileName << " is too small." ); }
+    m_DataOffset = fileSize - dataSize;
+    }
+}
+
+
+template <class TImage>
+std::string
+MappedImageFileReader<TImage>
+::GetExtension( const std::string & fileName )
+{
+  std::string::size_type dot = fileName.rfind( '.' );
+  std::string::size_type slash = fileName.find_last_of( "/\\" );
+  if( dot == std::string::npos || ( slash != std::string::npos && dot < slash ) )
+    {
+    return "";
+    }
+  std::string ext = fileName.substr( dot );
+  for( std::string::size_type i=0; i<ext.size(); i++ )
+    {
+    ext[i] = tolower( ext[i] );
+    }
+  return ext;
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::ReadRawHeader()
+{
+  for( unsigned int d=0; d<ImageDimension; d++ )
+    {
+    if( m_RawSize[d] == 0 )
+      { itkExceptionMacro( << "RawSize must be set to read the raw file " << m_FileName ); }
+    }
+  m_Size = m_RawSize;
+  m_DataFileName = m_FileName;
+  m_DataOffset = m_RawHeaderSize;
+  m_DataBigEndian = m_RawBigEndian;
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::CheckPixelType( const std::string & typeName )
+{
+  if( typeName != ChunkedVolumePixelTypeName< PixelType >() )
+    {
+    itkExceptionMacro( << "The pixel type of " << m_FileName << " is " << typeName
+                       << ", not " << ChunkedVolumePixelTypeName< PixelType >() );
+    }
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::SetSizeFromHeader( const std::vector< unsigned long > & dims )
+{
+  m_Size.Fill( 1 );
+  for( unsigned int d=0; d<dims.size(); d++ )
+    {
+    if( d < ImageDimension )
+      {
+      m_Size[d] = dims[d];
+      }
+    else if( dims[d] > 1 )
+      {
+      itkExceptionMacro( << m_FileName << " has more than " << ImageDimension << " dimensions." );
+      }
+    }
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::EnlargeOutputRequestedRegion(DataObject *output)
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::GenerateData()
+{
+  ImageType * output = this->GetOutput();
+  output->SetBufferedRegion( output->GetLargestPossibleRegion() );
+  const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+
+  // the mapping can only be used directly if the pixels are usable as they
+  // are stored
+  const bool native = sizeof( PixelType ) == 1
+    || m_DataBigEndian == ByteSwapper< PixelType >::SystemIsBigEndian();
+  const bool aligned = m_DataOffset % sizeof( PixelType ) == 0;
+  m_Mapped = native && aligned;
+
+  typename MappedContainerType::Pointer container = MappedContainerType::New();
+  if( !container->Map( m_DataFileName, m_DataOffset, nbOfPixels, m_CopyOnWrite ) )
+    { itkExceptionMacro( << "Can't map " << nbOfPixels << " pixels at the offset " << m_DataOffset << " of " << m_DataFileName ); }
+
+  if( m_Mapped )
+    {
+    output->SetPixelContainer( container );
+    return;
+    }
+
+  // copy the data, and fix the byte order. The mapping is released with the
+  // container.
+  output->Allocate();
+  PixelType * buffer = output->GetBufferPointer();
+  memcpy( buffer, container->GetBufferPointer(), nbOfPixels * sizeof( PixelType ) );
+  if( m_DataBigEndian )
+    {
+    ByteSwapper< PixelType >::SwapRangeFromSystemToBigEndian( buffer, nbOfPixels );
+    }
+  else
+    {
+    ByteSwapper< PixelType >::SwapRangeFromSystemToLittleEndian( buffer, nbOfPixels );
+    }
+}
+
+
+template <class TImage>
+void
+MappedImageFileReader<TImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: "  << m_FileName << std::endl;
+  os << indent << "CopyOnWrite: "  << m_CopyOnWrite << std::endl;
+  os << indent << "RawSize: "  << m_RawSize << std::endl;
+  os << indent << "RawHeaderSize: "  << m_RawHeaderSize << std::endl;
+  os << indent << "RawBigEndian: "  << m_RawBigEndian << std::endl;
+  os << indent << "Mapped: "  << m_Mapped << std::endl;
+  os << indent << "DataFileName: "  << m_DataFileName << std::endl;
+  os << indent << "DataOffset: "  << m_DataOffset << std::endl;
+}
+
+}// end namespace itk
+#endif
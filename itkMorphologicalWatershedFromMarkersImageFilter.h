@@ -3,9 +3,116 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkConnectivity.h"
+#include "itkWatershedEdgeGraph.h"
+#include "itkProgressReporter.h"
+#include "itkHierarchicalQueue.h"
 
 namespace itk {
 
+namespace Functor {
+
+/** \class CompactLabel
+ * \brief Map a label to a compact label where the background is 0
+ *
+ * The labels lower than the background are shifted by one, and the others
+ * are kept, so the order of the labels is preserved. The labels and the
+ * background must be positive.
+ *
+ * \sa ExpandCompactLabel
+ */
+template< class TInput, class TOutput >
+class CompactLabel
+{
+public:
+  CompactLabel()
+    {
+    m_BackgroundValue = NumericTraits< TInput >::Zero;
+    }
+  ~CompactLabel() {}
+
+  void SetBackgroundValue( const TInput & value )
+    {
+    m_BackgroundValue = value;
+    }
+
+  bool operator!=( const CompactLabel & other ) const
+    {
+    return m_BackgroundValue != other.m_BackgroundValue;
+    }
+  bool operator==( const CompactLabel & other ) const
+    {
+    return !( *this != other );
+    }
+
+  inline TOutput operator()( const TInput & v ) const
+    {
+    if( v == m_BackgroundValue )
+      {
+      return NumericTraits< TOutput >::Zero;
+      }
+    if( v < m_BackgroundValue )
+      {
+      return static_cast< TOutput >( v ) + 1;
+      }
+    return static_cast< TOutput >( v );
+    }
+
+private:
+  TInput m_BackgroundValue;
+};
+
+/** \class ExpandCompactLabel
+ * \brief The inverse of CompactLabel
+ *
+ * It is also the relation between the labels produced by
+ * ConnectedComponentImageFilter with a background of 0 and the ones
+ * produced with the background given to this functor.
+ *
+ * \sa CompactLabel
+ */
+template< class TInput, class TOutput >
+class ExpandCompactLabel
+{
+public:
+  ExpandCompactLabel()
+    {
+    m_BackgroundValue = NumericTraits< TOutput >::Zero;
+    }
+  ~ExpandCompactLabel() {}
+
+  void SetBackgroundValue( const TOutput & value )
+    {
+    m_BackgroundValue = value;
+    }
+
+  bool operator!=( const ExpandCompactLabel & other ) const
+    {
+    return m_BackgroundValue != other.m_BackgroundValue;
+    }
+  bool operator==( const ExpandCompactLabel & other ) const
+    {
+    return !( *this != other );
+    }
+
+  inline TOutput operator()( const TInput & v ) const
+    {
+    if( v == NumericTraits< TInput >::Zero )
+      {
+      return m_BackgroundValue;
+      }
+    if( static_cast< unsigned long >( v ) <= static_cast< unsigned long >( m_BackgroundValue ) )
+      {
+      return static_cast< TOutput >( v - 1 );
+      }
+    return static_cast< TOutput >( v );
+    }
+
+private:
+  TOutput m_BackgroundValue;
+};
+
+} // end namespace Functor
+
 /** \class MorphologicalWatershedFromMarkersImageFilter
  * \brief Morphological watershed transform from markers
  *
@@ -21,12 +128,109 @@ namespace itk {
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The flooding can also be replaced by a watershed cut, with
+ * SetFloodingMethod( MINIMUM_SPANNING_FOREST ): the edges between the
+ * neighbor pixels are weighted with the maximum of the two pixel values (or
+ * their absolute difference, see SetEdgeWeight()), sorted, and the minimum
+ * spanning forest rooted in the markers is built with the Kruskal algorithm.
+ * With the MAXIMUM edge weight, each pixel gets the label of a marker
+ * reached by a path whose highest value is minimal, like with the flooding
+ * of Meyer (the default HIERARCHICAL_QUEUE method, with MarkWatershedLine
+ * on). Compared to the output of Meyer, the labels differ only:
+ *  - on the watershed line of Meyer, which this method doesn't produce:
+ *    each line pixel is given to one of the basins it separates, and
+ *    MarkWatershedLine is ignored;
+ *  - on the plateaus and on the pixels reached at the same level from two
+ *    markers: the flooding gives those pixels to the first label which
+ *    reaches them in the hierarchical queue, while the Kruskal algorithm
+ *    gives them to the label of the first edge in raster order;
+ *  - next to the markers placed on pixels higher than their neighbors: the
+ *    weight of an edge includes the value of the marker pixel, while the
+ *    flooding starts at the value of the neighbors.
+ * UseImageSpacing is ignored.
+ * The edges are sorted in parallel, but the method requires about 16 bytes
+ * per edge, so it uses more memory than the flooding.
+ *
+ * The flooding is an image foresting transform (see ImageForestingTransform)
+ * and the same propagation can be used with other costs, with
+ * SetPropagation(): GEODESIC_VORONOI gives each pixel to the marker with the
+ * cheapest path, the input image being the cost to cross each pixel, and
+ * SEEDED_REGION_GROWING adds to the regions the pixels the closest to their
+ * mean. FloodingMethod is only used with the default WATERSHED propagation.
+ *
+ * For the integer input images of 8 or 16 bits, SetFloodingMethod(
+ * SORTED_LEVELS ) replaces the hierarchical queue by the sorting approach of
+ * Vincent and Soille: the pixels are sorted by grey level with a counting
+ * sort in a single array allocated once, with exactly one offset per pixel,
+ * and the levels are then processed in increasing order, with a FIFO reused
+ * from one level to the other for the propagation on the plateaus. The
+ * FIFO has one place per floodable pixel, so it never grows, and only the
+ * pixels on the border of the image pay a bound check. The
+ * result is the same as the one of the hierarchical queue, except for the
+ * order of the pixels at the same distance of two markers on a plateau.
+ * The other pixel types, and UseImageSpacing, fall back to the hierarchical
+ * queue.
+ *
+ * With the other pixel types, like float or 32 bits integers, the
+ * hierarchical queue is a map of FIFOs, and each push or pop pays a search
+ * in that map. SetUseRankTransform( true ) replaces the input values by
+ * their rank in the sorted distinct values of the image (see
+ * RankTransformImageFilter) before the flooding: the order of the pixels is
+ * exactly preserved, so the result is the same, but the ranks are dense
+ * integers which can be flooded with a DenseHierarchicalQueue, indexed
+ * directly by the rank. The ranks are stored on 16 bits when the image has
+ * at most 65536 distinct values, and on 32 bits otherwise. It is only used
+ * with the WATERSHED propagation, the HIERARCHICAL_QUEUE method, and without
+ * UseImageSpacing.
+ *
+ * The markers often fit in 8 or 16 bits while the output label type is
+ * larger. By default, the propagation is done on a copy of the markers
+ * stored with the narrowest unsigned type able to store them, and the
+ * labels are widened only when they are written in the output. The
+ * background is mapped to 0 in that copy, and the other labels keep their
+ * order. See SetUseCompactLabels(). The MINIMUM_SPANNING_FOREST and
+ * SORTED_LEVELS methods always work on the output label type.
+ *
+ * The scratch memory of the flooding (the status of the pixels, the
+ * buckets of the hierarchical queue, the compact label images, the sorted
+ * pixels of SORTED_LEVELS and the sorted edges of MINIMUM_SPANNING_FOREST)
+ * is kept from one execution to the
+ * other, so running the filter on a stream of images of the same size does
+ * no large allocation. SetMaximumScratchSize() limits the memory kept, and
+ * ReleaseScratch() frees it.
+ *
+ * The flooding can be bounded with an optional mask image, given with
+ * SetMaskImage(), and with SetMaximumFloodLevel(): the pixels outside the
+ * mask (where the mask is 0) or with an input value greater than the
+ * maximum flood level are never put in the queue, and keep the background
+ * value in the output. The markers are always copied in the output, even
+ * outside those bounds. When the floodable pixels are less than
+ * SparseFloodingFraction of the image, the status of the pixels is stored
+ * by blocks allocated on demand (see BlockedBitArray) instead of a bit per
+ * pixel of the image, and SORTED_LEVELS only sorts the floodable pixels. The
+ * output and the compact label images are still of the size of the image.
+ *
+ * See "Watershed Cuts: Minimum Spanning Forests and the Drop of Water
+ * Principle", J. Cousty, G. Bertrand, L. Najman and M. Couprie, IEEE
+ * PAMI, 2009.
+ *
+ * The marker image is often a temporary image, like the output of
+ * ConnectedComponentImageFilter. With SetInPlace( true ), the output is
+ * grafted on the marker image and the flooding is done directly in its
+ * buffer, so the filter doesn't allocate another label image. The result is
+ * the same: the markers are all read before the first label is written. The
+ * marker image is released after the execution, as the input of an
+ * InPlaceImageFilter, so its source is executed again at the next update.
+ * The filter doesn't run in place when the marker image is also the mask
+ * image. With the compact labels, the compact markers are also flooded in
+ * place.
+ *
  * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * \sa WatershedImageFilter, MorphologicalWatershedImageFilter
  * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
  */
-template<class TInputImage, class TLabelImage>
+template<class TInputImage, class TLabelImage, class TMaskImage=TLabelImage>
 class ITK_EXPORT MorphologicalWatershedFromMarkersImageFilter : 
     public ImageToImageFilter<TInputImage, TLabelImage>
 {
@@ -41,6 +245,7 @@ public:
   /** Some convenient typedefs. */
   typedef TInputImage InputImageType;
   typedef TLabelImage LabelImageType;
+  typedef TMaskImage MaskImageType;
   typedef typename InputImageType::Pointer        InputImagePointer;
   typedef typename InputImageType::ConstPointer   InputImageConstPointer;
   typedef typename InputImageType::RegionType     InputImageRegionType;
@@ -49,6 +254,7 @@ public:
   typedef typename LabelImageType::ConstPointer   LabelImageConstPointer;
   typedef typename LabelImageType::RegionType     LabelImageRegionType;
   typedef typename LabelImageType::PixelType      LabelImagePixelType;
+  typedef typename MaskImageType::PixelType       MaskImagePixelType;
   
   typedef typename LabelImageType::IndexType      IndexType;
 
@@ -57,6 +263,25 @@ public:
                       TInputImage::ImageDimension);
 
   typedef Connectivity< ImageDimension > ConnectivityType;
+
+  typedef WatershedEdgeGraph< InputImageType > EdgeGraphType;
+
+  typedef enum {
+    HIERARCHICAL_QUEUE,
+    MINIMUM_SPANNING_FOREST,
+    SORTED_LEVELS
+  } FloodingMethodType;
+
+  typedef enum {
+    WATERSHED,
+    GEODESIC_VORONOI,
+    SEEDED_REGION_GROWING
+  } PropagationType;
+
+  typedef enum {
+    MAXIMUM = EdgeGraphType::MAXIMUM,
+    ABSOLUTE_DIFFERENCE = EdgeGraphType::ABSOLUTE_DIFFERENCE
+  } EdgeWeightType;
   
   /** Standard New method. */
   itkNewMacro(Self);  
@@ -79,6 +304,19 @@ public:
     return static_cast<LabelImageType*>(const_cast<DataObject *>(this->ProcessObject::GetInput(1)));
     }
 
+  /** Set the mask image. The flooding is restricted to the pixels where
+   * the mask is not 0. The mask is optional. */
+  void SetMaskImage(const TMaskImage *input)
+     {
+     this->SetNthInput( 2, const_cast<TMaskImage *>(input) );
+     }
+
+  /** Get the mask image */
+  const MaskImageType * GetMaskImage() const
+    {
+    return static_cast<const MaskImageType*>(this->ProcessObject::GetInput(2));
+    }
+
    /** Set the input image */
   void SetInput1(TInputImage *input)
      {
@@ -91,6 +329,12 @@ public:
      this->SetMarkerImage( input );
      }
 
+   /** Set the mask image */
+  void SetInput3(const TMaskImage *input)
+     {
+     this->SetMaskImage( input );
+     }
+
   /**
    * Set/Get whether the connected components are defined strictly by
    * face connectivity or by face+edge+vertex connectivity.  Default is
@@ -148,6 +392,93 @@ public:
   itkSetMacro(BackgroundValue, LabelImagePixelType);
   itkGetMacro(BackgroundValue, LabelImagePixelType);
 
+  /**
+   * Set/Get the algorithm used to compute the watershed: the flooding with a
+   * hierarchical queue, the flooding of the pixels sorted by level, or the
+   * watershed cut computed with a minimum spanning forest. Default is
+   * HIERARCHICAL_QUEUE.
+   */
+  itkSetMacro(FloodingMethod, FloodingMethodType);
+  itkGetConstReferenceMacro(FloodingMethod, FloodingMethodType);
+
+  /**
+   * Set/Get the weight of the edges used by the MINIMUM_SPANNING_FOREST
+   * method: the MAXIMUM of the two pixels, to segment a gradient image, or
+   * the ABSOLUTE_DIFFERENCE of the two pixels, to segment directly the
+   * intensity image. Default is MAXIMUM.
+   */
+  itkSetMacro(EdgeWeight, EdgeWeightType);
+  itkGetConstReferenceMacro(EdgeWeight, EdgeWeightType);
+
+  /**
+   * Set/Get the cost used to propagate the markers: the WATERSHED flooding,
+   * the geodesic distance with the input image as local cost
+   * (GEODESIC_VORONOI), or the distance to the mean of the regions
+   * (SEEDED_REGION_GROWING). MarkWatershedLine is not used by
+   * GEODESIC_VORONOI. Default is WATERSHED.
+   */
+  itkSetMacro(Propagation, PropagationType);
+  itkGetConstReferenceMacro(Propagation, PropagationType);
+
+  /**
+   * Set/Get whether the input values are replaced by their rank before the
+   * flooding, to use a dense integer queue. It has no effect on the 8 and
+   * 16 bits integer images, which already use a vector based queue. Default
+   * is false.
+   */
+  itkSetMacro(UseRankTransform, bool);
+  itkGetConstReferenceMacro(UseRankTransform, bool);
+  itkBooleanMacro(UseRankTransform);
+
+  /**
+   * Set/Get whether the flooding is done with the narrowest unsigned label
+   * type able to store the markers, instead of the output label type. The
+   * labels are widened when they are written in the output. Default is
+   * true.
+   */
+  itkSetMacro(UseCompactLabels, bool);
+  itkGetConstReferenceMacro(UseCompactLabels, bool);
+  itkBooleanMacro(UseCompactLabels);
+
+  /**
+   * Set/Get the maximum size, in bytes, of the scratch memory kept from one
+   * execution to the other. When the memory used by an execution is larger,
+   * it is released at the end of that execution. Default is the maximum of
+   * unsigned long: all the scratch memory is kept.
+   */
+  itkSetMacro(MaximumScratchSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumScratchSize, unsigned long);
+
+  /**
+   * Set/Get the highest input value flooded. The pixels with a higher value
+   * are not reached by the flooding, and keep the background value. Default
+   * is the maximum of the input pixel type: the whole image is flooded.
+   */
+  itkSetMacro(MaximumFloodLevel, InputImagePixelType);
+  itkGetConstReferenceMacro(MaximumFloodLevel, InputImagePixelType);
+
+  /**
+   * Set/Get the fraction of floodable pixels under which the status of the
+   * pixels is stored sparsely. It is only used when the flooding is bounded
+   * by a mask or by a maximum flood level. Default is 0.1.
+   */
+  itkSetClampMacro(SparseFloodingFraction, double, 0.0, 1.0);
+  itkGetConstReferenceMacro(SparseFloodingFraction, double);
+
+  /**
+   * Set/Get whether the flooding is done in the buffer of the marker image.
+   * The marker image is overwritten by the output. Default is false.
+   */
+  itkSetMacro(InPlace, bool);
+  itkGetConstReferenceMacro(InPlace, bool);
+  itkBooleanMacro(InPlace);
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  unsigned long GetScratchSize() const;
+
+  /** Release the scratch memory kept from the last execution */
+  void ReleaseScratch();
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() {};
@@ -167,6 +498,13 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
 
+  /** Graft the output on the marker image when running in place, or
+   * allocate it */
+  void AllocateOutputs();
+
+  /** Release the marker image when it has been overwritten by the output */
+  void ReleaseInputs();
+
   /** Single-threaded version of GenerateData.  This version is used
    * when the filter is configured to run to convergence. This method
    * may delegate to the multithreaded version if the filter is
@@ -174,6 +512,67 @@ protected:
    * delegate to a separate instance to run each iteration until the
    * filter converges. */
   void GenerateData();
+
+  /** Compute the watershed with the method selected by the user */
+  void ComputeWatershed();
+
+  /** Return true if the flooding is bounded by a mask or a maximum flood
+   * level */
+  bool IsBounded() const;
+
+  /** Return the number of pixels the flooding can reach */
+  unsigned long ComputeNumberOfFloodablePixels() const;
+
+  /** Return true if the pixel at the offset p in the buffers can be
+   * flooded */
+  inline bool IsFloodable( const InputImagePixelType * input, const MaskImagePixelType * mask, unsigned long p ) const
+    {
+    return ( !mask || mask[p] != NumericTraits< MaskImagePixelType >::Zero ) && !( m_MaximumFloodLevel < input[p] );
+    }
+
+  /** Return the highest label of the markers once compacted, or the
+   * maximum of unsigned long if they can't be compacted */
+  unsigned long ComputeMaximumCompactLabel();
+
+  /** Flood with the labels stored on the TCompactLabel type, and widen them
+   * in the output */
+  template < class TCompactLabel >
+  void CompactFlood( ProgressReporter & progress );
+
+  /** Flood the markers in output, with the propagation selected by the
+   * user */
+  template < class TInternalLabelImage >
+  void Flood( const TInternalLabelImage * markers, TInternalLabelImage * output,
+              const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress );
+
+  /** Propagate the markers with the image foresting transform, with the
+   * given path cost and tie break policies */
+  template < class TPathCost, class TTieBreak, class TInternalLabelImage >
+  void ComputeForestingTransform( const TInternalLabelImage * markers, TInternalLabelImage * output,
+                                  const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress );
+
+  /** Flood the rank image of the input, stored with the TRank pixel type,
+   * with a dense hierarchical queue */
+  template < class TRank, class TTieBreak, class TInternalLabelImage >
+  void ComputeRankForestingTransform( const std::vector< InputImagePixelType > & values,
+                                      const TInternalLabelImage * markers, TInternalLabelImage * output,
+                                      const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress );
+
+  /** Compute the watershed cut with the Kruskal algorithm */
+  void MinimumSpanningForestFlooding();
+
+  /** Flood the pixels sorted by level, with the algorithm of Vincent and
+   * Soille. The status of the pixels, and the flag of the pixels on the
+   * border of the image, are stored in std::vector< bool > or in
+   * BlockedBitArray. */
+  template < class TStatus >
+  void SortedLevelsFlooding( TStatus & queued, TStatus & border );
+
+  /** Return the hierarchical queue kept in the scratch memory, cleared by
+   * the propagation. A new queue is created when the one kept has another
+   * type. */
+  template < class TQueue >
+  TQueue * GetScratchQueue();
   
 private:
   MorphologicalWatershedFromMarkersImageFilter(const Self&); //purposely not implemented
@@ -185,10 +584,30 @@ private:
   bool m_PadImageBoundary;
   bool m_UseImageSpacing;
   LabelImagePixelType m_BackgroundValue;
-
-  typedef Image< float, ImageDimension > DistanceImageType;
-  typedef std::vector<typename DistanceImageType::PixelType> WeightType;
-  typedef typename DistanceImageType::PixelType DistancePixelType;
+  FloodingMethodType m_FloodingMethod;
+  EdgeWeightType m_EdgeWeight;
+  PropagationType m_Propagation;
+  bool m_UseRankTransform;
+  bool m_UseCompactLabels;
+  unsigned long m_MaximumScratchSize;
+  InputImagePixelType m_MaximumFloodLevel;
+  double m_SparseFloodingFraction;
+  bool m_InPlace;
+
+  // whether the current execution stores the status sparsely
+  bool m_SparseStatus;
+
+  // the scratch memory, kept from one execution to the other
+  std::vector< bool > m_Status;
+  std::vector< bool > m_Border;
+  std::vector< unsigned long > m_Sorted;
+  std::vector< unsigned long > m_Fifo;
+  typename EdgeGraphType::Pointer m_EdgeGraph;
+  WatershedUnionFind m_UnionFind;
+  DataObject::Pointer m_CompactMarkers;
+  DataObject::Pointer m_CompactOutput;
+  unsigned long m_CompactScratchSize;
+  HierarchicalQueueHolderBase::Pointer m_Queue;
 
 } ; // end of class
 
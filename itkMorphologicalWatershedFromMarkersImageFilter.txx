@@ -20,18 +20,18 @@
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionIterator.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
-#include "itkShapedNeighborhoodIterator.h"
-#include "itkConstShapedNeighborhoodIterator.h"
-#include "itkConstantBoundaryCondition.h"
-#include "itkSize.h"
-#include "itkHierarchicalQueue.h"
-#include "itkImageDuplicator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageForestingTransform.h"
+#include "itkImageForestingTransformPathCost.h"
+#include "itkRankTransformImageFilter.h"
+#include "itkBlockedBitArray.h"
+#include <vector>
+#include <algorithm>
 
 namespace itk {
 
-template <class TInputImage, class TLabelImage>
-MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+template <class TInputImage, class TLabelImage, class TMaskImage>
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
 ::MorphologicalWatershedFromMarkersImageFilter()
 {
   this->SetNumberOfRequiredInputs(2);
@@ -39,12 +39,23 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
   m_MarkWatershedLine = true;
   m_UseImageSpacing = false;
   m_BackgroundValue = NumericTraits< LabelImagePixelType >::Zero;
+  m_FloodingMethod = HIERARCHICAL_QUEUE;
+  m_EdgeWeight = MAXIMUM;
+  m_Propagation = WATERSHED;
+  m_UseRankTransform = false;
+  m_UseCompactLabels = true;
+  m_MaximumScratchSize = NumericTraits< unsigned long >::max();
+  m_CompactScratchSize = 0;
+  m_MaximumFloodLevel = NumericTraits< InputImagePixelType >::max();
+  m_SparseFloodingFraction = 0.1;
+  m_SparseStatus = false;
+  m_InPlace = false;
 }
 
 
-template <class TInputImage, class TLabelImage>
+template <class TInputImage, class TLabelImage, class TMaskImage>
 void 
-MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
 ::GenerateInputRequestedRegion()
 {
   // call the superclass' implementation of this method
@@ -64,38 +75,185 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
   //
   markerPtr->SetRequestedRegion(markerPtr->GetLargestPossibleRegion());
   inputPtr->SetRequestedRegion(inputPtr->GetLargestPossibleRegion());
+
+  // the mask is optional
+  MaskImageType * maskPtr = const_cast< MaskImageType * >( this->GetMaskImage() );
+  if( maskPtr )
+    {
+    maskPtr->SetRequestedRegion(maskPtr->GetLargestPossibleRegion());
+    }
 }
 
 
-template <class TInputImage, class TLabelImage>
+template <class TInputImage, class TLabelImage, class TMaskImage>
 void 
-MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
 ::EnlargeOutputRequestedRegion(DataObject *)
 {
   this->GetOutput()->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
 }
 
 
-template<class TInputImage, class TLabelImage>
+template<class TInputImage, class TLabelImage, class TMaskImage>
 void
-MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::AllocateOutputs()
+{
+  LabelImageType * markerPtr = this->GetMarkerImage();
+  LabelImageType * outputPtr = this->GetOutput();
+
+  // the mask must not change during the flooding
+  const bool markerIsMask = static_cast< const DataObject * >( markerPtr )
+    == static_cast< const DataObject * >( this->GetMaskImage() );
+
+  if( m_InPlace && markerPtr && !markerIsMask
+      && markerPtr->GetBufferedRegion() == outputPtr->GetRequestedRegion() )
+    {
+    // the flooding reads all the markers before writing any label, so the
+    // output can use the buffer of the markers
+    this->GraftOutput( markerPtr );
+    }
+  else
+    {
+    Superclass::AllocateOutputs();
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ReleaseInputs()
+{
+  LabelImageType * markerPtr = this->GetMarkerImage();
+  const bool ranInPlace = markerPtr
+    && markerPtr->GetPixelContainer() == this->GetOutput()->GetPixelContainer();
+
+  Superclass::ReleaseInputs();
+
+  if( ranInPlace )
+    {
+    // the markers have been overwritten: their source must run again
+    markerPtr->ReleaseData();
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
 ::GenerateData()
 {
-  // there are 2 possible cases: with or without watershed lines.
-  // the algorithm with watershed lines is from Meyer
-  // the algorithm without watershed lines is from beucher
-  // The 2 algorithms are very similar and so are integrated in the same filter.
-
-  //---------------------------------------------------------------------------
-  // declare the vars common to the 2 algorithms: constants, iterators,
-  // hierarchical queue, progress reporter, and status image
-  // also allocate output images and verify preconditions
-  //---------------------------------------------------------------------------
-
-  // the label used to find background in the marker image
-  static const LabelImagePixelType bgLabel = m_BackgroundValue;
-  // the label used to mark the watershed line in the output image
-  static const LabelImagePixelType wsLabel = m_BackgroundValue;
+  this->ComputeWatershed();
+
+  // don't keep too much memory between the executions
+  if( this->GetScratchSize() > m_MaximumScratchSize )
+    {
+    this->ReleaseScratch();
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+unsigned long
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::GetScratchSize() const
+{
+  unsigned long size = ( m_Status.capacity() + m_Border.capacity() ) / 8
+    + ( m_Sorted.capacity() + m_Fifo.capacity() ) * sizeof( unsigned long )
+    + m_UnionFind.GetMemorySize()
+    + m_CompactScratchSize;
+  if( m_EdgeGraph )
+    {
+    size += m_EdgeGraph->GetMemorySize();
+    }
+  if( m_Queue )
+    {
+    size += m_Queue->GetMemorySize();
+    }
+  return size;
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ReleaseScratch()
+{
+  std::vector< bool >().swap( m_Status );
+  std::vector< bool >().swap( m_Border );
+  std::vector< unsigned long >().swap( m_Sorted );
+  std::vector< unsigned long >().swap( m_Fifo );
+  m_EdgeGraph = NULL;
+  m_UnionFind.Clear();
+  m_CompactMarkers = NULL;
+  m_CompactOutput = NULL;
+  m_CompactScratchSize = 0;
+  m_Queue = NULL;
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TQueue>
+TQueue *
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::GetScratchQueue()
+{
+  typedef HierarchicalQueueHolder< TQueue > HolderType;
+  HolderType * holder = dynamic_cast< HolderType * >( m_Queue.GetPointer() );
+  if( holder == NULL )
+    {
+    // the queue kept, if any, is for another pixel type or another method
+    typename HolderType::Pointer newHolder = HolderType::New();
+    holder = newHolder;
+    m_Queue = holder;
+    }
+  return &holder->GetQueue();
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ComputeWatershed()
+{
+  // the mask and the input must have the same size
+  const MaskImageType * mask = this->GetMaskImage();
+  if( mask && mask->GetRequestedRegion().GetSize() != this->GetInput()->GetRequestedRegion().GetSize() )
+    { itkExceptionMacro( << "Mask and input must have the same size." ); }
+
+  // store the status sparsely when only a small part of the image can be
+  // flooded
+  m_SparseStatus = false;
+  if( this->IsBounded() )
+    {
+    const unsigned long nbOfPixels = this->GetInput()->GetBufferedRegion().GetNumberOfPixels();
+    m_SparseStatus = this->ComputeNumberOfFloodablePixels() < m_SparseFloodingFraction * nbOfPixels;
+    }
+
+  if( m_Propagation == WATERSHED && m_FloodingMethod == MINIMUM_SPANNING_FOREST )
+    {
+    this->MinimumSpanningForestFlooding();
+    return;
+    }
+
+  // the sort is only done on the small integer types
+  if( m_Propagation == WATERSHED && m_FloodingMethod == SORTED_LEVELS && !m_UseImageSpacing
+      && NumericTraits< InputImagePixelType >::is_integer
+      && sizeof( InputImagePixelType ) <= 2 )
+    {
+    if( m_SparseStatus )
+      {
+      BlockedBitArray queued;
+      BlockedBitArray border;
+      this->SortedLevelsFlooding( queued, border );
+      }
+    else
+      {
+      this->SortedLevelsFlooding( m_Status, m_Border );
+      }
+    return;
+    }
 
   this->AllocateOutputs();
   // Set up the progress reporter
@@ -105,485 +263,655 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
   // mask and marker must have the same size
   if ( this->GetMarkerImage()->GetRequestedRegion().GetSize() != this->GetInput()->GetRequestedRegion().GetSize() )
     { itkExceptionMacro( << "Marker and input must have the same size." ); }
-  
 
-  // the radius which will be used for all the shaped iterators
-  Size< ImageDimension > radius;
-  radius.Fill(1);
-
-  // iterator for the marker image
-  typedef ConstShapedNeighborhoodIterator<LabelImageType> MarkerIteratorType;
-  typename MarkerIteratorType::ConstIterator nmIt;
-  MarkerIteratorType markerIt(radius, this->GetMarkerImage(), this->GetMarkerImage()->GetRequestedRegion());
-  // add a boundary constant to avoid adding pixels on the border in the fah
-  ConstantBoundaryCondition<LabelImageType> lcbc;
-  lcbc.SetConstant( NumericTraits<LabelImagePixelType>::max() );
-  markerIt.OverrideBoundaryCondition(&lcbc);
-  setConnectivity( &markerIt, m_Connectivity.GetPointer() );
-
-  // iterator for the input image
-  typedef ConstShapedNeighborhoodIterator<InputImageType> InputIteratorType;
-  InputIteratorType inputIt(radius, this->GetInput(), this->GetInput()->GetRequestedRegion());
-  typename InputIteratorType::ConstIterator niIt;
-  setConnectivity( &inputIt, m_Connectivity.GetPointer() );
-  
-  // iterator for the output image
-  typedef ShapedNeighborhoodIterator<LabelImageType> OutputIteratorType;
-  typedef typename OutputIteratorType::OffsetType OffsetType;
-  typename OutputIteratorType::Iterator noIt;
-  OutputIteratorType outputIt(radius, this->GetOutput(), this->GetOutput()->GetRequestedRegion());
-  setConnectivity( &outputIt, m_Connectivity.GetPointer() );
-
-  if (!m_UseImageSpacing)
-    {
-    // FAH (in french: File d'Attente Hierarchique)
-    typedef HierarchicalQueue< InputImagePixelType, IndexType > HierarchicalQueueType;
-    HierarchicalQueueType fah;
-    //---------------------------------------------------------------------------
-    // Meyer's algorithm
-    //---------------------------------------------------------------------------
+  // flood with the narrowest label type able to store the markers
+  if( m_UseCompactLabels && NumericTraits< LabelImagePixelType >::is_integer && sizeof( LabelImagePixelType ) > 1 )
+    {
+    const unsigned long maxLabel = this->ComputeMaximumCompactLabel();
+    if( maxLabel <= NumericTraits< unsigned char >::max() )
+      {
+      this->CompactFlood< unsigned char >( progress );
+      return;
+      }
+    if( maxLabel <= NumericTraits< unsigned short >::max() && sizeof( LabelImagePixelType ) > 2 )
+      {
+      this->CompactFlood< unsigned short >( progress );
+      return;
+      }
+    if( maxLabel <= NumericTraits< unsigned int >::max() && sizeof( LabelImagePixelType ) > sizeof( unsigned int ) )
+      {
+      this->CompactFlood< unsigned int >( progress );
+      return;
+      }
+    }
+
+  this->Flood( this->GetMarkerImage(), this->GetOutput(), m_BackgroundValue, progress );
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+bool
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::IsBounded() const
+{
+  return this->GetMaskImage() != NULL || m_MaximumFloodLevel < NumericTraits< InputImagePixelType >::max();
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+unsigned long
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ComputeNumberOfFloodablePixels() const
+{
+  const InputImageType * input = this->GetInput();
+  const MaskImageType * maskImage = this->GetMaskImage();
+  const InputImagePixelType * inputBuffer = input->GetBufferPointer();
+  const MaskImagePixelType * mask = maskImage ? maskImage->GetBufferPointer() : NULL;
+  const unsigned long nbOfPixels = input->GetBufferedRegion().GetNumberOfPixels();
+  unsigned long nbOfFloodablePixels = 0;
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( this->IsFloodable( inputBuffer, mask, p ) )
+      {
+      nbOfFloodablePixels++;
+      }
+    }
+  return nbOfFloodablePixels;
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+unsigned long
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ComputeMaximumCompactLabel()
+{
+  // the negative labels can't be compacted: the highest value is returned
+  // so the flooding is done with the label type of the output
+  if( m_BackgroundValue < NumericTraits< LabelImagePixelType >::Zero )
+    { return NumericTraits< unsigned long >::max(); }
+
+  Functor::CompactLabel< LabelImagePixelType, unsigned long > compact;
+  compact.SetBackgroundValue( m_BackgroundValue );
+
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  const LabelImagePixelType * markers = markerImage->GetBufferPointer();
+  const unsigned long nbOfPixels = markerImage->GetBufferedRegion().GetNumberOfPixels();
+  unsigned long maxLabel = 0;
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( markers[p] < NumericTraits< LabelImagePixelType >::Zero )
+      { return NumericTraits< unsigned long >::max(); }
+    maxLabel = std::max( maxLabel, compact( markers[p] ) );
+    }
+  return maxLabel;
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TCompactLabel>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::CompactFlood( ProgressReporter & progress )
+{
+  typedef Image< TCompactLabel, ImageDimension > CompactImageType;
+
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  LabelImageType * output = this->GetOutput();
+  const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+
+  // when the filter runs in place, the compact markers are flooded in place
+  // too
+  const bool inPlace = markerImage->GetPixelContainer() == output->GetPixelContainer();
+
+  // the compact images are reused from the previous execution when they
+  // have the same type: Allocate() then reuses their buffer
+  typename CompactImageType::Pointer compactMarkers = dynamic_cast< CompactImageType * >( m_CompactMarkers.GetPointer() );
+  typename CompactImageType::Pointer compactOutput = dynamic_cast< CompactImageType * >( m_CompactOutput.GetPointer() );
+  if( !compactMarkers || !compactOutput )
+    {
+    compactMarkers = CompactImageType::New();
+    compactOutput = CompactImageType::New();
+    m_CompactMarkers = compactMarkers;
+    m_CompactOutput = compactOutput;
+    }
+  m_CompactScratchSize = std::max( m_CompactScratchSize, ( inPlace ? 1 : 2 ) * nbOfPixels * sizeof( TCompactLabel ) );
+
+  // the compact markers, with the background set to 0
+  compactMarkers->SetRegions( output->GetBufferedRegion() );
+  compactMarkers->Allocate();
+  Functor::CompactLabel< LabelImagePixelType, TCompactLabel > compact;
+  compact.SetBackgroundValue( m_BackgroundValue );
+  const LabelImagePixelType * markers = markerImage->GetBufferPointer();
+  TCompactLabel * compactMarkersBuffer = compactMarkers->GetBufferPointer();
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    compactMarkersBuffer[p] = compact( markers[p] );
+    }
+
+  CompactImageType * floodOutput = compactMarkers;
+  if( !inPlace )
+    {
+    compactOutput->SetRegions( output->GetBufferedRegion() );
+    compactOutput->Allocate();
+    floodOutput = compactOutput;
+    }
+
+  this->Flood( compactMarkers.GetPointer(), floodOutput, NumericTraits< TCompactLabel >::Zero, progress );
+
+  // widen the labels in the output
+  Functor::ExpandCompactLabel< TCompactLabel, LabelImagePixelType > expand;
+  expand.SetBackgroundValue( m_BackgroundValue );
+  const TCompactLabel * compactOutputBuffer = floodOutput->GetBufferPointer();
+  LabelImagePixelType * outputBuffer = output->GetBufferPointer();
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    outputBuffer[p] = expand( compactOutputBuffer[p] );
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TInternalLabelImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::Flood( const TInternalLabelImage * markers, TInternalLabelImage * output,
+         const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress )
+{
+  typedef TInternalLabelImage InternalLabelImageType;
+
+  // The algorithm with watershed lines is from Meyer: the pixels are labeled
+  // when they are removed from the queue. The algorithm without watershed
+  // lines is from Beucher: the pixels are labeled when they are put in the
+  // queue. Both are instantiations of the same image foresting transform,
+  // with the path cost of the flooding.
+  if( m_Propagation == GEODESIC_VORONOI )
+    {
+    this->ComputeForestingTransform< AdditivePathCost< InputImageType, InternalLabelImageType >, FirstComeTieBreak >( markers, output, background, progress );
+    }
+  else if( m_Propagation == SEEDED_REGION_GROWING )
+    {
     if( m_MarkWatershedLine )
       {
-      // first stage:
-      //  - set markers pixels to already processed status
-      //  - copy markers pixels to output image
-      //  - init FAH with indexes of background pixels with marker pixel(s) in their neighborhood
-      
-      ConstantBoundaryCondition<LabelImageType> lcbc2;
-      lcbc2.SetConstant( wsLabel ); // outside pixel are watershed so they won't be use to find real watershed  pixels
-      outputIt.OverrideBoundaryCondition(&lcbc2);
-      
-      // create a temporary image to store the state of each pixel (processed or not)
-      typedef Image< bool, ImageDimension > StatusImageType;
-      typename StatusImageType::Pointer statusImage = StatusImageType::New();
-      statusImage->SetRegions( this->GetMarkerImage()->GetLargestPossibleRegion() );
-      statusImage->Allocate();
-  
-      // iterator for the status image
-      typedef ShapedNeighborhoodIterator<StatusImageType> StatusIteratorType;
-      typename StatusIteratorType::Iterator nsIt;
-      StatusIteratorType statusIt(radius, statusImage, this->GetOutput()->GetRequestedRegion());
-      ConstantBoundaryCondition< StatusImageType > bcbc;
-      bcbc.SetConstant( true );  // outside pixel are already processed
-      statusIt.OverrideBoundaryCondition(&bcbc);
-      setConnectivity( &statusIt, m_Connectivity.GetPointer() );
-
-      // the status image must be initialized before the first stage. In the first stage, the
-      // set to true are the neighbors of the marker (and the marker) so it's difficult
-      // (impossible ?)to init the status image at the same time
-      // the overhead should be small
-      statusImage->FillBuffer( false );
-      
-      for ( markerIt.GoToBegin(), statusIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-            !markerIt.IsAtEnd(); ++markerIt, ++outputIt)
+      this->ComputeForestingTransform< RegionMeanPathCost< InputImageType, InternalLabelImageType >, WatershedLineTieBreak >( markers, output, background, progress );
+      }
+    else
+      {
+      this->ComputeForestingTransform< RegionMeanPathCost< InputImageType, InternalLabelImageType >, FirstComeTieBreak >( markers, output, background, progress );
+      }
+    }
+  else if( m_UseImageSpacing )
+    {
+    // This is the image integration method that is able to account
+    // for image spacing
+    if( m_MarkWatershedLine )
+      {
+      this->ComputeForestingTransform< LexicographicPathCost< InputImageType, InternalLabelImageType >, WatershedLineTieBreak >( markers, output, background, progress );
+      }
+    else
+      {
+      this->ComputeForestingTransform< LexicographicPathCost< InputImageType, InternalLabelImageType >, FirstComeTieBreak >( markers, output, background, progress );
+      }
+    }
+  else if( m_UseRankTransform
+           && !( NumericTraits< InputImagePixelType >::is_integer && sizeof( InputImagePixelType ) <= 2 ) )
+    {
+    // flood the ranks of the values, on the smallest type able to store them
+    typedef Image< unsigned short, ImageDimension > ShortRankImageType;
+    std::vector< InputImagePixelType > values;
+    RankTransformImageFilter< InputImageType, ShortRankImageType >::ComputeValues( this->GetInput(), values, this->GetNumberOfThreads() );
+    if( values.size() <= 65536 )
+      {
+      if( m_MarkWatershedLine )
         {
-        LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-        if ( markerPixel != bgLabel )
-          {
-        
-          IndexType idx = markerIt.GetIndex();
-          
-          // move the iterators to the right place
-          OffsetType shift = idx - statusIt.GetIndex();
-          statusIt += shift;
-          inputIt += shift;
-          
-          // this pixel belongs to a marker
-          // mark it as already processed
-          statusIt.SetCenterPixel( true );
-          // copy it to the output image
-          outputIt.SetCenterPixel( markerPixel );
-          // and increase progress because this pixel will not be used in the flooding stage.
-          progress.CompletedPixel();
-          
-          // search the background pixels in the neighborhood
-          for ( nmIt= markerIt.Begin(), nsIt= statusIt.Begin(), niIt= inputIt.Begin();
-                nmIt != markerIt.End();
-                nmIt++, nsIt++, niIt++ )
-            {
-            if ( !nsIt.Get() && nmIt.Get() == bgLabel )
-              {
-              // this neighbor is a background pixel and is not already processed; add its
-              // index to fah
-              fah.Push( niIt.Get(), markerIt.GetIndex() + nmIt.GetNeighborhoodOffset() );
-              // mark it as already in the fah to avoid adding it several times
-              nsIt.Set( true );
-              }
-            }
-          }
-        else
-          {
-          // Some pixels may be never processed so, by default, non marked pixels
-          // must be marked as watershed
-          outputIt.SetCenterPixel( wsLabel );
-          }
-        // one more pixel done in the init stage
-        progress.CompletedPixel();
+        this->ComputeRankForestingTransform< unsigned short, WatershedLineTieBreak >( values, markers, output, background, progress );
         }
-      // end of init stage
-      
-      // flooding
-      // init all the iterators
-      outputIt.GoToBegin();
-      statusIt.GoToBegin();
-      inputIt.GoToBegin();
-      
-      // and start flooding
-      while( !fah.Empty() )
+      else
         {
-        // store the current vars
-        const InputImagePixelType & currentValue = fah.FrontKey();
-        const IndexType & idx = fah.FrontValue();
-        
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        statusIt += shift;
-        inputIt += shift;
-        
-        // iterate over the neighbors. If there is only one marker value, give that value
-        // to the pixel, else keep it as is (watershed line)
-        LabelImagePixelType marker = wsLabel;
-        bool collision = false;
-        for (noIt = outputIt.Begin(); noIt != outputIt.End(); noIt++)
-          {
-          LabelImagePixelType o = noIt.Get();
-          if( o != wsLabel )
-            {
-            if( marker != wsLabel && o != marker )
-              { 
-              collision = true; 
-              break;
-              }
-            else
-              { marker = o; }
-            }
-          }
-        if( !collision )
-          {
-          // set the marker value
-          outputIt.SetCenterPixel( marker );
-          // and propagate to the neighbors
-          for (niIt = inputIt.Begin(), nsIt = statusIt.Begin();
-              niIt != inputIt.End();
-              niIt++, nsIt++)
-            {
-            if ( !nsIt.Get() )
-              {
-              // the pixel is not yet processed. add it to the fah
-              InputImagePixelType grayVal = niIt.Get();
-              if ( grayVal <= currentValue )
-                { fah.Push( currentValue, inputIt.GetIndex() + niIt.GetNeighborhoodOffset() ); }
-              else
-                { fah.Push( grayVal, inputIt.GetIndex() + niIt.GetNeighborhoodOffset() ); }
-              // mark it as already in the fah
-              nsIt.Set( true );
-              }
-            }
-          }
-        // one more pixel in the flooding stage
-        progress.CompletedPixel();
-        // remove the processed pixel of the queue
-        fah.Pop();
+        this->ComputeRankForestingTransform< unsigned short, FirstComeTieBreak >( values, markers, output, background, progress );
         }
       }
-
-
-    //---------------------------------------------------------------------------
-    // Beucher's algorithm
-    //---------------------------------------------------------------------------
     else
       {
-      // first stage:
-      //  - copy markers pixels to output image
-      //  - init FAH with indexes of pixels with background pixel in their neighborhood
-      
-      ConstantBoundaryCondition<LabelImageType> lcbc2;
-      lcbc2.SetConstant( NumericTraits< LabelImagePixelType >::max() ); // outside pixel are watershed so they won't be use to find real watershed  pixels
-      outputIt.OverrideBoundaryCondition(&lcbc2);
-      
-      for ( markerIt.GoToBegin(), outputIt.GoToBegin(), inputIt.GoToBegin();
-            !markerIt.IsAtEnd();
-            ++markerIt, ++outputIt ) 
+      if( m_MarkWatershedLine )
         {
-        LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-        if ( markerPixel != bgLabel )
-          {
-          IndexType idx = markerIt.GetIndex();
-          OffsetType shift = idx - inputIt.GetIndex();
-          inputIt += shift;
-          
-          // this pixels belongs to a marker
-          // copy it to the output image
-          outputIt.SetCenterPixel( markerPixel );
-          // search if it has background pixel in its neighborhood
-          bool haveBgNeighbor = false;
-          for ( nmIt= markerIt.Begin(); nmIt != markerIt.End(); nmIt++ )
-            {
-            if ( nmIt.Get() == bgLabel )
-              { 
-              haveBgNeighbor = true; 
-              break;
-              }
-            }
-          if ( haveBgNeighbor )
-            {
-            // there is a background pixel in the neighborhood; add to fah
-            fah.Push( inputIt.GetCenterPixel(), markerIt.GetIndex() );
-            }
-          else
-            {
-            // increase progress because this pixel will not be used in the flooding stage.
-            progress.CompletedPixel();
-            }
-          }
-        else
-          {
-          outputIt.SetCenterPixel( wsLabel );
-          }
-        progress.CompletedPixel();
+        this->ComputeRankForestingTransform< unsigned int, WatershedLineTieBreak >( values, markers, output, background, progress );
         }
-      // end of init stage
-      
-      // flooding
-      // init all the iterators
-      outputIt.GoToBegin();
-      inputIt.GoToBegin();
-      
-      // and start flooding
-      while( !fah.Empty() )
+      else
         {
-        // store the current vars
-        const InputImagePixelType & currentValue = fah.FrontKey();
-        const IndexType & idx = fah.FrontValue();
-        
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        inputIt += shift;
-        
-        LabelImagePixelType currentMarker = outputIt.GetCenterPixel();
-        // get the current value of the pixel
-        // iterate over neighbors to propagate the marker
-        for (noIt = outputIt.Begin(), niIt = inputIt.Begin();
-            noIt != outputIt.End();
-            noIt++, niIt++)
-          {
-          if ( noIt.Get() == wsLabel )
-            {
-            // the pixel is not yet processed. It can be labeled with the current label
-            noIt.Set( currentMarker );
-            const InputImagePixelType & grayVal = niIt.Get();
-            if ( grayVal <= currentValue )
-              { fah.Push( currentValue, inputIt.GetIndex() + niIt.GetNeighborhoodOffset() ); }
-            else
-              { fah.Push( grayVal, inputIt.GetIndex() + niIt.GetNeighborhoodOffset() ); }
-            progress.CompletedPixel();
-            }
-          }
-        // remove the processed pixel of the queue
-        fah.Pop();
+        this->ComputeRankForestingTransform< unsigned int, FirstComeTieBreak >( values, markers, output, background, progress );
         }
       }
     }
   else
     {
-    // This is the image integration method that is able to account
-    // for image spacing
-    // We need a distance image, lets assume that it is floating point
-    typename InputImageType::SpacingType spacing;
-    typename DistanceImageType::Pointer distanceImage = DistanceImageType::New();
-    distanceImage->SetRegions( this->GetMarkerImage()->GetLargestPossibleRegion() );
-    distanceImage->Allocate();
-    // set distance image to infinity
-    distanceImage->FillBuffer(itk::NumericTraits<DistancePixelType>::max());
-    // recconstructed image
-    typedef typename itk::ImageDuplicator<InputImageType> DupType;
-    typename DupType::Pointer duplicator = DupType::New();
-    duplicator->SetInputImage(this->GetInput());
-    duplicator->Update();
-    typename InputImageType::Pointer reconImage = duplicator->GetOutput();
-    
-    typedef ShapedNeighborhoodIterator<InputImageType> InputIteratorType2;
-    InputIteratorType2 inputIt2(radius, reconImage, this->GetInput()->GetRequestedRegion());
-    typename InputIteratorType2::Iterator niIt;
-    setConnectivity( &inputIt2, m_Connectivity.GetPointer() );
-
-    // FAH (in french: File d'Attente Hierarchique)
-    typedef HierarchicalQueue< InputImagePixelType, IndexType > HierarchicalQueueType;
-    HierarchicalQueueType fah;
-    // iterator for the distance image
-    typedef ShapedNeighborhoodIterator<DistanceImageType> DistanceIteratorType;
-    typename DistanceIteratorType::Iterator ndIt;
-    DistanceIteratorType distanceIt(radius, distanceImage, this->GetOutput()->GetRequestedRegion());
-    setConnectivity( &distanceIt, m_Connectivity.GetPointer() );
-    // a boundary condition for the distance image - set to a minimum
-    // because we are always looking to reduce the current value
-    ConstantBoundaryCondition<DistanceImageType> dcbc;
-    dcbc.SetConstant( NumericTraits<DistancePixelType>::NonpositiveMin() );
-    distanceIt.OverrideBoundaryCondition(&dcbc);
-    // set up the weights
-    WeightType weights;
-    spacing = this->GetInput()->GetSpacing();
-    for (noIt = outputIt.Begin(); noIt != outputIt.End(); ++noIt)
+    if( m_MarkWatershedLine )
+      {
+      this->ComputeForestingTransform< MaxArcPathCost< InputImageType, InternalLabelImageType >, WatershedLineTieBreak >( markers, output, background, progress );
+      }
+    else
+      {
+      this->ComputeForestingTransform< MaxArcPathCost< InputImageType, InternalLabelImageType >, FirstComeTieBreak >( markers, output, background, progress );
+      }
+    }
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TPathCost, class TTieBreak, class TInternalLabelImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ComputeForestingTransform( const TInternalLabelImage * markers, TInternalLabelImage * output,
+                             const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress )
+{
+  typedef ImageForestingTransform< InputImageType, TInternalLabelImage, TPathCost, TTieBreak, MaskImageType > IFTType;
+  IFTType ift;
+  ift.SetInput( this->GetInput() );
+  ift.SetMarkerImage( markers );
+  ift.SetOutput( output );
+  ift.SetConnectivity( m_Connectivity );
+  ift.SetBackgroundValue( background );
+  ift.SetStatusBuffer( &m_Status );
+  ift.SetBorderBuffer( &m_Border );
+  ift.SetQueue( this->template GetScratchQueue< typename IFTType::QueueType >() );
+  ift.SetMaskImage( this->GetMaskImage() );
+  if( m_MaximumFloodLevel < NumericTraits< InputImagePixelType >::max() )
+    {
+    ift.SetMaximumValue( m_MaximumFloodLevel );
+    }
+  ift.SetUseSparseStatus( m_SparseStatus );
+  ift.Compute( progress );
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TRank, class TTieBreak, class TInternalLabelImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::ComputeRankForestingTransform( const std::vector< InputImagePixelType > & values,
+                                 const TInternalLabelImage * markers, TInternalLabelImage * output,
+                                 const typename TInternalLabelImage::PixelType & background, ProgressReporter & progress )
+{
+  // the highest rank flooded: the number of values lower or equal to the
+  // maximum flood level, minus one
+  const unsigned long nbOfFloodableValues =
+    std::upper_bound( values.begin(), values.end(), m_MaximumFloodLevel ) - values.begin();
+  if( nbOfFloodableValues == 0 )
+    {
+    // all the pixels are above the maximum flood level: only the markers are
+    // kept
+    if( markers != output )
+      {
+      const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+      std::copy( markers->GetBufferPointer(), markers->GetBufferPointer() + nbOfPixels, output->GetBufferPointer() );
+      }
+    return;
+    }
+
+  typedef Image< TRank, ImageDimension > RankImageType;
+  typedef RankTransformImageFilter< InputImageType, RankImageType > RankType;
+  typename RankType::Pointer rank = RankType::New();
+  rank->SetInput( this->GetInput() );
+  rank->SetValues( values );
+  rank->SetNumberOfThreads( this->GetNumberOfThreads() );
+  rank->Update();
+
+  typedef DenseHierarchicalQueue< TRank, unsigned long > QueueType;
+  typedef MaxArcPathCost< RankImageType, TInternalLabelImage, QueueType > PathCostType;
+  ImageForestingTransform< RankImageType, TInternalLabelImage, PathCostType, TTieBreak, MaskImageType > ift;
+  ift.SetInput( rank->GetOutput() );
+  ift.SetMarkerImage( markers );
+  ift.SetOutput( output );
+  ift.SetConnectivity( m_Connectivity );
+  ift.SetBackgroundValue( background );
+  ift.SetStatusBuffer( &m_Status );
+  ift.SetBorderBuffer( &m_Border );
+  ift.SetQueue( this->template GetScratchQueue< QueueType >() );
+  ift.SetMaskImage( this->GetMaskImage() );
+  if( nbOfFloodableValues < values.size() )
+    {
+    ift.SetMaximumValue( static_cast< TRank >( nbOfFloodableValues - 1 ) );
+    }
+  ift.SetUseSparseStatus( m_SparseStatus );
+  ift.Compute( progress );
+}
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::MinimumSpanningForestFlooding()
+{
+  this->AllocateOutputs();
+
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  LabelImageType * output = this->GetOutput();
+
+  // mask and marker must have the same size
+  if ( markerImage->GetRequestedRegion().GetSize() != this->GetInput()->GetRequestedRegion().GetSize() )
+    { itkExceptionMacro( << "Marker and input must have the same size." ); }
+
+  // the edges are identified by their offset in the input buffer, which must
+  // be the same in the output buffer
+  if ( output->GetBufferedRegion().GetSize() != this->GetInput()->GetBufferedRegion().GetSize() )
+    { itkExceptionMacro( << "Input and output must have the same buffered region." ); }
+
+  // the output is initialized with the markers
+  ImageRegionConstIterator< LabelImageType > markerIt( markerImage, output->GetBufferedRegion() );
+  ImageRegionIterator< LabelImageType > outputIt( output, output->GetBufferedRegion() );
+  for( markerIt.GoToBegin(), outputIt.GoToBegin(); !markerIt.IsAtEnd(); ++markerIt, ++outputIt )
+    {
+    outputIt.Set( markerIt.Get() );
+    }
+
+  // build and sort the edges. The graph is kept to reuse its memory.
+  if( !m_EdgeGraph )
+    {
+    m_EdgeGraph = EdgeGraphType::New();
+    }
+  EdgeGraphType * graph = m_EdgeGraph;
+  graph->SetInput( this->GetInput() );
+  graph->SetConnectivity( m_Connectivity );
+  graph->SetEdgeWeight( static_cast< typename EdgeGraphType::EdgeWeightType >( m_EdgeWeight ) );
+  graph->SetNumberOfThreads( this->GetNumberOfThreads() );
+  graph->Build();
+  const typename EdgeGraphType::EdgeContainerType & edges = graph->GetEdges();
+
+  const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+  LabelImagePixelType * labels = output->GetBufferPointer();
+  ProgressReporter progress( this, 0, edges.size() + nbOfPixels );
+
+  // the edges with a pixel which is neither floodable nor a marker are not
+  // used, so that pixel keeps its own tree
+  const bool bounded = this->IsBounded();
+  const InputImagePixelType * inputBuffer = this->GetInput()->GetBufferPointer();
+  const MaskImagePixelType * mask = this->GetMaskImage() ? this->GetMaskImage()->GetBufferPointer() : NULL;
+  const LabelImagePixelType * markers = markerImage->GetBufferPointer();
+
+  // Kruskal: the label of a tree is stored on its root. Two trees are merged
+  // if they don't contain two different markers.
+  WatershedUnionFind & sets = m_UnionFind;
+  sets.Initialize( nbOfPixels );
+  for( typename EdgeGraphType::EdgeContainerType::const_iterator it=edges.begin(); it!=edges.end(); it++ )
+    {
+    unsigned long p, q;
+    graph->GetPixels( *it, p, q );
+    if( bounded
+        && ( ( markers[p] == m_BackgroundValue && !this->IsFloodable( inputBuffer, mask, p ) )
+             || ( markers[q] == m_BackgroundValue && !this->IsFloodable( inputBuffer, mask, q ) ) ) )
+      {
+      progress.CompletedPixel();
+      continue;
+      }
+    unsigned long rp = sets.Find( p );
+    unsigned long rq = sets.Find( q );
+    if( rp != rq )
+      {
+      const LabelImagePixelType lp = labels[rp];
+      const LabelImagePixelType lq = labels[rq];
+      if( lp == m_BackgroundValue || lq == m_BackgroundValue || lp == lq )
+        {
+        unsigned long r = sets.Union( rp, rq );
+        labels[r] = lp != m_BackgroundValue ? lp : lq;
+        }
+      }
+    progress.CompletedPixel();
+    }
+  // only the memory of the graph is kept, not the input
+  graph->SetInput( NULL );
+
+  // propagate the labels of the roots to the whole trees
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    labels[p] = labels[ sets.Find( p ) ];
+    progress.CompletedPixel();
+    }
+}
+
+
+
+template<class TInputImage, class TLabelImage, class TMaskImage>
+template<class TStatus>
+void
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
+::SortedLevelsFlooding( TStatus & queued, TStatus & border )
+{
+  // the label used to find background in the marker image, and to mark the
+  // watershed line in the output image
+  const LabelImagePixelType wsLabel = m_BackgroundValue;
+
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  LabelImageType * output = this->GetOutput();
+
+  // mask and marker must have the same size
+  if ( markerImage->GetRequestedRegion().GetSize() != input->GetRequestedRegion().GetSize() )
+    { itkExceptionMacro( << "Marker and input must have the same size." ); }
+
+  // the pixels are identified by their offset in the input buffer, which must
+  // be the same in the output buffer
+  if ( output->GetBufferedRegion().GetSize() != input->GetBufferedRegion().GetSize() )
+    { itkExceptionMacro( << "Input and output must have the same buffered region." ); }
+
+  const LabelImageRegionType region = output->GetBufferedRegion();
+  const IndexType & start = region.GetIndex();
+  const typename LabelImageType::SizeType & size = region.GetSize();
+  const unsigned long nbOfPixels = region.GetNumberOfPixels();
+  const InputImagePixelType * inputBuffer = input->GetBufferPointer();
+  const MaskImagePixelType * mask = this->GetMaskImage() ? this->GetMaskImage()->GetBufferPointer() : NULL;
+  LabelImagePixelType * labels = output->GetBufferPointer();
+
+  ProgressReporter progress( this, 0, nbOfPixels * 2 );
+
+  // the neighbors, and their offset in the buffer
+  const typename ConnectivityType::OffsetContainerType & neighbors = m_Connectivity->GetNeighbors();
+  const unsigned int nbOfNeighbors = neighbors.size();
+  std::vector< long > offsets( nbOfNeighbors, 0 );
+  for( unsigned int k=0; k<nbOfNeighbors; k++ )
+    {
+    long stride = 1;
+    for( unsigned int i=0; i<ImageDimension; i++ )
       {
-      OffsetType offset = noIt.GetNeighborhoodOffset();
-      float w = 0;
-      for (unsigned i=0;i<ImageDimension;i++)
+      offsets[k] += neighbors[k][i] * stride;
+      stride *= size[i];
+      }
+    }
+
+  // the histogram gives the position of each level in the sorted array.
+  // Only the floodable pixels are sorted.
+  // The floodable pixels on the border of the image are also flagged, so the
+  // neighbors of the other ones are used without computing their index nor
+  // checking the bounds. The index is incremented here, without division.
+  const bool bounded = this->IsBounded();
+  InputImagePixelType minValue = NumericTraits< InputImagePixelType >::max();
+  InputImagePixelType maxValue = NumericTraits< InputImagePixelType >::NonpositiveMin();
+  unsigned long nbOfFloodablePixels = 0;
+  border.assign( nbOfPixels, false );
+  typename LabelImageType::SizeType position;
+  position.Fill( 0 );
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( !bounded || this->IsFloodable( inputBuffer, mask, p ) )
+      {
+      minValue = std::min( minValue, inputBuffer[p] );
+      maxValue = std::max( maxValue, inputBuffer[p] );
+      nbOfFloodablePixels++;
+      bool onBorder = false;
+      for( unsigned int d=0; d<ImageDimension && !onBorder; d++ )
         {
-        w += pow(offset[i]*spacing[i],2);
+        onBorder = position[d] == 0 || position[d] == size[d] - 1;
+        }
+      if( onBorder )
+        {
+        border[p] = true;
         }
-      weights.push_back(sqrt(w));
-//      std::cout << sqrt(w) << std::endl;
       }
-    if (m_MarkWatershedLine)
+    for( unsigned int d=0; d<ImageDimension; d++ )
       {
-      
+      if( ++position[d] < size[d] )
+        { break; }
+      position[d] = 0;
       }
-    else
+    }
+  const unsigned long nbOfLevels = nbOfFloodablePixels > 0 ? (long)maxValue - (long)minValue + 1 : 0;
+  std::vector< unsigned long > levelStart( nbOfLevels + 1, 0 );
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( !bounded || this->IsFloodable( inputBuffer, mask, p ) )
       {
-      ConstantBoundaryCondition<LabelImageType> lcbc2;
-      lcbc2.SetConstant( NumericTraits< LabelImagePixelType >::max() ); // outside pixel are watershed so they won't be use to find real watershed  pixels
-      outputIt.OverrideBoundaryCondition(&lcbc2);
-
-      // initialization
-      for ( markerIt.GoToBegin(), distanceIt.GoToBegin(), outputIt.GoToBegin(), 
-              inputIt2.GoToBegin();
-            !markerIt.IsAtEnd(); ++markerIt, ++outputIt)
+      levelStart[ (long)inputBuffer[p] - (long)minValue + 1 ]++;
+      }
+    }
+  for( unsigned long l=0; l<nbOfLevels; l++ )
+    {
+    levelStart[l+1] += levelStart[l];
+    }
+
+  // counting sort of the pixel offsets
+  std::vector< unsigned long > & sorted = m_Sorted;
+  sorted.resize( nbOfFloodablePixels );
+  {
+  std::vector< unsigned long > position( levelStart.begin(), levelStart.end() - 1 );
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( !bounded || this->IsFloodable( inputBuffer, mask, p ) )
+      {
+      sorted[ position[ (long)inputBuffer[p] - (long)minValue ]++ ] = p;
+      }
+    }
+  }
+
+  // copy the markers to the output. The marker pixels are already processed.
+  queued.assign( nbOfPixels, false );
+  ImageRegionConstIterator< LabelImageType > markerIt( markerImage, region );
+  unsigned long p = 0;
+  for( markerIt.GoToBegin(); !markerIt.IsAtEnd(); ++markerIt, p++ )
+    {
+    const LabelImagePixelType & markerPixel = markerIt.Get();
+    labels[p] = markerPixel;
+    if( markerPixel != wsLabel )
+      {
+      queued[p] = true;
+      }
+    progress.CompletedPixel();
+    }
+
+  // a pixel is put at most once in the FIFO, so the FIFO is allocated once
+  // with one place per floodable pixel, and never grows. It is reused from
+  // one level to the other.
+  std::vector< unsigned long > & fifo = m_Fifo;
+  fifo.resize( nbOfFloodablePixels );
+  unsigned long tail = 0;
+  std::vector< unsigned long > inside;
+  inside.reserve( nbOfNeighbors );
+
+  for( unsigned long l=0; l<nbOfLevels; l++ )
+    {
+    const InputImagePixelType level = static_cast< InputImagePixelType >( (long)minValue + (long)l );
+
+    // the pixels of that level with an already labeled neighbor start the
+    // propagation
+    for( unsigned long i=levelStart[l]; i<levelStart[l+1]; i++ )
+      {
+      p = sorted[i];
+      if( queued[p] )
+        { continue; }
+      const bool onBorder = border[p];
+      IndexType idx;
+      if( onBorder )
         {
-        LabelImagePixelType markerPixel = markerIt.GetCenterPixel();
-        if ( markerPixel != bgLabel )
+        idx = output->ComputeIndex( p );
+        }
+      for( unsigned int k=0; k<nbOfNeighbors; k++ )
+        {
+        bool isInside = true;
+        for( unsigned int d=0; d<ImageDimension && isInside && onBorder; d++ )
           {
-          IndexType idx = markerIt.GetIndex();
-          // move the iterators to the right place
-          OffsetType shift = idx - inputIt2.GetIndex();
-          distanceIt += shift;
-          inputIt2 += shift;
-          // perhaps we should initialize these points to zero
-          distanceIt.SetCenterPixel(0);  
-          //distanceIt.SetCenterPixel(inputIt2.GetCenterPixel() );  
-          // copy it to the output image
-          outputIt.SetCenterPixel( markerPixel );
-          // Check the neighbors
-          // test whether there is a background pixel in the neighborhood
-          bool haveBgNeighbor = false;
-          for ( nmIt= markerIt.Begin(); nmIt != markerIt.End(); nmIt++ )
-            {
-            if ( nmIt.Get() == bgLabel )
-              { 
-              haveBgNeighbor = true; 
-              break;
-              }
-            }
-          if ( haveBgNeighbor )
-            {
-            // there is a background pixel in the neighborhood; add to
-            // fah. All marker pixels should have the same priority???
-            fah.Push(NumericTraits<InputImagePixelType>::NonpositiveMin(), markerIt.GetIndex() );
-            }
-          else
-            {
-            //increase progress because this pixel will not be used in the flooding stage.
-            progress.CompletedPixel();
-            }
-          
+          long c = idx[d] + neighbors[k][d];
+          isInside = c >= start[d] && c < start[d] + (long)size[d];
+          }
+        if( isInside && labels[ p + offsets[k] ] != wsLabel )
+          {
+          fifo[tail++] = p;
+          queued[p] = true;
+          break;
+          }
+        }
+      }
+
+    // propagate on the plateau, and in the lower pixels not reached yet
+    for( unsigned long head=0; head<tail; head++ )
+      {
+      p = fifo[head];
+      const bool onBorder = border[p];
+      IndexType idx;
+      if( onBorder )
+        {
+        idx = output->ComputeIndex( p );
+        }
+      inside.clear();
+      for( unsigned int k=0; k<nbOfNeighbors; k++ )
+        {
+        bool isInside = true;
+        for( unsigned int d=0; d<ImageDimension && isInside && onBorder; d++ )
+          {
+          long c = idx[d] + neighbors[k][d];
+          isInside = c >= start[d] && c < start[d] + (long)size[d];
           }
-        else
+        if( isInside )
           {
-          // Some pixels may be never processed so, by default, non marked pixels
-          // must be marked as watershed
-          outputIt.SetCenterPixel( wsLabel );	
+          inside.push_back( p + offsets[k] );
           }
-        progress.CompletedPixel();
         }
-      // now for flooding
-      // init all the iterators
-      outputIt.GoToBegin();
-      inputIt2.GoToBegin();
-      distanceIt.GoToBegin();
 
-      while( !fah.Empty() )
+      // If there is only one marker value, give that value to the pixel,
+      // else keep it as is (watershed line)
+      LabelImagePixelType marker = wsLabel;
+      bool collision = false;
+      for( unsigned int k=0; k<inside.size(); k++ )
         {
-        // store the current vars
-        const InputImagePixelType & StoredVal = fah.FrontKey();
-        const IndexType & idx = fah.FrontValue();
-        // move the iterators to the right place
-        OffsetType shift = idx - outputIt.GetIndex();
-        outputIt += shift;
-        inputIt2 += shift;
-        distanceIt += shift;
-        float ThisDistance = distanceIt.GetCenterPixel();
-        LabelImagePixelType currentMarker = outputIt.GetCenterPixel();
-
-        // visit neighbors
-        unsigned i;
-        for (noIt = outputIt.Begin(), niIt = inputIt2.Begin(), 
-              ndIt = distanceIt.Begin(), i=0;
-            noIt != outputIt.End();
-            noIt++, niIt++, ++ndIt, i++)
+        const LabelImagePixelType & o = labels[ inside[k] ];
+        if( o != wsLabel )
           {
-          float NewDistance, NeighDistance = ndIt.Get();
-          InputImagePixelType priority = StoredVal, NeighVal = niIt.Get();
-          // need to be very careful about the reconstruction
-          // component - how do we make sure reconstruction is
-          // happening implicitly without allowing labels to flood
-          // downhill over already labelled regions unnecessarily. One
-          // possibility is to have a copy of the input image
-          if (NeighVal == StoredVal)
+          if( marker == wsLabel )
             {
-            // we are on the same plateau
-            NewDistance = ThisDistance + weights[i];
-            priority = StoredVal;
+            marker = o;
+            if( !m_MarkWatershedLine )
+              { break; }
             }
-          else
+          else if( o != marker )
             {
-            if (NeighVal > StoredVal)
-              {
-              // new plateau
-              NewDistance = weights[i]; //0.0; //ThisDistance + weights[i];
-              priority = NeighVal;
-              }
-            else
-              {
-              // either a reconstruction or falling onto an already
-              // flooded area
-              LabelImagePixelType NMarker = noIt.Get();
-              if (NMarker == wsLabel)
-                {
-                // reconstruction
-                niIt.Set(StoredVal);
-                NewDistance = ThisDistance + weights[i];
-                priority = StoredVal;
-                }
-              else
-                {
-                // Going somewhere we've been -- set the cost high so
-                // we don't do anythin
-                NewDistance = NumericTraits<DistancePixelType>::max();
-                }
-              }
+            collision = true;
+            break;
             }
-          if (NewDistance < NeighDistance)
+          }
+        }
+
+      if( !collision )
+        {
+        labels[p] = marker;
+        for( unsigned int k=0; k<inside.size(); k++ )
+          {
+          const unsigned long & q = inside[k];
+          if( !queued[q] && inputBuffer[q] <= level
+              && ( !bounded || this->IsFloodable( inputBuffer, mask, q ) ) )
             {
-            // found a cheaper way of getting to the target pixel
-            noIt.Set(currentMarker);
-            ndIt.Set(NewDistance);
-            fah.Push(priority, idx + niIt.GetNeighborhoodOffset());
+            fifo[tail++] = q;
+            queued[q] = true;
             }
-          progress.CompletedPixel();
           }
-        // remove the processed pixel from the queue
-        fah.Pop();	
         }
+      progress.CompletedPixel();
       }
+    tail = 0;
     }
 }
 
 
-
-template<class TInputImage, class TLabelImage>
+template<class TInputImage, class TLabelImage, class TMaskImage>
 void
-MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
+MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage, TMaskImage>
 ::PrintSelf(std::ostream &os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
@@ -593,6 +921,16 @@ MorphologicalWatershedFromMarkersImageFilter<TInputImage, TLabelImage>
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
   os << indent << "UseImageSpacing: "  << m_UseImageSpacing << std::endl;
   os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<LabelImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "FloodingMethod: "  << m_FloodingMethod << std::endl;
+  os << indent << "EdgeWeight: "  << m_EdgeWeight << std::endl;
+  os << indent << "Propagation: "  << m_Propagation << std::endl;
+  os << indent << "UseRankTransform: "  << m_UseRankTransform << std::endl;
+  os << indent << "UseCompactLabels: "  << m_UseCompactLabels << std::endl;
+  os << indent << "MaximumScratchSize: "  << m_MaximumScratchSize << std::endl;
+  os << indent << "ScratchSize: "  << this->GetScratchSize() << std::endl;
+  os << indent << "MaximumFloodLevel: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_MaximumFloodLevel) << std::endl;
+  os << indent << "SparseFloodingFraction: "  << m_SparseFloodingFraction << std::endl;
+  os << indent << "InPlace: "  << m_InPlace << std::endl;
 }
   
 }// end namespace itk
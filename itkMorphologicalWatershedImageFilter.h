@@ -18,9 +18,147 @@
 #define __itkMorphologicalWatershedImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkImage.h"
+#include "itkProgressAccumulator.h"
+#include "itkHMinimaImageFilter.h"
+#include "itkRegionalMinimaImageFilter.h"
+#include "itkConnectedComponentImageFilter.h"
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageCache.h"
+#include <map>
 
 namespace itk {
 
+/** \class MorphologicalWatershedPipelineBase
+ * \brief The internal filters of MorphologicalWatershedImageFilter for a
+ * label type
+ *
+ * MorphologicalWatershedImageFilter keeps one set of internal filters for
+ * each label type used for the markers, in a
+ * MorphologicalWatershedPipelineBase::Pointer, so their scratch memory is
+ * reused by the next executions. The scratch memory is managed through
+ * that base class, whatever the label type.
+ *
+ * \sa MorphologicalWatershedPipeline
+ */
+class MorphologicalWatershedPipelineBase : public LightObject
+{
+public:
+  typedef MorphologicalWatershedPipelineBase Self;
+  typedef LightObject                        Superclass;
+  typedef SmartPointer<Self>                 Pointer;
+  typedef SmartPointer<const Self>           ConstPointer;
+
+  itkTypeMacro(MorphologicalWatershedPipelineBase, LightObject);
+
+  /** Set the maximum size, in bytes, of the scratch memory kept by each
+   * internal filter */
+  virtual void SetMaximumScratchSize( unsigned long size ) = 0;
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  virtual unsigned long GetScratchSize() const = 0;
+
+  /** Release the scratch memory kept from the last execution */
+  virtual void ReleaseScratch() = 0;
+
+protected:
+  MorphologicalWatershedPipelineBase() {}
+  virtual ~MorphologicalWatershedPipelineBase() {}
+
+private:
+  MorphologicalWatershedPipelineBase(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+};
+
+/** \class MorphologicalWatershedPipeline
+ * \brief Label the regional minima in a TMarkerImage, and flood them
+ *
+ * When the markers are stored with a compact label type, the output of the
+ * flooding is an intermediate image, kept with the scratch memory so its
+ * buffer is reused by the next flooding. See SetOutputIsScratch().
+ *
+ * \sa MorphologicalWatershedImageFilter
+ */
+template<class TInputImage, class TMarkerImage>
+class MorphologicalWatershedPipeline : public MorphologicalWatershedPipelineBase
+{
+public:
+  typedef MorphologicalWatershedPipeline     Self;
+  typedef MorphologicalWatershedPipelineBase Superclass;
+  typedef SmartPointer<Self>                 Pointer;
+  typedef SmartPointer<const Self>           ConstPointer;
+
+  typedef Image< unsigned char, TInputImage::ImageDimension > MinimaImageType;
+  typedef ConnectedComponentImageFilter< MinimaImageType, TMarkerImage > LabelerType;
+  typedef MorphologicalWatershedFromMarkersImageFilter< TInputImage, TMarkerImage > WatershedType;
+
+  itkNewMacro(Self);
+  itkTypeMacro(MorphologicalWatershedPipeline, MorphologicalWatershedPipelineBase);
+
+  LabelerType * GetLabeler()
+    {
+    return m_Labeler;
+    }
+
+  WatershedType * GetWatershed()
+    {
+    return m_Watershed;
+    }
+
+  /** Set whether the output of the flooding is counted and released with
+   * the scratch memory. It must be false when that output is grafted from
+   * the output of another filter. */
+  void SetOutputIsScratch( bool value )
+    {
+    m_OutputIsScratch = value;
+    }
+
+  virtual void SetMaximumScratchSize( unsigned long size )
+    {
+    m_Labeler->SetMaximumScratchSize( size );
+    m_Watershed->SetMaximumScratchSize( size );
+    }
+
+  virtual unsigned long GetScratchSize() const
+    {
+    unsigned long size = m_Labeler->GetScratchSize() + m_Watershed->GetScratchSize();
+    const TMarkerImage * output = m_Watershed->GetOutput();
+    if( m_OutputIsScratch && output->GetBufferPointer() )
+      {
+      size += output->GetPixelContainer()->Capacity() * sizeof( typename TMarkerImage::PixelType );
+      }
+    return size;
+    }
+
+  virtual void ReleaseScratch()
+    {
+    m_Labeler->ReleaseScratch();
+    m_Watershed->ReleaseScratch();
+    if( m_OutputIsScratch )
+      {
+      m_Watershed->GetOutput()->ReleaseData();
+      }
+    }
+
+protected:
+  MorphologicalWatershedPipeline()
+    {
+    m_Labeler = LabelerType::New();
+    m_Watershed = WatershedType::New();
+    m_OutputIsScratch = false;
+    }
+  virtual ~MorphologicalWatershedPipeline() {}
+
+private:
+  MorphologicalWatershedPipeline(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typename LabelerType::Pointer m_Labeler;
+  typename WatershedType::Pointer m_Watershed;
+  bool m_OutputIsScratch;
+};
+
+
 /** \class MorphologicalWatershedImageFilter
  * \brief TODO
  *
@@ -39,6 +177,31 @@ namespace itk {
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The flooding is done by MorphologicalWatershedFromMarkersImageFilter, and
+ * SetFloodingMethod() selects the algorithm it uses. SORTED_LEVELS, which
+ * sorts the pixels by level instead of using a hierarchical queue, is only
+ * used with the 8 and 16 bits integer input images. SetUseRankTransform()
+ * floods the other pixel types on their ranks, with a dense integer queue.
+ *
+ * The regional minima are stored in a binary image of unsigned char, and
+ * their number of runs is used to label and flood them with the narrowest
+ * label type able to store them. The labels are widened to the output type
+ * at the end. See SetUseCompactLabels().
+ *
+ * The labeled markers are kept from one execution to the other, with the
+ * modification time of the input, the Level, the FullyConnected and the
+ * label parameters used to compute them. When only the flooding
+ * parameters, like MarkWatershedLine or FloodingMethod, are changed, the
+ * markers are reused and only the flooding is run again. ReleaseMarkers()
+ * frees them.
+ *
+ * The internal filters run with the number of threads of this filter, so
+ * SetNumberOfThreads(1) runs the whole watershed in the calling thread.
+ * They are kept from one execution to the other, with one labeling and one
+ * flooding filter for each label type used, so a stream of images of the
+ * same size reuses their scratch memory. SetMaximumScratchSize() limits the
+ * memory kept by each of them, and ReleaseScratch() frees it.
+ *
  * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * \sa WatershedImageFilter, MorphologicalWatershedFromMarkersImageFilter, RelabelComponentImageFilter
@@ -73,6 +236,16 @@ public:
                       TInputImage::ImageDimension);
   itkStaticConstMacro(OutputImageDimension, unsigned int,
                       TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** The binary image of the regional minima */
+  typedef unsigned char MinimaImagePixelType;
+  typedef Image< MinimaImagePixelType, ImageDimension > MinimaImageType;
+
+  /** The internal filters used to find the markers */
+  typedef HMinimaImageFilter< TInputImage, TInputImage > HMinimaType;
+  typedef RegionalMinimaImageFilter< TInputImage, MinimaImageType > RegionalMinimaType;
 
   /** Standard New method. */
   itkNewMacro(Self);  
@@ -110,6 +283,70 @@ public:
   itkSetMacro(WatershedLabel, OutputImagePixelType);
   itkGetMacro(WatershedLabel, OutputImagePixelType);
 
+  typedef enum {
+    HIERARCHICAL_QUEUE,
+    MINIMUM_SPANNING_FOREST,
+    SORTED_LEVELS
+  } FloodingMethodType;
+
+  /**
+   * Set/Get the algorithm used to flood the image from the regional minima.
+   * Default is HIERARCHICAL_QUEUE.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetFloodingMethod()
+   */
+  itkSetMacro(FloodingMethod, FloodingMethodType);
+  itkGetConstReferenceMacro(FloodingMethod, FloodingMethodType);
+
+  /**
+   * Set/Get whether the flooding is done on the ranks of the input values.
+   * Default is false.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetUseRankTransform()
+   */
+  itkSetMacro(UseRankTransform, bool);
+  itkGetConstReferenceMacro(UseRankTransform, bool);
+  itkBooleanMacro(UseRankTransform);
+
+  /**
+   * Set/Get whether the regional minima are labeled and flooded with the
+   * narrowest unsigned label type able to store them. The labels are
+   * widened only when they are written in the output, and are the same as
+   * the ones computed with the output type. Default is true.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetUseCompactLabels()
+   */
+  itkSetMacro(UseCompactLabels, bool);
+  itkGetConstReferenceMacro(UseCompactLabels, bool);
+  itkBooleanMacro(UseCompactLabels);
+
+  /** Release the markers kept from the last execution. They are recomputed
+   * at the next update. */
+  void ReleaseMarkers();
+
+  /**
+   * Set/Get the on-disk cache of the markers. When it is set, the labeled
+   * markers are stored in the cache, and loaded from there instead of being
+   * computed again for an input with the same content and the same
+   * parameters, even in another process. Default is NULL: no cache.
+   * \sa ImageCache
+   */
+  itkSetObjectMacro(Cache, ImageCache);
+  itkGetObjectMacro(Cache, ImageCache);
+
+  /**
+   * Set/Get the maximum size, in bytes, of the scratch memory kept by each
+   * internal filter from one execution to the other. Default is the maximum
+   * of unsigned long: all the scratch memory is kept.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::SetMaximumScratchSize()
+   */
+  void SetMaximumScratchSize( unsigned long size );
+  itkGetConstReferenceMacro(MaximumScratchSize, unsigned long);
+
+  /** Return the size, in bytes, of the scratch memory currently kept by the
+   * internal filters */
+  unsigned long GetScratchSize() const;
+
+  /** Release the scratch memory kept by the internal filters */
+  void ReleaseScratch();
+
 protected:
   MorphologicalWatershedImageFilter();
   ~MorphologicalWatershedImageFilter() {};
@@ -126,6 +363,50 @@ protected:
   /** Single-threaded version of GenerateData.  This filter delegates
    * to GrayscaleGeodesicErodeImageFilter. */
   void GenerateData();
+
+  /** Return true if the markers kept from the last execution have been
+   * computed from the same input, with the same parameters */
+  bool MarkersAreUpToDate() const;
+
+  /** Find and label the regional minima, or load them from the cache, and
+   * keep them in m_Markers */
+  void ComputeMarkers( ProgressAccumulator * progress, float weight );
+
+  /** Find and label the regional minima, and keep them in m_Markers */
+  void FindMarkers( ProgressAccumulator * progress, float weight );
+
+  /** Store m_Markers in the cache with a key */
+  void StoreMarkers( const std::string & key );
+
+  /** Count the runs of pixels of the regional minima, along the first
+   * dimension */
+  unsigned long CountRuns( const MinimaImageType * minima );
+
+  /** Label the regional minima in an image of type TMarkerImage, and keep
+   * it in m_Markers */
+  template < class TMarkerImage >
+  void LabelMinima( const MinimaImageType * minima, const typename TMarkerImage::PixelType & background,
+                    ProgressAccumulator * progress, float weight );
+
+  /** Load the markers of type TMarkerImage stored in the cache with a key,
+   * and keep them in m_Markers. Return false if they are not in the cache. */
+  template < class TMarkerImage >
+  bool LoadTypedMarkers( const std::string & key );
+
+  /** Load the markers stored in the cache with a key, with any of the label
+   * types which can be chosen for the current parameters, and set
+   * m_MarkerLabelSize */
+  bool LoadMarkers( const std::string & key );
+
+  /** Flood the markers stored with the TCompactLabel type, and widen the
+   * labels in the output */
+  template < class TCompactLabel >
+  void CompactFlood( ProgressAccumulator * progress, float weight );
+
+  /** Return the internal filters for the markers of type TMarkerImage. They
+   * are created at the first use of that type. */
+  template < class TMarkerImage >
+  MorphologicalWatershedPipeline< TInputImage, TMarkerImage > * GetPipeline();
   
 
 private:
@@ -140,6 +421,35 @@ private:
 
   InputImagePixelType m_Level;
 
+  FloodingMethodType m_FloodingMethod;
+
+  bool m_UseRankTransform;
+
+  bool m_UseCompactLabels;
+
+  // the internal filters, kept from one execution to the other
+  typename HMinimaType::Pointer m_HMinima;
+  typename RegionalMinimaType::Pointer m_RegionalMinima;
+
+  // the labeling and flooding filters, by size of the label type
+  typedef std::map< unsigned int, MorphologicalWatershedPipelineBase::Pointer > PipelineMapType;
+  PipelineMapType m_Pipelines;
+  unsigned long m_MaximumScratchSize;
+
+  // the labeled markers, stored on m_MarkerLabelSize bytes, or on the
+  // output type when m_MarkerLabelSize is 0, and the key of that cache
+  DataObject::Pointer m_Markers;
+  DataObject::Pointer m_PreviousMarkers;
+  unsigned int m_MarkerLabelSize;
+  const InputImageType * m_MarkersInput;
+  unsigned long m_MarkersInputMTime;
+  InputImagePixelType m_MarkersLevel;
+  bool m_MarkersFullyConnected;
+  bool m_MarkersUseCompactLabels;
+  OutputImagePixelType m_MarkersWatershedLabel;
+
+  ImageCache::Pointer m_Cache;
+
 } ; // end of class
 
 } // end namespace itk
@@ -18,11 +18,9 @@
 #define __itkMorphologicalWatershedImageFilter_txx
 
 #include "itkMorphologicalWatershedImageFilter.h"
-#include "itkRegionalMinimaImageFilter.h"
-#include "itkHMinimaImageFilter.h"
-#include "itkConnectedComponentImageFilter.h"
-#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkUnaryFunctorImageFilter.h"
 #include "itkNumericTraits.h"
+#include <sstream>
 
 namespace itk {
 
@@ -34,6 +32,20 @@ MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
   m_MarkWatershedLine = true;
   m_Level = NumericTraits< InputImagePixelType >::Zero;
   m_WatershedLabel = NumericTraits< OutputImagePixelType >::Zero;
+  m_FloodingMethod = HIERARCHICAL_QUEUE;
+  m_UseRankTransform = false;
+  m_UseCompactLabels = true;
+  m_HMinima = HMinimaType::New();
+  m_RegionalMinima = RegionalMinimaType::New();
+  m_MaximumScratchSize = NumericTraits< unsigned long >::max();
+  m_MarkerLabelSize = 0;
+  m_MarkersInput = NULL;
+  m_MarkersInputMTime = 0;
+  m_MarkersLevel = NumericTraits< InputImagePixelType >::Zero;
+  m_MarkersFullyConnected = false;
+  m_MarkersUseCompactLabels = false;
+  m_MarkersWatershedLabel = NumericTraits< OutputImagePixelType >::Zero;
+  m_Cache = NULL;
 }
 
 template <class TInputImage, class TOutputImage>
@@ -73,72 +85,473 @@ MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
 
   // Allocate the output
   this->AllocateOutputs();
-  
-  // h-minima filter to remove the smallest minima
-  typedef HMinimaImageFilter<TInputImage, TInputImage> HMinimaType;
-  typename HMinimaType::Pointer hmin;
-
-  // Delegate to a R-Min filter to find the regional minima
-  typedef RegionalMinimaImageFilter<TInputImage, TOutputImage> RMinType;
-  typename RMinType::Pointer rmin = RMinType::New();
-  rmin->SetInput( this->GetInput() );
-  rmin->SetFullyConnected( m_FullyConnected );
-  rmin->SetBackgroundValue( NumericTraits< OutputImagePixelType >::Zero );
-  rmin->SetForegroundValue( NumericTraits< OutputImagePixelType >::max() );
-
-  // label the components
-  typedef ConnectedComponentImageFilter< TOutputImage, TOutputImage > ConnectedCompType;
-  typename ConnectedCompType::Pointer label = ConnectedCompType::New();
-  label->SetFullyConnected( m_FullyConnected );
-  label->SetInput( rmin->GetOutput() );
-  label->SetBackgroundValue( m_WatershedLabel );
 
-  // the watershed
-  typedef MorphologicalWatershedFromMarkersImageFilter< TInputImage, TOutputImage > WatershedType;
-  typename WatershedType::Pointer wshed = WatershedType::New();
+  // the markers only depend on the input, the level and the connectivity:
+  // they are computed again only if one of them has changed
+  float wshedWeight = 1.0f;
+  if( !this->MarkersAreUpToDate() )
+    {
+    if( m_Level != NumericTraits< InputImagePixelType >::Zero )
+      {
+      this->ComputeMarkers( progress, 0.7f );
+      wshedWeight = 0.3f;
+      }
+    else
+      {
+      this->ComputeMarkers( progress, 0.5f );
+      wshedWeight = 0.5f;
+      }
+    }
+
+  if( m_MarkerLabelSize == 1 )
+    {
+    this->CompactFlood< unsigned char >( progress, wshedWeight );
+    return;
+    }
+  if( m_MarkerLabelSize == 2 )
+    {
+    this->CompactFlood< unsigned short >( progress, wshedWeight );
+    return;
+    }
+  if( m_MarkerLabelSize == 4 )
+    {
+    this->CompactFlood< unsigned int >( progress, wshedWeight );
+    return;
+    }
+
+  // the watershed, kept from one execution to the other
+  typedef typename MorphologicalWatershedPipeline< TInputImage, TOutputImage >::WatershedType WatershedType;
+  WatershedType * wshed = this->template GetPipeline< TOutputImage >()->GetWatershed();
   wshed->SetInput( this->GetInput() );
-  wshed->SetMarkerImage( label->GetOutput() );
+  wshed->SetMarkerImage( static_cast< TOutputImage * >( m_Markers.GetPointer() ) );
   wshed->SetFullyConnected( m_FullyConnected );
   wshed->SetMarkWatershedLine( m_MarkWatershedLine );
   wshed->SetBackgroundValue( m_WatershedLabel );
+  wshed->SetFloodingMethod( static_cast< typename WatershedType::FloodingMethodType >( m_FloodingMethod ) );
+  wshed->SetUseRankTransform( m_UseRankTransform );
+  wshed->SetUseCompactLabels( m_UseCompactLabels );
+  wshed->SetNumberOfThreads( this->GetNumberOfThreads() );
+  // the output is grafted again at each execution, so the filter must run
+  // even if its inputs and parameters have not changed
+  wshed->Modified();
 
+  progress->RegisterInternalFilter(wshed,wshedWeight);
 
+  // run the algorithm
+  // graft our output to the watershed filter to force the proper regions
+  // to be generated
+  wshed->GraftOutput( this->GetOutput() );
+
+  wshed->Update();
+
+  // graft the output of the watershed filter back onto this filter's
+  // output. this is needed to get the appropriate regions passed
+  // back.
+  this->GraftOutput( wshed->GetOutput() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+bool
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::MarkersAreUpToDate() const
+{
+  return m_Markers
+    && m_MarkersInput == this->GetInput()
+    && m_MarkersInputMTime == this->GetInput()->GetMTime()
+    && m_MarkersLevel == m_Level
+    && m_MarkersFullyConnected == m_FullyConnected
+    && m_MarkersUseCompactLabels == m_UseCompactLabels
+    // the watershed label is the background of the markers stored on the
+    // output type
+    && ( m_MarkerLabelSize != 0 || m_MarkersWatershedLabel == m_WatershedLabel );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ReleaseMarkers()
+{
+  m_Markers = NULL;
+  m_MarkersInput = NULL;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::SetMaximumScratchSize( unsigned long size )
+{
+  if( size == m_MaximumScratchSize )
+    {
+    return;
+    }
+  m_MaximumScratchSize = size;
+  m_HMinima->SetMaximumScratchSize( size );
+  for( typename PipelineMapType::iterator it=m_Pipelines.begin(); it!=m_Pipelines.end(); it++ )
+    {
+    it->second->SetMaximumScratchSize( size );
+    }
+  this->Modified();
+}
+
+
+template<class TInputImage, class TOutputImage>
+unsigned long
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::GetScratchSize() const
+{
+  unsigned long size = m_HMinima->GetScratchSize();
+  for( typename PipelineMapType::const_iterator it=m_Pipelines.begin(); it!=m_Pipelines.end(); it++ )
+    {
+    size += it->second->GetScratchSize();
+    }
+  return size;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ReleaseScratch()
+{
+  m_HMinima->ReleaseScratch();
+  for( typename PipelineMapType::iterator it=m_Pipelines.begin(); it!=m_Pipelines.end(); it++ )
+    {
+    it->second->ReleaseScratch();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+template<class TMarkerImage>
+MorphologicalWatershedPipeline< TInputImage, TMarkerImage > *
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::GetPipeline()
+{
+  // the label types used for the markers all have different sizes
+  typedef MorphologicalWatershedPipeline< TInputImage, TMarkerImage > PipelineType;
+  MorphologicalWatershedPipelineBase::Pointer & pipeline = m_Pipelines[ sizeof( typename TMarkerImage::PixelType ) ];
+  PipelineType * typedPipeline = dynamic_cast< PipelineType * >( pipeline.GetPointer() );
+  if( typedPipeline == NULL )
+    {
+    typename PipelineType::Pointer newPipeline = PipelineType::New();
+    newPipeline->SetMaximumScratchSize( m_MaximumScratchSize );
+    typedPipeline = newPipeline;
+    pipeline = typedPipeline;
+    }
+  return typedPipeline;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::ComputeMarkers( ProgressAccumulator * progress, float weight )
+{
+  // the buffer of the previous markers is reused by the labeling
+  m_PreviousMarkers = m_Markers;
+  this->ReleaseMarkers();
+
+  // the markers may have been computed already, by this process or by
+  // another one
+  std::string cacheKey;
+  if( m_Cache )
+    {
+    std::ostringstream parameters;
+    parameters.precision( 17 );
+    parameters << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_Level) << " "
+               << m_FullyConnected << " " << m_UseCompactLabels << " "
+               << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_WatershedLabel) << " "
+               << ChunkedVolumePixelTypeName< OutputImagePixelType >();
+    cacheKey = m_Cache->ComputeKey( "MorphologicalWatershedMarkers", parameters.str(), this->GetInput() );
+    }
+
+  if( !m_Cache || !this->LoadMarkers( cacheKey ) )
+    {
+    this->FindMarkers( progress, weight );
+    if( m_Cache )
+      {
+      this->StoreMarkers( cacheKey );
+      }
+    }
+
+  m_PreviousMarkers = NULL;
+  m_MarkersInput = this->GetInput();
+  m_MarkersInputMTime = this->GetInput()->GetMTime();
+  m_MarkersLevel = m_Level;
+  m_MarkersFullyConnected = m_FullyConnected;
+  m_MarkersUseCompactLabels = m_UseCompactLabels;
+  m_MarkersWatershedLabel = m_WatershedLabel;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::FindMarkers( ProgressAccumulator * progress, float weight )
+{
+  // Delegate to a R-Min filter to find the regional minima. They are stored
+  // in a binary image, whatever the output type.
+  m_RegionalMinima->SetInput( this->GetInput() );
+  m_RegionalMinima->SetFullyConnected( m_FullyConnected );
+  m_RegionalMinima->SetBackgroundValue( NumericTraits< MinimaImagePixelType >::Zero );
+  m_RegionalMinima->SetForegroundValue( NumericTraits< MinimaImagePixelType >::max() );
+  m_RegionalMinima->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  float labelWeight;
   if( m_Level != NumericTraits< InputImagePixelType >::Zero )
     {
     // insert a h-minima filter to remove the smallest minima
     //
-    hmin = HMinimaType::New();
-    hmin->SetInput( this->GetInput() );
-    hmin->SetHeight( m_Level );
-    hmin->SetFullyConnected( m_FullyConnected );
+    m_HMinima->SetInput( this->GetInput() );
+    m_HMinima->SetHeight( m_Level );
+    m_HMinima->SetFullyConnected( m_FullyConnected );
+    m_HMinima->SetNumberOfThreads( this->GetNumberOfThreads() );
+    // only the labeled markers are kept
+    m_HMinima->ReleaseDataFlagOn();
     // replace the input of the r-min filter
-    rmin->SetInput( hmin->GetOutput() );
+    m_RegionalMinima->SetInput( m_HMinima->GetOutput() );
 
-    progress->RegisterInternalFilter(hmin,0.4f);
-    progress->RegisterInternalFilter(rmin,0.1f);
-    progress->RegisterInternalFilter(label,.2f);
-    progress->RegisterInternalFilter(wshed,.3f);
+    progress->RegisterInternalFilter(m_HMinima,weight * 0.4f / 0.7f);
+    progress->RegisterInternalFilter(m_RegionalMinima,weight * 0.1f / 0.7f);
+    labelWeight = weight * 0.2f / 0.7f;
    }
   else
     {
     // don't insert the h-minima to save some ressources
-    progress->RegisterInternalFilter(rmin,0.167f);
-    progress->RegisterInternalFilter(label,.333f);
-    progress->RegisterInternalFilter(wshed,.5f);
+    progress->RegisterInternalFilter(m_RegionalMinima,weight * 0.333f);
+    labelWeight = weight * 0.667f;
     }
 
+  m_RegionalMinima->Update();
+  typename MinimaImageType::ConstPointer minima = m_RegionalMinima->GetOutput();
 
-  // run the algorithm
-  // graft our output to the watershed filter to force the proper regions
-  // to be generated
-  wshed->GraftOutput( this->GetOutput() );
+  // the number of runs of minima is an upper bound of the number of labels,
+  // so it is used to choose the narrowest label type for the flooding
+  m_MarkerLabelSize = 0;
+  if( m_UseCompactLabels && NumericTraits< OutputImagePixelType >::is_integer && sizeof( OutputImagePixelType ) > 1 )
+    {
+    const unsigned long nbOfRuns = this->CountRuns( minima );
+    if( nbOfRuns <= NumericTraits< unsigned char >::max() )
+      {
+      m_MarkerLabelSize = 1;
+      }
+    else if( nbOfRuns <= NumericTraits< unsigned short >::max() && sizeof( OutputImagePixelType ) > 2 )
+      {
+      m_MarkerLabelSize = 2;
+      }
+    else if( nbOfRuns <= NumericTraits< unsigned int >::max() && sizeof( OutputImagePixelType ) > sizeof( unsigned int ) )
+      {
+      m_MarkerLabelSize = 4;
+      }
+    }
 
-  wshed->Update();
+  if( m_MarkerLabelSize == 1 )
+    {
+    this->LabelMinima< Image< unsigned char, ImageDimension > >( minima, 0, progress, labelWeight );
+    }
+  else if( m_MarkerLabelSize == 2 )
+    {
+    this->LabelMinima< Image< unsigned short, ImageDimension > >( minima, 0, progress, labelWeight );
+    }
+  else if( m_MarkerLabelSize == 4 )
+    {
+    this->LabelMinima< Image< unsigned int, ImageDimension > >( minima, 0, progress, labelWeight );
+    }
+  else
+    {
+    this->LabelMinima< TOutputImage >( minima, m_WatershedLabel, progress, labelWeight );
+    }
 
-  // graft the output of the watershed filter back onto this filter's
-  // output. this is needed to get the appropriate regions passed
-  // back.
-  this->GraftOutput( wshed->GetOutput() );
+  // free the minima: they are not needed anymore
+  m_RegionalMinima->GetOutput()->ReleaseData();
+}
+
+
+template<class TInputImage, class TOutputImage>
+bool
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::LoadMarkers( const std::string & key )
+{
+  // the label type depends on the number of minima, which is not known yet:
+  // try all the ones allowed by the parameters
+  if( m_UseCompactLabels && NumericTraits< OutputImagePixelType >::is_integer && sizeof( OutputImagePixelType ) > 1 )
+    {
+    if( this->LoadTypedMarkers< Image< unsigned char, ImageDimension > >( key ) )
+      {
+      m_MarkerLabelSize = 1;
+      return true;
+      }
+    if( sizeof( OutputImagePixelType ) > 2
+        && this->LoadTypedMarkers< Image< unsigned short, ImageDimension > >( key ) )
+      {
+      m_MarkerLabelSize = 2;
+      return true;
+      }
+    if( sizeof( OutputImagePixelType ) > sizeof( unsigned int )
+        && this->LoadTypedMarkers< Image< unsigned int, ImageDimension > >( key ) )
+      {
+      m_MarkerLabelSize = 4;
+      return true;
+      }
+    }
+  if( this->LoadTypedMarkers< TOutputImage >( key ) )
+    {
+    m_MarkerLabelSize = 0;
+    return true;
+    }
+  return false;
+}
+
+
+template<class TInputImage, class TOutputImage>
+template<class TMarkerImage>
+bool
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::LoadTypedMarkers( const std::string & key )
+{
+  typename TMarkerImage::Pointer markers = TMarkerImage::New();
+  markers->CopyInformation( this->GetInput() );
+  markers->SetBufferedRegion( this->GetInput()->GetBufferedRegion() );
+  markers->SetRequestedRegion( this->GetInput()->GetBufferedRegion() );
+  if( !m_Cache->Load( key, markers.GetPointer() ) )
+    {
+    return false;
+    }
+  m_Markers = markers;
+  return true;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::StoreMarkers( const std::string & key )
+{
+  if( m_MarkerLabelSize == 1 )
+    {
+    m_Cache->Store( key, static_cast< Image< unsigned char, ImageDimension > * >( m_Markers.GetPointer() ) );
+    }
+  else if( m_MarkerLabelSize == 2 )
+    {
+    m_Cache->Store( key, static_cast< Image< unsigned short, ImageDimension > * >( m_Markers.GetPointer() ) );
+    }
+  else if( m_MarkerLabelSize == 4 )
+    {
+    m_Cache->Store( key, static_cast< Image< unsigned int, ImageDimension > * >( m_Markers.GetPointer() ) );
+    }
+  else
+    {
+    m_Cache->Store( key, static_cast< TOutputImage * >( m_Markers.GetPointer() ) );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+unsigned long
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::CountRuns( const MinimaImageType * minima )
+{
+  const MinimaImagePixelType * buffer = minima->GetBufferPointer();
+  const unsigned long nbOfPixels = minima->GetBufferedRegion().GetNumberOfPixels();
+  const unsigned long xsize = minima->GetBufferedRegion().GetSize()[0];
+  unsigned long nbOfRuns = 0;
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    if( buffer[p] != NumericTraits< MinimaImagePixelType >::Zero
+        && ( p % xsize == 0 || buffer[p-1] == NumericTraits< MinimaImagePixelType >::Zero ) )
+      {
+      nbOfRuns++;
+      }
+    }
+  return nbOfRuns;
+}
+
+
+template<class TInputImage, class TOutputImage>
+template<class TMarkerImage>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::LabelMinima( const MinimaImageType * minima, const typename TMarkerImage::PixelType & background,
+               ProgressAccumulator * progress, float weight )
+{
+  // label the components, with the filter kept from one execution to the
+  // other
+  typedef typename MorphologicalWatershedPipeline< TInputImage, TMarkerImage >::LabelerType ConnectedCompType;
+  ConnectedCompType * label = this->template GetPipeline< TMarkerImage >()->GetLabeler();
+  label->SetFullyConnected( m_FullyConnected );
+  label->SetInput( minima );
+  label->SetBackgroundValue( background );
+  label->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progress->RegisterInternalFilter(label,weight);
+
+  // label in the buffer of the previous markers, if they have the same type:
+  // it is only reallocated when it is too small
+  TMarkerImage * previousMarkers = dynamic_cast< TMarkerImage * >( m_PreviousMarkers.GetPointer() );
+  if( previousMarkers )
+    {
+    label->GetOutput()->SetPixelContainer( previousMarkers->GetPixelContainer() );
+    }
+  m_PreviousMarkers = NULL;
+  label->Update();
+
+  // keep the labels out of the pipeline: the next execution of the filter
+  // produces a new image
+  typename TMarkerImage::Pointer markers = label->GetOutput();
+  markers->DisconnectPipeline();
+  m_Markers = markers;
+}
+
+
+template<class TInputImage, class TOutputImage>
+template<class TCompactLabel>
+void
+MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
+::CompactFlood( ProgressAccumulator * progress, float weight )
+{
+  typedef Image< TCompactLabel, ImageDimension > CompactImageType;
+
+  // the watershed, kept from one execution to the other with its output
+  typedef MorphologicalWatershedPipeline< TInputImage, CompactImageType > PipelineType;
+  typedef typename PipelineType::WatershedType WatershedType;
+  PipelineType * pipeline = this->template GetPipeline< CompactImageType >();
+  pipeline->SetOutputIsScratch( true );
+  WatershedType * wshed = pipeline->GetWatershed();
+  wshed->SetInput( this->GetInput() );
+  wshed->SetMarkerImage( static_cast< CompactImageType * >( m_Markers.GetPointer() ) );
+  wshed->SetFullyConnected( m_FullyConnected );
+  wshed->SetMarkWatershedLine( m_MarkWatershedLine );
+  wshed->SetBackgroundValue( NumericTraits< TCompactLabel >::Zero );
+  wshed->SetFloodingMethod( static_cast< typename WatershedType::FloodingMethodType >( m_FloodingMethod ) );
+  wshed->SetUseRankTransform( m_UseRankTransform );
+  wshed->SetNumberOfThreads( this->GetNumberOfThreads() );
+  // the expansion is a new filter, so the watershed must run even if its
+  // inputs and parameters have not changed
+  wshed->Modified();
+
+  // widen the labels, to get the ones produced with the watershed label as
+  // background
+  typedef Functor::ExpandCompactLabel< TCompactLabel, OutputImagePixelType > ExpandFunctorType;
+  typedef UnaryFunctorImageFilter< CompactImageType, TOutputImage, ExpandFunctorType > ExpandType;
+  typename ExpandType::Pointer expand = ExpandType::New();
+  expand->SetInput( wshed->GetOutput() );
+  expand->GetFunctor().SetBackgroundValue( m_WatershedLabel );
+  expand->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  progress->RegisterInternalFilter(wshed,weight * 0.9f);
+  progress->RegisterInternalFilter(expand,weight * 0.1f);
+
+  expand->GraftOutput( this->GetOutput() );
+  expand->Update();
+  this->GraftOutput( expand->GetOutput() );
+
+  // the compact output of the watershed is only kept within the limit
+  if( pipeline->GetScratchSize() > m_MaximumScratchSize )
+    {
+    wshed->GetOutput()->ReleaseData();
+    }
 }
 
 
@@ -152,6 +565,14 @@ MorphologicalWatershedImageFilter<TInputImage, TOutputImage>
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
   os << indent << "Level: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_Level) << std::endl;
+  os << indent << "FloodingMethod: "  << m_FloodingMethod << std::endl;
+  os << indent << "UseRankTransform: "  << m_UseRankTransform << std::endl;
+  os << indent << "UseCompactLabels: "  << m_UseCompactLabels << std::endl;
+  os << indent << "MarkersAreUpToDate: "  << this->MarkersAreUpToDate() << std::endl;
+  os << indent << "MarkerLabelSize: "  << m_MarkerLabelSize << std::endl;
+  os << indent << "Cache: "  << m_Cache.GetPointer() << std::endl;
+  os << indent << "MaximumScratchSize: "  << m_MaximumScratchSize << std::endl;
+  os << indent << "ScratchSize: "  << this->GetScratchSize() << std::endl;
 }
   
 }// end namespace itk
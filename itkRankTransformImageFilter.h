@@ -0,0 +1,148 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkRankTransformImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkRankTransformImageFilter_h
+#define __itkRankTransformImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkMultiThreader.h"
+#include <vector>
+
+namespace itk {
+
+/** \class RankTransformImageFilter
+ * \brief Replace the pixel values by their rank in the sorted values of the
+ * image
+ *
+ * The output pixel is the position of the input pixel value in the sorted
+ * list of the distinct values of the image: the lowest value gets 0, the
+ * next one 1, and so on. The ranks are dense, and the order of the pixels
+ * is exactly preserved, so the filters which only compare the pixel values,
+ * like the flooding, give the same result on the rank image as on the
+ * input image. On a float image, that lets them use an integer queue.
+ *
+ * The distinct values are sorted in parallel, and can be retrieved with
+ * GetValues() to map the ranks back to the input values. They can also be
+ * computed once with ComputeValues() and given with SetValues(), to
+ * choose the output type according to the number of distinct values. The
+ * output pixel type must be an unsigned integer type able to store the
+ * number of distinct values minus one: 16 bits are enough up to 65536
+ * values.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter, DenseHierarchicalQueue
+ * \ingroup IntensityImageFilters  Multithreaded
+ */
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT RankTransformImageFilter : 
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef RankTransformImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+
+  typedef std::vector< InputImagePixelType >       ValueContainerType;
+  
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);  
+
+  /** Runtime information support. */
+  itkTypeMacro(RankTransformImageFilter, 
+               ImageToImageFilter);
+
+  /** Set the sorted distinct values of the input image. If they are not
+   * set, they are computed by the filter. */
+  void SetValues( const ValueContainerType & values )
+    {
+    m_Values = values;
+    m_ValuesProvided = !values.empty();
+    this->Modified();
+    }
+
+  /** Get the sorted distinct values of the input image. The value of the
+   * rank r is GetValues()[r]. */
+  const ValueContainerType & GetValues() const
+    {
+    return m_Values;
+    }
+
+  /** Get the number of distinct values */
+  unsigned long GetNumberOfRanks() const
+    {
+    return m_Values.size();
+    }
+
+  /** Compute the sorted distinct values of an image, with nbOfThreads
+   * threads */
+  static void ComputeValues( const InputImageType * image, ValueContainerType & values, int nbOfThreads );
+
+protected:
+  RankTransformImageFilter();
+  ~RankTransformImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  void BeforeThreadedGenerateData();
+
+  void ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, int threadId);
+
+  /** data shared by the sorting threads */
+  struct ThreadStruct
+    {
+    ValueContainerType * Values;
+    std::vector< unsigned long > * Bounds;
+    };
+
+  static ITK_THREAD_RETURN_TYPE SortThreaderCallback( void * arg );
+
+private:
+  RankTransformImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  ValueContainerType m_Values;
+  bool m_ValuesProvided;
+
+} ; // end of class
+
+} // end namespace itk
+  
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRankTransformImageFilter.txx"
+#endif
+
+#endif
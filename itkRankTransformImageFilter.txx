@@ -0,0 +1,138 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkRankTransformImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkRankTransformImageFilter_txx
+#define __itkRankTransformImageFilter_txx
+
+#include "itkRankTransformImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+RankTransformImageFilter<TInputImage, TOutputImage>
+::RankTransformImageFilter()
+{
+  m_ValuesProvided = false;
+}
+
+
+template <class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+RankTransformImageFilter<TInputImage, TOutputImage>
+::SortThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+  const std::vector< unsigned long > & bounds = *str->Bounds;
+  std::sort( str->Values->begin() + bounds[ info->ThreadID ], str->Values->begin() + bounds[ info->ThreadID + 1 ] );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+RankTransformImageFilter<TInputImage, TOutputImage>
+::ComputeValues( const InputImageType * image, ValueContainerType & values, int nbOfThreads )
+{
+  const unsigned long nbOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  values.assign( image->GetBufferPointer(), image->GetBufferPointer() + nbOfPixels );
+
+  // sort some parts of the values in parallel
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( std::max( 1, std::min( nbOfThreads, (int)( nbOfPixels / 65536 + 1 ) ) ) );
+  nbOfThreads = threader->GetNumberOfThreads();
+  std::vector< unsigned long > bounds( nbOfThreads + 1 );
+  for( int t=0; t<=nbOfThreads; t++ )
+    {
+    bounds[t] = ( nbOfPixels / nbOfThreads ) * t;
+    }
+  bounds[nbOfThreads] = nbOfPixels;
+
+  ThreadStruct str;
+  str.Values = &values;
+  str.Bounds = &bounds;
+  threader->SetSingleMethod( Self::SortThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  // and merge them
+  for( int step=1; step<nbOfThreads; step*=2 )
+    {
+    for( int t=0; t+step<nbOfThreads; t+=2*step )
+      {
+      std::inplace_merge( values.begin() + bounds[t],
+                          values.begin() + bounds[t+step],
+                          values.begin() + bounds[ std::min( t+2*step, nbOfThreads ) ] );
+      }
+    }
+
+  values.erase( std::unique( values.begin(), values.end() ), values.end() );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+RankTransformImageFilter<TInputImage, TOutputImage>
+::BeforeThreadedGenerateData()
+{
+  if( !m_ValuesProvided )
+    {
+    Self::ComputeValues( this->GetInput(), m_Values, this->GetNumberOfThreads() );
+    }
+  if( !m_Values.empty()
+      && m_Values.size() - 1 > static_cast< unsigned long >( NumericTraits< OutputImagePixelType >::max() ) )
+    {
+    itkExceptionMacro( << "The output pixel type can't store the " << m_Values.size() << " ranks of the image." );
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+RankTransformImageFilter<TInputImage, TOutputImage>
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, int threadId)
+{
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  ImageRegionConstIterator< InputImageType > inIt( this->GetInput(), outputRegionForThread );
+  ImageRegionIterator< OutputImageType > outIt( this->GetOutput(), outputRegionForThread );
+  for( inIt.GoToBegin(), outIt.GoToBegin(); !inIt.IsAtEnd(); ++inIt, ++outIt )
+    {
+    const InputImagePixelType & v = inIt.Get();
+    outIt.Set( static_cast< OutputImagePixelType >(
+      std::lower_bound( m_Values.begin(), m_Values.end(), v ) - m_Values.begin() ) );
+    progress.CompletedPixel();
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+RankTransformImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfRanks: "  << m_Values.size() << std::endl;
+  os << indent << "ValuesProvided: "  << m_ValuesProvided << std::endl;
+}
+  
+}// end namespace itk
+#endif
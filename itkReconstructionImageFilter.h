@@ -19,6 +19,7 @@
 
 #ifdef COPY
 #include "itkNeighborhoodAlgorithm.h"
+#include "itkConstantPadImageFilter.h"
 #endif
 
 namespace itk {
@@ -121,6 +122,21 @@ public:
   itkSetMacro(MarkerValue, typename TInputImage::PixelType);
   itkGetConstReferenceMacro(MarkerValue, typename TInputImage::PixelType);
 
+  /**
+   * Set/Get the maximum size, in bytes, of the padded copies of the marker
+   * and of the mask kept from one execution to the other. The padded mask is
+   * not computed again if the mask has not changed, and the buffers are
+   * reused by the next execution. Default is the maximum of unsigned long.
+   */
+  itkSetMacro(MaximumScratchSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumScratchSize, unsigned long);
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  unsigned long GetScratchSize() const;
+
+  /** Release the scratch memory kept from the last execution */
+  void ReleaseScratch();
+
  
 protected:
   ReconstructionImageFilter();
@@ -143,6 +159,7 @@ private:
   void operator=(const Self&); //purposely not implemented
   typename TInputImage::PixelType m_MarkerValue;
   bool                m_FullyConnected;
+  unsigned long       m_MaximumScratchSize;
 
 #ifdef FACES
   TCompare compare;
@@ -187,6 +204,12 @@ private:
 #endif
 
 #ifdef COPY
+  typedef typename itk::ConstantPadImageFilter<InputImageType, InputImageType> PadType;
+
+  // the padded copies, kept between the executions
+  typename PadType::Pointer m_MaskPad;
+  typename PadType::Pointer m_MarkerPad;
+
   typedef typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator<OutputImageType> FaceCalculatorType;
 
   typedef typename FaceCalculatorType::FaceListType FaceListType;
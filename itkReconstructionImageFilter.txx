@@ -10,7 +10,6 @@
 #include "itkConnectedComponentAlgorithm.h"
 
 #ifdef COPY
-#include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
 #endif
 #ifdef FACES
@@ -23,6 +22,46 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
 ::ReconstructionImageFilter()
 {
   m_FullyConnected = false;
+  m_MaximumScratchSize = NumericTraits< unsigned long >::max();
+#ifdef COPY
+  m_MaskPad = PadType::New();
+  m_MarkerPad = PadType::New();
+#endif
+}
+
+template <class TInputImage, class TOutputImage, class TCompare>
+unsigned long
+ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
+::GetScratchSize() const
+{
+  unsigned long size = 0;
+#ifdef COPY
+  const InputImageType * mask = m_MaskPad->GetOutput();
+  const InputImageType * marker = m_MarkerPad->GetOutput();
+  if( mask->GetBufferPointer() )
+    {
+    size += mask->GetPixelContainer()->Capacity() * sizeof( InputImagePixelType );
+    }
+  if( marker->GetBufferPointer() )
+    {
+    size += marker->GetPixelContainer()->Capacity() * sizeof( InputImagePixelType );
+    }
+#endif
+  return size;
+}
+
+template <class TInputImage, class TOutputImage, class TCompare>
+void
+ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
+::ReleaseScratch()
+{
+#ifdef COPY
+  // also drop the references to the inputs
+  m_MaskPad->SetInput( NULL );
+  m_MarkerPad->SetInput( NULL );
+  m_MaskPad->GetOutput()->ReleaseData();
+  m_MarkerPad->GetOutput()->ReleaseData();
+#endif
 }
 
 template <class TInputImage, class TOutputImage, class TCompare>
@@ -631,11 +670,12 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
 
 
 
-  // create padded versions of the marker image and the mask image
-  typedef typename itk::ConstantPadImageFilter<InputImageType, InputImageType> PadType;
-  
-  typename PadType::Pointer MaskPad = PadType::New();
-  typename PadType::Pointer MarkerPad = PadType::New();
+  // create padded versions of the marker image and the mask image. The
+  // filters are kept between the executions: the padded mask is reused as
+  // is when neither the mask nor the marker value have changed, and the
+  // buffers are reused otherwise
+  PadType * MaskPad = m_MaskPad;
+  PadType * MarkerPad = m_MarkerPad;
 
   ISizeType padSize;
   padSize.Fill( 1 );
@@ -649,6 +689,9 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
 
   MaskPad->SetInput(maskImage);
   MarkerPad->SetInput(markerImage);
+  // the padded marker is modified in place below, so it must be computed
+  // again
+  MarkerPad->Modified();
   MaskPad->Update();
   MarkerPad->Update();
 
@@ -829,7 +872,11 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
 
     /** graft the minipipeline output back into this filter's output */
     this->GraftOutput( crop->GetOutput() );
-  
+
+  if( this->GetScratchSize() > m_MaximumScratchSize )
+    {
+    this->ReleaseScratch();
+    }
 }
 #endif
 
@@ -842,6 +889,7 @@ ReconstructionImageFilter<TInputImage, TOutputImage, TCompare>
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "boundary value: " << m_MarkerValue << std::endl;
+  os << indent << "MaximumScratchSize: " << m_MaximumScratchSize << std::endl;
 }
 }
 #endif
@@ -19,6 +19,9 @@
 
 #include "itkImage.h"
 #include "itkImageToImageFilter.h"
+#include "itkImageCache.h"
+#include "vnl/vnl_vector.h"
+#include <vector>
 
 /** \class SignedMaurerDistanceMapImageFilter
  *
@@ -146,6 +149,31 @@ public:
   itkSetMacro(BackgroundValue, InputPixelType);
   itkGetConstReferenceMacro(BackgroundValue, InputPixelType);
 
+  /**
+   * Set/Get the maximum size, in bytes, of the rows buffers kept from one
+   * execution to the other. Each thread reuses its buffers for all the
+   * rows, and for the next executions. Default is the maximum of unsigned
+   * long.
+   */
+  itkSetMacro(MaximumScratchSize, unsigned long);
+  itkGetConstReferenceMacro(MaximumScratchSize, unsigned long);
+
+  /** Return the size, in bytes, of the scratch memory currently kept */
+  unsigned long GetScratchSize() const;
+
+  /** Release the scratch memory kept from the last execution */
+  void ReleaseScratch();
+
+  /**
+   * Set/Get the on-disk cache of the output. When it is set, the distance
+   * map is stored in the cache, and loaded from there instead of being
+   * computed again for an input with the same content and the same
+   * parameters, even in another process. Default is NULL: no cache.
+   * \sa ImageCache
+   */
+  itkSetObjectMacro(Cache, ImageCache);
+  itkGetObjectMacro(Cache, ImageCache);
+
 protected:
 
   SignedMaurerDistanceMapImageFilter();
@@ -166,7 +194,9 @@ private:
   SignedMaurerDistanceMapImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
   
-  void Voronoi( unsigned int, OutputIndexType );
+  typedef vnl_vector< OutputPixelType > RowBufferType;
+
+  void Voronoi( unsigned int, OutputIndexType, RowBufferType & g, RowBufferType & h );
   bool Remove( OutputPixelType, OutputPixelType, OutputPixelType, 
                OutputPixelType, OutputPixelType, OutputPixelType );
   
@@ -179,6 +209,14 @@ private:
   
   int      m_CurrentDimension;
 
+  unsigned long m_MaximumScratchSize;
+
+  // the row buffers of the threads
+  std::vector< RowBufferType > m_G;
+  std::vector< RowBufferType > m_H;
+
+  ImageCache::Pointer m_Cache;
+
 };
 
 } // end namespace itk
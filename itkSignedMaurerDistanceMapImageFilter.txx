@@ -26,6 +26,7 @@
 #include "itkProgressAccumulator.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_math.h"
+#include <sstream>
 
 //Simple functor to invert an image for Outside Danielsson distance map
 namespace itk
@@ -63,6 +64,8 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
                                          m_UseImageSpacing( false ),
                                          m_SquaredDistance( true )
 {
+  m_MaximumScratchSize = NumericTraits< unsigned long >::max();
+  m_Cache = NULL;
 }
 
 
@@ -107,8 +110,8 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
 
   // determine the actual number of pieces that will be generated
   typename TOutputImage::SizeType::SizeValueType range = requestedRegionSize[splitAxis];
-  int valuesPerThread = (int)::ceil(range/(double)num);
-  int maxThreadIdUsed = (int)::ceil(range/(double)valuesPerThread) - 1;
+  typename TOutputImage::SizeType::SizeValueType valuesPerThread = ( range + num - 1 ) / num;
+  int maxThreadIdUsed = (int)( ( range + valuesPerThread - 1 ) / valuesPerThread ) - 1;
 
   // Split the region
   if (i < maxThreadIdUsed)
@@ -138,6 +141,25 @@ void
 SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
 ::GenerateData()
 {
+  // the distance map may have been computed already, by this process or by
+  // another one
+  std::string cacheKey;
+  if( m_Cache )
+    {
+    std::ostringstream parameters;
+    parameters.precision( 17 );
+    parameters << static_cast<typename NumericTraits<InputPixelType>::PrintType>(m_BackgroundValue) << " "
+               << m_InsideIsPositive << " " << m_UseImageSpacing << " " << m_SquaredDistance << " "
+               << ChunkedVolumePixelTypeName< OutputPixelType >();
+    cacheKey = m_Cache->ComputeKey( "SignedMaurerDistanceMap", parameters.str(), this->GetInput() );
+    OutputImageType * output = this->GetOutput();
+    output->SetBufferedRegion( output->GetRequestedRegion() );
+    if( m_Cache->Load( cacheKey, output ) )
+      {
+      return;
+      }
+    }
+
   // prepare the data
   this->AllocateOutputs();
   this->m_Spacing = this->GetOutput()->GetSpacing();
@@ -186,12 +208,50 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
   this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
   this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
   
+  // the row buffers of the threads, kept from the previous execution
+  m_G.resize( this->GetNumberOfThreads() );
+  m_H.resize( this->GetNumberOfThreads() );
+
   // multithread the execution
   for( int d=0; d<ImageDimension; d++ )
     {
     m_CurrentDimension = d;
     this->GetMultiThreader()->SingleMethodExecute();
     }
+
+  if( this->GetScratchSize() > m_MaximumScratchSize )
+    {
+    this->ReleaseScratch();
+    }
+
+  if( m_Cache )
+    {
+    m_Cache->Store( cacheKey, this->GetOutput() );
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+unsigned long
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
+::GetScratchSize() const
+{
+  unsigned long size = 0;
+  for( unsigned int i=0; i<m_G.size(); i++ )
+    {
+    size += ( m_G[i].size() + m_H[i].size() ) * sizeof( OutputPixelType );
+    }
+  return size;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
+::ReleaseScratch()
+{
+  std::vector< RowBufferType >().swap( m_G );
+  std::vector< RowBufferType >().swap( m_H );
 }
 
 
@@ -201,7 +261,7 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, int threadId)
 {
 
-  vnl_vector<unsigned int> k(InputImageDimension-1);
+  vnl_vector<unsigned long> k(InputImageDimension-1);
 
   typedef typename InputImageType::RegionType   InputRegionType;
 
@@ -211,7 +271,7 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
   startIndex = outputRegionForThread.GetIndex();
 
   // compute the number of rows first, so we can setup a progress reporter
-  typename std::vector< unsigned int > NumberOfRows;
+  typename std::vector< unsigned long > NumberOfRows;
   unsigned long totalNumberOfRows = 0;
 
   for (unsigned int i = 0; i < InputImageDimension; i++)
@@ -252,23 +312,21 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
       }
     k.flip();
 
-    unsigned int index;
-    for (unsigned int n = 0; n < NumberOfRows[i];n++)
+    unsigned long index;
+    for (unsigned long n = 0; n < NumberOfRows[i];n++)
       {
       index = n;
       count = 0;
       for (unsigned int d = i+1; d < i+InputImageDimension; d++)
         {
-        idx[ d % InputImageDimension ] =
-             static_cast<unsigned int>(
-                 static_cast<double>( index ) /
-                 static_cast<double>( k[count] ) )
+        // an integer division: the double one is not exact above 2^53
+        idx[ d % InputImageDimension ] = index / k[count]
              + startIndex[ d % InputImageDimension ];
 
         index %= k[ count ];
         count++;
         }
-      this->Voronoi(i, idx);
+      this->Voronoi(i, idx, m_G[threadId], m_H[threadId]);
       progress->CompletedPixel();
       }
   delete progress;
@@ -332,10 +390,10 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
 template<class TInputImage, class TOutputImage>
 void
 SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
-::Voronoi(unsigned int d, OutputIndexType idx)
+::Voronoi(unsigned int d, OutputIndexType idx, RowBufferType & g, RowBufferType & h)
 {
   typename OutputImageType::Pointer output(this->GetOutput());
-  unsigned int nd = output->GetRequestedRegion().GetSize()[d];
+  const unsigned long nd = output->GetRequestedRegion().GetSize()[d];
 
   if( nd == 1 )
     {
@@ -343,17 +401,22 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
     return;
     }
 
-  vnl_vector<OutputPixelType> g(nd);  g = 0;
-  vnl_vector<OutputPixelType> h(nd);  h = 0;
+  // the buffers only grow: only their first values, written below, are
+  // read
+  if( g.size() < nd )
+    {
+    g.set_size( nd );
+    h.set_size( nd );
+    }
 
   typename InputImageType::RegionType::IndexType startIndex;
   startIndex = this->GetInput()->GetRequestedRegion().GetIndex();
 
   OutputPixelType di;
 
-  int l = -1;
+  long l = -1;
 
-  for( unsigned int i = 0; i < nd; i++ )
+  for( unsigned long i = 0; i < nd; i++ )
     {
     idx[d] = i + startIndex[d];
 
@@ -397,11 +460,11 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
     return;
     }
 
-  int ns = l;
+  long ns = l;
 
   l = 0;
 
-  for( unsigned int i = 0; i < nd; i++ )
+  for( unsigned long i = 0; i < nd; i++ )
     {
 
     OutputPixelType iw;
@@ -489,6 +552,10 @@ SignedMaurerDistanceMapImageFilter<TInputImage, TOutputImage>
      << this->m_UseImageSpacing << std::endl;
   os << indent << "Squared distance: "
      << this->m_SquaredDistance << std::endl;
+  os << indent << "Maximum scratch size: "
+     << this->m_MaximumScratchSize << std::endl;
+  os << indent << "Cache: "
+     << this->m_Cache.GetPointer() << std::endl;
 }
 
 } // end namespace itk
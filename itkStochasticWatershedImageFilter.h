@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStochasticWatershedImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStochasticWatershedImageFilter_h
+#define __itkStochasticWatershedImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkWatershedEdgeGraph.h"
+#include <vector>
+
+namespace itk {
+
+/** \class StochasticWatershedImageFilter
+ * \brief Compute the probability of the pixels to be on a watershed line
+ * with random markers
+ *
+ * The stochastic watershed floods the image many times, each time from a
+ * different set of markers placed uniformly at random, and counts how often
+ * each pixel is on the boundary between two regions. The output is that
+ * frequency, between 0 and 1.
+ *
+ * The image is not flooded again for each set of markers: the watershed
+ * with markers is the cut of the minimum spanning tree of the image, so the
+ * tree is computed once (see WatershedEdgeGraph), and each realization only
+ * walks along the tree edges, sorted by weight, with a union-find, and
+ * refuses the edges which would join two regions with a marker. This is
+ * almost linear in the number of pixels. The realizations are distributed
+ * over the threads, and each one uses its own random generator, seeded with
+ * Seed plus the number of the realization, so the result doesn't depend on
+ * the number of threads.
+ *
+ * The tree is kept between two updates as long as the input, the
+ * connectivity and the edge weight don't change, so changing the number of
+ * realizations or of markers doesn't compute it again.
+ *
+ * A pixel is on the boundary when one of its neighbors is in another
+ * region, so the boundaries are 2 pixels thick.
+ *
+ * See "The stochastic watershed", J. Angulo and D. Jeulin, ISMM 2007, and
+ * "Watershed Cuts: Minimum Spanning Forests and the Drop of Water
+ * Principle", J. Cousty, G. Bertrand, L. Najman and M. Couprie, IEEE
+ * PAMI, 2009.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter, WatershedEdgeGraph
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT StochasticWatershedImageFilter : 
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef StochasticWatershedImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  
+  /** ImageDimension constants */
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  typedef WatershedEdgeGraph< InputImageType > EdgeGraphType;
+  typedef typename EdgeGraphType::EdgeContainerType EdgeContainerType;
+  typedef typename EdgeGraphType::ConnectivityType ConnectivityType;
+
+  typedef enum {
+    MAXIMUM = EdgeGraphType::MAXIMUM,
+    ABSOLUTE_DIFFERENCE = EdgeGraphType::ABSOLUTE_DIFFERENCE
+  } EdgeWeightType;
+
+  /** Standard New method. */
+  itkNewMacro(Self);  
+
+  /** Runtime information support. */
+  itkTypeMacro(StochasticWatershedImageFilter, 
+               ImageToImageFilter);
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.  For objects that are 1 pixel wide, use
+   * FullyConnectedOn.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get the weight of the edges: the MAXIMUM of the two pixels, to use
+   * a gradient image, or their ABSOLUTE_DIFFERENCE, to use directly the
+   * intensity image. Default is MAXIMUM.
+   */
+  itkSetMacro(EdgeWeight, EdgeWeightType);
+  itkGetConstReferenceMacro(EdgeWeight, EdgeWeightType);
+
+  /** Set/Get the number of floodings. Default is 100. */
+  itkSetMacro(NumberOfRealizations, unsigned long);
+  itkGetConstReferenceMacro(NumberOfRealizations, unsigned long);
+
+  /** Set/Get the number of random markers in each flooding. Each marker is
+   * a single pixel. Default is 20. */
+  itkSetMacro(NumberOfMarkers, unsigned long);
+  itkGetConstReferenceMacro(NumberOfMarkers, unsigned long);
+
+  /** Set/Get the seed of the random generators. Default is 0. */
+  itkSetMacro(Seed, unsigned long);
+  itkGetConstReferenceMacro(Seed, unsigned long);
+
+protected:
+  StochasticWatershedImageFilter();
+  ~StochasticWatershedImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** StochasticWatershedImageFilter needs the entire input be
+   * available. Thus, it needs to provide an implementation of
+   * GenerateInputRequestedRegion(). */
+  void GenerateInputRequestedRegion() ;
+
+  /** StochasticWatershedImageFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+  
+  void GenerateData();
+
+  /** Compute the minimum spanning tree, if the input has changed */
+  void ComputeTree();
+
+  /** data shared by the threads */
+  struct ThreadStruct
+    {
+    Self * Filter;
+    };
+
+  static ITK_THREAD_RETURN_TYPE RealizationsThreaderCallback( void * arg );
+
+  /** Run the realizations of a thread, and accumulate the boundaries in
+   * m_Counts[threadId] */
+  void ThreadedRealizations( int threadId, int nbOfThreads );
+
+private:
+  StochasticWatershedImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  bool m_FullyConnected;
+  EdgeWeightType m_EdgeWeight;
+  unsigned long m_NumberOfRealizations;
+  unsigned long m_NumberOfMarkers;
+  unsigned long m_Seed;
+
+  // the tree, and what it has been computed with
+  typename EdgeGraphType::Pointer m_Graph;
+  EdgeContainerType m_Tree;
+  EdgeContainerType m_RasterEdges;
+  unsigned long m_TreeInputMTime;
+  bool m_TreeFullyConnected;
+  EdgeWeightType m_TreeEdgeWeight;
+
+  std::vector< std::vector< unsigned long > > m_Counts;
+
+} ; // end of class
+
+} // end namespace itk
+  
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStochasticWatershedImageFilter.txx"
+#endif
+
+#endif
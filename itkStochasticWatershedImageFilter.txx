@@ -0,0 +1,268 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStochasticWatershedImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStochasticWatershedImageFilter_txx
+#define __itkStochasticWatershedImageFilter_txx
+
+#include "itkStochasticWatershedImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+#include "vnl/vnl_random.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::StochasticWatershedImageFilter()
+{
+  m_FullyConnected = false;
+  m_EdgeWeight = MAXIMUM;
+  m_NumberOfRealizations = 100;
+  m_NumberOfMarkers = 20;
+  m_Seed = 0;
+  m_TreeInputMTime = 0;
+  m_TreeFullyConnected = false;
+  m_TreeEdgeWeight = MAXIMUM;
+}
+
+template <class TInputImage, class TOutputImage>
+void 
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+  
+  // We need all the input.
+  InputImagePointer input = const_cast<InputImageType *>(this->GetInput());
+  if ( !input )
+    { return; }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void 
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+    ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::ComputeTree()
+{
+  const InputImageType * input = this->GetInput();
+  if( m_Graph && m_Graph->GetInput() == input && m_TreeInputMTime == input->GetMTime()
+      && m_TreeFullyConnected == m_FullyConnected && m_TreeEdgeWeight == m_EdgeWeight )
+    {
+    // the tree is still valid
+    return;
+    }
+
+  typename ConnectivityType::Pointer connectivity = ConnectivityType::New();
+  connectivity->SetFullyConnected( m_FullyConnected );
+
+  m_Graph = EdgeGraphType::New();
+  m_Graph->SetInput( input );
+  m_Graph->SetConnectivity( connectivity );
+  m_Graph->SetEdgeWeight( static_cast< typename EdgeGraphType::EdgeWeightType >( m_EdgeWeight ) );
+  m_Graph->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_Graph->Build();
+  const EdgeContainerType & edges = m_Graph->GetEdges();
+
+  // Kruskal: keep the edges which join two trees
+  const unsigned long nbOfPixels = input->GetBufferedRegion().GetNumberOfPixels();
+  WatershedUnionFind sets( nbOfPixels );
+  m_Tree.clear();
+  m_Tree.reserve( nbOfPixels );
+  for( typename EdgeContainerType::const_iterator it=edges.begin(); it!=edges.end(); it++ )
+    {
+    unsigned long p, q;
+    m_Graph->GetPixels( *it, p, q );
+    unsigned long rp = sets.Find( p );
+    unsigned long rq = sets.Find( q );
+    if( rp != rq )
+      {
+      sets.Union( rp, rq );
+      m_Tree.push_back( *it );
+      }
+    }
+
+  // the edges in raster order, to find the boundaries
+  m_RasterEdges = edges;
+  std::sort( m_RasterEdges.begin(), m_RasterEdges.end() );
+  m_Graph->Clear();
+
+  m_TreeInputMTime = input->GetMTime();
+  m_TreeFullyConnected = m_FullyConnected;
+  m_TreeEdgeWeight = m_EdgeWeight;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  // Allocate the output
+  this->AllocateOutputs();
+  OutputImageType * output = this->GetOutput();
+
+  this->ComputeTree();
+
+  long nbOfThreads = this->GetNumberOfThreads();
+  if( itk::MultiThreader::GetGlobalMaximumNumberOfThreads() != 0 )
+    {
+    nbOfThreads = std::min( this->GetNumberOfThreads(), itk::MultiThreader::GetGlobalMaximumNumberOfThreads() );
+    }
+  nbOfThreads = std::max( 1L, std::min( nbOfThreads, (long)m_NumberOfRealizations ) );
+
+  m_Counts.clear();
+  m_Counts.resize( nbOfThreads );
+
+  ThreadStruct str;
+  str.Filter = this;
+  MultiThreader * threader = this->GetMultiThreader();
+  threader->SetNumberOfThreads( nbOfThreads );
+  threader->SetSingleMethod( Self::RealizationsThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  // sum the counts of the threads, and compute the frequency
+  const unsigned long nbOfPixels = output->GetBufferedRegion().GetNumberOfPixels();
+  OutputImagePixelType * buffer = output->GetBufferPointer();
+  const double nbOfRealizations = std::max( m_NumberOfRealizations, 1UL );
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    unsigned long count = 0;
+    for( unsigned int t=0; t<m_Counts.size(); t++ )
+      {
+      if( !m_Counts[t].empty() )
+        {
+        count += m_Counts[t][p];
+        }
+      }
+    buffer[p] = static_cast< OutputImagePixelType >( count / nbOfRealizations );
+    }
+  m_Counts.clear();
+}
+
+
+template<class TInputImage, class TOutputImage>
+ITK_THREAD_RETURN_TYPE
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::RealizationsThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+  str->Filter->ThreadedRealizations( info->ThreadID, info->NumberOfThreads );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::ThreadedRealizations( int threadId, int nbOfThreads )
+{
+  const unsigned long nbOfPixels = this->GetInput()->GetBufferedRegion().GetNumberOfPixels();
+  if( nbOfPixels == 0 || threadId >= (int)m_Counts.size() )
+    { return; }
+
+  ProgressReporter progress( this, threadId, ( m_NumberOfRealizations + nbOfThreads - 1 - threadId ) / nbOfThreads );
+
+  std::vector< unsigned long > & counts = m_Counts[threadId];
+  counts.assign( nbOfPixels, 0 );
+  WatershedUnionFind sets;
+  std::vector< bool > marked;
+  std::vector< bool > boundary;
+  std::vector< unsigned long > roots( nbOfPixels );
+
+  for( unsigned long r=threadId; r<m_NumberOfRealizations; r+=nbOfThreads )
+    {
+    // the random markers
+    vnl_random random( m_Seed + r );
+    sets.Initialize( nbOfPixels );
+    marked.assign( nbOfPixels, false );
+    for( unsigned long m=0; m<m_NumberOfMarkers; m++ )
+      {
+      unsigned long p = static_cast< unsigned long >( random.drand64() * nbOfPixels );
+      marked[ std::min( p, nbOfPixels - 1 ) ] = true;
+      }
+
+    // cut the tree: the regions with a marker are never joined. The marker
+    // flag is kept on the root of the regions.
+    for( typename EdgeContainerType::const_iterator it=m_Tree.begin(); it!=m_Tree.end(); it++ )
+      {
+      unsigned long p, q;
+      m_Graph->GetPixels( *it, p, q );
+      unsigned long rp = sets.Find( p );
+      unsigned long rq = sets.Find( q );
+      if( marked[rp] && marked[rq] )
+        { continue; }
+      bool m = marked[rp] || marked[rq];
+      marked[ sets.Union( rp, rq ) ] = m;
+      }
+
+    // find the boundaries
+    for( unsigned long p=0; p<nbOfPixels; p++ )
+      {
+      roots[p] = sets.Find( p );
+      }
+    boundary.assign( nbOfPixels, false );
+    for( typename EdgeContainerType::const_iterator it=m_RasterEdges.begin(); it!=m_RasterEdges.end(); it++ )
+      {
+      unsigned long p, q;
+      m_Graph->GetPixels( *it, p, q );
+      if( roots[p] != roots[q] )
+        {
+        boundary[p] = true;
+        boundary[q] = true;
+        }
+      }
+    for( unsigned long p=0; p<nbOfPixels; p++ )
+      {
+      if( boundary[p] )
+        {
+        counts[p]++;
+        }
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StochasticWatershedImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "EdgeWeight: "  << m_EdgeWeight << std::endl;
+  os << indent << "NumberOfRealizations: "  << m_NumberOfRealizations << std::endl;
+  os << indent << "NumberOfMarkers: "  << m_NumberOfMarkers << std::endl;
+  os << indent << "Seed: "  << m_Seed << std::endl;
+}
+  
+}// end namespace itk
+#endif
@@ -0,0 +1,249 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStreamingImageToLabelMapFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStreamingImageToLabelMapFilter_h
+#define __itkStreamingImageToLabelMapFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkLabelMap.h"
+#include "itkLabelObject.h"
+#include "itkNumericTraits.h"
+#include <vector>
+#include <deque>
+
+namespace itk {
+
+/** \class StreamingImageToLabelMapFilter
+ * \brief Convert a label image or a binary image to a label map, slab by
+ * slab
+ *
+ * LabelImageToLabelMapFilter and BinaryImageToLabelMapFilter need the whole
+ * input image in memory. This filter streams its input instead: it
+ * requests the input slab by slab along the last dimension, like
+ * StreamingImageFilter, and encodes the runs of each slab in the output
+ * label map before requesting the next one. With an ImageFileReader with
+ * UseStreaming on, and a file format able to stream, like MetaImage, only
+ * one slab of the image is in memory in addition to the label map. The
+ * other filters of the pipeline, a BinaryThresholdImageFilter for example,
+ * also only process one slab at a time. When the input can't stream and
+ * produces the whole image, the whole image is encoded at once.
+ *
+ * With Binary off, the input is a label image: the labels are the values
+ * of the input pixels, and the pixels with the BackgroundValue are not
+ * part of an object, like with LabelImageToLabelMapFilter.
+ *
+ * With Binary on, the objects are the connected components of the pixels
+ * with the ForegroundValue, like with BinaryImageToLabelMapFilter, and have
+ * the same labels. The runs of a slab are connected to the ones of the
+ * previous plane, which is kept from one slab to the other, and the labels
+ * of the connected runs are merged with a union-find. The lines of the
+ * runs are grouped by component as they are merged, so no line is copied
+ * to build the objects at the end.
+ *
+ * NumberOfStreamDivisions sets the number of slabs. It is limited by the
+ * size of the image along the last dimension.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa StreamingLabelMapToImageFilter, LabelImageToLabelMapFilter, BinaryImageToLabelMapFilter, StreamingImageFilter
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TOutputImage=LabelMap< LabelObject< typename TInputImage::PixelType, TInputImage::ImageDimension > > >
+class ITK_EXPORT StreamingImageToLabelMapFilter :
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef StreamingImageToLabelMapFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename InputImageType::IndexType       IndexType;
+  typedef typename InputImageType::OffsetType      OffsetType;
+
+  typedef typename OutputImageType::Pointer         OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer    OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType      OutputImageRegionType;
+  typedef typename OutputImageType::PixelType       OutputImagePixelType;
+  typedef typename OutputImageType::LabelObjectType LabelObjectType;
+  typedef typename LabelObjectType::LineType          LineType;
+  typedef typename LabelObjectType::LineContainerType LineContainerType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(StreamingImageToLabelMapFilter,
+               ImageToImageFilter);
+
+  /**
+   * Set/Get the number of slabs requested to the input. Default is 10.
+   */
+  itkSetClampMacro(NumberOfStreamDivisions, unsigned long, 1, NumericTraits<unsigned long>::max());
+  itkGetConstReferenceMacro(NumberOfStreamDivisions, unsigned long);
+
+  /**
+   * Set/Get whether the input is a binary image, which connected components
+   * are the objects, or a label image. Default is false.
+   */
+  itkSetMacro(Binary, bool);
+  itkGetConstReferenceMacro(Binary, bool);
+  itkBooleanMacro(Binary);
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.  For objects that are 1 pixel wide, use
+   * FullyConnectedOn. Only used with Binary on.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set/Get the value used as "background" in the output image, and, with
+   * Binary off, in the input image.
+   * Defaults to NumericTraits<PixelType>::NonpositiveMin().
+   */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetConstMacro(BackgroundValue, OutputImagePixelType);
+
+  /**
+   * Set/Get the value of the objects in the binary input image. Only used
+   * with Binary on. Defaults to NumericTraits<PixelType>::max().
+   */
+  itkSetMacro(ForegroundValue, InputImagePixelType);
+  itkGetConstMacro(ForegroundValue, InputImagePixelType);
+
+  /** Return the number of objects found in the binary image during the last
+   * update */
+  itkGetConstReferenceMacro(ObjectCount, unsigned long);
+
+  /** Request the input slab by slab, instead of running the standard
+   * pipeline execution. */
+  virtual void UpdateOutputData(DataObject *output);
+
+  /** Don't propagate the requested region to the input: the slabs are
+   * requested by UpdateOutputData(). */
+  virtual void PropagateRequestedRegion(DataObject *output);
+
+protected:
+  StreamingImageToLabelMapFilter();
+  ~StreamingImageToLabelMapFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** StreamingImageToLabelMapFilter will produce the entire output. */
+  void EnlargeOutputRequestedRegion(DataObject *itkNotUsed(output));
+
+  /** Encode the runs of a slab of the input in the output */
+  void EncodeSlab( const InputImageRegionType & slab );
+
+  /** Encode the runs of a line of the binary input, and connect them to the
+   * runs of the previous lines */
+  void EncodeBinaryLine( const InputImagePixelType * line, const IndexType & idx, unsigned long length );
+
+  /** Build the objects from the connected runs */
+  void CreateObjects();
+
+  /** Compute the offsets to the previous neighbor lines, in the plane
+   * coordinates */
+  void SetupLineOffsets();
+
+  /** The union-find of the labels of the runs */
+  unsigned long LookupSet( unsigned long label );
+  void LinkLabels( unsigned long label1, unsigned long label2 );
+
+  /** Compare the lines in the raster order */
+  static bool LineIsBefore( const LineType & a, const LineType & b )
+    {
+    for( int d=ImageDimension-1; d>=0; d-- )
+      {
+      if( a.GetIndex()[d] != b.GetIndex()[d] )
+        {
+        return a.GetIndex()[d] < b.GetIndex()[d];
+        }
+      }
+    return false;
+    }
+
+  /** a run of the binary image, with the label of its connected component */
+  struct RunType
+    {
+    long Begin;
+    long End;
+    unsigned long Label;
+    };
+  typedef std::vector< RunType > RunLineType;
+
+private:
+  StreamingImageToLabelMapFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  unsigned long m_NumberOfStreamDivisions;
+
+  bool m_Binary;
+
+  bool m_FullyConnected;
+
+  OutputImagePixelType m_BackgroundValue;
+
+  InputImagePixelType m_ForegroundValue;
+
+  unsigned long m_ObjectCount;
+
+  // the union-find of the run labels, and the lines of each set, stored in
+  // its root
+  std::vector< unsigned long > m_UnionFind;
+  std::deque< LineContainerType > m_Lines;
+
+  // the runs of the lines of the current plane and of the previous one,
+  // along the last dimension
+  std::vector< RunLineType > m_CurrentPlane;
+  std::vector< RunLineType > m_PreviousPlane;
+  long m_CurrentPlaneIndex;
+
+  // the offsets of the previous neighbor lines, along the dimensions 1 to
+  // ImageDimension-1
+  std::vector< OffsetType > m_LineOffsets;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStreamingImageToLabelMapFilter.txx"
+#endif
+
+#endif
+
+
@@ -0,0 +1,518 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStreamingImageToLabelMapFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStreamingImageToLabelMapFilter_txx
+#define __itkStreamingImageToLabelMapFilter_txx
+
+#include "itkStreamingImageToLabelMapFilter.h"
+#include "itkNumericTraits.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::StreamingImageToLabelMapFilter()
+{
+  m_NumberOfStreamDivisions = 10;
+  m_Binary = false;
+  m_FullyConnected = false;
+  m_BackgroundValue = NumericTraits<OutputImagePixelType>::NonpositiveMin();
+  m_ForegroundValue = NumericTraits<InputImagePixelType>::max();
+  m_ObjectCount = 0;
+  m_CurrentPlaneIndex = 0;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+    ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::PropagateRequestedRegion(DataObject *output)
+{
+  // the input requested region is set by UpdateOutputData(), for each slab
+  if( this->m_Updating )
+    {
+    return;
+    }
+  this->EnlargeOutputRequestedRegion( output );
+  this->GenerateOutputRequestedRegion( output );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::UpdateOutputData(DataObject *itkNotUsed(output))
+{
+  // prevent chasing our tail
+  if( this->m_Updating )
+    {
+    return;
+    }
+
+  // Prepare all the outputs. This may deallocate previous bulk data.
+  this->PrepareOutputs();
+
+  if( this->GetNumberOfValidRequiredInputs() < this->GetNumberOfRequiredInputs() )
+    {
+    itkExceptionMacro(<< "At least " << this->GetNumberOfRequiredInputs() << " inputs are required but only " << this->GetNumberOfValidRequiredInputs() << " are specified.");
+    }
+
+  this->SetAbortGenerateData( 0 );
+  this->SetProgress( 0.0 );
+  this->m_Updating = true;
+  this->InvokeEvent( StartEvent() );
+
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  OutputImageType * output = this->GetOutput();
+  output->SetBufferedRegion( output->GetLargestPossibleRegion() );
+  output->Allocate();
+  output->SetBackgroundValue( m_BackgroundValue );
+
+  m_ObjectCount = 0;
+  if( m_Binary )
+    {
+    this->SetupLineOffsets();
+    }
+
+  try
+    {
+    // the slabs are along the last dimension
+    const unsigned int last = ImageDimension - 1;
+    const InputImageRegionType largest = input->GetLargestPossibleRegion();
+    const unsigned long nbOfSlabs = std::min( m_NumberOfStreamDivisions, (unsigned long)largest.GetSize()[last] );
+    for( unsigned long s=0; s<nbOfSlabs && !this->GetAbortGenerateData(); s++ )
+      {
+      InputImageRegionType slab = largest;
+      const unsigned long begin = largest.GetSize()[last] * s / nbOfSlabs;
+      const unsigned long end = largest.GetSize()[last] * ( s + 1 ) / nbOfSlabs;
+      IndexType slabIndex = largest.GetIndex();
+      typename InputImageRegionType::SizeType slabSize = largest.GetSize();
+      slabIndex[last] += begin;
+      slabSize[last] = end - begin;
+      slab.SetIndex( slabIndex );
+      slab.SetSize( slabSize );
+
+      input->SetRequestedRegion( slab );
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+
+      // an input which can't stream produces the whole image: encode all
+      // the rest of the image at once, instead of producing it again for
+      // each slab
+      if( input->GetBufferedRegion().IsInside( largest ) )
+        {
+        slabSize[last] = largest.GetSize()[last] - begin;
+        slab.SetSize( slabSize );
+        this->EncodeSlab( slab );
+        break;
+        }
+
+      this->EncodeSlab( slab );
+      this->UpdateProgress( ( s + 1.0f ) / nbOfSlabs );
+      }
+
+    if( m_Binary )
+      {
+      this->CreateObjects();
+      }
+    }
+  catch( ... )
+    {
+    m_UnionFind.clear();
+    m_Lines.clear();
+    m_CurrentPlane.clear();
+    m_PreviousPlane.clear();
+    this->m_Updating = false;
+    throw;
+    }
+
+  if( !this->GetAbortGenerateData() )
+    {
+    this->UpdateProgress( 1.0 );
+    }
+
+  this->InvokeEvent( EndEvent() );
+
+  // Mark the output as up to date
+  for( unsigned int idx=0; idx<this->GetNumberOfOutputs(); ++idx )
+    {
+    if( this->GetOutput( idx ) )
+      {
+      this->GetOutput( idx )->DataHasBeenGenerated();
+      }
+    }
+
+  // Release upstream data if requested
+  if( input->ShouldIReleaseData() )
+    {
+    input->ReleaseData();
+    }
+
+  this->m_Updating = false;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::EncodeSlab( const InputImageRegionType & slab )
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+
+  const unsigned long xsize = slab.GetSize()[0];
+  if( xsize == 0 )
+    {
+    return;
+    }
+  const unsigned long nbOfLines = slab.GetNumberOfPixels() / xsize;
+
+  IndexType idx = slab.GetIndex();
+  for( unsigned long l=0; l<nbOfLines; l++ )
+    {
+    const InputImagePixelType * line = input->GetBufferPointer() + input->ComputeOffset( idx );
+
+    if( m_Binary )
+      {
+      this->EncodeBinaryLine( line, idx, xsize );
+      }
+    else
+      {
+      unsigned long x = 0;
+      while( x < xsize )
+        {
+        const InputImagePixelType & v = line[x];
+        if( v != m_BackgroundValue )
+          {
+          // We've hit the start of a run
+          IndexType runIdx = idx;
+          runIdx[0] += x;
+          unsigned long length = 1;
+          x++;
+          while( x < xsize && line[x] == v )
+            {
+            length++;
+            x++;
+            }
+          output->SetLine( runIdx, length, v );
+          }
+        else
+          {
+          x++;
+          }
+        }
+      }
+
+    // the next line
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      idx[d]++;
+      if( idx[d] < slab.GetIndex()[d] + (long)slab.GetSize()[d] )
+        {
+        break;
+        }
+      idx[d] = slab.GetIndex()[d];
+      }
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::SetupLineOffsets()
+{
+  const InputImageRegionType & largest = this->GetInput()->GetLargestPossibleRegion();
+  const unsigned int last = ImageDimension - 1;
+
+  // the lines of a plane are indexed by their position along the dimensions
+  // 1 to ImageDimension-2
+  unsigned long nbOfLinesPerPlane = 1;
+  for( unsigned int d=1; d<last; d++ )
+    {
+    nbOfLinesPerPlane *= largest.GetSize()[d];
+    }
+  m_CurrentPlane.clear();
+  m_PreviousPlane.clear();
+  m_CurrentPlane.resize( nbOfLinesPerPlane );
+  m_PreviousPlane.resize( nbOfLinesPerPlane );
+  m_CurrentPlaneIndex = largest.GetIndex()[last] - 1;
+
+  m_UnionFind.clear();
+  m_Lines.clear();
+
+  // the lines visited before the current one which may touch it: the last
+  // non zero coordinate is negative, and only one coordinate is not zero
+  // with the face connectivity
+  m_LineOffsets.clear();
+  if( ImageDimension < 2 )
+    {
+    return;
+    }
+  OffsetType o;
+  o.Fill( -1 );
+  o[0] = 0;
+  for(;;)
+    {
+    int lastNonZero = last;
+    while( lastNonZero > 0 && o[lastNonZero] == 0 )
+      {
+      lastNonZero--;
+      }
+    unsigned int nbOfNonZero = 0;
+    for( unsigned int d=1; d<ImageDimension; d++ )
+      {
+      nbOfNonZero += o[d] != 0;
+      }
+    if( lastNonZero > 0 && o[lastNonZero] < 0 && ( m_FullyConnected || nbOfNonZero == 1 ) )
+      {
+      m_LineOffsets.push_back( o );
+      }
+
+    // the next offset
+    unsigned int d = 1;
+    while( d < ImageDimension && o[d] == 1 )
+      {
+      o[d] = -1;
+      d++;
+      }
+    if( d == ImageDimension )
+      {
+      break;
+      }
+    o[d]++;
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::EncodeBinaryLine( const InputImagePixelType * line, const IndexType & idx, unsigned long length )
+{
+  const InputImageRegionType & largest = this->GetInput()->GetLargestPossibleRegion();
+  const unsigned int last = ImageDimension - 1;
+
+  // a new plane: the current one becomes the previous one
+  if( idx[last] != m_CurrentPlaneIndex )
+    {
+    m_PreviousPlane.swap( m_CurrentPlane );
+    for( unsigned long l=0; l<m_CurrentPlane.size(); l++ )
+      {
+      m_CurrentPlane[l].clear();
+      }
+    m_CurrentPlaneIndex = idx[last];
+    }
+
+  unsigned long lineInPlane = 0;
+  unsigned long stride = 1;
+  for( unsigned int d=1; d<last; d++ )
+    {
+    lineInPlane += ( idx[d] - largest.GetIndex()[d] ) * stride;
+    stride *= largest.GetSize()[d];
+    }
+  RunLineType & runs = m_CurrentPlane[lineInPlane];
+
+  // encode the runs, each one in its own set
+  unsigned long x = 0;
+  while( x < length )
+    {
+    if( line[x] == m_ForegroundValue )
+      {
+      RunType run;
+      run.Begin = idx[0] + x;
+      x++;
+      while( x < length && line[x] == m_ForegroundValue )
+        {
+        x++;
+        }
+      run.End = idx[0] + x - 1;
+      run.Label = m_UnionFind.size();
+      m_UnionFind.push_back( run.Label );
+      IndexType runIdx = idx;
+      runIdx[0] = run.Begin;
+      m_Lines.push_back( LineContainerType() );
+      m_Lines.back().push_back( LineType( runIdx, run.End - run.Begin + 1 ) );
+      runs.push_back( run );
+      }
+    else
+      {
+      x++;
+      }
+    }
+  if( runs.empty() )
+    {
+    return;
+    }
+
+  // connect them to the runs of the previous lines
+  const long extension = m_FullyConnected ? 1 : 0;
+  for( unsigned int o=0; o<m_LineOffsets.size(); o++ )
+    {
+    const OffsetType & offset = m_LineOffsets[o];
+    bool isInside = true;
+    unsigned long neighborLine = 0;
+    stride = 1;
+    for( unsigned int d=1; d<last && isInside; d++ )
+      {
+      const long c = idx[d] + offset[d];
+      isInside = c >= largest.GetIndex()[d] && c < largest.GetIndex()[d] + (long)largest.GetSize()[d];
+      neighborLine += ( c - largest.GetIndex()[d] ) * stride;
+      stride *= largest.GetSize()[d];
+      }
+    if( !isInside || ( offset[last] < 0 && idx[last] == largest.GetIndex()[last] ) )
+      {
+      continue;
+      }
+    const RunLineType & neighbors = offset[last] < 0 ? m_PreviousPlane[neighborLine] : m_CurrentPlane[neighborLine];
+
+    // both lines are sorted
+    unsigned long first = 0;
+    for( typename RunLineType::const_iterator it=runs.begin(); it!=runs.end(); it++ )
+      {
+      while( first < neighbors.size() && neighbors[first].End < it->Begin - extension )
+        {
+        first++;
+        }
+      for( unsigned long n=first; n<neighbors.size() && neighbors[n].Begin <= it->End + extension; n++ )
+        {
+        this->LinkLabels( it->Label, neighbors[n].Label );
+        }
+      }
+    }
+}
+
+
+template <class TInputImage, class TOutputImage>
+unsigned long
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::LookupSet( unsigned long label )
+{
+  unsigned long root = label;
+  while( m_UnionFind[root] != root )
+    {
+    root = m_UnionFind[root];
+    }
+  // compress the path
+  while( m_UnionFind[label] != root )
+    {
+    const unsigned long next = m_UnionFind[label];
+    m_UnionFind[label] = root;
+    label = next;
+    }
+  return root;
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::LinkLabels( unsigned long label1, unsigned long label2 )
+{
+  unsigned long root1 = this->LookupSet( label1 );
+  unsigned long root2 = this->LookupSet( label2 );
+  if( root1 == root2 )
+    {
+    return;
+    }
+  // the smallest label is the root, like in BinaryImageToLabelMapFilter, so
+  // the objects get the same labels
+  if( root2 < root1 )
+    {
+    std::swap( root1, root2 );
+    }
+  m_UnionFind[root2] = root1;
+
+  // move the lines of the smallest set in the largest one
+  if( m_Lines[root2].size() > m_Lines[root1].size() )
+    {
+    m_Lines[root1].swap( m_Lines[root2] );
+    }
+  m_Lines[root1].insert( m_Lines[root1].end(), m_Lines[root2].begin(), m_Lines[root2].end() );
+  LineContainerType().swap( m_Lines[root2] );
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::CreateObjects()
+{
+  OutputImageType * output = this->GetOutput();
+
+  unsigned long label = 0;
+  for( unsigned long l=0; l<m_UnionFind.size(); l++ )
+    {
+    if( m_UnionFind[l] != l )
+      {
+      continue;
+      }
+    if( label == static_cast< unsigned long >( m_BackgroundValue ) )
+      {
+      label++;
+      }
+    if( label > static_cast< unsigned long >( NumericTraits< OutputImagePixelType >::max() ) )
+      {
+      itkExceptionMacro( << "Number of objects greater than maximum of output pixel type " );
+      }
+
+    // the merged sets have their lines in no particular order
+    LineContainerType & lines = m_Lines[l];
+    std::sort( lines.begin(), lines.end(), Self::LineIsBefore );
+
+    typename LabelObjectType::Pointer labelObject = LabelObjectType::New();
+    labelObject->SetLabel( static_cast< OutputImagePixelType >( label ) );
+    labelObject->GetLineContainer().swap( lines );
+    output->AddLabelObject( labelObject );
+    label++;
+    m_ObjectCount++;
+    }
+
+  m_UnionFind.clear();
+  m_Lines.clear();
+  m_CurrentPlane.clear();
+  m_PreviousPlane.clear();
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingImageToLabelMapFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfStreamDivisions: "  << m_NumberOfStreamDivisions << std::endl;
+  os << indent << "Binary: "  << m_Binary << std::endl;
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "ForegroundValue: "  << static_cast<typename NumericTraits<InputImagePixelType>::PrintType>(m_ForegroundValue) << std::endl;
+  os << indent << "ObjectCount: "  << m_ObjectCount << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStreamingLabelMapToImageFilter.h,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStreamingLabelMapToImageFilter_h
+#define __itkStreamingLabelMapToImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkNumericTraits.h"
+
+namespace itk {
+
+/** \class StreamingLabelMapToImageFilter
+ * \brief Convert a label map to a label image or a binary image, only in
+ * the requested region
+ *
+ * LabelMapToLabelImageFilter and LabelMapToBinaryImageFilter always
+ * produce the whole output image. This filter only produces the requested
+ * region of its output, so an ImageFileWriter with several stream divisions
+ * and a file format able to stream, like MetaImage, writes the label map
+ * slab by slab, with only one slab of the image in memory in addition to
+ * the label map.
+ *
+ * The objects in the requested region are found with the spatial index of
+ * the label map, so a slab only visits the lines of the objects it
+ * intersects, and the lines are cropped to the slab.
+ *
+ * With Binary off, the pixels of the objects are set to their label, and
+ * the other pixels to the background value of the label map. With Binary
+ * on, they are set to ForegroundValue and BackgroundValue.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa StreamingImageToLabelMapFilter, LabelMapToLabelImageFilter, LabelMapToBinaryImageFilter, LabelMapSpatialIndex
+ * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
+ */
+template<class TInputImage, class TOutputImage>
+class ITK_EXPORT StreamingLabelMapToImageFilter :
+    public ImageToImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  typedef StreamingLabelMapToImageFilter Self;
+  typedef ImageToImageFilter<TInputImage, TOutputImage>
+  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Some convenient typedefs. */
+  typedef TInputImage InputImageType;
+  typedef TOutputImage OutputImageType;
+  typedef typename InputImageType::Pointer         InputImagePointer;
+  typedef typename InputImageType::ConstPointer    InputImageConstPointer;
+  typedef typename InputImageType::RegionType      InputImageRegionType;
+  typedef typename InputImageType::PixelType       InputImagePixelType;
+  typedef typename InputImageType::LabelObjectType LabelObjectType;
+
+  typedef typename OutputImageType::Pointer        OutputImagePointer;
+  typedef typename OutputImageType::ConstPointer   OutputImageConstPointer;
+  typedef typename OutputImageType::RegionType     OutputImageRegionType;
+  typedef typename OutputImageType::PixelType      OutputImagePixelType;
+  typedef typename OutputImageType::IndexType      IndexType;
+
+  /** ImageDimension constants */
+  itkStaticConstMacro(InputImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+  itkStaticConstMacro(OutputImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TOutputImage::ImageDimension);
+
+  /** Standard New method. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(StreamingLabelMapToImageFilter,
+               ImageToImageFilter);
+
+  /**
+   * Set/Get whether a binary image is produced instead of a label image.
+   * Default is false.
+   */
+  itkSetMacro(Binary, bool);
+  itkGetConstReferenceMacro(Binary, bool);
+  itkBooleanMacro(Binary);
+
+  /**
+   * Set/Get the value used as "background" in the binary output image.
+   * Defaults to NumericTraits<PixelType>::NonpositiveMin().
+   */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetConstMacro(BackgroundValue, OutputImagePixelType);
+
+  /**
+   * Set/Get the value used as "foreground" in the binary output image.
+   * Defaults to NumericTraits<PixelType>::max().
+   */
+  itkSetMacro(ForegroundValue, OutputImagePixelType);
+  itkGetConstMacro(ForegroundValue, OutputImagePixelType);
+
+protected:
+  StreamingLabelMapToImageFilter();
+  ~StreamingLabelMapToImageFilter() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** The label map is not streamed: the whole input is requested, whatever
+   * the requested region of the output. */
+  void GenerateInputRequestedRegion() ;
+
+  /** Produce the requested region of the output */
+  void GenerateData();
+
+private:
+  StreamingLabelMapToImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  bool m_Binary;
+
+  OutputImagePixelType m_BackgroundValue;
+
+  OutputImagePixelType m_ForegroundValue;
+
+} ; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStreamingLabelMapToImageFilter.txx"
+#endif
+
+#endif
+
+
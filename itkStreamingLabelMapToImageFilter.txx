@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkStreamingLabelMapToImageFilter.txx,v $
+  Language:  C++
+  Date:      $Date: 2005/08/23 15:09:03 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkStreamingLabelMapToImageFilter_txx
+#define __itkStreamingLabelMapToImageFilter_txx
+
+#include "itkStreamingLabelMapToImageFilter.h"
+#include "itkNumericTraits.h"
+#include "itkProgressReporter.h"
+#include "itkImageRegionIterator.h"
+#include <algorithm>
+
+namespace itk {
+
+template <class TInputImage, class TOutputImage>
+StreamingLabelMapToImageFilter<TInputImage, TOutputImage>
+::StreamingLabelMapToImageFilter()
+{
+  m_Binary = false;
+  m_BackgroundValue = NumericTraits<OutputImagePixelType>::NonpositiveMin();
+  m_ForegroundValue = NumericTraits<OutputImagePixelType>::max();
+}
+
+
+template <class TInputImage, class TOutputImage>
+void
+StreamingLabelMapToImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+
+  // We need all the input.
+  InputImagePointer input = const_cast<InputImageType *>(this->GetInput());
+  if ( !input )
+    { return; }
+  input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StreamingLabelMapToImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  // only the requested region is allocated
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType & region = output->GetRequestedRegion();
+
+  const OutputImagePixelType background = m_Binary ? m_BackgroundValue : static_cast< OutputImagePixelType >( input->GetBackgroundValue() );
+  ImageRegionIterator< OutputImageType > oIt( output, region );
+  for( oIt.GoToBegin(); !oIt.IsAtEnd(); ++oIt )
+    {
+    oIt.Set( background );
+    }
+
+  // the objects which may have some lines in the region
+  typename InputImageType::SpatialIndexType::LabelObjectVectorType objects;
+  input->GetSpatialIndex()->FindObjects( region, objects );
+
+  ProgressReporter progress( this, 0, objects.size() );
+
+  const long regionBegin = region.GetIndex()[0];
+  const long regionEnd = regionBegin + (long)region.GetSize()[0];
+  for( unsigned long o=0; o<objects.size(); o++ )
+    {
+    const LabelObjectType * labelObject = objects[o];
+    const OutputImagePixelType value = m_Binary ? m_ForegroundValue : static_cast< OutputImagePixelType >( labelObject->GetLabel() );
+
+    typename LabelObjectType::LineContainerType::const_iterator lit;
+    const typename LabelObjectType::LineContainerType & lineContainer = labelObject->GetLineContainer();
+
+    for( lit = lineContainer.begin(); lit != lineContainer.end(); lit++ )
+      {
+      // crop the line to the region
+      IndexType idx = lit->GetIndex();
+      bool isInside = true;
+      for( unsigned int d=1; d<ImageDimension && isInside; d++ )
+        {
+        isInside = idx[d] >= region.GetIndex()[d] && idx[d] < region.GetIndex()[d] + (long)region.GetSize()[d];
+        }
+      const long begin = std::max( idx[0], regionBegin );
+      const long end = std::min( (long)( idx[0] + lit->GetLength() ), regionEnd );
+      if( !isInside || begin >= end )
+        {
+        continue;
+        }
+      idx[0] = begin;
+      OutputImagePixelType * line = output->GetBufferPointer() + output->ComputeOffset( idx );
+      std::fill( line, line + ( end - begin ), value );
+      }
+    progress.CompletedPixel();
+    }
+}
+
+
+template<class TInputImage, class TOutputImage>
+void
+StreamingLabelMapToImageFilter<TInputImage, TOutputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Binary: "  << m_Binary << std::endl;
+  os << indent << "BackgroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_BackgroundValue) << std::endl;
+  os << indent << "ForegroundValue: "  << static_cast<typename NumericTraits<OutputImagePixelType>::PrintType>(m_ForegroundValue) << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,320 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkWatershedEdgeGraph.h,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkWatershedEdgeGraph_h
+#define __itkWatershedEdgeGraph_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkConnectivity.h"
+#include "itkMultiThreader.h"
+#include "itkNumericTraits.h"
+#include "vxl_config.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace itk
+{
+
+/** \class WatershedUnionFind
+ *  \brief Disjoint sets of pixels, identified by their offset in the buffer
+ *
+ * Union by rank, and path halving in Find().
+ */
+class WatershedUnionFind
+{
+
+public:
+
+  typedef unsigned long ValueType;
+
+  WatershedUnionFind( ValueType size = 0 )
+    {
+    this->Initialize( size );
+    }
+
+  /** release the memory */
+  void Clear()
+    {
+    std::vector< ValueType >().swap( m_Parent );
+    std::vector< unsigned char >().swap( m_Rank );
+    }
+
+  /** return the allocated memory, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    return m_Parent.capacity() * sizeof( ValueType ) + m_Rank.capacity();
+    }
+
+  /** make each element its own set. The memory already allocated is
+   * reused. */
+  void Initialize( ValueType size )
+    {
+    m_Parent.resize( size );
+    m_Rank.resize( size );
+    for( ValueType i=0; i<size; i++ )
+      {
+      m_Parent[i] = i;
+      }
+    std::fill( m_Rank.begin(), m_Rank.end(), 0 );
+    }
+
+  /** return the representative of the set of v */
+  inline ValueType Find( ValueType v )
+    {
+    while( m_Parent[v] != v )
+      {
+      m_Parent[v] = m_Parent[ m_Parent[v] ];
+      v = m_Parent[v];
+      }
+    return v;
+    }
+
+  /** merge the sets represented by a and b, and return the new
+   * representative. a and b must be representatives. */
+  inline ValueType Union( ValueType a, ValueType b )
+    {
+    if( m_Rank[a] < m_Rank[b] )
+      {
+      m_Parent[a] = b;
+      return b;
+      }
+    m_Parent[b] = a;
+    if( m_Rank[a] == m_Rank[b] )
+      {
+      m_Rank[a]++;
+      }
+    return a;
+    }
+
+private:
+
+  std::vector< ValueType > m_Parent;
+  std::vector< unsigned char > m_Rank;
+
+};
+
+
+/** \class WatershedEdgeGraph
+ *  \brief The edges of an image, sorted by weight
+ *
+ * This class builds the graph of an image for the watershed cut algorithms:
+ * the pixels are the nodes, and there is an edge between each pair of
+ * neighbor pixels, according to the given connectivity. The weight of an
+ * edge is either the maximum of the values of the two pixels, which gives
+ * the same relief as the flooding algorithms, or the absolute difference of
+ * the values of the two pixels, which can be used directly on the raw
+ * intensity image.
+ *
+ * The edges are sorted by increasing weight with a parallel, stable, LSD
+ * radix sort. The weights are first transformed in order preserving
+ * unsigned integers, and only the significant bytes are sorted, so an 8 bit
+ * image is sorted in a single pass. The edges of same weight are kept in the
+ * raster order of their first pixel.
+ *
+ * An edge is identified by pixelOffset * GetNumberOfOffsets() + k, where
+ * pixelOffset is the offset of its first pixel in the buffer, and k the
+ * position of the neighbor in GetOffsets(). Only the neighbors which come
+ * after the pixel in the buffer are used, so each edge is stored only once.
+ *
+ * \author Gatan Lehmann. Biologie du Dveloppement et de la Reproduction, INRA de Jouy-en-Josas, France.
+ *
+ * \sa MorphologicalWatershedFromMarkersImageFilter, WatershedUnionFind
+ */
+template <class TInputImage>
+class ITK_EXPORT WatershedEdgeGraph : public Object
+{
+
+public:
+
+  /** Standard typedefs */
+  typedef WatershedEdgeGraph      Self;
+  typedef Object                  Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(WatershedEdgeGraph, Object);
+
+  typedef TInputImage InputImageType;
+  typedef typename InputImageType::PixelType     InputImagePixelType;
+  typedef typename InputImageType::IndexType     IndexType;
+  typedef typename InputImageType::OffsetType    OffsetType;
+  typedef typename InputImageType::RegionType    RegionType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int,
+                      TInputImage::ImageDimension);
+
+  typedef Connectivity< ImageDimension > ConnectivityType;
+
+  typedef unsigned long EdgeType;
+  typedef std::vector< EdgeType > EdgeContainerType;
+  typedef vxl_uint_64 KeyType;
+
+  typedef enum {
+    MAXIMUM,
+    ABSOLUTE_DIFFERENCE
+  } EdgeWeightType;
+
+  /** Set/Get the image */
+  itkSetConstObjectMacro( Input, InputImageType );
+  itkGetConstObjectMacro( Input, InputImageType );
+
+  /** Set/Get the connectivity used to find the edges */
+  itkSetConstObjectMacro( Connectivity, ConnectivityType );
+  itkGetConstObjectMacro( Connectivity, ConnectivityType );
+
+  /** Set/Get the weight function. Default is MAXIMUM. */
+  itkSetMacro( EdgeWeight, EdgeWeightType );
+  itkGetConstReferenceMacro( EdgeWeight, EdgeWeightType );
+
+  /** Set/Get the number of threads used to sort the edges */
+  itkSetClampMacro( NumberOfThreads, int, 1, ITK_MAX_THREADS );
+  itkGetConstReferenceMacro( NumberOfThreads, int );
+
+  /** Build the edges and sort them */
+  void Build();
+
+  /** Release the memory used by the edges and by the sort. That memory is
+   * otherwise reused by the next Build() */
+  void Clear()
+    {
+    EdgeContainerType().swap( m_Edges );
+    std::vector< KeyType >().swap( m_Keys );
+    EdgeContainerType().swap( m_TmpEdges );
+    std::vector< KeyType >().swap( m_TmpKeys );
+    }
+
+  /** return the memory allocated by the edges and by the sort, in bytes */
+  unsigned long GetMemorySize() const
+    {
+    return ( m_Edges.capacity() + m_TmpEdges.capacity() ) * sizeof( EdgeType )
+      + ( m_Keys.capacity() + m_TmpKeys.capacity() ) * sizeof( KeyType );
+    }
+
+  /** return the edges, sorted by weight */
+  const EdgeContainerType & GetEdges() const
+    {
+    return m_Edges;
+    }
+
+  /** return the weight of the edges, in the same order as GetEdges(). The
+   * weights are transformed in order preserving integers, with the smallest
+   * weight set to 0. */
+  const std::vector< KeyType > & GetKeys() const
+    {
+    return m_Keys;
+    }
+
+  /** return the neighbor offsets, in the buffer, used by the edges */
+  const std::vector< long > & GetOffsets() const
+    {
+    return m_Offsets;
+    }
+
+  unsigned long GetNumberOfOffsets() const
+    {
+    return m_Offsets.size();
+    }
+
+  /** return the buffer offsets of the two pixels of an edge */
+  inline void GetPixels( const EdgeType & edge, unsigned long & p, unsigned long & q ) const
+    {
+    p = edge / m_Offsets.size();
+    q = p + m_Offsets[ edge % m_Offsets.size() ];
+    }
+
+  /** return an order preserving unsigned integer for a pixel value */
+  static inline KeyType ValueToKey( const InputImagePixelType & v )
+    {
+    static const KeyType signBit = ( (KeyType)1 ) << 63;
+    if( NumericTraits< InputImagePixelType >::is_integer )
+      {
+      if( NumericTraits< InputImagePixelType >::is_signed )
+        {
+        return ( (KeyType)(vxl_int_64)v ) ^ signBit;
+        }
+      return (KeyType)v;
+      }
+    // floating point: flip the negative values, and set the sign bit of the
+    // positive ones
+    double d = v;
+    KeyType k;
+    memcpy( &k, &d, sizeof( KeyType ) );
+    if( k & signBit )
+      {
+      return ~k;
+      }
+    return k | signBit;
+    }
+
+protected:
+
+  WatershedEdgeGraph();
+  ~WatershedEdgeGraph() {};
+  void PrintSelf(std::ostream& os, Indent indent) const;
+
+  /** Sort m_Edges according to m_Keys */
+  void RadixSort( unsigned int nbOfBytes );
+
+  /** data shared by the sorting threads */
+  struct ThreadStruct
+    {
+    Self * Graph;
+    unsigned int Shift;
+    bool Scatter;
+    };
+
+  static ITK_THREAD_RETURN_TYPE RadixSortThreaderCallback( void * arg );
+
+  /** compute the histogram of a part of the keys, or scatter that part
+   * according to the offsets computed from the histograms */
+  void ThreadedRadixSort( int threadId, int nbOfThreads, unsigned int shift, bool scatter );
+
+private:
+
+  WatershedEdgeGraph(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  typename InputImageType::ConstPointer m_Input;
+  typename ConnectivityType::ConstPointer m_Connectivity;
+  EdgeWeightType m_EdgeWeight;
+  int m_NumberOfThreads;
+
+  std::vector< long > m_Offsets;
+  std::vector< OffsetType > m_NeighborOffsets;
+  EdgeContainerType m_Edges;
+  std::vector< KeyType > m_Keys;
+
+  // temporary storage of the radix sort
+  EdgeContainerType m_TmpEdges;
+  std::vector< KeyType > m_TmpKeys;
+  std::vector< std::vector< unsigned long > > m_Histograms;
+  int m_NumberOfSortThreads;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkWatershedEdgeGraph.txx"
+#endif
+
+#endif
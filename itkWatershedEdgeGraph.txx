@@ -0,0 +1,255 @@
+/*=========================================================================
+
+  Program:   Insight Segmentation & Registration Toolkit
+  Module:    $RCSfile: itkWatershedEdgeGraph.txx,v $
+  Language:  C++
+  Date:      $Date: 2006/03/28 19:59:05 $
+  Version:   $Revision: 1.1 $
+
+  Copyright (c) Insight Software Consortium. All rights reserved.
+  See ITKCopyright.txt or http://www.itk.org/HTML/Copyright.htm for details.
+
+    This software is distributed WITHOUT ANY WARRANTY; without even
+    the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+    PURPOSE.  See the above copyright notices for more information.
+
+=========================================================================*/
+#ifndef __itkWatershedEdgeGraph_txx
+#define __itkWatershedEdgeGraph_txx
+
+#include "itkWatershedEdgeGraph.h"
+
+namespace itk {
+
+template <class TInputImage>
+WatershedEdgeGraph<TInputImage>
+::WatershedEdgeGraph()
+{
+  m_EdgeWeight = MAXIMUM;
+  m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  m_NumberOfSortThreads = 1;
+}
+
+
+template <class TInputImage>
+void
+WatershedEdgeGraph<TInputImage>
+::Build()
+{
+  if( !m_Input || !m_Connectivity )
+    { itkExceptionMacro( << "Input and Connectivity must be set." ); }
+
+  const RegionType region = m_Input->GetBufferedRegion();
+  const IndexType & start = region.GetIndex();
+  const typename RegionType::SizeType & size = region.GetSize();
+  const unsigned long nbOfPixels = region.GetNumberOfPixels();
+  const InputImagePixelType * buffer = m_Input->GetBufferPointer();
+
+  // keep only the neighbors after the pixel in the buffer, so each edge is
+  // stored only once
+  long stride[ImageDimension];
+  stride[0] = 1;
+  for( unsigned int i=1; i<ImageDimension; i++ )
+    {
+    stride[i] = stride[i-1] * size[i-1];
+    }
+  m_Offsets.clear();
+  m_NeighborOffsets.clear();
+  const typename ConnectivityType::OffsetContainerType & neighbors = m_Connectivity->GetNeighbors();
+  for( unsigned int n=0; n<neighbors.size(); n++ )
+    {
+    const OffsetType & o = neighbors[n];
+    int d = ImageDimension - 1;
+    while( d > 0 && o[d] == 0 )
+      { d--; }
+    if( o[d] > 0 )
+      {
+      long linear = 0;
+      for( unsigned int i=0; i<ImageDimension; i++ )
+        {
+        linear += o[i] * stride[i];
+        }
+      m_Offsets.push_back( linear );
+      m_NeighborOffsets.push_back( o );
+      }
+    }
+  const unsigned long nbOfOffsets = m_Offsets.size();
+
+  // build the edges, in raster order
+  m_Edges.clear();
+  m_Keys.clear();
+  m_Edges.reserve( nbOfPixels * nbOfOffsets );
+  m_Keys.reserve( nbOfPixels * nbOfOffsets );
+  KeyType minKey = NumericTraits< KeyType >::max();
+  KeyType maxKey = NumericTraits< KeyType >::Zero;
+  IndexType idx = start;
+  for( unsigned long p=0; p<nbOfPixels; p++ )
+    {
+    const InputImagePixelType & v = buffer[p];
+    for( unsigned long k=0; k<nbOfOffsets; k++ )
+      {
+      const OffsetType & o = m_NeighborOffsets[k];
+      bool inside = true;
+      for( unsigned int i=0; i<ImageDimension && inside; i++ )
+        {
+        long c = idx[i] + o[i];
+        inside = c >= start[i] && c < start[i] + (long)size[i];
+        }
+      if( !inside )
+        { continue; }
+      const InputImagePixelType & nv = buffer[ p + m_Offsets[k] ];
+      InputImagePixelType w;
+      if( m_EdgeWeight == MAXIMUM )
+        {
+        w = std::max( v, nv );
+        }
+      else
+        {
+        w = static_cast< InputImagePixelType >( v > nv ? v - nv : nv - v );
+        }
+      KeyType key = Self::ValueToKey( w );
+      minKey = std::min( minKey, key );
+      maxKey = std::max( maxKey, key );
+      m_Edges.push_back( p * nbOfOffsets + k );
+      m_Keys.push_back( key );
+      }
+
+    // next index
+    for( unsigned int i=0; i<ImageDimension; i++ )
+      {
+      idx[i]++;
+      if( idx[i] < start[i] + (long)size[i] )
+        { break; }
+      idx[i] = start[i];
+      }
+    }
+
+  if( m_Edges.empty() )
+    { return; }
+
+  // only sort the significant bytes
+  for( unsigned long i=0; i<m_Keys.size(); i++ )
+    {
+    m_Keys[i] -= minKey;
+    }
+  unsigned int nbOfBytes = 0;
+  for( KeyType range = maxKey - minKey; range != 0; range >>= 8 )
+    {
+    nbOfBytes++;
+    }
+  this->RadixSort( nbOfBytes );
+}
+
+
+template <class TInputImage>
+void
+WatershedEdgeGraph<TInputImage>
+::RadixSort( unsigned int nbOfBytes )
+{
+  const unsigned long n = m_Edges.size();
+  if( n == 0 || nbOfBytes == 0 )
+    { return; }
+
+  // don't use more threads than useful on small images
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( std::min( (unsigned long)m_NumberOfThreads, n / 65536 + 1 ) );
+  m_NumberOfSortThreads = threader->GetNumberOfThreads();
+
+  m_TmpEdges.resize( n );
+  m_TmpKeys.resize( n );
+  m_Histograms.assign( m_NumberOfSortThreads, std::vector< unsigned long >( 256 ) );
+
+  ThreadStruct str;
+  str.Graph = this;
+  threader->SetSingleMethod( Self::RadixSortThreaderCallback, &str );
+
+  for( unsigned int pass=0; pass<nbOfBytes; pass++ )
+    {
+    str.Shift = 8 * pass;
+
+    // histogram of each part
+    str.Scatter = false;
+    threader->SingleMethodExecute();
+
+    // transform the histograms in start positions. The parts are stored one
+    // after the other for each byte value, so the sort is stable.
+    unsigned long sum = 0;
+    for( unsigned int b=0; b<256; b++ )
+      {
+      for( int t=0; t<m_NumberOfSortThreads; t++ )
+        {
+        unsigned long count = m_Histograms[t][b];
+        m_Histograms[t][b] = sum;
+        sum += count;
+        }
+      }
+
+    // scatter
+    str.Scatter = true;
+    threader->SingleMethodExecute();
+
+    m_Edges.swap( m_TmpEdges );
+    m_Keys.swap( m_TmpKeys );
+    }
+
+  // the temporary storage is kept for the next build, until Clear() is
+  // called
+}
+
+
+template <class TInputImage>
+ITK_THREAD_RETURN_TYPE
+WatershedEdgeGraph<TInputImage>
+::RadixSortThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct * str = static_cast< ThreadStruct * >( info->UserData );
+  str->Graph->ThreadedRadixSort( info->ThreadID, str->Graph->m_NumberOfSortThreads, str->Shift, str->Scatter );
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+
+template <class TInputImage>
+void
+WatershedEdgeGraph<TInputImage>
+::ThreadedRadixSort( int threadId, int nbOfThreads, unsigned int shift, bool scatter )
+{
+  const unsigned long n = m_Edges.size();
+  const unsigned long begin = ( n / nbOfThreads ) * threadId;
+  const unsigned long end = threadId == nbOfThreads - 1 ? n : ( n / nbOfThreads ) * ( threadId + 1 );
+  std::vector< unsigned long > & histogram = m_Histograms[threadId];
+
+  if( !scatter )
+    {
+    std::fill( histogram.begin(), histogram.end(), 0 );
+    for( unsigned long i=begin; i<end; i++ )
+      {
+      histogram[ ( m_Keys[i] >> shift ) & 0xff ]++;
+      }
+    }
+  else
+    {
+    for( unsigned long i=begin; i<end; i++ )
+      {
+      unsigned long pos = histogram[ ( m_Keys[i] >> shift ) & 0xff ]++;
+      m_TmpEdges[pos] = m_Edges[i];
+      m_TmpKeys[pos] = m_Keys[i];
+      }
+    }
+}
+
+
+template <class TInputImage>
+void
+WatershedEdgeGraph<TInputImage>
+::PrintSelf(std::ostream &os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "EdgeWeight: "  << m_EdgeWeight << std::endl;
+  os << indent << "NumberOfThreads: "  << m_NumberOfThreads << std::endl;
+  os << indent << "NumberOfEdges: "  << m_Edges.size() << std::endl;
+}
+
+}// end namespace itk
+#endif
@@ -0,0 +1,117 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelContourLabelMapFilter.h"
+#include "itkLabelContourAttributeLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkAttributeLabelObject.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkSimpleFilterWatcher.h"
+#include <map>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 4 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected input output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::AttributeLabelObject< PType, dim, unsigned long > LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[2] );
+
+  typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( reader->GetOutput() );
+
+  // the contour, computed from the lines
+  typedef itk::LabelContourLabelMapFilter< LabelMapType > ContourType;
+  ContourType::Pointer contour = ContourType::New();
+  contour->SetInput( i2l->GetOutput() );
+  contour->SetFullyConnected( atoi( argv[1] ) );
+  contour->SetInPlace( false );
+  itk::SimpleFilterWatcher watcher(contour, "contour");
+
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, IType > L2IType;
+  L2IType::Pointer l2i = L2IType::New();
+  l2i->SetInput( contour->GetOutput() );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( l2i->GetOutput() );
+  writer->SetFileName( argv[3] );
+  writer->Update();
+
+  // the contour size, as attribute
+  typedef itk::LabelContourAttributeLabelMapFilter< LabelMapType > AttributeType;
+  AttributeType::Pointer attribute = AttributeType::New();
+  attribute->SetInput( i2l->GetOutput() );
+  attribute->SetFullyConnected( atoi( argv[1] ) );
+  attribute->SetInPlace( false );
+  attribute->Update();
+
+  // the same contour, computed pixel by pixel
+  const IType * input = reader->GetOutput();
+  const IType * output = l2i->GetOutput();
+  const IType::RegionType & region = input->GetLargestPossibleRegion();
+  const ContourType::ConnectivityType::OffsetContainerType & neighbors = contour->GetConnectivity()->GetNeighbors();
+  std::map< PType, unsigned long > sizes;
+  unsigned long diff = 0;
+  itk::ImageRegionConstIteratorWithIndex< IType > it( input, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    PType v = it.Get();
+    bool onContour = false;
+    if( v != i2l->GetBackgroundValue() )
+      {
+      for( unsigned int i=0; i<neighbors.size() && !onContour; i++ )
+        {
+        IType::IndexType idx = it.GetIndex() + neighbors[i];
+        if( region.IsInside( idx ) && input->GetPixel( idx ) != v )
+          {
+          onContour = true;
+          }
+        }
+      }
+    if( onContour )
+      {
+      sizes[ v ]++;
+      }
+    PType expected = onContour ? v : i2l->GetBackgroundValue();
+    if( output->GetPixel( it.GetIndex() ) != expected )
+      {
+      diff++;
+      }
+    }
+
+  if( diff != 0 )
+    {
+    std::cerr << diff << " pixels differ from the pixel by pixel contour." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const LabelMapType::LabelObjectContainerType & objects = attribute->GetOutput()->GetLabelObjectContainer();
+  for( LabelMapType::LabelObjectContainerType::const_iterator oit = objects.begin(); oit != objects.end(); oit++ )
+    {
+    if( oit->second->GetAttribute() != sizes[ oit->first ] )
+      {
+      std::cerr << "Wrong contour size for the label " << (int)oit->first << ": "
+                << oit->second->GetAttribute() << " instead of " << sizes[ oit->first ] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return 0;
+}
+
@@ -0,0 +1,181 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkMappedImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkByteSwapper.h"
+#include <fstream>
+#include <cmath>
+#include <string>
+
+
+template < class TImage >
+bool SameImages( const TImage * image1, const TImage * image2 )
+{
+  if( image1->GetLargestPossibleRegion() != image2->GetLargestPossibleRegion() )
+    {
+    std::cerr << "The regions differ." << std::endl;
+    return false;
+    }
+  // the header may be written with a limited precision
+  for( unsigned int d=0; d<TImage::ImageDimension; d++ )
+    {
+    if( fabs( image1->GetSpacing()[d] - image2->GetSpacing()[d] ) > 1e-4
+      || fabs( image1->GetOrigin()[d] - image2->GetOrigin()[d] ) > 1e-4 )
+      {
+      std::cerr << "The spacings or the origins differ." << std::endl;
+      return false;
+      }
+    }
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      std::cerr << "The pixels differ." << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 3 )
+    {
+    std::cerr << "usage: " << argv[0] << " input prefix" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 3;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  reader->Update();
+
+  typedef itk::MappedImageFileReader< IType > MappedReaderType;
+  MappedReaderType::Pointer mapped = MappedReaderType::New();
+  mapped->SetFileName( argv[1] );
+  mapped->Update();
+  mapped->Print( std::cout );
+
+  // the input reader may reorient the image, so only the size and the sum of
+  // the pixels are compared
+  if( !mapped->GetMapped()
+    || mapped->GetOutput()->GetLargestPossibleRegion().GetNumberOfPixels() != reader->GetOutput()->GetLargestPossibleRegion().GetNumberOfPixels() )
+    {
+    std::cerr << "Wrong mapping of " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  double sum1 = 0;
+  double sum2 = 0;
+  const unsigned long nbOfPixels = reader->GetOutput()->GetLargestPossibleRegion().GetNumberOfPixels();
+  for( unsigned long i=0; i<nbOfPixels; i++ )
+    {
+    sum1 += reader->GetOutput()->GetBufferPointer()[i];
+    sum2 += mapped->GetOutput()->GetBufferPointer()[i];
+    }
+  if( sum1 != sum2 )
+    {
+    std::cerr << "The pixels of " << argv[1] << " differ." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // MetaImage, with the data in the header file or in a separate file
+  const std::string prefix = argv[2];
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( reader->GetOutput() );
+  writer->UseCompressionOff();
+  const char * extensions[] = { ".mha", ".mhd" };
+  for( int i=0; i<2; i++ )
+    {
+    writer->SetFileName( prefix + extensions[i] );
+    writer->Update();
+    mapped->SetFileName( prefix + extensions[i] );
+    mapped->Update();
+    if( !mapped->GetMapped() || !SameImages< IType >( reader->GetOutput(), mapped->GetOutput() ) )
+      {
+      std::cerr << "Wrong mapping of " << prefix + extensions[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // the modifications of a copy-on-write mapping are not written in the file
+  mapped->CopyOnWriteOn();
+  mapped->Modified();
+  mapped->Update();
+  IType::IndexType idx;
+  idx.Fill( 0 );
+  const PType value = mapped->GetOutput()->GetPixel( idx );
+  mapped->GetOutput()->SetPixel( idx, value + 1 );
+  MappedReaderType::Pointer mapped2 = MappedReaderType::New();
+  mapped2->SetFileName( prefix + ".mhd" );
+  mapped2->Update();
+  if( mapped2->GetOutput()->GetPixel( idx ) != value )
+    {
+    std::cerr << "The file has been modified." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a big endian raw file of 16 bits pixels, with a header which breaks the
+  // alignment
+  typedef unsigned short SPType;
+  typedef itk::Image< SPType, dim > SIType;
+  const std::string rawFileName = prefix + "-16.raw";
+  std::vector< SPType > values( nbOfPixels );
+  for( unsigned long i=0; i<nbOfPixels; i++ )
+    {
+    values[i] = reader->GetOutput()->GetBufferPointer()[i] * 257 + i % 3;
+    }
+  std::vector< SPType > swapped( values );
+  itk::ByteSwapper< SPType >::SwapRangeFromSystemToBigEndian( &swapped[0], nbOfPixels );
+  std::ofstream raw( rawFileName.c_str(), std::ios::binary );
+  raw.write( "abc", 3 );
+  raw.write( reinterpret_cast< const char * >( &swapped[0] ), nbOfPixels * sizeof( SPType ) );
+  raw.close();
+
+  typedef itk::MappedImageFileReader< SIType > MappedRawReaderType;
+  MappedRawReaderType::Pointer rawReader = MappedRawReaderType::New();
+  rawReader->SetFileName( rawFileName );
+  rawReader->SetRawSize( reader->GetOutput()->GetLargestPossibleRegion().GetSize() );
+  rawReader->SetRawHeaderSize( 3 );
+  rawReader->RawBigEndianOn();
+  rawReader->Update();
+  if( rawReader->GetMapped() )
+    {
+    std::cerr << "An unaligned big endian raw file can't be mapped." << std::endl;
+    return EXIT_FAILURE;
+    }
+  for( unsigned long i=0; i<nbOfPixels; i++ )
+    {
+    if( rawReader->GetOutput()->GetBufferPointer()[i] != values[i] )
+      {
+      std::cerr << "The pixels of " << rawFileName << " differ." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // a wrong pixel type must be detected
+  MappedRawReaderType::Pointer wrongReader = MappedRawReaderType::New();
+  wrongReader->SetFileName( prefix + ".mha" );
+  try
+    {
+    wrongReader->Update();
+    std::cerr << "The wrong pixel type has not been detected." << std::endl;
+    return EXIT_FAILURE;
+    }
+  catch( itk::ExceptionObject & e )
+    {
+    std::cout << "Expected exception: " << e.GetDescription() << std::endl;
+    }
+
+  return 0;
+}
+
@@ -1,4 +1,5 @@
 #include "itkImageFileReader.h"
+#include "itkMappedImageFileReader.h"
 #include "itkImageFileWriter.h"
 
 #include "itkRegionalMinimaImageFilter.h"
@@ -28,11 +29,12 @@ int main(int, char * argv[])
   typedef unsigned long LPType;
   typedef itk::Image< LPType, dim > LIType;
 
-  // read the input image
-  typedef itk::ImageFileReader< IType > ReaderType;
-  ReaderType::Pointer reader = ReaderType::New();
+  // map the input image, rather than reading it
+  typedef itk::MappedImageFileReader< IType > MappedReaderType;
+  MappedReaderType::Pointer reader = MappedReaderType::New();
   reader->SetFileName( argv[1] );
   
+  typedef itk::ImageFileReader< IType > ReaderType;
   ReaderType::Pointer reader2 = ReaderType::New();
   reader2->SetFileName( argv[2] );
   
@@ -40,6 +42,9 @@ int main(int, char * argv[])
   typedef itk::InvertIntensityImageFilter< IType, IType > InvertType;
   InvertType::Pointer invert = InvertType::New();
   invert->SetInput( reader->GetOutput() );
+  // the output of the reader is a read only mapping of the file, and is
+  // used by several filters: the inverted image must not be written in it
+  invert->InPlaceOff();
 
   typedef itk::MorphologicalWatershedFromMarkersImageFilter< IType, IType > MMWatershedType;
   MMWatershedType::Pointer mmws = MMWatershedType::New();
@@ -60,6 +65,19 @@ int main(int, char * argv[])
   change->SetInput( ws->GetOutput() );
 
 
+  // the pages of the file are read when they are accessed for the first time:
+  // read them all here, so the filter timings don't include the I/O
+  itk::TimeProbe iotime;
+  iotime.Start();
+  reader->Update();
+  unsigned long checksum = 0;
+  itk::ImageRegionConstIterator< IType > iit( reader->GetOutput(),
+                                              reader->GetOutput()->GetLargestPossibleRegion() );
+  for( iit.GoToBegin(); !iit.IsAtEnd(); ++iit )
+    { checksum += iit.Get(); }
+  iotime.Stop();
+  std::cout << "# io: " << iotime.GetMeanTime() << " (" << checksum << ")" << std::endl;
+
   std::cout << "#F" << "\t" 
             << "M" << "\t" 
             << "min" << "\t" 
@@ -0,0 +1,174 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkReconstructionByErosionImageFilter.h"
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected absoluteDifference input markers output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[4] );
+
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetFullyConnected( atoi( argv[1] ) );
+  filter->SetFloodingMethod( FilterType::MINIMUM_SPANNING_FOREST );
+  if( atoi( argv[2] ) )
+    {
+    filter->SetEdgeWeight( FilterType::ABSOLUTE_DIFFERENCE );
+    }
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  const IType * input = reader->GetOutput();
+  const IType * markers = reader2->GetOutput();
+  const IType * output = filter->GetOutput();
+  const IType::RegionType region = output->GetBufferedRegion();
+  bool ok = true;
+
+  // the markers keep their label, and all the other pixels are labeled: there
+  // is no watershed line
+  typedef itk::ImageRegionConstIterator< IType > IteratorType;
+  unsigned long nbOfErrors = 0;
+  IteratorType oit( output, region );
+  IteratorType mit( markers, region );
+  for( oit.GoToBegin(), mit.GoToBegin(); !oit.IsAtEnd(); ++oit, ++mit )
+    {
+    if( ( mit.Get() != 0 && oit.Get() != mit.Get() ) || oit.Get() == 0 )
+      {
+      nbOfErrors++;
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels with a wrong label or without label" << std::endl;
+    ok = false;
+    }
+
+  if( !atoi( argv[2] ) )
+    {
+    // the lowest possible highest value of the paths from the markers to
+    // each pixel, markers included: the reconstruction by erosion of the
+    // input from the markers
+    IType::Pointer seeds = IType::New();
+    seeds->SetRegions( region );
+    seeds->Allocate();
+    itk::ImageRegionIterator< IType > sit( seeds, region );
+    IteratorType iit( input, region );
+    for( sit.GoToBegin(), iit.GoToBegin(), mit.GoToBegin(); !sit.IsAtEnd(); ++sit, ++iit, ++mit )
+      {
+      sit.Set( mit.Get() != 0 ? iit.Get() : itk::NumericTraits< PType >::max() );
+      }
+    typedef itk::ReconstructionByErosionImageFilter< IType, IType > ReconstructionType;
+    ReconstructionType::Pointer reconstruction = ReconstructionType::New();
+    reconstruction->SetMarkerImage( seeds );
+    reconstruction->SetMaskImage( input );
+    reconstruction->SetFullyConnected( atoi( argv[1] ) );
+    reconstruction->Update();
+    const IType * cost = reconstruction->GetOutput();
+
+    // the path of the spanning forest from a pixel to its marker is one of
+    // those paths: each pixel which is not a marker has a neighbor with the
+    // same label and a cost not greater than its own. Any other difference
+    // with the flooding of Meyer is unexpected.
+    IType::OffsetType offsets[8];
+    unsigned int nbOfOffsets = 0;
+    for( int y=-1; y<=1; y++ )
+      {
+      for( int x=-1; x<=1; x++ )
+        {
+        if( ( x != 0 || y != 0 ) && ( atoi( argv[1] ) || x == 0 || y == 0 ) )
+          {
+          offsets[nbOfOffsets][0] = x;
+          offsets[nbOfOffsets][1] = y;
+          nbOfOffsets++;
+          }
+        }
+      }
+    nbOfErrors = 0;
+    itk::ImageRegionConstIteratorWithIndex< IType > cit( cost, region );
+    for( cit.GoToBegin(), oit.GoToBegin(), mit.GoToBegin(); !cit.IsAtEnd(); ++cit, ++oit, ++mit )
+      {
+      if( mit.Get() != 0 )
+        {
+        continue;
+        }
+      bool found = false;
+      for( unsigned int i=0; i<nbOfOffsets && !found; i++ )
+        {
+        const IType::IndexType idx = cit.GetIndex() + offsets[i];
+        found = region.IsInside( idx ) && output->GetPixel( idx ) == oit.Get()
+          && cost->GetPixel( idx ) <= cit.Get();
+        }
+      if( !found )
+        {
+        nbOfErrors++;
+        }
+      }
+    if( nbOfErrors )
+      {
+      std::cerr << nbOfErrors << " pixels not given to a marker reached by a lowest path" << std::endl;
+      ok = false;
+      }
+
+    // for the record, the pixels labeled differently by the flooding of
+    // Meyer, out of its watershed line
+    FilterType::Pointer flood = FilterType::New();
+    flood->SetInput( reader->GetOutput() );
+    flood->SetMarkerImage( reader2->GetOutput() );
+    flood->SetFullyConnected( atoi( argv[1] ) );
+    flood->SetMarkWatershedLine( true );
+    flood->Update();
+
+    IteratorType fit( flood->GetOutput(), region );
+    unsigned long diff = 0;
+    unsigned long line = 0;
+    for( oit.GoToBegin(), fit.GoToBegin(); !oit.IsAtEnd(); ++oit, ++fit )
+      {
+      if( fit.Get() == 0 )
+        {
+        line++;
+        }
+      else if( oit.Get() != fit.Get() )
+        {
+        diff++;
+        }
+      }
+    std::cout << "Pixels different from the flooding of Meyer: " << diff << " / "
+              << region.GetNumberOfPixels() << " (" << line << " on the watershed line)" << std::endl;
+    }
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
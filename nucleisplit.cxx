@@ -0,0 +1,105 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkBinaryWatershedImageToLabelMapFilter.h"
+#include "itkBinaryWatershedImageFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 7 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected level minSize maxContourRatio input output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  typedef unsigned short LType;
+  typedef itk::Image< LType, dim > LIType;
+
+  typedef itk::AttributeLabelObject< unsigned long, dim, unsigned long > LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[5] );
+
+  typedef itk::BinaryWatershedImageToLabelMapFilter< IType, LabelMapType > SplitType;
+  SplitType::Pointer split = SplitType::New();
+  split->SetInput( reader->GetOutput() );
+  split->SetFullyConnected( atoi( argv[1] ) );
+  split->SetLevel( atof( argv[2] ) );
+  split->SetForegroundValue( 255 );
+  itk::SimpleFilterWatcher watcher(split, "split");
+
+  // without selection, the objects must be the ones of the image filter
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, LIType > L2IType;
+  L2IType::Pointer l2i = L2IType::New();
+  l2i->SetInput( split->GetOutput() );
+  l2i->Update();
+
+  typedef itk::BinaryWatershedImageFilter< IType, LIType > BinaryWatershedType;
+  BinaryWatershedType::Pointer bws = BinaryWatershedType::New();
+  bws->SetInput( reader->GetOutput() );
+  bws->SetFullyConnected( atoi( argv[1] ) );
+  bws->SetLevel( atof( argv[2] ) );
+  bws->SetForegroundValue( 255 );
+  bws->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it( l2i->GetOutput(), l2i->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > rit( bws->GetOutput(), bws->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  if( diff != 0 )
+    {
+    std::cerr << diff << " pixels differ from the binary watershed image filter." << std::endl;
+    return EXIT_FAILURE;
+    }
+  const unsigned long nbOfObjects = split->GetOutput()->GetNumberOfLabelObjects();
+
+  // now remove the small and the irregular objects
+  split->SetMinimumSize( atoi( argv[3] ) );
+  split->SetMaximumContourRatio( atof( argv[4] ) );
+  split->Update();
+
+  std::cout << "Number of objects: " << nbOfObjects << " split, "
+            << split->GetOutput()->GetNumberOfLabelObjects() << " selected" << std::endl;
+  std::cout << "labeling: " << split->GetLabelingTime() << std::endl;
+  std::cout << "splitting: " << split->GetSplittingTime() << std::endl;
+  std::cout << "attributes: " << split->GetAttributesTime() << std::endl;
+  std::cout << "selection: " << split->GetSelectionTime() << std::endl;
+
+  const LabelMapType::LabelObjectContainerType & objects = split->GetOutput()->GetLabelObjectContainer();
+  for( LabelMapType::LabelObjectContainerType::const_iterator oit = objects.begin(); oit != objects.end(); oit++ )
+    {
+    const LabelObjectType * object = oit->second;
+    const double ratio = double( object->GetAttribute() ) / object->Size();
+    if( object->Size() < split->GetMinimumSize() || ratio > split->GetMaximumContourRatio() )
+      {
+      std::cerr << "The object " << oit->first << " has been kept: " << object->Size()
+                << " pixels, contour ratio " << ratio << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  typedef itk::ImageFileWriter< LIType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( l2i->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  return 0;
+}
+
@@ -0,0 +1,166 @@
+#include "itkImageFileReader.h"
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapOverlapMeasures.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+#include <map>
+#include <cmath>
+
+
+const int dim = 2;
+
+typedef unsigned short PType;
+typedef itk::Image< PType, dim > IType;
+
+typedef itk::LabelObject< PType, dim > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+typedef itk::LabelMapOverlapMeasures< LabelMapType > MeasuresType;
+
+typedef std::map< std::pair< PType, PType >, unsigned long > TableType;
+typedef std::map< PType, unsigned long > CountType;
+
+bool check( const char * name, double value, double expected )
+{
+  if( std::fabs( value - expected ) > 1e-9 * std::max( 1.0, std::fabs( expected ) ) )
+    {
+    std::cerr << name << ": " << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 4 )
+    {
+    std::cerr << "usage: " << argv[0] << " input1 input2 nbOfThreads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader1 = ReaderType::New();
+  reader1->SetFileName( argv[1] );
+  ReaderType::Pointer reader2 = ReaderType::New();
+  reader2->SetFileName( argv[2] );
+
+  typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l1 = I2LType::New();
+  i2l1->SetInput( reader1->GetOutput() );
+  i2l1->Update();
+  I2LType::Pointer i2l2 = I2LType::New();
+  i2l2->SetInput( reader2->GetOutput() );
+  i2l2->Update();
+
+  MeasuresType::Pointer measures = MeasuresType::New();
+  measures->SetNumberOfThreads( atoi( argv[3] ) );
+  itk::TimeProbe time;
+  time.Start();
+  measures->Compute( i2l1->GetOutput(), i2l2->GetOutput() );
+  time.Stop();
+  std::cout << "overlap: " << time.GetMeanTime() << std::endl;
+  std::cout << "Jaccard: " << measures->GetJaccard() << std::endl;
+  std::cout << "Dice: " << measures->GetDice() << std::endl;
+  std::cout << "variation of information: " << measures->GetVariationOfInformation() << std::endl;
+  std::cout << "adjusted Rand index: " << measures->GetAdjustedRandIndex() << std::endl;
+  std::cout << "mean best match Jaccard: " << measures->GetMeanBestMatchJaccard() << std::endl;
+
+  // the full contingency table, background included, computed pixel by pixel
+  const PType bg1 = i2l1->GetOutput()->GetBackgroundValue();
+  const PType bg2 = i2l2->GetOutput()->GetBackgroundValue();
+  TableType table;
+  CountType rows;
+  CountType cols;
+  itk::ImageRegionConstIterator< IType > it1( reader1->GetOutput(), reader1->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< IType > it2( reader2->GetOutput(), reader2->GetOutput()->GetBufferedRegion() );
+  double n = 0;
+  double intersection = 0;
+  double foreground1 = 0;
+  double foreground2 = 0;
+  for( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    table[ std::make_pair( it1.Get(), it2.Get() ) ]++;
+    rows[ it1.Get() ]++;
+    cols[ it2.Get() ]++;
+    n++;
+    foreground1 += it1.Get() != bg1;
+    foreground2 += it2.Get() != bg2;
+    intersection += it1.Get() != bg1 && it2.Get() != bg2;
+    }
+
+  bool ok = true;
+
+  // the overlaps of the objects
+  unsigned long nbOfOverlaps = 0;
+  for( TableType::const_iterator it = table.begin(); it != table.end(); it++ )
+    {
+    if( it->first.first != bg1 && it->first.second != bg2 )
+      {
+      nbOfOverlaps++;
+      if( measures->GetOverlap( it->first.first, it->first.second ) != it->second )
+        {
+        std::cerr << "overlap of " << it->first.first << " and " << it->first.second << ": "
+                  << measures->GetOverlap( it->first.first, it->first.second ) << " instead of " << it->second << std::endl;
+        ok = false;
+        }
+      }
+    }
+  if( measures->GetOverlapTable().size() != nbOfOverlaps )
+    {
+    std::cerr << measures->GetOverlapTable().size() << " overlaps instead of " << nbOfOverlaps << std::endl;
+    ok = false;
+    }
+
+  // the measures
+  double pairs = 0;
+  double information = 0;
+  for( TableType::const_iterator it = table.begin(); it != table.end(); it++ )
+    {
+    const double nij = it->second;
+    const double ni = rows[ it->first.first ];
+    const double nj = cols[ it->first.second ];
+    pairs += nij * ( nij - 1 ) / 2;
+    information -= nij / n * ( std::log( nij / ni ) + std::log( nij / nj ) );
+    }
+  double rowPairs = 0;
+  for( CountType::const_iterator it = rows.begin(); it != rows.end(); it++ )
+    {
+    rowPairs += it->second * ( it->second - 1.0 ) / 2;
+    }
+  double colPairs = 0;
+  for( CountType::const_iterator it = cols.begin(); it != cols.end(); it++ )
+    {
+    colPairs += it->second * ( it->second - 1.0 ) / 2;
+    }
+  const double expected = rowPairs * colPairs / ( n * ( n - 1 ) / 2 );
+  const double ari = ( pairs - expected ) / ( ( rowPairs + colPairs ) / 2 - expected );
+
+  ok = check( "Jaccard", measures->GetJaccard(), intersection / ( foreground1 + foreground2 - intersection ) ) && ok;
+  ok = check( "Dice", measures->GetDice(), 2 * intersection / ( foreground1 + foreground2 ) ) && ok;
+  ok = check( "variation of information", measures->GetVariationOfInformation(), information ) && ok;
+  ok = check( "adjusted Rand index", measures->GetAdjustedRandIndex(), ari ) && ok;
+
+  // a segmentation matches itself perfectly
+  measures->Compute( i2l1->GetOutput(), i2l1->GetOutput() );
+  ok = check( "self Jaccard", measures->GetJaccard(), 1 ) && ok;
+  ok = check( "self variation of information", measures->GetVariationOfInformation(), 0 ) && ok;
+  ok = check( "self adjusted Rand index", measures->GetAdjustedRandIndex(), 1 ) && ok;
+  ok = check( "self mean best match Jaccard", measures->GetMeanBestMatchJaccard(), 1 ) && ok;
+  const MeasuresType::MatchTableType & matches = measures->GetSourceBestMatches();
+  for( MeasuresType::MatchTableType::const_iterator it = matches.begin(); it != matches.end(); it++ )
+    {
+    if( it->second.Label != it->first )
+      {
+      std::cerr << "self best match of " << it->first << ": " << it->second.Label << std::endl;
+      ok = false;
+      }
+    }
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
+
@@ -1,4 +1,5 @@
 #include "itkImageFileReader.h"
+#include "itkMappedImageFileReader.h"
 #include "itkImageFileWriter.h"
 
 #include "itkRegionalMinimaImageFilter.h"
@@ -8,6 +9,7 @@
 #include "itkConnectedComponentImageFilter.h"
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
 #include "itkInvertIntensityImageFilter.h"
+#include "itkImageRegionConstIterator.h"
 
 #include "itkTimeProbe.h"
 #include <vector>
@@ -22,8 +24,8 @@ int main(int, char * argv[])
   typedef unsigned char PType;
   typedef itk::Image< PType, dim >    IType;
   
-  // read the input image
-  typedef itk::ImageFileReader< IType > ReaderType;
+  // map the input image, rather than reading it
+  typedef itk::MappedImageFileReader< IType > ReaderType;
   ReaderType::Pointer reader = ReaderType::New();
   reader->SetFileName( argv[1] );
   
@@ -31,6 +33,9 @@ int main(int, char * argv[])
   typedef itk::InvertIntensityImageFilter< IType, IType > InvertType;
   InvertType::Pointer invert = InvertType::New();
   invert->SetInput( reader->GetOutput() );
+  // the output of the reader is a read only mapping of the file, and is
+  // used by several filters: the inverted image must not be written in it
+  invert->InPlaceOff();
 
   // remove some minima
   typedef itk::HMinimaImageFilter< IType, IType > MinimaType;
@@ -72,6 +77,19 @@ int main(int, char * argv[])
   mws->SetInput( minima->GetOutput() );
   
 
+  // the pages of the file are read when they are accessed for the first time:
+  // read them all here, so the filter timings don't include the I/O
+  itk::TimeProbe iotime;
+  iotime.Start();
+  reader->Update();
+  unsigned long checksum = 0;
+  itk::ImageRegionConstIterator< IType > iit( reader->GetOutput(),
+                                              reader->GetOutput()->GetLargestPossibleRegion() );
+  for( iit.GoToBegin(); !iit.IsAtEnd(); ++iit )
+    { checksum += iit.Get(); }
+  iotime.Stop();
+  std::cout << "# io: " << iotime.GetMeanTime() << " (" << checksum << ")" << std::endl;
+
   // should take about 20 sec
   minima->Update();
   
@@ -0,0 +1,74 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkSimpleFilterWatcher.h"
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " markLine fullyConnected input markers output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  // a float input, to use the rank transform
+  typedef float FType;
+  typedef itk::Image< FType, dim > FIType;
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< FIType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  typedef itk::ImageFileReader< IType > LabelReaderType;
+  LabelReaderType::Pointer reader2 = LabelReaderType::New();
+  reader2->SetFileName( argv[4] );
+
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< FIType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkerImage( reader2->GetOutput() );
+  filter->SetMarkWatershedLine( atoi( argv[1] ) );
+  filter->SetFullyConnected( atoi( argv[2] ) );
+  filter->SetUseRankTransform( true );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  // the ranks must give exactly the same result as the map based queue
+  FilterType::Pointer ref = FilterType::New();
+  ref->SetInput( reader->GetOutput() );
+  ref->SetMarkerImage( reader2->GetOutput() );
+  ref->SetMarkWatershedLine( atoi( argv[1] ) );
+  ref->SetFullyConnected( atoi( argv[2] ) );
+  ref->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< IType > it( filter->GetOutput(), filter->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< IType > rit( ref->GetOutput(), ref->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if( it.Get() != rit.Get() )
+      {
+      diff++;
+      }
+    }
+  std::cout << "Number of pixels different from the hierarchical queue: " << diff << std::endl;
+
+  if( diff != 0 )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
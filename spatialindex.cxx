@@ -0,0 +1,208 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkChangeRegionLabelMapFilter.h"
+#include "itkLabelMapMaskImageFilter.h"
+#include "itkLabelMapSpatialIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkSimpleFilterWatcher.h"
+#include <algorithm>
+#include <map>
+#include <cstdlib>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 7 )
+    {
+    std::cerr << "usage: " << argv[0] << " input x y sizeX sizeY output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::LabelObject< PType, dim > LabelObjectType;
+  typedef itk::LabelMap< LabelObjectType > LabelMapType;
+  typedef LabelMapType::SpatialIndexType SpatialIndexType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+
+  typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+  I2LType::Pointer i2l = I2LType::New();
+  i2l->SetInput( reader->GetOutput() );
+  i2l->Update();
+
+  IType::RegionType region;
+  region.SetIndex( 0, atoi( argv[2] ) );
+  region.SetIndex( 1, atoi( argv[3] ) );
+  region.SetSize( 0, atoi( argv[4] ) );
+  region.SetSize( 1, atoi( argv[5] ) );
+
+  // the bounding boxes, computed without the index
+  LabelMapType * labelMap = i2l->GetOutput();
+  typedef std::map< LabelObjectType *, IType::RegionType > BoxMapType;
+  BoxMapType boxes;
+  const LabelMapType::LabelObjectContainerType & objects = labelMap->GetLabelObjectContainer();
+  for( LabelMapType::LabelObjectContainerType::const_iterator it = objects.begin(); it != objects.end(); it++ )
+    {
+    IType::IndexType min;
+    min.Fill( itk::NumericTraits< long >::max() );
+    IType::IndexType max;
+    max.Fill( itk::NumericTraits< long >::NonpositiveMin() );
+    const LabelObjectType::LineContainerType & lines = it->second->GetLineContainer();
+    for( LabelObjectType::LineContainerType::const_iterator lit = lines.begin(); lit != lines.end(); lit++ )
+      {
+      for( int d=0; d<dim; d++ )
+        {
+        min[d] = std::min( min[d], lit->GetIndex()[d] );
+        max[d] = std::max( max[d], lit->GetIndex()[d] );
+        }
+      max[0] = std::max( max[0], lit->GetIndex()[0] + (long)lit->GetLength() - 1 );
+      }
+    IType::RegionType box;
+    box.SetIndex( min );
+    for( int d=0; d<dim; d++ )
+      {
+      box.SetSize( d, max[d] - min[d] + 1 );
+      }
+    boxes[ it->second.GetPointer() ] = box;
+    }
+
+  const SpatialIndexType * index = labelMap->GetSpatialIndex();
+  index->Print( std::cout );
+  if( index->GetNumberOfObjects() != labelMap->GetNumberOfLabelObjects() )
+    {
+    std::cerr << "Wrong number of objects in the index." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // compare the queries with a scan of all the boxes, on random regions
+  srand( 0 );
+  const IType::SizeType & size = labelMap->GetLargestPossibleRegion().GetSize();
+  for( int q=0; q<1000; q++ )
+    {
+    IType::RegionType query;
+    for( int d=0; d<dim; d++ )
+      {
+      query.SetIndex( d, rand() % size[d] );
+      query.SetSize( d, q % 2 ? 1 : rand() % ( size[d] / 4 ) + 1 );
+      }
+    SpatialIndexType::LabelObjectVectorType found;
+    SpatialIndexType::LabelObjectVectorType foundInside;
+    if( q % 2 )
+      {
+      index->FindObjects( query.GetIndex(), found );
+      }
+    else
+      {
+      index->FindObjects( query, found );
+      }
+    index->FindObjectsInside( query, foundInside );
+    std::sort( found.begin(), found.end() );
+    std::sort( foundInside.begin(), foundInside.end() );
+
+    SpatialIndexType::LabelObjectVectorType expected;
+    SpatialIndexType::LabelObjectVectorType expectedInside;
+    for( BoxMapType::const_iterator bit = boxes.begin(); bit != boxes.end(); bit++ )
+      {
+      IType::RegionType box = bit->second;
+      if( box.Crop( query ) )
+        {
+        expected.push_back( bit->first );
+        }
+      if( query.IsInside( bit->second ) )
+        {
+        expectedInside.push_back( bit->first );
+        }
+      }
+    std::sort( expected.begin(), expected.end() );
+    std::sort( expectedInside.begin(), expectedInside.end() );
+
+    if( found != expected || foundInside != expectedInside )
+      {
+      std::cerr << "Wrong objects found in " << query << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // the index must be built again after a modification
+  labelMap->RemoveLabelObject( labelMap->GetNthLabelObject( 0 ) );
+  if( labelMap->GetSpatialIndex()->GetNumberOfObjects() != labelMap->GetNumberOfLabelObjects() )
+    {
+    std::cerr << "The index has not been updated." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // change the region with the index, and compare with the input image
+  i2l->Modified();
+  typedef itk::ChangeRegionLabelMapFilter< LabelMapType > ChangeType;
+  ChangeType::Pointer change = ChangeType::New();
+  change->SetInput( i2l->GetOutput() );
+  change->SetRegion( region );
+  change->InPlaceOff();
+  itk::SimpleFilterWatcher watcher(change, "change");
+
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, IType > L2IType;
+  L2IType::Pointer l2i = L2IType::New();
+  l2i->SetInput( change->GetOutput() );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( l2i->GetOutput() );
+  writer->SetFileName( argv[6] );
+  writer->Update();
+
+  unsigned long diff = 0;
+  itk::ImageRegionConstIteratorWithIndex< IType > it( l2i->GetOutput(), region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != reader->GetOutput()->GetPixel( it.GetIndex() ) )
+      {
+      diff++;
+      }
+    }
+  if( diff != 0 || l2i->GetOutput()->GetLargestPossibleRegion() != region )
+    {
+    std::cerr << diff << " pixels differ after the change of region." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // mask and crop the input image with all the objects
+  typedef itk::LabelMapMaskImageFilter< LabelMapType, IType > MaskType;
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetInput( i2l->GetOutput() );
+  mask->SetFeatureImage( reader->GetOutput() );
+  mask->SetLabel( i2l->GetBackgroundValue() );
+  mask->SetNegated( true );
+  mask->SetCrop( true );
+  mask->Update();
+
+  if( mask->GetOutput()->GetLargestPossibleRegion() != i2l->GetOutput()->GetSpatialIndex()->GetBoundingBox() )
+    {
+    std::cerr << "Wrong crop region: " << mask->GetOutput()->GetLargestPossibleRegion() << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::ImageRegionConstIteratorWithIndex< IType > mit( mask->GetOutput(), mask->GetOutput()->GetLargestPossibleRegion() );
+  for( mit.GoToBegin(); !mit.IsAtEnd(); ++mit )
+    {
+    if( mit.Get() != reader->GetOutput()->GetPixel( mit.GetIndex() ) )
+      {
+      diff++;
+      }
+    }
+  if( diff != 0 )
+    {
+    std::cerr << diff << " pixels differ after the mask." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return 0;
+}
+
@@ -0,0 +1,132 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkRescaleIntensityImageFilter.h"
+
+#include "itkStochasticWatershedImageFilter.h"
+#include "itkSimpleFilterWatcher.h"
+#include "itkImageRegionConstIterator.h"
+#include <cmath>
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 6 )
+    {
+    std::cerr << "usage: " << argv[0] << " fullyConnected nbOfRealizations nbOfMarkers input output" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+  typedef itk::Image< float, dim > FType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+
+  typedef itk::StochasticWatershedImageFilter< IType, FType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetFullyConnected( atoi( argv[1] ) );
+  filter->SetNumberOfRealizations( atoi( argv[2] ) );
+  filter->SetNumberOfMarkers( atoi( argv[3] ) );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::RescaleIntensityImageFilter< FType, IType > RescaleType;
+  RescaleType::Pointer rescale = RescaleType::New();
+  rescale->SetInput( filter->GetOutput() );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( rescale->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  bool ok = true;
+  typedef itk::ImageRegionConstIterator< FType > IteratorType;
+  const FType::RegionType region = filter->GetOutput()->GetBufferedRegion();
+  const unsigned long nbOfRealizations = filter->GetNumberOfRealizations();
+
+  // the output is a frequency: between 0 and 1, a multiple of 1 / the
+  // number of realizations, and not 0 everywhere
+  FType::Pointer first = filter->GetOutput();
+  first->DisconnectPipeline();
+  unsigned long nbOfErrors = 0;
+  bool hasBoundary = false;
+  IteratorType it( first, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double count = it.Get() * nbOfRealizations;
+    if( it.Get() < 0 || it.Get() > 1 || std::fabs( count - std::floor( count + 0.5 ) ) > 1e-3 )
+      {
+      nbOfErrors++;
+      }
+    hasBoundary = hasBoundary || it.Get() > 0;
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels are not a frequency" << std::endl;
+    ok = false;
+    }
+  if( !hasBoundary )
+    {
+    std::cerr << "no boundary found" << std::endl;
+    ok = false;
+    }
+
+  // the result only depends on the seed, not on the number of threads
+  FilterType::Pointer single = FilterType::New();
+  single->SetInput( reader->GetOutput() );
+  single->SetFullyConnected( atoi( argv[1] ) );
+  single->SetNumberOfRealizations( nbOfRealizations );
+  single->SetNumberOfMarkers( atoi( argv[3] ) );
+  single->SetNumberOfThreads( 1 );
+  single->Update();
+  nbOfErrors = 0;
+  IteratorType sit( single->GetOutput(), region );
+  for( it.GoToBegin(), sit.GoToBegin(); !it.IsAtEnd(); ++it, ++sit )
+    {
+    if( it.Get() != sit.Get() )
+      {
+      nbOfErrors++;
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels differ with the same seed and a single thread" << std::endl;
+    ok = false;
+    }
+
+  // the tree must be reused when only the number of realizations changes.
+  // The realizations from nbOfRealizations to 2 * nbOfRealizations are the
+  // ones of a filter seeded with Seed + nbOfRealizations.
+  filter->SetNumberOfRealizations( nbOfRealizations * 2 );
+  filter->Update();
+
+  single->SetSeed( single->GetSeed() + nbOfRealizations );
+  single->SetNumberOfThreads( filter->GetNumberOfThreads() );
+  single->Update();
+  nbOfErrors = 0;
+  IteratorType dit( filter->GetOutput(), region );
+  for( it.GoToBegin(), sit.GoToBegin(), dit.GoToBegin(); !it.IsAtEnd(); ++it, ++sit, ++dit )
+    {
+    if( std::fabs( dit.Get() - ( it.Get() + sit.Get() ) / 2 ) > 1e-5 )
+      {
+      nbOfErrors++;
+      }
+    }
+  if( nbOfErrors )
+    {
+    std::cerr << nbOfErrors << " pixels differ after doubling the number of realizations" << std::endl;
+    ok = false;
+    }
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
@@ -0,0 +1,187 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+
+#include "itkStreamingImageToLabelMapFilter.h"
+#include "itkStreamingLabelMapToImageFilter.h"
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkBinaryImageToLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+
+const int dim = 2;
+
+typedef unsigned char PType;
+typedef itk::Image< PType, dim > IType;
+typedef unsigned short LType;
+typedef itk::Image< LType, dim > LIType;
+
+typedef itk::LabelObject< LType, dim > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType > LabelMapType;
+
+
+unsigned long compare( const LIType * image1, const LIType * image2 )
+{
+  unsigned long diff = 0;
+  itk::ImageRegionConstIterator< LIType > it1( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LIType > it2( image2, image2->GetBufferedRegion() );
+  for( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      diff++;
+      }
+    }
+  return diff;
+}
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 7 )
+    {
+    std::cerr << "usage: " << argv[0] << " binary fullyConnected nbOfDivisions input tmp.mha output.mha" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const bool binary = atoi( argv[1] );
+  const bool fullyConnected = atoi( argv[2] );
+  const unsigned long nbOfDivisions = atoi( argv[3] );
+
+  // store the input in a format able to stream
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[4] );
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( reader->GetOutput() );
+  writer->SetFileName( argv[5] );
+  writer->Update();
+
+  // the streamed pipeline
+  ReaderType::Pointer sreader = ReaderType::New();
+  sreader->SetFileName( argv[5] );
+  sreader->SetUseStreaming( true );
+
+  typedef itk::BinaryThresholdImageFilter< IType, IType > ThresholdType;
+  ThresholdType::Pointer th = ThresholdType::New();
+  th->SetInput( sreader->GetOutput() );
+  th->SetLowerThreshold( 128 );
+  th->SetInsideValue( 255 );
+  th->SetOutsideValue( 0 );
+
+  typedef itk::StreamingImageToLabelMapFilter< IType, LabelMapType > ImportType;
+  ImportType::Pointer import = ImportType::New();
+  if( binary )
+    {
+    import->SetInput( th->GetOutput() );
+    }
+  else
+    {
+    import->SetInput( sreader->GetOutput() );
+    }
+  import->SetBinary( binary );
+  import->SetFullyConnected( fullyConnected );
+  import->SetForegroundValue( 255 );
+  import->SetNumberOfStreamDivisions( nbOfDivisions );
+  itk::TimeProbe time;
+  time.Start();
+  import->Update();
+  time.Stop();
+  std::cout << "import: " << time.GetMeanTime() << " " << import->GetOutput()->GetNumberOfLabelObjects() << " objects" << std::endl;
+
+  bool ok = true;
+
+  // only the last slab is in memory
+  if( nbOfDivisions > 1 && sreader->GetOutput()->GetBufferedRegion() == sreader->GetOutput()->GetLargestPossibleRegion() )
+    {
+    std::cerr << "the input has not been streamed" << std::endl;
+    ok = false;
+    }
+
+  // the label map must be the one of the non streamed filters
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, LIType > L2IType;
+  L2IType::Pointer l2i = L2IType::New();
+  l2i->SetInput( import->GetOutput() );
+  l2i->Update();
+
+  ThresholdType::Pointer rth = ThresholdType::New();
+  rth->SetInput( reader->GetOutput() );
+  rth->SetLowerThreshold( 128 );
+  rth->SetInsideValue( 255 );
+  rth->SetOutsideValue( 0 );
+
+  L2IType::Pointer rl2i = L2IType::New();
+  if( binary )
+    {
+    typedef itk::BinaryImageToLabelMapFilter< IType, LabelMapType > I2LType;
+    I2LType::Pointer i2l = I2LType::New();
+    i2l->SetInput( rth->GetOutput() );
+    i2l->SetFullyConnected( fullyConnected );
+    i2l->SetForegroundValue( 255 );
+    rl2i->SetInput( i2l->GetOutput() );
+    rl2i->Update();
+    if( import->GetObjectCount() != i2l->GetObjectCount() )
+      {
+      std::cerr << import->GetObjectCount() << " objects instead of " << i2l->GetObjectCount() << std::endl;
+      ok = false;
+      }
+    }
+  else
+    {
+    typedef itk::LabelImageToLabelMapFilter< IType, LabelMapType > I2LType;
+    I2LType::Pointer i2l = I2LType::New();
+    i2l->SetInput( reader->GetOutput() );
+    rl2i->SetInput( i2l->GetOutput() );
+    rl2i->Update();
+    }
+
+  unsigned long diff = compare( l2i->GetOutput(), rl2i->GetOutput() );
+  if( diff )
+    {
+    std::cerr << diff << " pixels differ after the import" << std::endl;
+    ok = false;
+    }
+
+  // write the label map slab by slab
+  typedef itk::StreamingLabelMapToImageFilter< LabelMapType, LIType > ExportType;
+  ExportType::Pointer exporter = ExportType::New();
+  exporter->SetInput( import->GetOutput() );
+
+  typedef itk::ImageFileWriter< LIType > LWriterType;
+  LWriterType::Pointer lwriter = LWriterType::New();
+  lwriter->SetInput( exporter->GetOutput() );
+  lwriter->SetFileName( argv[6] );
+  lwriter->SetNumberOfStreamDivisions( nbOfDivisions );
+  time.Start();
+  lwriter->Update();
+  time.Stop();
+  std::cout << "export: " << time.GetMeanTime() << std::endl;
+
+  if( nbOfDivisions > 1 && exporter->GetOutput()->GetBufferedRegion() == exporter->GetOutput()->GetLargestPossibleRegion() )
+    {
+    std::cerr << "the output has not been streamed" << std::endl;
+    ok = false;
+    }
+
+  typedef itk::ImageFileReader< LIType > LReaderType;
+  LReaderType::Pointer lreader = LReaderType::New();
+  lreader->SetFileName( argv[6] );
+  lreader->Update();
+  diff = compare( lreader->GetOutput(), rl2i->GetOutput() );
+  if( diff )
+    {
+    std::cerr << diff << " pixels differ after the export" << std::endl;
+    ok = false;
+    }
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}
+
@@ -0,0 +1,192 @@
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMorphologicalWatershedImageFilter.h"
+#include "itkLabelOverlayImageFilter.h"
+#include "itkRegionalMinimaImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <set>
+
+#include "itkSimpleFilterWatcher.h"
+
+
+int main(int arglen, char * argv[])
+{
+  if( arglen < 5 )
+    {
+    std::cerr << "usage: " << argv[0] << " markLine fullyConnected input output [rgbOutput [opacity]]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int dim = 2;
+  
+  typedef unsigned char PType;
+  typedef itk::Image< PType, dim > IType;
+
+  typedef itk::ImageFileReader< IType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[3] );
+
+  typedef itk::MorphologicalWatershedImageFilter< IType, IType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+  filter->SetMarkWatershedLine( atoi( argv[1] ) );
+  filter->SetFullyConnected( atoi( argv[2] ) );
+  filter->SetFloodingMethod( FilterType::SORTED_LEVELS );
+
+  itk::SimpleFilterWatcher watcher(filter, "filter");
+
+  typedef itk::ImageFileWriter< IType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( filter->GetOutput() );
+  writer->SetFileName( argv[4] );
+  writer->Update();
+
+  if( arglen > 5 )
+    {
+    typedef itk::RGBPixel<unsigned char>   RGBPixelType;
+    typedef itk::Image<RGBPixelType, dim>    RGBImageType;
+    
+    typedef itk::LabelOverlayImageFilter<IType, IType, RGBImageType> OverlayType;
+    OverlayType::Pointer overlay = OverlayType::New();
+    overlay->SetInput( reader->GetOutput() );
+    overlay->SetLabelImage( filter->GetOutput() );
+    if( arglen > 6 )
+      {
+      overlay->SetOpacity( atof( argv[6] ) );
+      }
+
+    typedef itk::ImageFileWriter< RGBImageType > RGBWriterType;
+    RGBWriterType::Pointer rgbwriter = RGBWriterType::New();
+    rgbwriter->SetInput( overlay->GetOutput() );
+    rgbwriter->SetFileName( argv[5] );
+    rgbwriter->Update();
+    }
+
+  // compare with the flooding with the hierarchical queue. The two methods
+  // can only give different labels to the pixels which can be reached at
+  // the same level from several minima, so both outputs must be valid
+  // floodings, with the same labels.
+  FilterType::Pointer hq = FilterType::New();
+  hq->SetInput( reader->GetOutput() );
+  hq->SetMarkWatershedLine( atoi( argv[1] ) );
+  hq->SetFullyConnected( atoi( argv[2] ) );
+  hq->SetFloodingMethod( FilterType::HIERARCHICAL_QUEUE );
+  hq->Update();
+
+  // the level at which each pixel is flooded: the reconstruction by erosion
+  // of the input from its regional minima
+  typedef itk::RegionalMinimaImageFilter< IType, IType > MinimaType;
+  MinimaType::Pointer minima = MinimaType::New();
+  minima->SetInput( reader->GetOutput() );
+  minima->SetFullyConnected( atoi( argv[2] ) );
+  minima->SetForegroundValue( 1 );
+  minima->SetBackgroundValue( 0 );
+  minima->Update();
+
+  const IType * input = reader->GetOutput();
+  const IType::RegionType region = input->GetBufferedRegion();
+  IType::Pointer seeds = IType::New();
+  seeds->SetRegions( region );
+  seeds->Allocate();
+  typedef itk::ImageRegionConstIterator< IType > IteratorType;
+  itk::ImageRegionIterator< IType > sit( seeds, region );
+  IteratorType iit( input, region );
+  IteratorType mit( minima->GetOutput(), region );
+  for( sit.GoToBegin(), iit.GoToBegin(), mit.GoToBegin(); !sit.IsAtEnd(); ++sit, ++iit, ++mit )
+    {
+    sit.Set( mit.Get() ? iit.Get() : itk::NumericTraits< PType >::max() );
+    }
+  typedef itk::ReconstructionByErosionImageFilter< IType, IType > ReconstructionType;
+  ReconstructionType::Pointer reconstruction = ReconstructionType::New();
+  reconstruction->SetMarkerImage( seeds );
+  reconstruction->SetMaskImage( input );
+  reconstruction->SetFullyConnected( atoi( argv[2] ) );
+  reconstruction->Update();
+  const IType * cost = reconstruction->GetOutput();
+
+  IType::OffsetType offsets[8];
+  unsigned int nbOfOffsets = 0;
+  for( int y=-1; y<=1; y++ )
+    {
+    for( int x=-1; x<=1; x++ )
+      {
+      if( ( x != 0 || y != 0 ) && ( atoi( argv[2] ) || x == 0 || y == 0 ) )
+        {
+        offsets[nbOfOffsets][0] = x;
+        offsets[nbOfOffsets][1] = y;
+        nbOfOffsets++;
+        }
+      }
+    }
+
+  bool ok = true;
+  const IType * outputs[2] = { filter->GetOutput(), hq->GetOutput() };
+  const char * names[2] = { "sorted levels", "hierarchical queue" };
+  std::set< PType > labels[2];
+  for( unsigned int o=0; o<2; o++ )
+    {
+    const IType * output = outputs[o];
+    unsigned long nbOfErrors = 0;
+    itk::ImageRegionConstIteratorWithIndex< IType > cit( cost, region );
+    IteratorType oit( output, region );
+    for( cit.GoToBegin(), oit.GoToBegin(), mit.GoToBegin(); !cit.IsAtEnd(); ++cit, ++oit, ++mit )
+      {
+      labels[o].insert( oit.Get() );
+      if( mit.Get() )
+        {
+        // the minima are the markers
+        continue;
+        }
+      // a labeled pixel gets its label from a neighbor flooded before it,
+      // and a pixel of the watershed line separates two labels
+      std::set< PType > neighborLabels;
+      bool found = false;
+      for( unsigned int i=0; i<nbOfOffsets; i++ )
+        {
+        const IType::IndexType idx = cit.GetIndex() + offsets[i];
+        if( region.IsInside( idx ) && output->GetPixel( idx ) != 0 )
+          {
+          neighborLabels.insert( output->GetPixel( idx ) );
+          found = found || ( output->GetPixel( idx ) == oit.Get() && cost->GetPixel( idx ) <= cit.Get() );
+          }
+        }
+      if( ( oit.Get() != 0 && !found )
+          || ( oit.Get() == 0 && ( !atoi( argv[1] ) || neighborLabels.size() < 2 ) ) )
+        {
+        nbOfErrors++;
+        }
+      }
+    if( nbOfErrors )
+      {
+      std::cerr << names[o] << ": " << nbOfErrors << " pixels not flooded from a lowest path" << std::endl;
+      ok = false;
+      }
+    }
+  if( labels[0] != labels[1] )
+    {
+    std::cerr << "the labels differ: " << labels[0].size() << " and " << labels[1].size() << std::endl;
+    ok = false;
+    }
+
+  unsigned long diff = 0;
+  IteratorType it1( filter->GetOutput(), region );
+  IteratorType it2( hq->GetOutput(), region );
+  for( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      diff++;
+      }
+    }
+  std::cout << "Pixels different from the hierarchical queue: " << diff << " / "
+            << region.GetNumberOfPixels() << std::endl;
+
+  if( !ok )
+    {
+    return EXIT_FAILURE;
+    }
+  return 0;
+}